@@ -103,13 +103,13 @@ class ndIsoSurfaceParticleVolume : public ndBodySphFluid
 		}
 	}
 
-	void UpdateIsoSurface()
+	void UpdateIsoSurface(ndThreadPool* const threadPool)
 	{
 		D_TRACKTIME();
 		ndArray<ndVector>& pointCloud = GetPositions();
 		ndFloat32 gridSpacing = GetSphGridSize();
 		//gridSpacing *= 1.0f;
-		m_isoSurface.GenerateMesh(pointCloud, gridSpacing);
+		m_isoSurface.GenerateMesh(pointCloud, gridSpacing, nullptr, threadPool);
 
 #if 1
 		BuildIndexList();
@@ -393,7 +393,8 @@ matrix.m_posit = ndVector (2.0f, 2.0f, 2.0f, 0.0f);
 	//BuildHollowBox(matrix, fluidObject, particleCountPerAxis);
 
 	// make sure we have the first surface generated before rendering.
-	fluidObject->UpdateIsoSurface();
+	// the world is not updating yet, so the mesher can borrow its threads.
+	fluidObject->UpdateIsoSurface(world->GetScene());
 
 	// add particle volume to world
 	world->AddBody(fluidObject);
@@ -889,6 +889,7 @@ void ndDemoEntityManager::ShowMainMenuBar()
 			ndInt32 solverMode(m_solverMode);
 			ImGui::RadioButton("avx2", &solverMode, ndWorld::ndSimdAvx2Solver);
 			ImGui::RadioButton("sse soa", &solverMode, ndWorld::ndSimdSoaSolver);
+			ImGui::RadioButton("gauss seidel", &solverMode, ndWorld::ndGaussSeidelSolver);
 			ImGui::RadioButton("cuda", &solverMode, ndWorld::ndCudaSolver);
 			ImGui::RadioButton("opencl1", &solverMode, ndWorld::ndOpenclSolver1);
 			ImGui::RadioButton("opencl2", &solverMode, ndWorld::ndOpenclSolver2);
@@ -901,7 +902,7 @@ void ndDemoEntityManager::ShowMainMenuBar()
 			ImGui::Text("iterative solver passes");
 			ImGui::SliderInt("##intera", &m_solverPasses, 4, 32);
 			ImGui::Text("worker threads");
-			ImGui::SliderInt("##worker", &m_workerThreads, 1, D_MAX_THREADS_COUNT);
+			ImGui::SliderInt("##worker", &m_workerThreads, 1, ndThreadPool::GetMaxThreads());
 			ImGui::Separator();
 
 			ImGui::RadioButton("hide collision Mesh", &m_collisionDisplayMode, 0);
@@ -0,0 +1,2177 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "benchmarks.h"
+
+class ndBenchmarkNotify: public ndBodyNotify
+{
+	public:
+	ndBenchmarkNotify()
+		:ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f))
+	{
+	}
+
+	virtual void OnApplyExternalForce(ndInt32, ndFloat32)
+	{
+		ndBodyDynamic* const dynamicBody = GetBody()->GetAsBodyDynamic();
+		if (dynamicBody)
+		{
+			ndVector massMatrix(dynamicBody->GetMassMatrix());
+			ndVector force(GetGravity().Scale(massMatrix.m_w));
+			dynamicBody->SetForce(force);
+			dynamicBody->SetTorque(ndVector::m_zero);
+		}
+	}
+
+	virtual void OnTransform(ndInt32, const ndMatrix&)
+	{
+	}
+};
+
+static ndBodyDynamic* AddBenchmarkBox(ndWorld& world, const ndVector& origin, ndFloat32 mass, ndFloat32 sizex, ndFloat32 sizey, ndFloat32 sizez)
+{
+	ndShapeInstance box(new ndShapeBox(sizex, sizey, sizez));
+	ndBodyDynamic* const body = new ndBodyDynamic();
+
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = origin;
+	matrix.m_posit.m_w = ndFloat32(1.0f);
+
+	body->SetNotifyCallback(new ndBenchmarkNotify);
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	if (mass > ndFloat32(0.0f))
+	{
+		body->SetMassMatrix(mass, box);
+	}
+	world.AddBody(body);
+	return body;
+}
+
+// a floor with a grid of box stacks, most bodies are in contact so all 
+// phases of the update (broad phase, narrow phase and solver) get exercised.
+static void BuildBoxStacks(ndWorld& world, ndInt32 stacksPerSide, ndInt32 stackHigh)
+{
+	AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(500.0f), ndFloat32(1.0f), ndFloat32(500.0f));
+	const ndFloat32 spacing = ndFloat32(1.5f);
+	const ndFloat32 offset = ndFloat32(stacksPerSide) * spacing * ndFloat32(0.5f);
+	for (ndInt32 i = 0; i < stacksPerSide; ++i)
+	{
+		for (ndInt32 j = 0; j < stacksPerSide; ++j)
+		{
+			for (ndInt32 k = 0; k < stackHigh; ++k)
+			{
+				ndVector origin(ndFloat32(i) * spacing - offset, ndFloat32(0.5f) + ndFloat32(k) * ndFloat32(1.01f), ndFloat32(j) * spacing - offset, ndFloat32(1.0f));
+				AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+			}
+		}
+	}
+}
+
+static ndFloat64 StepWorld(ndWorld& world, ndInt32 steps)
+{
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	// a few warm up steps so that the contacts and the memory pools are populated
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		world.Update(timestep);
+		world.Sync();
+	}
+
+	const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < steps; ++i)
+	{
+		world.Update(timestep);
+		world.Sync();
+	}
+	const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+	return ndFloat64(time1 - time0) * ndFloat64(1.0e-3f) / ndFloat64(steps);
+}
+
+// measures the step time of the same scene from 1 to N threads
+// usage: ndTest -benchmark threads [maxThreads] [stacksPerSide] [steps]
+static ndInt32 ThreadScalingBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 maxThreads = (argc > 0) ? dClamp(atoi(argv[0]), 1, D_MAX_THREADS_COUNT) : ndThreadPool::GetMaxThreads();
+	const ndInt32 stacksPerSide = (argc > 1) ? dMax(atoi(argv[1]), 1) : 24;
+	const ndInt32 steps = (argc > 2) ? dMax(atoi(argv[2]), 1) : 200;
+	const ndInt32 stackHigh = 8;
+
+	printf("thread scaling: %d bodies, %d steps\n", stacksPerSide * stacksPerSide * stackHigh, steps);
+	printf("threads    ms/step    speedup\n");
+
+	ndFloat64 baseTime = ndFloat64(0.0f);
+	ndInt32 threadCount = 1;
+	while (threadCount <= maxThreads)
+	{
+		ndWorld world;
+		world.SetSubSteps(2);
+		world.SetThreadCount(threadCount);
+		BuildBoxStacks(world, stacksPerSide, stackHigh);
+
+		const ndFloat64 time = StepWorld(world, steps);
+		if (threadCount == 1)
+		{
+			baseTime = time;
+		}
+		printf("%7d %10.3f %10.2f\n", threadCount, time, baseTime / time);
+
+		// 1, 2, 3, 4, 8, 16 ... always ending at maxThreads
+		ndInt32 nextCount = (threadCount < 4) ? threadCount + 1 : threadCount * 2;
+		if ((threadCount < maxThreads) && (nextCount > maxThreads))
+		{
+			nextCount = maxThreads;
+		}
+		threadCount = nextCount;
+	}
+	return 0;
+}
+
+static ndFloat64 CalculateChecksum(const ndWorld& world)
+{
+	ndFloat64 checksum = ndFloat64(0.0f);
+	const ndBodyList& bodyList = world.GetBodyList();
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndVector posit(node->GetInfo()->GetMatrix().m_posit);
+		checksum += posit.m_x + posit.m_y * ndFloat32(3.0f) + posit.m_z * ndFloat32(7.0f);
+	}
+	return checksum;
+}
+
+// steps two identical sets of small worlds, one with each world using its 
+// own threads, the other with all worlds in one ndWorldGroup sharing a pool.
+// usage: ndTest -benchmark worlds [worldCount] [threads] [steps]
+static ndInt32 WorldGroupBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 worldCount = (argc > 0) ? dMax(atoi(argv[0]), 1) : 64;
+	const ndInt32 threadCount = (argc > 1) ? dClamp(atoi(argv[1]), 1, D_MAX_THREADS_COUNT) : ndThreadPool::GetMaxThreads();
+	const ndInt32 steps = (argc > 2) ? dMax(atoi(argv[2]), 1) : 200;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	printf("world group: %d worlds, %d threads, %d steps\n", worldCount, threadCount, steps);
+
+	ndWorldGroup group;
+	group.SetThreadCount(threadCount);
+	ndWorld** const worlds = new ndWorld*[worldCount * 2];
+	for (ndInt32 i = 0; i < worldCount * 2; ++i)
+	{
+		worlds[i] = new ndWorld();
+		worlds[i]->SetThreadCount(threadCount);
+		BuildBoxStacks(*worlds[i], 4, 4);
+		if (i >= worldCount)
+		{
+			group.AddWorld(worlds[i]);
+		}
+	}
+
+	ndUnsigned64 time0 = dGetTimeInMicroseconds();
+	for (ndInt32 j = 0; j < steps; ++j)
+	{
+		for (ndInt32 i = 0; i < worldCount; ++i)
+		{
+			worlds[i]->Update(timestep);
+		}
+		for (ndInt32 i = 0; i < worldCount; ++i)
+		{
+			worlds[i]->Sync();
+		}
+	}
+	ndUnsigned64 time1 = dGetTimeInMicroseconds();
+	const ndFloat64 independentTime = ndFloat64(time1 - time0) * ndFloat64(1.0e-3f) / ndFloat64(steps);
+
+	time0 = dGetTimeInMicroseconds();
+	for (ndInt32 j = 0; j < steps; ++j)
+	{
+		group.Update(timestep);
+		group.Sync();
+	}
+	time1 = dGetTimeInMicroseconds();
+	const ndFloat64 groupTime = ndFloat64(time1 - time0) * ndFloat64(1.0e-3f) / ndFloat64(steps);
+
+	ndFloat64 independentChecksum = ndFloat64(0.0f);
+	ndFloat64 groupChecksum = ndFloat64(0.0f);
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		independentChecksum += CalculateChecksum(*worlds[i]);
+		groupChecksum += CalculateChecksum(*worlds[worldCount + i]);
+	}
+
+	printf("independent worlds %10.3f ms/step  checksum %f\n", independentTime, independentChecksum);
+	printf("world group        %10.3f ms/step  checksum %f\n", groupTime, groupChecksum);
+
+	for (ndInt32 i = 0; i < worldCount * 2; ++i)
+	{
+		if (i >= worldCount)
+		{
+			group.RemoveWorld(worlds[i]);
+		}
+		delete worlds[i];
+	}
+	delete[] worlds;
+	return 0;
+}
+
+// rejects all pairs after the broad phase, so that the narrow phase does not hide 
+// the cost of finding the pairs and creating the contacts.
+class ndBroadPhaseOnlyNotify: public ndContactNotify
+{
+	public:
+	virtual bool OnAabbOverlap(const ndContact* const, ndFloat32)
+	{
+		return false;
+	}
+};
+
+// measures the creation of new contacts in a dense debris pile, all bodies 
+// are moved at once into overlapping positions, so one collision update 
+// finds and creates every pair.
+// usage: ndTest -benchmark pairs [bodiesPerSide] [threads ...]
+static ndInt32 PairCreationBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 bodiesPerSide = (argc > 0) ? dMax(atoi(argv[0]), 2) : 24;
+	ndInt32 threadCounts[D_MAX_THREADS_COUNT];
+	ndInt32 threadCountsCount = 0;
+	for (ndInt32 i = 1; (i < argc) && (threadCountsCount < D_MAX_THREADS_COUNT); ++i)
+	{
+		threadCounts[threadCountsCount] = dClamp(atoi(argv[i]), 1, D_MAX_THREADS_COUNT);
+		threadCountsCount++;
+	}
+	if (!threadCountsCount)
+	{
+		threadCounts[0] = 8;
+		threadCounts[1] = 16;
+		threadCounts[2] = 32;
+		threadCountsCount = 3;
+	}
+
+	const ndInt32 frames = 8;
+	printf("pair creation: %d bodies\n", bodiesPerSide * bodiesPerSide * bodiesPerSide);
+	printf("threads   contacts   ms/update   Mpairs/s\n");
+	for (ndInt32 i = 0; i < threadCountsCount; ++i)
+	{
+		ndFloat64 time = ndFloat64(0.0f);
+		ndInt32 contactCount = 0;
+		for (ndInt32 j = 0; j < frames; ++j)
+		{
+			ndWorld world;
+			world.SetThreadCount(threadCounts[i]);
+			world.SetContactNotify(new ndBroadPhaseOnlyNotify);
+
+			// add the bodies apart from each other and let one update insert them in the 
+			// broad phase, then teleport them into a pile where each box overlaps its neighbors.
+			ndInt32 index = 0;
+			ndBodyDynamic** const bodies = new ndBodyDynamic*[bodiesPerSide * bodiesPerSide * bodiesPerSide];
+			for (ndInt32 x = 0; x < bodiesPerSide; ++x)
+			{
+				for (ndInt32 y = 0; y < bodiesPerSide; ++y)
+				{
+					for (ndInt32 z = 0; z < bodiesPerSide; ++z)
+					{
+						ndVector origin(ndFloat32(x) * ndFloat32(4.0f), ndFloat32(y) * ndFloat32(4.0f), ndFloat32(z) * ndFloat32(4.0f), ndFloat32(1.0f));
+						bodies[index] = AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+						index++;
+					}
+				}
+			}
+			world.Update(ndFloat32(1.0f / 60.0f));
+			world.Sync();
+
+			index = 0;
+			const ndFloat32 spacing = ndFloat32(0.75f);
+			for (ndInt32 x = 0; x < bodiesPerSide; ++x)
+			{
+				for (ndInt32 y = 0; y < bodiesPerSide; ++y)
+				{
+					for (ndInt32 z = 0; z < bodiesPerSide; ++z)
+					{
+						ndMatrix matrix(dGetIdentityMatrix());
+						matrix.m_posit = ndVector(ndFloat32(x) * spacing, ndFloat32(y) * spacing, ndFloat32(z) * spacing, ndFloat32(1.0f));
+						bodies[index]->SetMatrix(matrix);
+						index++;
+					}
+				}
+			}
+			delete[] bodies;
+
+			const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+			world.CollisionUpdate(ndFloat32(1.0f / 60.0f));
+			world.Sync();
+			const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+
+			time += ndFloat64(time1 - time0);
+			contactCount = world.GetContactList().GetCount();
+		}
+		const ndFloat64 msPerUpdate = time * ndFloat64(1.0e-3f) / ndFloat64(frames);
+		printf("%7d %10d %11.3f %10.2f\n", threadCounts[i], contactCount, msPerUpdate, ndFloat64(contactCount) * ndFloat64(1.0e-3f) / msPerUpdate);
+	}
+	return 0;
+}
+
+// a town full of props, boxes resting on the floor next to each other with 
+// sleeping disabled, so that every body is awake but hardly moves.
+// usage: ndTest -benchmark resting [propsPerSide] [threads] [steps]
+static ndInt32 RestingPropsBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 propsPerSide = (argc > 0) ? dMax(atoi(argv[0]), 1) : 48;
+	const ndInt32 threadCount = (argc > 1) ? dClamp(atoi(argv[1]), 1, D_MAX_THREADS_COUNT) : 1;
+	const ndInt32 steps = (argc > 2) ? dMax(atoi(argv[2]), 1) : 200;
+
+	ndWorld world;
+	world.SetSubSteps(2);
+	world.SetThreadCount(threadCount);
+	AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(500.0f), ndFloat32(1.0f), ndFloat32(500.0f));
+
+	const ndFloat32 spacing = ndFloat32(1.05f);
+	const ndFloat32 offset = ndFloat32(propsPerSide) * spacing * ndFloat32(0.5f);
+	for (ndInt32 i = 0; i < propsPerSide; ++i)
+	{
+		for (ndInt32 j = 0; j < propsPerSide; ++j)
+		{
+			ndVector origin(ndFloat32(i) * spacing - offset, ndFloat32(0.5f), ndFloat32(j) * spacing - offset, ndFloat32(1.0f));
+			ndBodyDynamic* const body = AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+			body->SetAutoSleep(false);
+		}
+	}
+
+	printf("resting props: %d bodies, %d threads, %d steps\n", propsPerSide * propsPerSide, threadCount, steps);
+	const ndFloat64 time = StepWorld(world, steps);
+	printf("%10.3f ms/step\n", time);
+	return 0;
+}
+
+// line of sight queries over a field of props of random sizes, 
+// the kind of load ai sensors put on the scene.
+// usage: ndTest -benchmark raycast [rayCount] [propsPerSide] [repeats]
+static ndInt32 RayCastBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 rayCount = (argc > 0) ? dMax(atoi(argv[0]), 1) : 20000;
+	const ndInt32 propsPerSide = (argc > 1) ? dMax(atoi(argv[1]), 1) : 64;
+	const ndInt32 repeats = (argc > 2) ? dMax(atoi(argv[2]), 1) : 10;
+
+	ndWorld world;
+	dSetRandSeed(12345);
+	AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(1000.0f), ndFloat32(1.0f), ndFloat32(1000.0f));
+
+	const ndFloat32 spacing = ndFloat32(4.0f);
+	const ndFloat32 extent = ndFloat32(propsPerSide) * spacing * ndFloat32(0.5f);
+	for (ndInt32 i = 0; i < propsPerSide; ++i)
+	{
+		for (ndInt32 j = 0; j < propsPerSide; ++j)
+		{
+			const ndFloat32 sx = ndFloat32(0.5f) + ndFloat32(2.0f) * dRand();
+			const ndFloat32 sy = ndFloat32(0.5f) + ndFloat32(4.0f) * dRand();
+			const ndFloat32 sz = ndFloat32(0.5f) + ndFloat32(2.0f) * dRand();
+			ndVector origin(ndFloat32(i) * spacing - extent, sy * ndFloat32(0.5f), ndFloat32(j) * spacing - extent, ndFloat32(1.0f));
+			AddBenchmarkBox(world, origin, ndFloat32(0.0f), sx, sy, sz);
+		}
+	}
+	world.Update(ndFloat32(1.0f / 60.0f));
+	world.Sync();
+
+	// ai sensors, each agent casts a fan of rays from its eye point
+	// over a 90 degree view cone towards targets up to 40 meters away.
+	const ndInt32 raysPerAgent = 32;
+	ndArray<ndRayCastQuery> queries;
+	ndArray<ndRayCastResult> results;
+	ndVector eye(ndVector::m_wOne);
+	ndFloat32 heading = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < rayCount; ++i)
+	{
+		if ((i % raysPerAgent) == 0)
+		{
+			const ndFloat32 x = (ndFloat32(2.0f) * dRand() - ndFloat32(1.0f)) * extent;
+			const ndFloat32 z = (ndFloat32(2.0f) * dRand() - ndFloat32(1.0f)) * extent;
+			eye = ndVector(x, ndFloat32(1.0f) + ndFloat32(2.0f) * dRand(), z, ndFloat32(1.0f));
+			heading = ndFloat32(2.0f) * ndPi * dRand();
+		}
+		const ndFloat32 angle = heading + ndPi * ndFloat32(0.5f) * (dRand() - ndFloat32(0.5f));
+		const ndFloat32 dist = ndFloat32(40.0f) * dRand();
+		const ndVector target(eye + ndVector(ndCos(angle) * dist, dRand() - ndFloat32(0.5f), ndSin(angle) * dist, ndFloat32(0.0f)));
+		queries.PushBack(ndRayCastQuery(eye, target));
+	}
+	results.SetCount(rayCount);
+
+	// one ray and one callback at the time, best time of all repeats
+	ndInt32 hits = 0;
+	ndFloat64 checksum = ndFloat64(0.0f);
+	ndUnsigned64 bestTime = ndUnsigned64(-1);
+	for (ndInt32 j = 0; j < repeats; ++j)
+	{
+		hits = 0;
+		checksum = ndFloat64(0.0f);
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < rayCount; ++i)
+		{
+			ndRayCastClosestHitCallback callback;
+			if (world.RayCast(callback, queries[i].m_origin, queries[i].m_dest))
+			{
+				hits++;
+				checksum += callback.m_param;
+			}
+		}
+		bestTime = dMin(bestTime, dGetTimeInMicroseconds() - time0);
+	}
+	printf("ray cast: %d props, %d rays, %d hits, checksum %f\n", propsPerSide * propsPerSide, rayCount, hits, checksum);
+	printf("%10.3f ms per batch, %8.3f us/ray\n", ndFloat64(bestTime) * 1.0e-3, ndFloat64(bestTime) / rayCount);
+
+	// same rays through the batched interface, on every thread of the world
+	const ndInt32 maxThreads = ndThreadPool::GetMaxThreads();
+	for (ndInt32 threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		world.SetThreadCount(threads);
+		bestTime = ndUnsigned64(-1);
+		for (ndInt32 j = 0; j < repeats; ++j)
+		{
+			const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+			world.RayCast(&queries[0], &results[0], rayCount);
+			bestTime = dMin(bestTime, dGetTimeInMicroseconds() - time0);
+		}
+
+		hits = 0;
+		checksum = ndFloat64(0.0f);
+		for (ndInt32 i = 0; i < rayCount; ++i)
+		{
+			if (results[i].m_body)
+			{
+				hits++;
+				checksum += results[i].m_param;
+			}
+		}
+		printf("batched %3d threads: %d hits, checksum %f\n", threads, hits, checksum);
+		printf("%10.3f ms per batch, %8.3f us/ray\n", ndFloat64(bestTime) * 1.0e-3, ndFloat64(bestTime) / rayCount);
+	}
+	return 0;
+}
+
+// shape sweeps over the same prop field, the kind of load character 
+// controllers and projectile probes put on the scene.
+// usage: ndTest -benchmark convexcast [castCount] [propsPerSide] [repeats]
+static ndInt32 ConvexCastBenchmark(ndInt32 argc, const char* const argv[])
+{
+	class ndClosestHitConvexCast: public ndConvexCastNotify
+	{
+		public:
+		ndUnsigned32 OnRayPrecastAction(const ndBody* const, const ndShapeInstance* const)
+		{
+			return 1;
+		}
+	};
+
+	const ndInt32 castCount = (argc > 0) ? dMax(atoi(argv[0]), 1) : 4000;
+	const ndInt32 propsPerSide = (argc > 1) ? dMax(atoi(argv[1]), 1) : 64;
+	const ndInt32 repeats = (argc > 2) ? dMax(atoi(argv[2]), 1) : 5;
+
+	ndWorld world;
+	dSetRandSeed(12345);
+	AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(1000.0f), ndFloat32(1.0f), ndFloat32(1000.0f));
+
+	const ndFloat32 spacing = ndFloat32(4.0f);
+	const ndFloat32 extent = ndFloat32(propsPerSide) * spacing * ndFloat32(0.5f);
+	for (ndInt32 i = 0; i < propsPerSide; ++i)
+	{
+		for (ndInt32 j = 0; j < propsPerSide; ++j)
+		{
+			const ndFloat32 sx = ndFloat32(0.5f) + ndFloat32(2.0f) * dRand();
+			const ndFloat32 sy = ndFloat32(0.5f) + ndFloat32(4.0f) * dRand();
+			const ndFloat32 sz = ndFloat32(0.5f) + ndFloat32(2.0f) * dRand();
+			ndVector origin(ndFloat32(i) * spacing - extent, sy * ndFloat32(0.5f), ndFloat32(j) * spacing - extent, ndFloat32(1.0f));
+			AddBenchmarkBox(world, origin, ndFloat32(0.0f), sx, sy, sz);
+		}
+	}
+	world.Update(ndFloat32(1.0f / 60.0f));
+	world.Sync();
+
+	// spheres and capsules swept up to 10 meters in a random horizontal direction,
+	// starting above the floor so the floor only catches the ones that dip into it.
+	ndShapeInstance sphere(new ndShapeSphere(ndFloat32(0.25f)));
+	ndShapeInstance capsule(new ndShapeCapsule(ndFloat32(0.3f), ndFloat32(0.3f), ndFloat32(1.0f)));
+	ndArray<ndConvexCastQuery> queries;
+	ndArray<ndConvexCastResult> results;
+	for (ndInt32 i = 0; i < castCount; ++i)
+	{
+		ndMatrix origin(dGetIdentityMatrix());
+		origin.m_posit.m_x = (ndFloat32(2.0f) * dRand() - ndFloat32(1.0f)) * extent;
+		origin.m_posit.m_y = ndFloat32(0.6f) + ndFloat32(2.0f) * dRand();
+		origin.m_posit.m_z = (ndFloat32(2.0f) * dRand() - ndFloat32(1.0f)) * extent;
+		const ndFloat32 angle = ndFloat32(2.0f) * ndPi * dRand();
+		const ndFloat32 dist = ndFloat32(10.0f) * dRand();
+		const ndVector dest(origin.m_posit + ndVector(ndCos(angle) * dist, ndFloat32(0.0f), ndSin(angle) * dist, ndFloat32(0.0f)));
+		queries.PushBack(ndConvexCastQuery((i & 1) ? &capsule : &sphere, origin, dest));
+	}
+	results.SetCount(castCount);
+
+	// one sweep and one callback at the time, best time of all repeats
+	ndInt32 hits = 0;
+	ndFloat64 checksum = ndFloat64(0.0f);
+	ndUnsigned64 bestTime = ndUnsigned64(-1);
+	for (ndInt32 j = 0; j < repeats; ++j)
+	{
+		hits = 0;
+		checksum = ndFloat64(0.0f);
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < castCount; ++i)
+		{
+			ndClosestHitConvexCast callback;
+			const ndConvexCastQuery& query = queries[i];
+			world.ConvexCast(callback, *query.m_shape, query.m_origin, query.m_dest);
+			if (callback.m_contacts.GetCount())
+			{
+				hits++;
+				checksum += callback.m_param;
+			}
+		}
+		bestTime = dMin(bestTime, dGetTimeInMicroseconds() - time0);
+	}
+	printf("convex cast: %d props, %d casts, %d hits, checksum %f\n", propsPerSide * propsPerSide, castCount, hits, checksum);
+	printf("%10.3f ms per batch, %8.3f us/cast\n", ndFloat64(bestTime) * 1.0e-3, ndFloat64(bestTime) / castCount);
+
+	// same sweeps through the batched interface, on every thread of the world
+	const ndInt32 maxThreads = ndThreadPool::GetMaxThreads();
+	for (ndInt32 threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		world.SetThreadCount(threads);
+		bestTime = ndUnsigned64(-1);
+		for (ndInt32 j = 0; j < repeats; ++j)
+		{
+			const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+			world.ConvexCast(&queries[0], &results[0], castCount);
+			bestTime = dMin(bestTime, dGetTimeInMicroseconds() - time0);
+		}
+
+		hits = 0;
+		checksum = ndFloat64(0.0f);
+		for (ndInt32 i = 0; i < castCount; ++i)
+		{
+			if (results[i].m_body)
+			{
+				hits++;
+				checksum += results[i].m_param;
+			}
+		}
+		printf("batched %3d threads: %d hits, checksum %f\n", threads, hits, checksum);
+		printf("%10.3f ms per batch, %8.3f us/cast\n", ndFloat64(bestTime) * 1.0e-3, ndFloat64(bestTime) / castCount);
+	}
+	return 0;
+}
+
+// hash of the bits of every body matrix and velocity, any difference 
+// in the simulation, however small, shows as a different hash.
+static ndUnsigned64 CalculateStateHash(const ndWorld& world)
+{
+	ndUnsigned64 hash = 14695981039346656037ULL;
+	const ndBodyList& bodyList = world.GetBodyList();
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndBodyKinematic* const body = node->GetInfo();
+		ndVector state[6];
+		const ndMatrix matrix(body->GetMatrix());
+		state[0] = matrix.m_front;
+		state[1] = matrix.m_up;
+		state[2] = matrix.m_right;
+		state[3] = matrix.m_posit;
+		state[4] = body->GetVelocity();
+		state[5] = body->GetOmega();
+
+		const ndUnsigned8* const bytes = (ndUnsigned8*)&state[0];
+		for (ndInt32 i = 0; i < ndInt32(sizeof(state)); ++i)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+// drops the same pile of boxes with each solver in deterministic mode from 1 to N threads,
+// and fails if any thread count ends in a state different from the single thread run.
+// usage: ndTest -benchmark determinism [maxThreads] [boxesPerSide] [steps]
+static ndInt32 DeterminismTest(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 maxThreads = (argc > 0) ? dClamp(atoi(argv[0]), 1, D_MAX_THREADS_COUNT) : dMax(ndThreadPool::GetMaxThreads(), 8);
+	const ndInt32 boxesPerSide = (argc > 1) ? dMax(atoi(argv[1]), 1) : 8;
+	const ndInt32 steps = (argc > 2) ? dMax(atoi(argv[2]), 1) : 200;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	ndInt32 failures = 0;
+	const ndWorld::ndSolverModes solvers[] = { ndWorld::ndStandardSolver, ndWorld::ndSimdSoaSolver, ndWorld::ndGaussSeidelSolver };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(solvers) / sizeof(solvers[0])); ++i)
+	{
+		ndUnsigned64 baseHash = 0;
+		for (ndInt32 threadCount = 1; threadCount <= maxThreads; ++threadCount)
+		{
+			ndWorld world;
+			world.SetSubSteps(2);
+			world.SetThreadCount(threadCount);
+			world.SelectSolver(solvers[i]);
+			world.SetDeterministic(true);
+
+			// boxes dropped in loose layers so that new pairs show up every step
+			dSetRandSeed(7);
+			AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(200.0f), ndFloat32(1.0f), ndFloat32(200.0f));
+			for (ndInt32 y = 0; y < boxesPerSide; ++y)
+			{
+				for (ndInt32 x = 0; x < boxesPerSide; ++x)
+				{
+					for (ndInt32 z = 0; z < boxesPerSide; ++z)
+					{
+						const ndVector origin(ndFloat32(x) * ndFloat32(1.1f) + ndFloat32(0.1f) * dRand(), ndFloat32(0.5f) + ndFloat32(y) * ndFloat32(1.5f), ndFloat32(z) * ndFloat32(1.1f) + ndFloat32(0.1f) * dRand(), ndFloat32(1.0f));
+						AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+					}
+				}
+			}
+
+			for (ndInt32 j = 0; j < steps; ++j)
+			{
+				world.Update(timestep);
+				world.Sync();
+			}
+
+			const ndUnsigned64 hash = CalculateStateHash(world);
+			if (threadCount == 1)
+			{
+				baseHash = hash;
+			}
+			const bool pass = (hash == baseHash);
+			failures += pass ? 0 : 1;
+			printf("%s solver, %2d threads: %016llx %s\n", world.GetSolverString(), threadCount, (long long unsigned)hash, pass ? "ok" : "FAILED");
+		}
+	}
+	return failures ? -1 : 0;
+}
+
+static ndShapeHeightfield* CreateBenchmarkTerrain(ndInt32 size, ndFloat32 cellSize)
+{
+	ndShapeHeightfield* const heightfield = new ndShapeHeightfield(size, size, ndShapeHeightfield::m_normalDiagonals, cellSize, cellSize);
+	ndArray<ndReal>& elevation = heightfield->GetElevationMap();
+	for (ndInt32 z = 0; z < size; ++z)
+	{
+		for (ndInt32 x = 0; x < size; ++x)
+		{
+			const ndFloat32 hills = ndFloat32(8.0f) * ndSin(ndFloat32(x) * ndFloat32(0.02f)) * ndCos(ndFloat32(z) * ndFloat32(0.03f));
+			const ndFloat32 bumps = ndFloat32(1.0f) * ndSin(ndFloat32(x) * ndFloat32(0.31f) + ndFloat32(z) * ndFloat32(0.17f));
+			elevation[z * size + x] = ndReal(hills + bumps);
+		}
+	}
+	heightfield->UpdateElevationMapAabb();
+	return heightfield;
+}
+
+// serves terrain tiles from an elevation array standing in for the data on disk
+class ndBenchmarkTileLoader: public ndHeightfieldTileLoader
+{
+	public:
+	ndBenchmarkTileLoader(const ndArray<ndReal>& elevation, ndInt32 size)
+		:ndHeightfieldTileLoader()
+		,m_elevation()
+		,m_size(size)
+		,m_loads(0)
+	{
+		m_elevation.SetCount(elevation.GetCount());
+		memcpy(&m_elevation[0], &elevation[0], elevation.GetCount() * sizeof(ndReal));
+	}
+
+	virtual void GetTileBounds(ndInt32 tile_x, ndInt32 tile_z, ndFloat32& minHeight, ndFloat32& maxHeight)
+	{
+		minHeight = ndFloat32(1.0e10f);
+		maxHeight = ndFloat32(-1.0e10f);
+		const ndInt32 x0 = tile_x * D_HEIGHTFIELD_TILE_SIZE;
+		const ndInt32 z0 = tile_z * D_HEIGHTFIELD_TILE_SIZE;
+		for (ndInt32 z = z0; z < dMin(z0 + D_HEIGHTFIELD_TILE_SIZE, m_size); ++z)
+		{
+			for (ndInt32 x = x0; x < dMin(x0 + D_HEIGHTFIELD_TILE_SIZE, m_size); ++x)
+			{
+				minHeight = dMin(minHeight, ndFloat32(m_elevation[z * m_size + x]));
+				maxHeight = dMax(maxHeight, ndFloat32(m_elevation[z * m_size + x]));
+			}
+		}
+	}
+
+	virtual void LoadTile(ndInt32 tile_x, ndInt32 tile_z, ndHeightfieldTile& tile)
+	{
+		const ndInt32 x0 = tile_x * D_HEIGHTFIELD_TILE_SIZE;
+		const ndInt32 z0 = tile_z * D_HEIGHTFIELD_TILE_SIZE;
+		tile.Quantize(&m_elevation[z0 * m_size + x0], nullptr, dMin(D_HEIGHTFIELD_TILE_SIZE, m_size - x0), dMin(D_HEIGHTFIELD_TILE_SIZE, m_size - z0), m_size);
+		m_loads++;
+	}
+
+	ndArray<ndReal> m_elevation;
+	ndInt32 m_size;
+	ndInt32 m_loads;
+};
+
+// digs craters on a private copy of the terrain from the background thread and posts 
+// the edited patch to the world, the way a deformation system runs next to the simulation.
+class ndTerrainDigger: public ndBackgroundTask
+{
+	public:
+	ndTerrainDigger(ndWorld* const world, ndBodyKinematic* const terrain, const ndArray<ndReal>& elevation, ndInt32 size)
+		:ndBackgroundTask()
+		,m_elevation()
+		,m_patch()
+		,m_point(ndVector::m_zero)
+		,m_world(world)
+		,m_terrain(terrain)
+		,m_size(size)
+		,m_craters(0)
+	{
+		m_elevation.SetCount(elevation.GetCount());
+		memcpy(&m_elevation[0], &elevation[0], elevation.GetCount() * sizeof(ndReal));
+	}
+
+	void Dig(const ndVector& point)
+	{
+		m_point = point;
+		m_world->SendBackgroundTask(this);
+	}
+
+	protected:
+	virtual void Execute(ndThreadPool* const)
+	{
+		const ndInt32 radius = 4;
+		const ndInt32 xc = ndInt32(m_point.m_x);
+		const ndInt32 zc = ndInt32(m_point.m_z);
+		const ndInt32 x0 = dClamp(xc - radius, 0, m_size - 1);
+		const ndInt32 z0 = dClamp(zc - radius, 0, m_size - 1);
+		const ndInt32 x1 = dClamp(xc + radius, 0, m_size - 1);
+		const ndInt32 z1 = dClamp(zc + radius, 0, m_size - 1);
+
+		ndInt32 index = 0;
+		m_patch.SetCount((x1 - x0 + 1) * (z1 - z0 + 1));
+		for (ndInt32 z = z0; z <= z1; ++z)
+		{
+			for (ndInt32 x = x0; x <= x1; ++x)
+			{
+				const ndFloat32 dist2 = ndFloat32((x - xc) * (x - xc) + (z - zc) * (z - zc));
+				const ndFloat32 depth = dMax(ndFloat32(radius * radius) - dist2, ndFloat32(0.0f)) * ndFloat32(0.05f);
+				m_elevation[z * m_size + x] -= ndReal(depth);
+				m_patch[index] = m_elevation[z * m_size + x];
+				index++;
+			}
+		}
+		m_world->UpdateElevationRegion(m_terrain, x0, z0, x1, z1, &m_patch[0]);
+		m_craters++;
+	}
+
+	public:
+	ndArray<ndReal> m_elevation;
+	ndArray<ndReal> m_patch;
+	ndVector m_point;
+	ndWorld* m_world;
+	ndBodyKinematic* m_terrain;
+	ndInt32 m_size;
+	ndInt32 m_craters;
+};
+
+// long rays grazing a large terrain and boxes landing on it while it is deformed, 
+// exercises the heightfield ray marcher, the elevation range queries and region updates.
+// the terrain is kept as floats, quantized to 16 bit tiles, or streamed from a tile loader.
+// usage: ndTest -benchmark heightfield [size] [rayCount] [repeats] [float|quantized|streamed]
+static ndInt32 HeightfieldBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 size = (argc > 0) ? dMax(atoi(argv[0]), 16) : 2049;
+	const ndInt32 rayCount = (argc > 1) ? dMax(atoi(argv[1]), 1) : 10000;
+	const ndInt32 repeats = (argc > 2) ? dMax(atoi(argv[2]), 1) : 5;
+	const char* const mode = (argc > 3) ? argv[3] : "float";
+
+	const ndFloat32 cellSize = ndFloat32(1.0f);
+	const ndFloat32 extent = ndFloat32(size - 1) * cellSize;
+
+	ndWorld world;
+	dSetRandSeed(12345);
+	ndShapeHeightfield* const heightfield = CreateBenchmarkTerrain(size, cellSize);
+	ndArray<ndReal> elevation;
+	elevation.SetCount(size * size);
+	memcpy(&elevation[0], &heightfield->GetElevationMap()[0], size * size * sizeof(ndReal));
+
+	ndBenchmarkTileLoader* loader = nullptr;
+	const ndInt32 floatBytes = size * size * ndInt32(sizeof(ndReal) + sizeof(ndInt8));
+	if (!strcmp(mode, "quantized"))
+	{
+		heightfield->QuantizeElevationMap();
+	}
+	else if (!strcmp(mode, "streamed"))
+	{
+		loader = new ndBenchmarkTileLoader(elevation, size);
+		heightfield->SetTileLoader(loader);
+	}
+	ndShapeInstance terrainShape(heightfield);
+	ndBodyDynamic* const terrain = new ndBodyDynamic();
+	terrain->SetNotifyCallback(new ndBenchmarkNotify);
+	terrain->SetMatrix(dGetIdentityMatrix());
+	terrain->SetCollisionShape(terrainShape);
+	world.AddBody(terrain);
+	world.Update(ndFloat32(1.0f / 60.0f));
+	world.Sync();
+
+	ndArray<ndRayCastQuery> queries;
+	for (ndInt32 i = 0; i < rayCount; ++i)
+	{
+		const ndVector p0(extent * dRand(), ndFloat32(10.0f) + ndFloat32(4.0f) * dRand(), extent * dRand(), ndFloat32(1.0f));
+		const ndVector p1(extent * dRand(), ndFloat32(-4.0f) + ndFloat32(8.0f) * dRand(), extent * dRand(), ndFloat32(1.0f));
+		queries.PushBack(ndRayCastQuery(p0, p1));
+	}
+
+	ndInt32 hits = 0;
+	ndFloat64 checksum = ndFloat64(0.0f);
+	ndUnsigned64 bestTime = ndUnsigned64(-1);
+	for (ndInt32 j = 0; j < repeats; ++j)
+	{
+		hits = 0;
+		checksum = ndFloat64(0.0f);
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < rayCount; ++i)
+		{
+			ndRayCastClosestHitCallback callback;
+			if (world.RayCast(callback, queries[i].m_origin, queries[i].m_dest))
+			{
+				hits++;
+				checksum += callback.m_param;
+			}
+		}
+		bestTime = dMin(bestTime, dGetTimeInMicroseconds() - time0);
+	}
+	printf("heightfield: %d x %d cells, %d rays, %d hits, checksum %f\n", size - 1, size - 1, rayCount, hits, checksum);
+	printf("%10.3f ms per batch, %8.3f us/ray\n", ndFloat64(bestTime) * 1.0e-3, ndFloat64(bestTime) / rayCount);
+	if (strcmp(mode, "float"))
+	{
+		const ndInt32 tileBytes = heightfield->GetResidentTilesCount() * D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE * ndInt32(sizeof(ndUnsigned16));
+		printf("%s: %d resident tiles, %d KB of elevations, %d KB as floats\n", mode, heightfield->GetResidentTilesCount(), tileBytes / 1024, floatBytes / 1024);
+	}
+	if (loader)
+	{
+		const ndInt32 evicted = heightfield->EvictTiles(64);
+		printf("streamed: %d tile loads, %d evicted\n", loader->m_loads, evicted);
+	}
+
+	ndFloat64 aabbChecksum = ndFloat64(0.0f);
+	const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < rayCount; ++i)
+	{
+		ndVector box0;
+		ndVector box1;
+		const ndVector q0(queries[i].m_origin.GetMin(queries[i].m_dest) & ndVector::m_triplexMask);
+		const ndVector q1(queries[i].m_origin.GetMax(queries[i].m_dest) & ndVector::m_triplexMask);
+		heightfield->GetLocalAabb(q0, q1, box0, box1);
+		aabbChecksum += box0.m_y + box1.m_y;
+	}
+	const ndUnsigned64 aabbTime = dGetTimeInMicroseconds() - time1;
+	printf("aabb queries: checksum %f\n", aabbChecksum);
+	printf("%10.3f ms per batch, %8.3f us/query\n", ndFloat64(aabbTime) * 1.0e-3, ndFloat64(aabbTime) / rayCount);
+
+	for (ndInt32 i = 0; i < 256; ++i)
+	{
+		const ndVector origin(extent * (ndFloat32(0.25f) + ndFloat32(0.5f) * dRand()), ndFloat32(14.0f), extent * (ndFloat32(0.25f) + ndFloat32(0.5f) * dRand()), ndFloat32(1.0f));
+		AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+	}
+	const ndFloat64 time = StepWorld(world, 200);
+	printf("256 boxes on terrain: %10.3f ms/step, checksum %f\n", time, CalculateChecksum(world));
+
+	// dig under the boxes while the world updates
+	ndTerrainDigger digger(&world, terrain, elevation, size);
+	const ndBodyList& bodyList = world.GetBodyList();
+	ndBodyList::ndNode* target = bodyList.GetFirst();
+	const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < 200; ++i)
+	{
+		world.Update(ndFloat32(1.0f / 60.0f));
+		if (digger.taskState() == ndBackgroundTask::m_taskCompleted)
+		{
+			target = target->GetNext() ? target->GetNext() : bodyList.GetFirst();
+			digger.Dig(target->GetInfo()->GetMatrix().m_posit);
+		}
+		world.Sync();
+	}
+	digger.Sync();
+	const ndUnsigned64 digTime = dGetTimeInMicroseconds() - time2;
+	printf("%d craters: %10.3f ms/step, checksum %f\n", digger.m_craters, ndFloat64(digTime) * 1.0e-3 / 200, CalculateChecksum(world));
+	return 0;
+}
+
+// reads the arrays of a saved mesh into memory, the way meshes were loaded before mapping
+class ndBenchmarkPolygonSoup: public ndAabbPolygonSoup
+{
+	public:
+	ndBenchmarkPolygonSoup(const char* const pathName)
+		:ndAabbPolygonSoup()
+	{
+		Deserialize(pathName);
+	}
+};
+
+static ndBodyKinematic* AddStaticMesh(ndWorld& world, ndShapeStatic_bvh* const mesh)
+{
+	ndShapeInstance shape(mesh);
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBenchmarkNotify);
+	body->SetMatrix(dGetIdentityMatrix());
+	body->SetCollisionShape(shape);
+	world.AddBody(body);
+	return body;
+}
+
+// a rolling terrain of gridSize x gridSize quads, two triangles each
+static void BuildGridMesh(ndPolygonSoupBuilder& meshBuilder, ndInt32 gridSize)
+{
+	meshBuilder.Begin();
+	for (ndInt32 z = 0; z < gridSize; ++z)
+	{
+		for (ndInt32 x = 0; x < gridSize; ++x)
+		{
+			ndVector face[4];
+			const ndInt32 offsets[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+			for (ndInt32 i = 0; i < 4; ++i)
+			{
+				const ndFloat32 px = ndFloat32(x + offsets[i][0]);
+				const ndFloat32 pz = ndFloat32(z + offsets[i][1]);
+				const ndFloat32 py = ndFloat32(4.0f) * ndSin(px * ndFloat32(0.05f)) * ndCos(pz * ndFloat32(0.07f));
+				face[i] = ndVector(px, py, pz, ndFloat32(0.0f));
+			}
+			meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, 1);
+			meshBuilder.AddFace(&face[1].m_x, sizeof(ndVector), 3, 1);
+		}
+	}
+	meshBuilder.End(false);
+}
+
+// saves a large level mesh and loads it once per world, by building the tree again, 
+// by reading a copy of the arrays and by mapping the file, then checks the mapped 
+// mesh gives the same ray hits as the mesh it was saved from.
+// usage: ndTest -benchmark bvhload [gridSize] [worldCount]
+static ndInt32 StaticMeshLoadBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 gridSize = (argc > 0) ? dMax(atoi(argv[0]), 2) : 512;
+	const ndInt32 worldCount = (argc > 1) ? dMax(atoi(argv[1]), 1) : 8;
+	const char* const pathName = "ndTestStaticMesh.bin";
+
+	const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+	ndPolygonSoupBuilder meshBuilder;
+	BuildGridMesh(meshBuilder, gridSize);
+	ndShapeStatic_bvh* const sourceMesh = new ndShapeStatic_bvh(meshBuilder);
+	const ndUnsigned64 buildTime = dGetTimeInMicroseconds() - time0;
+	sourceMesh->Serialize(pathName);
+
+	ndWorld sourceWorld;
+	const ndShapeInfo sourceInfo(AddStaticMesh(sourceWorld, sourceMesh)->GetCollisionShape().GetShapeInfo());
+	sourceWorld.Update(ndFloat32(1.0f / 60.0f));
+	sourceWorld.Sync();
+
+	const ndInt32 vertexBytes = sourceMesh->GetVertexCount() * ndInt32(sizeof(ndTriplex));
+	const ndInt32 nodeBytes = sourceMesh->GetNodesCount() * ndInt32(sizeof(ndAabbPolygonSoup::ndNode));
+	printf("static mesh: %d triangles, %d KB of vertices, %d KB of nodes, build %8.3f ms\n", 2 * gridSize * gridSize, vertexBytes / 1024, nodeBytes / 1024, ndFloat64(buildTime) * 1.0e-3);
+
+	const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		ndBenchmarkPolygonSoup* const copy = new ndBenchmarkPolygonSoup(pathName);
+		delete copy;
+	}
+	const ndUnsigned64 copyTime = dGetTimeInMicroseconds() - time1;
+
+	ndArray<ndWorld*> worlds;
+	ndArray<ndShapeStatic_bvh*> meshes;
+	ndArray<ndBodyKinematic*> bodies;
+	const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		meshes.PushBack(new ndShapeStatic_bvh(pathName));
+	}
+	const ndUnsigned64 mapTime = dGetTimeInMicroseconds() - time2;
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		worlds.PushBack(new ndWorld());
+		bodies.PushBack(AddStaticMesh(*worlds[i], meshes[i]));
+	}
+	printf("%d loads: %8.3f ms reading copies, %8.3f ms mapping the file\n", worldCount, ndFloat64(copyTime) * 1.0e-3, ndFloat64(mapTime) * 1.0e-3);
+
+	ndInt32 failures = 0;
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		failures += (meshes[i]->GetLocalVertexPool() == meshes[0]->GetLocalVertexPool()) ? 0 : 1;
+		failures += (bodies[i]->GetCollisionShape().GetShapeInfo().m_bvh.m_indexCount == sourceInfo.m_bvh.m_indexCount) ? 0 : 1;
+	}
+
+	ndWorld* const world = worlds[0];
+	world->Update(ndFloat32(1.0f / 60.0f));
+	world->Sync();
+	dSetRandSeed(12345);
+	for (ndInt32 i = 0; i < 1000; ++i)
+	{
+		const ndFloat32 extent = ndFloat32(gridSize);
+		const ndVector p0(extent * dRand(), ndFloat32(10.0f), extent * dRand(), ndFloat32(1.0f));
+		const ndVector p1(extent * dRand(), ndFloat32(-10.0f), extent * dRand(), ndFloat32(1.0f));
+		ndRayCastClosestHitCallback sourceHit;
+		ndRayCastClosestHitCallback mappedHit;
+		const bool hit0 = sourceWorld.RayCast(sourceHit, p0, p1);
+		const bool hit1 = world->RayCast(mappedHit, p0, p1);
+		failures += ((hit0 == hit1) && (sourceHit.m_param == mappedHit.m_param)) ? 0 : 1;
+	}
+	printf("shared views and ray hits: %s\n", failures ? "FAILED" : "ok");
+
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		delete worlds[i];
+	}
+	remove(pathName);
+	return failures ? -1 : 0;
+}
+
+// builds a large level mesh serially and on a growing thread pool, checks every 
+// tree is the same as the serial one and measures ray and box query cost on it.
+// usage: ndTest -benchmark bvhbuild [gridSize] [maxThreads] [queryCount]
+static ndInt32 StaticMeshBuildBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 gridSize = (argc > 0) ? dMax(atoi(argv[0]), 2) : 512;
+	const ndInt32 maxThreads = (argc > 1) ? dMax(atoi(argv[1]), 1) : ndThreadPool::GetMaxThreads();
+	const ndInt32 queryCount = (argc > 2) ? dMax(atoi(argv[2]), 1) : 20000;
+
+	ndPolygonSoupBuilder meshBuilder;
+	BuildGridMesh(meshBuilder, gridSize);
+
+	const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+	ndShapeStatic_bvh* const serialMesh = new ndShapeStatic_bvh(meshBuilder);
+	const ndUnsigned64 serialTime = dGetTimeInMicroseconds() - time0;
+	const ndInt32 nodeCount = serialMesh->GetNodesCount();
+	printf("static mesh: %d triangles, %d nodes\n", 2 * gridSize * gridSize, nodeCount);
+	printf("serial build: %10.3f ms\n", ndFloat64(serialTime) * 1.0e-3);
+
+	// an idle world lends its worker threads to the builder
+	ndInt32 failures = 0;
+	ndWorld builderWorld;
+	for (ndInt32 threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		builderWorld.SetThreadCount(threads);
+		const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+		ndShapeStatic_bvh* const mesh = new ndShapeStatic_bvh(meshBuilder, builderWorld.GetScene());
+		const ndUnsigned64 buildTime = dGetTimeInMicroseconds() - time1;
+
+		const bool same = (mesh->GetNodesCount() == nodeCount) && 
+			!memcmp(mesh->GetRootNode(), serialMesh->GetRootNode(), nodeCount * sizeof(ndAabbPolygonSoup::ndNode));
+		failures += same ? 0 : 1;
+		printf("%3d threads build: %10.3f ms, tree %s\n", threads, ndFloat64(buildTime) * 1.0e-3, same ? "same" : "DIFFERENT");
+		delete mesh;
+	}
+
+	ndWorld world;
+	AddStaticMesh(world, serialMesh);
+	world.Update(ndFloat32(1.0f / 60.0f));
+	world.Sync();
+
+	dSetRandSeed(12345);
+	ndInt32 hits = 0;
+	ndFloat64 checksum = ndFloat64(0.0f);
+	const ndFloat32 extent = ndFloat32(gridSize);
+	const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < queryCount; ++i)
+	{
+		const ndVector p0(extent * dRand(), ndFloat32(10.0f), extent * dRand(), ndFloat32(1.0f));
+		const ndVector p1(p0 + ndVector(ndFloat32(16.0f) * (dRand() - ndFloat32(0.5f)), ndFloat32(-20.0f), ndFloat32(16.0f) * (dRand() - ndFloat32(0.5f)), ndFloat32(0.0f)));
+		ndRayCastClosestHitCallback callback;
+		if (world.RayCast(callback, p0, p1))
+		{
+			hits++;
+			checksum += callback.m_param;
+		}
+	}
+	const ndUnsigned64 rayTime = dGetTimeInMicroseconds() - time2;
+	printf("%d rays: %d hits, checksum %f, %8.3f us/ray\n", queryCount, hits, checksum, ndFloat64(rayTime) / queryCount);
+
+	ndShapeInstance box(new ndShapeBox(ndFloat32(2.0f), ndFloat32(2.0f), ndFloat32(2.0f)));
+	ndInt32 contacts = 0;
+	const ndUnsigned64 time3 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < queryCount; ++i)
+	{
+		ndMatrix matrix(dGetIdentityMatrix());
+		matrix.m_posit = ndVector(extent * dRand(), ndFloat32(6.0f), extent * dRand(), ndFloat32(1.0f));
+		const ndVector target(matrix.m_posit - ndVector(ndFloat32(0.0f), ndFloat32(12.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+		ndConvexCastNotify callback;
+		world.ConvexCast(callback, box, matrix, target);
+		contacts += callback.m_contacts.GetCount() ? 1 : 0;
+	}
+	const ndUnsigned64 castTime = dGetTimeInMicroseconds() - time3;
+	printf("%d box casts: %d hits, %8.3f us/cast\n", queryCount, contacts, ndFloat64(castTime) / queryCount);
+	printf("parallel trees: %s\n", failures ? "FAILED" : "ok");
+	return failures ? -1 : 0;
+}
+
+// the same level mesh with binary nodes and with the wide quantized nodes, ray casts, 
+// box casts and props resting on the mesh. ray hits must be the same in both layouts.
+// usage: ndTest -benchmark bvhwide [gridSize] [propsPerSide] [steps]
+static ndInt32 StaticMeshWideNodesBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 gridSize = (argc > 0) ? dMax(atoi(argv[0]), 2) : 256;
+	const ndInt32 propsPerSide = (argc > 1) ? dMax(atoi(argv[1]), 1) : 16;
+	const ndInt32 steps = (argc > 2) ? dMax(atoi(argv[2]), 1) : 200;
+	const ndInt32 queryCount = 20000;
+
+	ndPolygonSoupBuilder meshBuilder;
+	BuildGridMesh(meshBuilder, gridSize);
+
+	ndInt32 rayHits[2];
+	ndFloat64 rayChecksum[2];
+	const char* const layoutNames[] = { "binary", "wide" };
+	for (ndInt32 layout = 0; layout < 2; ++layout)
+	{
+		ndShapeStatic_bvh* const mesh = new ndShapeStatic_bvh(meshBuilder);
+		mesh->SetWideNodes(layout ? true : false);
+
+		ndWorld world;
+		AddStaticMesh(world, mesh);
+		world.Update(ndFloat32(1.0f / 60.0f));
+		world.Sync();
+
+		dSetRandSeed(12345);
+		rayHits[layout] = 0;
+		rayChecksum[layout] = ndFloat64(0.0f);
+		const ndFloat32 extent = ndFloat32(gridSize);
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < queryCount; ++i)
+		{
+			const ndVector p0(extent * dRand(), ndFloat32(10.0f), extent * dRand(), ndFloat32(1.0f));
+			const ndVector p1(extent * dRand(), ndFloat32(-10.0f), extent * dRand(), ndFloat32(1.0f));
+			ndRayCastClosestHitCallback callback;
+			if (world.RayCast(callback, p0, p1))
+			{
+				rayHits[layout]++;
+				rayChecksum[layout] += callback.m_param;
+			}
+		}
+		const ndUnsigned64 rayTime = dGetTimeInMicroseconds() - time0;
+
+		ndInt32 castHits = 0;
+		ndShapeInstance box(new ndShapeBox(ndFloat32(2.0f), ndFloat32(2.0f), ndFloat32(2.0f)));
+		const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < queryCount; ++i)
+		{
+			ndMatrix matrix(dGetIdentityMatrix());
+			matrix.m_posit = ndVector(extent * dRand(), ndFloat32(6.0f), extent * dRand(), ndFloat32(1.0f));
+			const ndVector target(matrix.m_posit - ndVector(ndFloat32(0.0f), ndFloat32(12.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+			ndConvexCastNotify callback;
+			world.ConvexCast(callback, box, matrix, target);
+			castHits += callback.m_contacts.GetCount() ? 1 : 0;
+		}
+		const ndUnsigned64 castTime = dGetTimeInMicroseconds() - time1;
+
+		const ndFloat32 spacing = extent / ndFloat32(propsPerSide);
+		for (ndInt32 i = 0; i < propsPerSide; ++i)
+		{
+			for (ndInt32 j = 0; j < propsPerSide; ++j)
+			{
+				const ndVector origin((ndFloat32(i) + ndFloat32(0.5f)) * spacing, ndFloat32(6.0f), (ndFloat32(j) + ndFloat32(0.5f)) * spacing, ndFloat32(1.0f));
+				AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+			}
+		}
+		const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < steps; ++i)
+		{
+			world.Update(ndFloat32(1.0f / 60.0f));
+			world.Sync();
+		}
+		const ndUnsigned64 stepTime = dGetTimeInMicroseconds() - time2;
+
+		printf("%s nodes:\n", layoutNames[layout]);
+		printf("  %d rays: %d hits, checksum %f, %8.3f us/ray\n", queryCount, rayHits[layout], rayChecksum[layout], ndFloat64(rayTime) / queryCount);
+		printf("  %d box casts: %d hits, %8.3f us/cast\n", queryCount, castHits, ndFloat64(castTime) / queryCount);
+		printf("  %d props: %8.3f ms/step, checksum %f\n", propsPerSide * propsPerSide, ndFloat64(stepTime) * 1.0e-3 / steps, CalculateChecksum(world));
+	}
+
+	const bool same = (rayHits[0] == rayHits[1]) && (rayChecksum[0] == rayChecksum[1]);
+	printf("ray hits: %s\n", same ? "same" : "DIFFERENT");
+	return same ? 0 : -1;
+}
+
+static ndInt32 GetFileSize(const char* const pathName)
+{
+	FILE* const file = fopen(pathName, "rb");
+	if (!file)
+	{
+		return 0;
+	}
+	fseek(file, 0, SEEK_END);
+	const ndInt32 size = ndInt32(ftell(file));
+	fclose(file);
+	return size;
+}
+
+// adds the loaded bodies to a world in the order of their hash, which is the order of the saved world.
+static void AddLoadedBodies(ndWorld& world, ndLoadSave& loadScene)
+{
+	ndBodyLoaderCache::Iterator it(loadScene.m_bodyMap);
+	for (it.Begin(); it; it++)
+	{
+		world.AddBody((ndBody*)it.GetNode()->GetInfo());
+	}
+}
+
+// saves and loads a world of box stacks, a level mesh and a terrain as xml and as a binary snapshot, 
+// checks the snapshot restores the exact state, and measures the step time while a snapshot is written every few steps.
+// usage: ndTest -benchmark snapshot [stacksPerSide] [steps] [snapshotInterval]
+static ndInt32 SnapshotBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 stacksPerSide = (argc > 0) ? dMax(atoi(argv[0]), 1) : 32;
+	const ndInt32 steps = (argc > 1) ? dMax(atoi(argv[1]), 1) : 120;
+	const ndInt32 interval = (argc > 2) ? dMax(atoi(argv[2]), 1) : 30;
+	const char* const xmlPathName = "ndTestSnapshot.nd";
+	const char* const snapshotPathName = "ndTestSnapshot.snap";
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	ndWorld world;
+	world.SetSubSteps(2);
+	BuildBoxStacks(world, stacksPerSide, 10);
+
+	// a level mesh and a terrain away from the stacks, only the first capture copies their assets
+	ndPolygonSoupBuilder meshBuilder;
+	BuildGridMesh(meshBuilder, 256);
+	ndMatrix meshMatrix(dGetIdentityMatrix());
+	meshMatrix.m_posit = ndVector(ndFloat32(1000.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(1.0f));
+	AddStaticMesh(world, new ndShapeStatic_bvh(meshBuilder))->SetMatrix(meshMatrix);
+
+	ndShapeInstance terrainShape(CreateBenchmarkTerrain(512, ndFloat32(1.0f)));
+	ndBodyDynamic* const terrain = new ndBodyDynamic();
+	meshMatrix.m_posit = ndVector(ndFloat32(-1000.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(1.0f));
+	terrain->SetNotifyCallback(new ndBenchmarkNotify);
+	terrain->SetMatrix(meshMatrix);
+	terrain->SetCollisionShape(terrainShape);
+	world.AddBody(terrain);
+
+	StepWorld(world, 30);
+	const ndUnsigned64 sourceHash = CalculateStateHash(world);
+	printf("%d bodies\n", world.GetBodyList().GetCount());
+
+	ndWordSettings settings;
+	ndLoadSave xmlSave;
+	const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+	xmlSave.SaveScene(xmlPathName, &world, &settings);
+	const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+	ndLoadSave xmlLoad;
+	xmlLoad.LoadScene(xmlPathName);
+	const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+	printf("xml:      %8d KB, save %8.3f ms, load %8.3f ms\n", GetFileSize(xmlPathName) / 1024, ndFloat64(time1 - time0) * 1.0e-3, ndFloat64(time2 - time1) * 1.0e-3);
+
+	ndWorldSnapshot snapshot;
+	const ndUnsigned64 time3 = dGetTimeInMicroseconds();
+	snapshot.Capture(snapshotPathName, &world, &settings);
+	const ndUnsigned64 time4 = dGetTimeInMicroseconds();
+	snapshot.Write();
+	const ndUnsigned64 time5 = dGetTimeInMicroseconds();
+	ndLoadSave snapshotLoad;
+	const bool loaded = snapshotLoad.LoadSnapshot(snapshotPathName);
+	const ndUnsigned64 time6 = dGetTimeInMicroseconds();
+	printf("snapshot: %8d KB, capture %8.3f ms, write %8.3f ms, load %8.3f ms\n", GetFileSize(snapshotPathName) / 1024, 
+		ndFloat64(time4 - time3) * 1.0e-3, ndFloat64(time5 - time4) * 1.0e-3, ndFloat64(time6 - time5) * 1.0e-3);
+
+	// the assets are already on disk, the next capture only references them
+	snapshot.Capture(snapshotPathName, &world, &settings);
+	const ndUnsigned64 time7 = dGetTimeInMicroseconds();
+	snapshot.Write();
+	const ndUnsigned64 time8 = dGetTimeInMicroseconds();
+	printf("again:    %8d KB, capture %8.3f ms, write %8.3f ms\n", GetFileSize(snapshotPathName) / 1024, ndFloat64(time7 - time6) * 1.0e-3, ndFloat64(time8 - time7) * 1.0e-3);
+
+	ndWorld xmlWorld;
+	AddLoadedBodies(xmlWorld, xmlLoad);
+	ndWorld snapshotWorld;
+	AddLoadedBodies(snapshotWorld, snapshotLoad);
+	const bool xmlSame = (CalculateStateHash(xmlWorld) == sourceHash);
+	const bool snapshotSame = loaded && (CalculateStateHash(snapshotWorld) == sourceHash);
+	printf("restored state: xml %s, snapshot %s\n", xmlSame ? "exact" : "rounded", snapshotSame ? "exact" : "DIFFERENT");
+
+	ndFloat64 worstStep[2];
+	ndFloat64 totalStep[2];
+	for (ndInt32 pass = 0; pass < 2; ++pass)
+	{
+		worstStep[pass] = 0.0f;
+		totalStep[pass] = 0.0f;
+		for (ndInt32 i = 0; i < steps; ++i)
+		{
+			const ndUnsigned64 stepTime0 = dGetTimeInMicroseconds();
+			world.Update(timestep);
+			world.Sync();
+			if (pass && ((i % interval) == 0))
+			{
+				snapshot.Capture(snapshotPathName, &world, &settings);
+				snapshot.WriteAsync(&world);
+			}
+			const ndFloat64 stepTime = ndFloat64(dGetTimeInMicroseconds() - stepTime0) * 1.0e-3;
+			worstStep[pass] = dMax(worstStep[pass], stepTime);
+			totalStep[pass] += stepTime;
+		}
+		snapshot.Sync();
+	}
+	printf("step time: %8.3f ms average, %8.3f ms worst\n", totalStep[0] / steps, worstStep[0]);
+	printf("snapshot every %d steps: %8.3f ms average, %8.3f ms worst, last write %s\n", interval, totalStep[1] / steps, worstStep[1], snapshot.GetWriteStatus() ? "ok" : "FAILED");
+
+	remove(xmlPathName);
+	remove(snapshotPathName);
+	for (ndInt32 i = 0; i < 2; ++i)
+	{
+		char assetName[256];
+		sprintf(assetName, "ndTestSnapshot_asset_%d.bin", i);
+		remove(assetName);
+	}
+	return (snapshotSame && snapshot.GetWriteStatus()) ? 0 : -1;
+}
+
+// saves a checkpoint of a pile of moving boxes, simulates a few frames, rolls back and simulates 
+// them again, which must end in the same state, and measures the cost of saving and restoring.
+// usage: ndTest -benchmark rollback [stacksPerSide ...]
+static ndInt32 RollbackBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 defaultSizes[] = { 10, 32 };
+	const ndInt32 sizeCount = argc ? argc : ndInt32(sizeof(defaultSizes) / sizeof(defaultSizes[0]));
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+	const ndInt32 rollbackFrames = 8;
+	const ndInt32 repeats = 32;
+
+	ndInt32 failures = 0;
+	for (ndInt32 i = 0; i < sizeCount; ++i)
+	{
+		const ndInt32 stacksPerSide = argc ? dMax(atoi(argv[i]), 1) : defaultSizes[i];
+		ndWorld world;
+		world.SetSubSteps(2);
+		world.SetDeterministic(true);
+		BuildBoxStacks(world, stacksPerSide, 10);
+
+		// knock the stacks over so that contacts are created and destroyed during the rollback window
+		dSetRandSeed(3);
+		const ndBodyList& bodyList = world.GetBodyList();
+		for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+		{
+			ndBodyKinematic* const body = node->GetInfo();
+			if (body->GetInvMass() > ndFloat32(0.0f))
+			{
+				body->SetVelocity(ndVector(ndFloat32(4.0f) * dGaussianRandom(ndFloat32(1.0f)), ndFloat32(0.0f), ndFloat32(4.0f) * dGaussianRandom(ndFloat32(1.0f)), ndFloat32(0.0f)));
+			}
+		}
+		for (ndInt32 j = 0; j < 30; ++j)
+		{
+			world.Update(timestep);
+			world.Sync();
+		}
+
+		ndWorldCheckpoint checkpoint;
+		world.SaveCheckpoint(checkpoint);
+		for (ndInt32 j = 0; j < rollbackFrames; ++j)
+		{
+			world.Update(timestep);
+			world.Sync();
+		}
+		const ndUnsigned64 hash0 = CalculateStateHash(world);
+		const bool restored = world.RestoreCheckpoint(checkpoint);
+		for (ndInt32 j = 0; j < rollbackFrames; ++j)
+		{
+			world.Update(timestep);
+			world.Sync();
+		}
+		const ndUnsigned64 hash1 = CalculateStateHash(world);
+		const bool pass = restored && (hash0 == hash1);
+		failures += pass ? 0 : 1;
+
+		ndUnsigned64 saveTime = 0;
+		ndUnsigned64 restoreTime = 0;
+		for (ndInt32 j = 0; j < repeats; ++j)
+		{
+			const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+			world.SaveCheckpoint(checkpoint);
+			const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+			world.Update(timestep);
+			world.Sync();
+			const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+			world.RestoreCheckpoint(checkpoint);
+			const ndUnsigned64 time3 = dGetTimeInMicroseconds();
+			saveTime += time1 - time0;
+			restoreTime += time3 - time2;
+		}
+
+		printf("%6d bodies %6d contacts: %6d KB checkpoint, save %8.3f ms, restore %8.3f ms, resimulated %d frames: %s\n",
+			bodyList.GetCount(), checkpoint.GetContactCount(), checkpoint.GetSizeInBytes() / 1024,
+			ndFloat64(saveTime) * 1.0e-3 / repeats, ndFloat64(restoreTime) * 1.0e-3 / repeats, rollbackFrames, pass ? "same state" : "DIFFERENT");
+	}
+	return failures ? -1 : 0;
+}
+
+// generates the iso surface of a block of jittered fluid particles serially and on a growing 
+// thread pool, for a few particle counts, and checks every mesh is the same as the serial one.
+// usage: ndTest -benchmark isosurface [maxThreads] [particlesPerSide ...]
+static ndInt32 IsoSurfaceBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 defaultSizes[] = { 16, 32, 48, 64 };
+	const ndInt32 maxThreads = (argc > 0) ? dMax(atoi(argv[0]), 1) : ndThreadPool::GetMaxThreads();
+	const ndInt32 sizeCount = (argc > 1) ? argc - 1 : ndInt32(sizeof(defaultSizes) / sizeof(defaultSizes[0]));
+	const ndFloat32 diameter = ndFloat32(0.125f);
+	const ndFloat32 gridSize = diameter * ndFloat32(1.5f);
+	const ndInt32 repeats = 4;
+
+	// an idle world lends its worker threads to the mesher
+	ndWorld poolWorld;
+	ndInt32 failures = 0;
+	for (ndInt32 i = 0; i < sizeCount; ++i)
+	{
+		const ndInt32 particlesPerSide = (argc > 1) ? dMax(atoi(argv[i + 1]), 2) : defaultSizes[i];
+		dSetRandSeed(7);
+		ndArray<ndVector> particles;
+		particles.SetCount(particlesPerSide * particlesPerSide * particlesPerSide);
+		ndInt32 particleCount = 0;
+		for (ndInt32 y = 0; y < particlesPerSide; ++y)
+		{
+			for (ndInt32 z = 0; z < particlesPerSide; ++z)
+			{
+				for (ndInt32 x = 0; x < particlesPerSide; ++x)
+				{
+					const ndVector jitter(dGaussianRandom(ndFloat32(0.3f)), dGaussianRandom(ndFloat32(0.3f)), dGaussianRandom(ndFloat32(0.3f)), ndFloat32(0.0f));
+					particles[particleCount] = (ndVector(ndFloat32(x), ndFloat32(y), ndFloat32(z), ndFloat32(0.0f)) + jitter).Scale(diameter) & ndVector::m_triplexMask;
+					particleCount++;
+				}
+			}
+		}
+
+		ndIsoSurface serialSurface;
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 j = 0; j < repeats; ++j)
+		{
+			serialSurface.GenerateMesh(particles, gridSize);
+		}
+		const ndUnsigned64 serialTime = dGetTimeInMicroseconds() - time0;
+		const ndArray<ndVector>& serialPoints = serialSurface.GetPoints();
+		printf("%7d particles: %8d triangles, serial %8.3f ms\n", particles.GetCount(), serialPoints.GetCount() / 3, ndFloat64(serialTime) * 1.0e-3 / repeats);
+
+		for (ndInt32 threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			poolWorld.SetThreadCount(threads);
+			ndIsoSurface surface;
+			const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+			for (ndInt32 j = 0; j < repeats; ++j)
+			{
+				surface.GenerateMesh(particles, gridSize, nullptr, poolWorld.GetScene());
+			}
+			const ndUnsigned64 parallelTime = dGetTimeInMicroseconds() - time1;
+
+			const ndArray<ndVector>& points = surface.GetPoints();
+			const bool same = (points.GetCount() == serialPoints.GetCount()) && 
+				(!points.GetCount() || !memcmp(&points[0], &serialPoints[0], points.GetCount() * sizeof(ndVector)));
+			failures += same ? 0 : 1;
+			printf("%26s %3d threads %8.3f ms, mesh %s\n", "", threads, ndFloat64(parallelTime) * 1.0e-3 / repeats, same ? "same" : "DIFFERENT");
+		}
+	}
+	return failures ? -1 : 0;
+}
+
+static void BuildSphFluidBlock(ndBodySphFluid& fluid, ndInt32 particlesPerSide, ndFloat32 diameter, ndFloat32 spacing)
+{
+	fluid.SetParticleRadius(diameter * ndFloat32(0.5f));
+	fluid.SetGravity(ndVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+	ndArray<ndVector>& posit = fluid.GetPositions();
+	ndArray<ndVector>& veloc = fluid.GetVelocity();
+	posit.SetCount(particlesPerSide * particlesPerSide * particlesPerSide);
+	veloc.SetCount(particlesPerSide * particlesPerSide * particlesPerSide);
+	ndInt32 particleCount = 0;
+	for (ndInt32 y = 0; y < particlesPerSide; ++y)
+	{
+		for (ndInt32 z = 0; z < particlesPerSide; ++z)
+		{
+			for (ndInt32 x = 0; x < particlesPerSide; ++x)
+			{
+				posit[particleCount] = ndVector(x * spacing, ndFloat32(1.5f) + y * spacing, z * spacing, ndFloat32(1.0f));
+				veloc[particleCount] = ndVector::m_zero;
+				particleCount++;
+			}
+		}
+	}
+}
+
+// every few steps the state of the fluid that reuses its neighbor list is copied to a fluid 
+// without skin, which builds an exact list, and both take one step from the same state.
+// the fluids sort their particles differently, so each velocity component is compared in sorted order.
+static ndFloat32 CompareSphNeighborSkin(ndScene* const pool, ndInt32 particlesPerSide, ndFloat32 diameter, ndFloat32 spacing, ndFloat32 skin, ndInt32 steps)
+{
+	class ndCompareFloat
+	{
+		public:
+		ndInt32 Compare(const ndFloat32 a, const ndFloat32 b, void* const) const
+		{
+			return (a < b) ? -1 : ((a > b) ? 1 : 0);
+		}
+	};
+
+	ndBodySphFluid fluid;
+	ndBodySphFluid exactFluid;
+	BuildSphFluidBlock(fluid, particlesPerSide, diameter, spacing);
+	BuildSphFluidBlock(exactFluid, particlesPerSide, diameter, spacing);
+	fluid.SetNeighborSkin(skin);
+	exactFluid.SetNeighborSkin(ndFloat32(0.0f));
+
+	const ndInt32 count = fluid.GetPositions().GetCount();
+	ndArray<ndFloat32> coordinate0(count);
+	ndArray<ndFloat32> coordinate1(count);
+	coordinate0.SetCount(count);
+	coordinate1.SetCount(count);
+
+	ndFloat32 maxError = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < steps; ++i)
+	{
+		const bool compare = ((i % 8) == 0);
+		if (compare)
+		{
+			for (ndInt32 j = 0; j < count; ++j)
+			{
+				exactFluid.GetPositions()[j] = fluid.GetPositions()[j];
+				exactFluid.GetVelocity()[j] = fluid.GetVelocity()[j];
+			}
+		}
+
+		pool->Begin();
+		fluid.Execute(pool);
+		pool->End();
+
+		if (compare)
+		{
+			pool->Begin();
+			exactFluid.Execute(pool);
+			pool->End();
+
+			const ndArray<ndVector>& veloc0 = fluid.GetVelocity();
+			const ndArray<ndVector>& veloc1 = exactFluid.GetVelocity();
+			for (ndInt32 k = 0; k < 3; ++k)
+			{
+				for (ndInt32 j = 0; j < count; ++j)
+				{
+					coordinate0[j] = veloc0[j][k];
+					coordinate1[j] = veloc1[j][k];
+				}
+				ndSort<ndFloat32, ndCompareFloat>(&coordinate0[0], count);
+				ndSort<ndFloat32, ndCompareFloat>(&coordinate1[0], count);
+				for (ndInt32 j = 0; j < count; ++j)
+				{
+					maxError = dMax(maxError, dAbs(coordinate0[j] - coordinate1[j]));
+				}
+			}
+		}
+	}
+	return maxError;
+}
+
+// drops a block of fluid particles on the floor and measures the cost of a fluid step with and without 
+// a neighbor skin on a growing thread pool, the fluid runs on the pool of an idle world as it does in the background.
+// then checks that reusing the neighbor list gives the same steps as building it every step.
+// usage: ndTest -benchmark sph [steps] [particlesPerSide ...]
+static ndInt32 SphFluidBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 defaultSizes[] = { 16, 24, 32, 40 };
+	const ndInt32 steps = (argc > 0) ? dMax(atoi(argv[0]), 1) : 200;
+	const ndInt32 sizeCount = (argc > 1) ? argc - 1 : ndInt32(sizeof(defaultSizes) / sizeof(defaultSizes[0]));
+	const ndFloat32 diameter = ndFloat32(0.125f);
+	const ndFloat32 tolerance = ndFloat32(1.0e-4f);
+	const ndFloat32 skin = ndFloat32(0.15f);
+
+	ndInt32 failures = 0;
+	ndWorld poolWorld;
+	ndScene* const pool = poolWorld.GetScene();
+	for (ndInt32 i = 0; i < sizeCount; ++i)
+	{
+		const ndInt32 particlesPerSide = (argc > 1) ? dMax(atoi(argv[i + 1]), 2) : defaultSizes[i];
+		for (ndInt32 threads = 1; threads <= ndThreadPool::GetMaxThreads(); threads *= 2)
+		{
+			poolWorld.SetThreadCount(threads);
+			for (ndInt32 k = 0; k < 2; ++k)
+			{
+				ndBodySphFluid fluid;
+				BuildSphFluidBlock(fluid, particlesPerSide, diameter, diameter);
+				fluid.SetNeighborSkin(k ? skin : ndFloat32(0.0f));
+				ndArray<ndVector>& posit = fluid.GetPositions();
+
+				const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+				for (ndInt32 j = 0; j < steps; ++j)
+				{
+					pool->Begin();
+					fluid.Execute(pool);
+					pool->End();
+				}
+				const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+
+				ndFloat32 height = ndFloat32(0.0f);
+				for (ndInt32 j = 0; j < posit.GetCount(); ++j)
+				{
+					height += posit[j].m_y;
+				}
+				printf("%7d particles %3d threads skin %.2f: %8.3f ms/step, mean height %.4f\n", 
+					posit.GetCount(), threads, fluid.GetNeighborSkin(), ndFloat64(time1 - time0) * 1.0e-3 / steps, height / posit.GetCount());
+			}
+		}
+
+		const ndFloat32 error = CompareSphNeighborSkin(pool, particlesPerSide, diameter, diameter, skin, steps);
+		failures += (error < tolerance) ? 0 : 1;
+		printf("%7d particles skin against exact list: max velocity deviation %g, %s\n", 
+			particlesPerSide * particlesPerSide * particlesPerSide, error, (error < tolerance) ? "same" : "DIFFERENT");
+	}
+
+	// a packed block has more particles inside the skin than fit in a list, it is kept 
+	// small so that the exact lists do not fill up when the block lands on the floor.
+	const ndInt32 packedPerSide = 16;
+	const ndFloat32 packedError = CompareSphNeighborSkin(pool, packedPerSide, diameter, diameter * ndFloat32(0.7f), skin, steps);
+	failures += (packedError < tolerance) ? 0 : 1;
+	printf("%7d packed particles skin against exact list: max velocity deviation %g, %s\n", 
+		packedPerSide * packedPerSide * packedPerSide, packedError, (packedError < tolerance) ? "same" : "DIFFERENT");
+	return failures ? -1 : 0;
+}
+
+// every thread of a growing pool creates and destroys batches of list nodes and of contact 
+// sized objects through the free list allocator, the way contacts and the body lists do. 
+// usage: ndTest -benchmark alloc [maxThreads] [blocksPerBatch] [batches]
+static ndInt32 AllocatorBenchmark(ndInt32 argc, const char* const argv[])
+{
+	class ndContactSizedObject: public ndContainersFreeListAlloc<ndContactSizedObject>
+	{
+		public:
+		char m_data[160];
+	};
+
+	const ndInt32 maxThreads = (argc > 0) ? dMax(atoi(argv[0]), 1) : ndThreadPool::GetMaxThreads();
+	const ndInt32 blocksPerBatch = (argc > 1) ? dMax(atoi(argv[1]), 1) : 256;
+	const ndInt32 batches = (argc > 2) ? dMax(atoi(argv[2]), 1) : 4000;
+
+	ndWorld poolWorld;
+	ndScene* const pool = poolWorld.GetScene();
+	for (ndInt32 threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		poolWorld.SetThreadCount(threads);
+		auto AllocateBlocks = ndMakeObject::ndFunction([blocksPerBatch, batches](ndInt32, ndInt32)
+		{
+			ndList<ndInt32, ndContainersFreeListAlloc<ndInt32>> list;
+			ndArray<ndContactSizedObject*> objects(blocksPerBatch);
+			objects.SetCount(blocksPerBatch);
+			for (ndInt32 i = 0; i < batches; ++i)
+			{
+				for (ndInt32 j = 0; j < blocksPerBatch; ++j)
+				{
+					list.Append(j);
+					objects[j] = new ndContactSizedObject;
+				}
+				for (ndInt32 j = 0; j < blocksPerBatch; ++j)
+				{
+					delete objects[j];
+				}
+				list.RemoveAll();
+			}
+		});
+
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		pool->Begin();
+		pool->ParallelExecute(AllocateBlocks);
+		pool->End();
+		const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+
+		const ndFloat64 allocations = ndFloat64(threads) * batches * blocksPerBatch * 2;
+		const ndFloat64 seconds = ndFloat64(time1 - time0) * 1.0e-6;
+		printf("%3d threads: %10.0f allocations, %8.3f ms, %7.2f million allocations per second\n", threads, allocations, seconds * 1.0e3, allocations * 1.0e-6 / seconds);
+	}
+	printf("memory used %.3f mbytes\n", ndFloat64(ndMemory::GetMemoryUsed()) / (1024 * 1024));
+	return 0;
+}
+
+// drops a grid of box stacks and reports how much transient memory the updates take from the 
+// frame arena, then runs the same scene with that much memory reserved before the first update.
+// a reserved arena must not go to the heap again.
+// usage: ndTest -benchmark frame [stacksPerSide] [steps]
+static ndInt32 FrameArenaBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 stacksPerSide = (argc > 0) ? dMax(atoi(argv[0]), 1) : 24;
+	const ndInt32 steps = (argc > 1) ? dMax(atoi(argv[1]), 1) : 300;
+	const ndInt32 stackHigh = 8;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	printf("frame arena: %d bodies, %d steps\n", stacksPerSide * stacksPerSide * stackHigh, steps);
+	printf("reserved   high water(kb)   heap allocs   steps with heap allocs   ms/step\n");
+
+	ndInt32 highWaterMark = 0;
+	for (ndInt32 pass = 0; pass < 2; ++pass)
+	{
+		ndWorld world;
+		world.SetSubSteps(2);
+		world.SetThreadCount(ndThreadPool::GetMaxThreads());
+		BuildBoxStacks(world, stacksPerSide, stackHigh);
+		if (pass)
+		{
+			world.ReserveFrameMemory(highWaterMark);
+		}
+
+		const ndFrameArena& arena = world.GetFrameArena();
+		const ndInt32 heapAllocations0 = arena.GetHeapAllocationCount();
+		ndInt32 stepsWithAllocations = 0;
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 i = 0; i < steps; ++i)
+		{
+			const ndInt32 count = arena.GetHeapAllocationCount();
+			world.Update(timestep);
+			world.Sync();
+			stepsWithAllocations += (arena.GetHeapAllocationCount() != count) ? 1 : 0;
+		}
+		const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+
+		highWaterMark = world.GetFrameMemoryHighWaterMark();
+		printf("%8s %16.1f %13d %24d %9.3f\n", pass ? "yes" : "no", ndFloat32(highWaterMark) / ndFloat32(1024.0f), 
+			arena.GetHeapAllocationCount() - heapAllocations0, stepsWithAllocations, ndFloat64(time1 - time0) * ndFloat64(1.0e-3f) / ndFloat64(steps));
+	}
+	return 0;
+}
+
+// steps several worlds of different size in one process and reports the memory charged to each 
+// world by subsystem, then the cost of querying an account, and the dump of all live accounts.
+// usage: ndTest -benchmark memory [worldCount] [stacksPerSide] [steps]
+static ndInt32 MemoryAccountBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 worldCount = (argc > 0) ? dMax(atoi(argv[0]), 1) : 4;
+	const ndInt32 stacksPerSide = (argc > 1) ? dMax(atoi(argv[1]), 1) : 4;
+	const ndInt32 steps = (argc > 2) ? dMax(atoi(argv[2]), 1) : 100;
+	const ndInt32 stackHigh = 8;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	ndArray<ndWorld*> worlds;
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		char name[32];
+		sprintf(name, "world %d", i);
+		ndWorld* const world = new ndWorld();
+		world->GetMemoryAccount().SetName(name);
+		world->SetSubSteps(2);
+
+		// the bodies and shapes created here are charged to the world too
+		ndMemoryScope scope(world->GetMemoryAccount());
+		BuildBoxStacks(*world, stacksPerSide + i, stackHigh);
+		worlds.PushBack(world);
+	}
+
+	const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < steps; ++i)
+	{
+		for (ndInt32 j = 0; j < worldCount; ++j)
+		{
+			worlds[j]->Update(timestep);
+		}
+		for (ndInt32 j = 0; j < worldCount; ++j)
+		{
+			worlds[j]->Sync();
+		}
+	}
+	const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+	printf("memory accounts: %d worlds, %d steps, %.3f ms/step\n", worldCount, steps, ndFloat64(time1 - time0) * 1.0e-3 / steps);
+
+	printf("world      bodies      total(kb)   peak(kb)  broadphase(kb)  contacts(kb)  solver(kb)\n");
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		const ndMemoryAccount& account = worlds[i]->GetMemoryAccount();
+		const ndMemoryStats total(account.GetTotal());
+		printf("%5d %11d %14.1f %10.1f %15.1f %13.1f %11.1f\n", i, worlds[i]->GetBodyList().GetCount(),
+			ndFloat64(total.m_bytes) / 1024.0, ndFloat64(total.m_peakBytes) / 1024.0,
+			ndFloat64(account.GetStats(m_broadphaseMemory).m_bytes) / 1024.0,
+			ndFloat64(account.GetStats(m_contactMemory).m_bytes) / 1024.0,
+			ndFloat64(account.GetStats(m_solverMemory).m_bytes) / 1024.0);
+	}
+
+	const ndInt32 queries = 10000;
+	ndInt64 checksum = 0;
+	const ndUnsigned64 time2 = dGetTimeInMicroseconds();
+	for (ndInt32 i = 0; i < queries; ++i)
+	{
+		checksum += worlds[i % worldCount]->GetMemoryAccount().GetTotal().m_bytes;
+	}
+	const ndUnsigned64 time3 = dGetTimeInMicroseconds();
+	printf("account query %.3f us (%lld)\n", ndFloat64(time3 - time2) / queries, (long long)(checksum / queries));
+
+	printf("\n");
+	ndMemoryAccount::Dump(stdout);
+
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		delete worlds[i];
+	}
+	return 0;
+}
+
+// same layout as BuildPyramid in the ndBasicStacks demo, the bottom row starts slightly inside the floor
+static void AddBenchmarkPyramid(ndWorld& world, ndArray<ndBodyDynamic*>& bodies, ndFloat32 x, ndInt32 high)
+{
+	const ndFloat32 stepz = ndFloat32(0.8f + 1.0e-2f);
+	const ndFloat32 stepy = ndFloat32(0.25f);
+	ndFloat32 z0 = -stepz * ndFloat32(high) * ndFloat32(0.5f);
+	ndFloat32 y = stepy * ndFloat32(0.5f) - ndFloat32(0.01f);
+	for (ndInt32 row = 0; row < high; ++row)
+	{
+		for (ndInt32 col = 0; col < high - row; ++col)
+		{
+			const ndVector origin(x, y, z0 + ndFloat32(col) * stepz, ndFloat32(1.0f));
+			bodies.PushBack(AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(0.5f), ndFloat32(0.25f), ndFloat32(0.8f)));
+		}
+		z0 += stepz * ndFloat32(0.5f);
+		y += stepy;
+	}
+}
+
+// the pyramids and the box column of the ndBasicStacks demo, solved by each solver with an increasing 
+// number of iterations. the bodies do not sleep, a solver that converges keeps the stacks at rest, 
+// so the residual speed and the drift from the initial positions measure the solver error.
+// usage: ndTest -benchmark solver [pyramidHigh] [steps] [iterations ...]
+static ndInt32 SolverConvergenceBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 pyramidHigh = (argc > 0) ? dMax(atoi(argv[0]), 2) : 20;
+	const ndInt32 steps = (argc > 1) ? dMax(atoi(argv[1]), 1) : 300;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	ndFixSizeArray<ndInt32, 16> iterations;
+	for (ndInt32 i = 2; (i < argc) && (iterations.GetCount() < 16); ++i)
+	{
+		iterations.PushBack(dMax(atoi(argv[i]), 4));
+	}
+	if (!iterations.GetCount())
+	{
+		iterations.PushBack(4);
+		iterations.PushBack(8);
+		iterations.PushBack(16);
+	}
+
+	printf("solver convergence: 4 pyramids of %d, a column of 20 boxes, %d steps\n", pyramidHigh, steps);
+	printf("solver         iterations    ms/step   max speed   mean drift   max drift\n");
+
+	const ndWorld::ndSolverModes solvers[] = { ndWorld::ndStandardSolver, ndWorld::ndSimdSoaSolver, ndWorld::ndGaussSeidelSolver };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(solvers) / sizeof(solvers[0])); ++i)
+	{
+		for (ndInt32 j = 0; j < iterations.GetCount(); ++j)
+		{
+			ndWorld world;
+			world.SetSubSteps(2);
+			world.SetThreadCount(ndThreadPool::GetMaxThreads());
+			world.SelectSolver(solvers[i]);
+			world.SetSolverIterations(iterations[j]);
+
+			ndArray<ndBodyDynamic*> bodies;
+			AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(200.0f), ndFloat32(1.0f), ndFloat32(200.0f));
+			for (ndInt32 k = 0; k < 4; ++k)
+			{
+				AddBenchmarkPyramid(world, bodies, ndFloat32(k) * ndFloat32(4.0f), pyramidHigh);
+			}
+			for (ndInt32 k = 0; k < 20; ++k)
+			{
+				const ndVector origin(ndFloat32(-2.0f), ndFloat32(0.5f) + ndFloat32(k), ndFloat32(3.0f), ndFloat32(1.0f));
+				bodies.PushBack(AddBenchmarkBox(world, origin, ndFloat32(10.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f)));
+			}
+
+			ndArray<ndVector> origins;
+			for (ndInt32 k = 0; k < bodies.GetCount(); ++k)
+			{
+				bodies[k]->SetAutoSleep(false);
+				origins.PushBack(bodies[k]->GetMatrix().m_posit);
+			}
+
+			const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+			for (ndInt32 k = 0; k < steps; ++k)
+			{
+				world.Update(timestep);
+				world.Sync();
+			}
+			const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+
+			ndFloat32 maxSpeed = ndFloat32(0.0f);
+			ndFloat32 maxDrift = ndFloat32(0.0f);
+			ndFloat64 drift = ndFloat64(0.0f);
+			for (ndInt32 k = 0; k < bodies.GetCount(); ++k)
+			{
+				const ndVector veloc(bodies[k]->GetVelocity());
+				const ndVector step(bodies[k]->GetMatrix().m_posit - origins[k]);
+				const ndFloat32 speed = ndSqrt(veloc.DotProduct(veloc & ndVector::m_triplexMask).GetScalar());
+				const ndFloat32 distance = ndSqrt(step.DotProduct(step & ndVector::m_triplexMask).GetScalar());
+				maxSpeed = dMax(maxSpeed, speed);
+				maxDrift = dMax(maxDrift, distance);
+				drift += distance;
+			}
+			printf("%-14s %10d %10.3f %11.5f %12.5f %11.5f\n", world.GetSolverString(), iterations[j],
+				ndFloat64(time1 - time0) * 1.0e-3 / steps, maxSpeed, drift / bodies.GetCount(), maxDrift);
+		}
+	}
+	return 0;
+}
+
+// pyramids of increasing height next to a field of loose boxes, all on the same floor, so that each 
+// pyramid and each box is an island of its own. the solver runs a fixed number of iterations with no 
+// tolerance, and then with each tolerance, where the islands that converge stop iterating early.
+// the residual is the largest acceleration error left by the solver in the last step.
+// usage: ndTest -benchmark adaptive [iterations] [steps] [tolerance ...]
+static ndInt32 AdaptiveSolverBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 iterations = (argc > 0) ? dMax(atoi(argv[0]), 4) : 16;
+	const ndInt32 steps = (argc > 1) ? dMax(atoi(argv[1]), 1) : 300;
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+
+	ndFixSizeArray<ndFloat32, 16> tolerances;
+	tolerances.PushBack(ndFloat32(0.0f));
+	for (ndInt32 i = 2; (i < argc) && (tolerances.GetCount() < 16); ++i)
+	{
+		tolerances.PushBack(ndFloat32(atof(argv[i])));
+	}
+	if (tolerances.GetCount() == 1)
+	{
+		tolerances.PushBack(ndFloat32(0.01f));
+		tolerances.PushBack(ndFloat32(0.1f));
+		tolerances.PushBack(ndFloat32(1.0f));
+	}
+
+	printf("adaptive solver: 8 pyramids of 2 to 16, 64 loose boxes, %d iterations, %d steps\n", iterations, steps);
+	printf("tolerance    ms/step   islands  passes/island  joint passes  early exits    residual   max speed   max drift\n");
+
+	ndInt64 fixedJointPasses = 0;
+	for (ndInt32 i = 0; i < tolerances.GetCount(); ++i)
+	{
+		ndWorld world;
+		world.SetSubSteps(2);
+		world.SetThreadCount(ndThreadPool::GetMaxThreads());
+		world.SetSolverIterations(iterations);
+		world.SetSolverTolerance(tolerances[i]);
+
+		ndArray<ndBodyDynamic*> bodies;
+		AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(200.0f), ndFloat32(1.0f), ndFloat32(200.0f));
+		for (ndInt32 j = 0; j < 8; ++j)
+		{
+			AddBenchmarkPyramid(world, bodies, ndFloat32(j) * ndFloat32(4.0f), 2 + j * 2);
+		}
+		for (ndInt32 j = 0; j < 64; ++j)
+		{
+			const ndVector origin(ndFloat32(j % 8) * ndFloat32(4.0f), ndFloat32(0.5f), ndFloat32(12.0f + (j / 8) * 2.0f), ndFloat32(1.0f));
+			bodies.PushBack(AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f)));
+		}
+
+		ndArray<ndVector> origins;
+		for (ndInt32 j = 0; j < bodies.GetCount(); ++j)
+		{
+			bodies[j]->SetAutoSleep(false);
+			origins.PushBack(bodies[j]->GetMatrix().m_posit);
+		}
+
+		ndInt32 islands = 0;
+		ndInt64 earlyExits = 0;
+		ndInt64 islandSolves = 0;
+		ndInt64 islandPasses = 0;
+		ndInt64 jointPasses = 0;
+		ndFloat32 residual = ndFloat32(0.0f);
+		const ndUnsigned64 time0 = dGetTimeInMicroseconds();
+		for (ndInt32 j = 0; j < steps; ++j)
+		{
+			world.Update(timestep);
+			world.Sync();
+
+			const ndWorld::ndSolverStats& stats = world.GetSolverStats();
+			islands = dMax(islands, stats.m_islandCount);
+			earlyExits += stats.m_earlyExits;
+			islandSolves += stats.m_islandSolves;
+			islandPasses += stats.m_islandPasses;
+			jointPasses += stats.m_jointPasses;
+			residual = stats.m_maxResidual;
+		}
+		const ndUnsigned64 time1 = dGetTimeInMicroseconds();
+		if (i == 0)
+		{
+			fixedJointPasses = dMax(jointPasses, ndInt64(1));
+		}
+
+		ndFloat32 maxSpeed = ndFloat32(0.0f);
+		ndFloat32 maxDrift = ndFloat32(0.0f);
+		for (ndInt32 j = 0; j < bodies.GetCount(); ++j)
+		{
+			const ndVector veloc(bodies[j]->GetVelocity());
+			const ndVector step(bodies[j]->GetMatrix().m_posit - origins[j]);
+			maxSpeed = dMax(maxSpeed, ndSqrt(veloc.DotProduct(veloc & ndVector::m_triplexMask).GetScalar()));
+			maxDrift = dMax(maxDrift, ndSqrt(step.DotProduct(step & ndVector::m_triplexMask).GetScalar()));
+		}
+
+		const ndFloat64 passesPerIsland = islandSolves ? ndFloat64(islandPasses) / ndFloat64(islandSolves) : ndFloat64(iterations);
+		printf("%9.4f %10.3f %9d %14.2f %12.1f%% %12lld %11.5f %11.5f %11.5f\n", tolerances[i],
+			ndFloat64(time1 - time0) * 1.0e-3 / steps, islands, passesPerIsland,
+			ndFloat64(jointPasses) * 100.0 / ndFloat64(fixedJointPasses), (long long)earlyExits, residual, maxSpeed, maxDrift);
+	}
+	return 0;
+}
+
+// columns of four boxes on a large floor with sleeping disabled, the body count the soa body state 
+// was made for. the same scene is stepped by the default and the soa solver with 16 iterations, so that 
+// the joint passes reading the body state weigh more than the once per step gather. the collision work 
+// is the same for both so the difference in step time is the difference in the solvers.
+// usage: ndTest -benchmark soabodies [columnsPerSide] [steps] [threads]
+static ndInt32 SoaBodyStateBenchmark(ndInt32 argc, const char* const argv[])
+{
+	const ndInt32 columnsPerSide = (argc > 0) ? dMax(atoi(argv[0]), 1) : 112;
+	const ndInt32 steps = (argc > 1) ? dMax(atoi(argv[1]), 1) : 20;
+	const ndInt32 threadCount = (argc > 2) ? dClamp(atoi(argv[2]), 1, D_MAX_THREADS_COUNT) : ndThreadPool::GetMaxThreads();
+
+	printf("soa body state: %d bodies, %d threads, %d steps\n", columnsPerSide * columnsPerSide * 4, threadCount, steps);
+	const ndWorld::ndSolverModes solvers[] = { ndWorld::ndStandardSolver, ndWorld::ndSimdSoaSolver };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(solvers) / sizeof(solvers[0])); ++i)
+	{
+		ndWorld world;
+		world.SetSubSteps(2);
+		world.SetThreadCount(threadCount);
+		world.SelectSolver(solvers[i]);
+		world.SetSolverIterations(16);
+		AddBenchmarkBox(world, ndVector(0.0f, -0.5f, 0.0f, 1.0f), ndFloat32(0.0f), ndFloat32(1000.0f), ndFloat32(1.0f), ndFloat32(1000.0f));
+
+		const ndFloat32 spacing = ndFloat32(1.5f);
+		const ndFloat32 offset = ndFloat32(columnsPerSide) * spacing * ndFloat32(0.5f);
+		for (ndInt32 j = 0; j < columnsPerSide; ++j)
+		{
+			for (ndInt32 k = 0; k < columnsPerSide; ++k)
+			{
+				for (ndInt32 n = 0; n < 4; ++n)
+				{
+					ndVector origin(ndFloat32(j) * spacing - offset, ndFloat32(0.5f) + ndFloat32(n), ndFloat32(k) * spacing - offset, ndFloat32(1.0f));
+					ndBodyDynamic* const body = AddBenchmarkBox(world, origin, ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f), ndFloat32(1.0f));
+					body->SetAutoSleep(false);
+				}
+			}
+		}
+
+		const ndFloat64 time = StepWorld(world, steps);
+		printf("%-14s %10.3f ms/step\n", world.GetSolverString(), time);
+	}
+	return 0;
+}
+
+ndInt32 RunBenchmark(ndInt32 argc, const char* const argv[])
+{
+	if (argc < 1)
+	{
+		printf("usage: ndTest -benchmark threads [maxThreads] [stacksPerSide] [steps]\n");
+		printf("       ndTest -benchmark worlds [worldCount] [threads] [steps]\n");
+		printf("       ndTest -benchmark pairs [bodiesPerSide] [threads ...]\n");
+		printf("       ndTest -benchmark resting [propsPerSide] [threads] [steps]\n");
+		printf("       ndTest -benchmark raycast [rayCount] [propsPerSide] [repeats]\n");
+		printf("       ndTest -benchmark convexcast [castCount] [propsPerSide] [repeats]\n");
+		printf("       ndTest -benchmark determinism [maxThreads] [boxesPerSide] [steps]\n");
+		printf("       ndTest -benchmark heightfield [size] [rayCount] [repeats] [float|quantized|streamed]\n");
+		printf("       ndTest -benchmark bvhload [gridSize] [worldCount]\n");
+		printf("       ndTest -benchmark bvhbuild [gridSize] [maxThreads] [queryCount]\n");
+		printf("       ndTest -benchmark bvhwide [gridSize] [propsPerSide] [steps]\n");
+		printf("       ndTest -benchmark snapshot [stacksPerSide] [steps] [snapshotInterval]\n");
+		printf("       ndTest -benchmark rollback [stacksPerSide ...]\n");
+		printf("       ndTest -benchmark isosurface [maxThreads] [particlesPerSide ...]\n");
+		printf("       ndTest -benchmark sph [steps] [particlesPerSide ...]\n");
+		printf("       ndTest -benchmark alloc [maxThreads] [blocksPerBatch] [batches]\n");
+		printf("       ndTest -benchmark frame [stacksPerSide] [steps]\n");
+		printf("       ndTest -benchmark memory [worldCount] [stacksPerSide] [steps]\n");
+		printf("       ndTest -benchmark solver [pyramidHigh] [steps] [iterations ...]\n");
+		printf("       ndTest -benchmark adaptive [iterations] [steps] [tolerance ...]\n");
+		printf("       ndTest -benchmark soabodies [columnsPerSide] [steps] [threads]\n");
+		return -1;
+	}
+
+	if (!strcmp(argv[0], "threads"))
+	{
+		return ThreadScalingBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "worlds"))
+	{
+		return WorldGroupBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "pairs"))
+	{
+		return PairCreationBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "resting"))
+	{
+		return RestingPropsBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "raycast"))
+	{
+		return RayCastBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "convexcast"))
+	{
+		return ConvexCastBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "determinism"))
+	{
+		return DeterminismTest(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "heightfield"))
+	{
+		return HeightfieldBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "bvhload"))
+	{
+		return StaticMeshLoadBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "bvhbuild"))
+	{
+		return StaticMeshBuildBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "bvhwide"))
+	{
+		return StaticMeshWideNodesBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "snapshot"))
+	{
+		return SnapshotBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "rollback"))
+	{
+		return RollbackBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "isosurface"))
+	{
+		return IsoSurfaceBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "sph"))
+	{
+		return SphFluidBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "alloc"))
+	{
+		return AllocatorBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "frame"))
+	{
+		return FrameArenaBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "memory"))
+	{
+		return MemoryAccountBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "solver"))
+	{
+		return SolverConvergenceBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "adaptive"))
+	{
+		return AdaptiveSolverBenchmark(argc - 1, &argv[1]);
+	}
+
+	if (!strcmp(argv[0], "soabodies"))
+	{
+		return SoaBodyStateBenchmark(argc - 1, &argv[1]);
+	}
+
+	printf("unknown benchmark: %s\n", argv[0]);
+	return -1;
+}
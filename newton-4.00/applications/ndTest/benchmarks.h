@@ -0,0 +1,18 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef _TEST_BENCHMARKS_H_
+#define _TEST_BENCHMARKS_H_
+
+// command line benchmarks, run as "ndTest -benchmark name [options]"
+ndInt32 RunBenchmark(ndInt32 argc, const char* const argv[]);
+
+#endif
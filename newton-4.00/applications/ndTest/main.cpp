@@ -10,6 +10,7 @@
 */
 
 #include "testStdafx.h"
+#include "benchmarks.h"
 
 
 // memory allocation for Newton
@@ -154,8 +155,13 @@ ndBodyDynamic* BuildSphere(ndWorld& world, ndFloat32 mass, const ndVector& origi
 	return body;
 }
 
-int main(int, const char*)
+int main(int argc, const char* argv[])
 {
+	if ((argc > 1) && !strcmp(argv[1], "-benchmark"))
+	{
+		return RunBenchmark(argc - 2, &argv[2]);
+	}
+
 	ndWorld world;
 	world.SetSubSteps(1);
 
@@ -13,9 +13,12 @@
 #define _TEST_SDT_AFTX_H_
 
 #include <stdio.h>
-#include <conio.h>
 #include <stdlib.h>
-#include <crtdbg.h>
+#include <string.h>
+#ifdef _MSC_VER
+	#include <conio.h>
+	#include <crtdbg.h>
+#endif
 #include <ndNewton.h>
 
 #endif
@@ -133,6 +133,8 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 	friend class ndScene;
 	friend class ndConstraint;
 	friend class ndBodyPlayerCapsuleImpulseSolver;
+	friend class ndLoadSave;
+	friend class ndWorldCheckpoint;
 } D_GCC_NEWTON_ALIGN_32;
 
 inline ndUnsigned32 ndBody::GetId() const
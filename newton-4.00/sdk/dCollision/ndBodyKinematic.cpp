@@ -35,38 +35,153 @@ D_CLASS_REFLECTION_IMPLEMENT_LOADER(ndBodyKinematic);
 
 ndVector ndBodyKinematic::m_velocTol(ndVector(ndFloat32(1.0e-8f)) & ndVector::m_triplexMask);
 
+#define D_CONTACT_MAP_MIN_CAPACITY 8
+
 ndBodyKinematic::ndContactMap::ndContactMap()
-	:ndTree<ndContact*, ndContactkey, ndContainersFreeListAlloc<ndContact*>>()
+	:m_table(nullptr)
+	,m_count(0)
+	,m_capacity(0)
 {
 }
 
 ndBodyKinematic::ndContactMap::~ndContactMap()
 {
+	if (m_table)
+	{
+		ndMemory::Free(m_table);
+	}
+}
+
+void ndBodyKinematic::ndContactMap::Rehash(ndInt32 capacity)
+{
+	dAssert(capacity >= D_CONTACT_MAP_MIN_CAPACITY);
+	dAssert(!(capacity & (capacity - 1)));
+	dAssert(m_count * 4 <= capacity * 3);
+
+	ndNode* const oldTable = m_table;
+	const ndInt32 oldCapacity = m_capacity;
+
+	m_capacity = capacity;
+	m_table = (ndNode*)ndMemory::Malloc(ndInt32(capacity * sizeof(ndNode)));
+	memset(m_table, 0, capacity * sizeof(ndNode));
+
+	const ndInt32 mask = capacity - 1;
+	for (ndInt32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldTable[i].m_contact)
+		{
+			ndInt32 index = GetHashSlot(oldTable[i].m_key);
+			while (m_table[index].m_contact)
+			{
+				index = (index + 1) & mask;
+			}
+			m_table[index] = oldTable[i];
+		}
+	}
+
+	if (oldTable)
+	{
+		ndMemory::Free(oldTable);
+	}
 }
 
 ndContact* ndBodyKinematic::ndContactMap::FindContact(const ndBody* const body0, const ndBody* const body1) const
 {
-	ndContactkey key(body0->GetId(), body1->GetId());
-	ndNode* const node = Find(key);
-	return node ? node->GetInfo() : nullptr;
+	if (!m_count)
+	{
+		return nullptr;
+	}
+
+	const ndUnsigned64 key = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+	const ndInt32 mask = m_capacity - 1;
+	for (ndInt32 index = GetHashSlot(key); m_table[index].m_contact; index = (index + 1) & mask)
+	{
+		if (m_table[index].m_key == key)
+		{
+			return m_table[index].m_contact;
+		}
+	}
+	return nullptr;
 }
 
 void ndBodyKinematic::ndContactMap::AttachContact(ndContact* const contact)
 {
 	ndBody* const body0 = contact->GetBody0();
 	ndBody* const body1 = contact->GetBody1();
-	ndContactkey key(body0->GetId(), body1->GetId());
-	dAssert(!Find(key));
-	Insert(contact, key);
+	dAssert(!FindContact(body0, body1));
+
+	// keep the load factor under 3/4 so that probe chains stay short
+	if ((m_count + 1) * 4 > m_capacity * 3)
+	{
+		Rehash(dMax(m_capacity * 2, D_CONTACT_MAP_MIN_CAPACITY));
+	}
+
+	const ndUnsigned64 key = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+	const ndInt32 mask = m_capacity - 1;
+	ndInt32 index = GetHashSlot(key);
+	while (m_table[index].m_contact)
+	{
+		index = (index + 1) & mask;
+	}
+	m_table[index].m_key = key;
+	m_table[index].m_contact = contact;
+	m_count++;
 }
 
 void ndBodyKinematic::ndContactMap::DetachContact(ndContact* const contact)
 {
 	ndBody* const body0 = contact->GetBody0();
 	ndBody* const body1 = contact->GetBody1();
-	ndContactkey key(body0->GetId(), body1->GetId());
-	dAssert(Find(key));
-	Remove(key);
+	const ndUnsigned64 key = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+
+	dAssert(m_count);
+	const ndInt32 mask = m_capacity - 1;
+	ndInt32 index = GetHashSlot(key);
+	while (m_table[index].m_key != key)
+	{
+		dAssert(m_table[index].m_contact);
+		index = (index + 1) & mask;
+	}
+	dAssert(m_table[index].m_contact == contact);
+
+	// backward shift deletion, move the entries that follow in the probe 
+	// chain into the hole, so that lookups never need tombstones.
+	ndInt32 hole = index;
+	for (ndInt32 next = (index + 1) & mask; m_table[next].m_contact; next = (next + 1) & mask)
+	{
+		const ndInt32 home = GetHashSlot(m_table[next].m_key);
+		if (((next - home) & mask) >= ((next - hole) & mask))
+		{
+			m_table[hole] = m_table[next];
+			hole = next;
+		}
+	}
+	m_table[hole].m_key = 0;
+	m_table[hole].m_contact = nullptr;
+	m_count--;
+
+	if ((m_capacity > D_CONTACT_MAP_MIN_CAPACITY) && (m_count * 4 < m_capacity))
+	{
+		Rehash(m_capacity / 2);
+	}
+}
+
+bool ndBodyKinematic::ndContactMap::SanityCheck() const
+{
+	ndInt32 count = 0;
+	for (ndInt32 i = 0; i < m_capacity; ++i)
+	{
+		const ndContact* const contact = m_table[i].m_contact;
+		if (contact)
+		{
+			count++;
+			if (FindContact(contact->GetBody0(), contact->GetBody1()) != contact)
+			{
+				return false;
+			}
+		}
+	}
+	return count == m_count;
 }
 
 ndBodyKinematic::ndBodyKinematic()
@@ -49,19 +49,9 @@ class ndBodyKinematic : public ndBody
 			dAssert(m_tagLow < m_tagHigh);
 		}
 
-		bool operator== (const ndContactkey& key) const
+		ndUnsigned64 GetTag() const
 		{
-			return m_tag == key.m_tag;
-		}
-
-		bool operator< (const ndContactkey& key) const
-		{
-			return m_tag < key.m_tag;
-		}
-
-		bool operator> (const ndContactkey& key) const
-		{
-			return m_tag > key.m_tag;
+			return m_tag;
 		}
 
 		private:
@@ -76,9 +66,45 @@ class ndBodyKinematic : public ndBody
 		};
 	};
 	public:
-	class ndContactMap: public ndTree<ndContact*, ndContactkey, ndContainersFreeListAlloc<ndContact*>>
+	// flat open addressing hash of the contacts attached to a body, keyed 
+	// by the pair of body ids. linear probing over a small power of two 
+	// table keeps a lookup within one or two cache lines.
+	// the map can not be modified while it is being iterated.
+	class ndContactMap
 	{
 		public:
+		class ndNode
+		{
+			public:
+			ndContact* GetInfo() const;
+
+			private:
+			ndUnsigned64 m_key;
+			ndContact* m_contact;
+			friend class ndContactMap;
+		};
+
+		class Iterator
+		{
+			public:
+			Iterator(const ndContactMap& map);
+
+			void Begin();
+			operator ndInt32() const;
+			void operator++ ();
+			void operator++ (ndInt32);
+			ndContact* operator* () const;
+			ndNode* GetNode() const;
+
+			private:
+			void Next(ndInt32 index);
+
+			const ndContactMap* m_map;
+			ndInt32 m_index;
+		};
+
+		ndInt32 GetCount() const;
+		D_COLLISION_API bool SanityCheck() const;
 		D_COLLISION_API ndContact* FindContact(const ndBody* const body0, const ndBody* const body1) const;
 
 		private:
@@ -86,6 +112,12 @@ class ndBodyKinematic : public ndBody
 		~ndContactMap();
 		void AttachContact(ndContact* const contact);
 		void DetachContact(ndContact* const contact);
+		void Rehash(ndInt32 capacity);
+		ndInt32 GetHashSlot(ndUnsigned64 key) const;
+
+		ndNode* m_table;
+		ndInt32 m_count;
+		ndInt32 m_capacity;
 		friend class ndBodyKinematic;
 	};
 
@@ -231,10 +263,13 @@ class ndBodyKinematic : public ndBody
 	friend class ndWorldSceneCuda;
 	friend class ndSkeletonContainer;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateCuda;
 	friend class ndDynamicsUpdateOpencl;
 	friend class ndJointBilateralConstraint;
+	friend class ndLoadSave;
+	friend class ndWorldCheckpoint;
 } D_GCC_NEWTON_ALIGN_32;
 
 
@@ -552,5 +587,73 @@ inline void ndBodyKinematic::ApplyExternalForces(ndInt32, ndFloat32)
 {
 }
 
+inline ndContact* ndBodyKinematic::ndContactMap::ndNode::GetInfo() const
+{
+	return m_contact;
+}
+
+inline ndInt32 ndBodyKinematic::ndContactMap::GetCount() const
+{
+	return m_count;
+}
+
+inline ndInt32 ndBodyKinematic::ndContactMap::GetHashSlot(ndUnsigned64 key) const
+{
+	dAssert(m_capacity && !(m_capacity & (m_capacity - 1)));
+	const ndUnsigned64 hash = key * ndUnsigned64(0x9E3779B97F4A7C15);
+	return ndInt32(hash >> 32) & (m_capacity - 1);
+}
+
+inline ndBodyKinematic::ndContactMap::Iterator::Iterator(const ndContactMap& map)
+	:m_map(&map)
+	,m_index(map.m_capacity)
+{
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::Next(ndInt32 index)
+{
+	const ndInt32 capacity = m_map->m_capacity;
+	const ndNode* const table = m_map->m_table;
+	while ((index < capacity) && !table[index].m_contact)
+	{
+		index++;
+	}
+	m_index = index;
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::Begin()
+{
+	Next(0);
+}
+
+inline ndBodyKinematic::ndContactMap::Iterator::operator ndInt32() const
+{
+	return m_index < m_map->m_capacity;
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::operator++ ()
+{
+	dAssert(m_index < m_map->m_capacity);
+	Next(m_index + 1);
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::operator++ (ndInt32)
+{
+	dAssert(m_index < m_map->m_capacity);
+	Next(m_index + 1);
+}
+
+inline ndContact* ndBodyKinematic::ndContactMap::Iterator::operator* () const
+{
+	dAssert(m_index < m_map->m_capacity);
+	return m_map->m_table[m_index].m_contact;
+}
+
+inline ndBodyKinematic::ndContactMap::ndNode* ndBodyKinematic::ndContactMap::Iterator::GetNode() const
+{
+	dAssert(m_index < m_map->m_capacity);
+	return &m_map->m_table[m_index];
+}
+
 #endif 
 
@@ -38,6 +38,7 @@
 #include <ndShapeNull.h>
 #include <ndShapeCone.h>
 #include <ndSceneNode.h>
+#include <ndSceneQueryTree.h>
 #include <ndJointList.h>
 #include <ndConstraint.h>
 #include <ndBodyNotify.h>
@@ -52,6 +52,7 @@ ndContact::ndContact()
 	,m_isIntersetionTestOnly(0)
 	,m_skeletonIntraCollision(1)
 	,m_skeletonSelftCollision(1)
+	,m_checkpointMark(0)
 {
 	m_active = 0;
 }
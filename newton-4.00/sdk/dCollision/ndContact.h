@@ -137,6 +137,7 @@ class ndContact: public ndConstraint
 	ndUnsigned32 m_isIntersetionTestOnly : 1;
 	ndUnsigned32 m_skeletonIntraCollision : 1;
 	ndUnsigned32 m_skeletonSelftCollision : 1;
+	ndUnsigned32 m_checkpointMark : 1;
 	static ndVector m_initialSeparatingVector;
 
 	friend class ndScene;
@@ -147,6 +148,7 @@ class ndContact: public ndConstraint
 	friend class ndConvexCastNotify;
 	friend class ndShapeConvexPolygon;
 	friend class ndBodyPlayerCapsuleContactSolver;
+	friend class ndWorldCheckpoint;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 inline const ndMaterial* ndContact::GetMaterial() const
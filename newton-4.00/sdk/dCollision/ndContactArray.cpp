@@ -27,13 +27,11 @@
 
 ndContactArray::ndContactArray()
 	:ndArray<ndContact*>(1024)
-	,m_lock()
 {
 }
 
 ndContactArray::ndContactArray(const ndContactArray& src)
 	:ndArray<ndContact*>()
-	,m_lock()
 {
 	ndContactArray& steal = (ndContactArray&)src;
 	Swap(steal);
@@ -43,16 +41,6 @@ ndContactArray::~ndContactArray()
 {
 }
 
-ndContact* ndContactArray::CreateContact(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
-{
-	ndContact* const contact = new ndContact;
-	contact->SetBodies(body0, body1);
-	contact->AttachToBodies();
-	ndScopeSpinLock lock(m_lock);
-	PushBack(contact);
-	return contact;
-}
-
 void ndContactArray::DeleteContact(ndContact* const contact)
 {
 	if (contact->m_isAttached)
@@ -34,9 +34,6 @@ class ndContactArray : public ndArray<ndContact*>
 
 	void DeleteAllContacts();
 	void DeleteContact(ndContact* const contact);
-	ndContact* CreateContact(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
-
-	ndSpinLock m_lock;
 };
 
 
@@ -27,6 +27,7 @@
 
 class ndBody;
 class ndScene;
+class ndBodyKinematic;
 class ndShapeInstance;
 
 D_MSV_NEWTON_ALIGN_32
@@ -69,4 +70,38 @@ class ndConvexCastNotify : public ndClassAlloc
 	ndFloat32 m_param;
 } D_GCC_NEWTON_ALIGN_32;
 
+// one shape sweep of a batched convex cast, m_ignoreBody is usually the body that owns the shape.
+D_MSV_NEWTON_ALIGN_32
+class ndConvexCastQuery
+{
+	public:
+	ndConvexCastQuery()
+	{
+	}
+
+	ndConvexCastQuery(const ndShapeInstance* const shape, const ndMatrix& origin, const ndVector& dest, const ndBodyKinematic* const ignoreBody = nullptr)
+		:m_origin(origin)
+		,m_dest(dest)
+		,m_shape(shape)
+		,m_ignoreBody(ignoreBody)
+	{
+	}
+
+	ndMatrix m_origin;
+	ndVector m_dest;
+	const ndShapeInstance* m_shape;
+	const ndBodyKinematic* m_ignoreBody;
+} D_GCC_NEWTON_ALIGN_32;
+
+// first hit of one sweep of a batched convex cast, m_body is null if the shape hit nothing.
+D_MSV_NEWTON_ALIGN_32
+class ndConvexCastResult
+{
+	public:
+	ndVector m_point;
+	ndVector m_normal;
+	const ndBodyKinematic* m_body;
+	ndFloat32 m_param;
+} D_GCC_NEWTON_ALIGN_32;
+
 #endif
@@ -154,9 +154,11 @@ class ndJointBilateralConstraint : public ndConstraint
 	friend class ndDynamicsUpdate;
 	friend class ndSkeletonContainer;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateCuda;
 	friend class ndDynamicsUpdateOpencl;
+	friend class ndWorldCheckpoint;
 };
 
 inline ndJointBilateralSolverModel ndJointBilateralConstraint::GetSolverModel() const
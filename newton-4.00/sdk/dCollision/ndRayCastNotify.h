@@ -80,4 +80,35 @@ class ndRayCastClosestHitCallback: public ndRayCastNotify
 } D_GCC_NEWTON_ALIGN_32 ;
 
 
+// one ray of a batched ray cast
+D_MSV_NEWTON_ALIGN_32
+class ndRayCastQuery
+{
+	public:
+	ndRayCastQuery()
+	{
+	}
+
+	ndRayCastQuery(const ndVector& origin, const ndVector& dest)
+		:m_origin(origin)
+		,m_dest(dest)
+	{
+	}
+
+	ndVector m_origin;
+	ndVector m_dest;
+} D_GCC_NEWTON_ALIGN_32;
+
+// closest hit of one ray of a batched ray cast, m_body is null if the ray hit nothing.
+D_MSV_NEWTON_ALIGN_32
+class ndRayCastResult
+{
+	public:
+	ndVector m_point;
+	ndVector m_normal;
+	const ndBodyKinematic* m_body;
+	const ndShapeInstance* m_shapeInstance;
+	ndFloat32 m_param;
+} D_GCC_NEWTON_ALIGN_32;
+
 #endif
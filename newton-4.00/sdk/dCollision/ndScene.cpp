@@ -32,10 +32,13 @@
 #include "ndConvexCastNotify.h"
 #include "ndBodyTriggerVolume.h"
 #include "ndBodiesInAabbNotify.h"
+#include "ndShapeHeightfield.h"
 #include "ndJointBilateralConstraint.h"
 #include "ndShapeStaticProceduralMesh.h"
 
 #define D_CONTACT_DELAY_FRAMES		4
+#define D_AABB_FAT_MARGIN			ndFloat32 (0.1f)
+#define D_AABB_FAT_PREDICTION		ndFloat32 (2.0f)
 #define D_NARROW_PHASE_DIST			ndFloat32 (0.2f)
 #define D_CONTACT_TRANSLATION_ERROR	ndFloat32 (1.0e-3f)
 #define D_CONTACT_ANGULAR_ERROR		(ndFloat32 (0.25f * ndDegreeToRad))
@@ -207,15 +210,19 @@ ndScene::ndScene()
 	:ndThreadPool("newtonWorker")
 	,m_bodyList()
 	,m_contactArray()
-	,m_scratchBuffer(1024 * sizeof (void*))
 	,m_sceneBodyArray(1024)
 	,m_activeConstraintArray(1024)
 	,m_specialUpdateList()
+	,m_elevationRegions()
+	,m_newPairs()
 	,m_backgroundThread()
+	,m_localFrameArena()
 	,m_lock()
+	,m_queryTreeLock()
 	,m_rootNode(nullptr)
 	,m_sentinelBody(nullptr)
 	,m_contactNotifyCallback(new ndContactNotify())
+	,m_frameArena(&m_localFrameArena)
 	,m_treeEntropy(ndFloat32(0.0f))
 	,m_fitness()
 	,m_timestep(ndFloat32 (0.0f))
@@ -223,6 +230,7 @@ ndScene::ndScene()
 	,m_forceBalanceSceneCounter(0)
 	,m_bodyListChanged(1)
 	,m_forceBalanceScene(0)
+	,m_deterministic(0)
 {
 	m_sentinelBody = new ndBodySentinel;
 	m_contactNotifyCallback->m_scene = this;
@@ -232,15 +240,19 @@ ndScene::ndScene(const ndScene& src)
 	:ndThreadPool("newtonWorker")
 	,m_bodyList(src.m_bodyList)
 	,m_contactArray(src.m_contactArray)
-	,m_scratchBuffer()
 	,m_sceneBodyArray()
 	,m_activeConstraintArray()
 	,m_specialUpdateList()
+	,m_elevationRegions()
+	,m_newPairs()
 	,m_backgroundThread()
+	,m_localFrameArena()
 	,m_lock()
+	,m_queryTreeLock()
 	,m_rootNode(nullptr)
 	,m_sentinelBody(nullptr)
 	,m_contactNotifyCallback(nullptr)
+	,m_frameArena((src.m_frameArena == &src.m_localFrameArena) ? &m_localFrameArena : src.m_frameArena)
 	,m_treeEntropy(ndFloat32(0.0f))
 	,m_fitness(src.m_fitness)
 	,m_timestep(ndFloat32(0.0f))
@@ -248,13 +260,13 @@ ndScene::ndScene(const ndScene& src)
 	,m_forceBalanceSceneCounter(src.m_forceBalanceSceneCounter)
 	,m_bodyListChanged(src.m_bodyListChanged)
 	,m_forceBalanceScene(src.m_forceBalanceScene)
+	,m_deterministic(src.m_deterministic)
 {
 	ndScene* const stealData = (ndScene*)&src;
 
 	SetThreadCount(src.GetThreadCount());
 	m_backgroundThread.SetThreadCount(m_backgroundThread.GetThreadCount());
 
-	m_scratchBuffer.Swap(stealData->m_scratchBuffer);
 	m_sceneBodyArray.Swap(stealData->m_sceneBodyArray);
 	m_activeConstraintArray.Swap(stealData->m_activeConstraintArray);
 
@@ -271,6 +283,14 @@ ndScene::ndScene(const ndScene& src)
 		m_specialUpdateList.Append(node);
 	}
 
+	ndList<ndElevationRegion>::ndNode* nextRegion;
+	for (ndList<ndElevationRegion>::ndNode* node = stealData->m_elevationRegions.GetFirst(); node; node = nextRegion)
+	{
+		nextRegion = node->GetNext();
+		stealData->m_elevationRegions.Unlink(node);
+		m_elevationRegions.Append(node);
+	}
+
 	for (ndBodyList::ndNode* node = m_bodyList.GetFirst(); node; node = node->GetNext())
 	{
 		ndBodyKinematic* const body = node->GetInfo();
@@ -292,6 +312,10 @@ ndScene::~ndScene()
 	{
 		delete m_contactNotifyCallback;
 	}
+	for (ndInt32 i = 0; i < m_newPairs.GetCount(); ++i)
+	{
+		delete m_newPairs[i];
+	}
 	ndFreeListAlloc::Flush();
 }
 
@@ -304,6 +328,7 @@ void ndScene::CollisionOnlyUpdate()
 {
 	D_TRACKTIME();
 	Begin();
+	ApplyElevationRegions();
 	m_lru = m_lru + 1;
 	InitBodyArray();
 	BalanceScene();
@@ -315,6 +340,7 @@ void ndScene::CollisionOnlyUpdate()
 void ndScene::ThreadFunction()
 {
 	D_TRACKTIME();
+	m_frameArena->Reset();
 	CollisionOnlyUpdate();
 }
 
@@ -379,9 +405,11 @@ void ndScene::DebugScene(ndSceneTreeNotiFy* const notify)
 
 bool ndScene::AddBody(ndBodyKinematic* const body)
 {
+	ndMemoryScope memoryScope(m_broadphaseMemory);
 	if ((body->m_scene == nullptr) && (body->m_sceneNode == nullptr))
 	{
 		m_bodyListChanged = 1;
+		m_queryTree.Invalidate();
 		ndBodyList::ndNode* const node = m_bodyList.Append(body);
 		body->SetSceneNodes(this, node);
 		m_contactNotifyCallback->OnBodyAdded(body);
@@ -402,16 +430,32 @@ bool ndScene::AddBody(ndBodyKinematic* const body)
 
 bool ndScene::RemoveBody(ndBodyKinematic* const body)
 {
+	{
+		ndScopeSpinLock lock(m_lock);
+		ndList<ndElevationRegion>::ndNode* nextRegion;
+		for (ndList<ndElevationRegion>::ndNode* node = m_elevationRegions.GetFirst(); node; node = nextRegion)
+		{
+			nextRegion = node->GetNext();
+			if (node->GetInfo().m_body == body)
+			{
+				m_elevationRegions.Remove(node);
+			}
+		}
+	}
+
 	ndSceneBodyNode* const node = body->GetSceneBodyNode();
 	if (node)
 	{
+		m_queryTree.Invalidate();
 		RemoveNode(node);
 	}
 
 	ndBodyKinematic::ndContactMap& contactMap = body->GetContactMap();
-	while (contactMap.GetRoot())
+	while (contactMap.GetCount())
 	{
-		ndContact* const contact = contactMap.GetRoot()->GetInfo();
+		ndBodyKinematic::ndContactMap::Iterator it(contactMap);
+		it.Begin();
+		ndContact* const contact = *it;
 		m_contactArray.DeleteContact(contact);
 	}
 
@@ -708,8 +752,8 @@ void ndScene::UpdateFitness(ndFitnessList& fitness, ndFloat64& oldEntropy, ndSce
 		{
 			if (fitness.GetFirst()) 
 			{
-				m_scratchBuffer.SetCount((fitness.GetCount() * 2 + 16) * sizeof (ndSceneNode*));
-				ndSceneNode** const leafArray = (ndSceneNode**)&m_scratchBuffer[0];
+				ndFrameArena::ndScope scope(*m_frameArena);
+				ndSceneNode** const leafArray = m_frameArena->Alloc<ndSceneNode*>(fitness.GetCount() * 2 + 16);
 
 				ndInt32 leafNodesCount = 0;
 				for (ndFitnessList::ndNode* nodePtr = fitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) 
@@ -772,6 +816,7 @@ void ndScene::UpdateFitness(ndFitnessList& fitness, ndFloat64& oldEntropy, ndSce
 void ndScene::BalanceScene()
 {
 	D_TRACKTIME();
+	ndMemoryScope memoryScope(m_broadphaseMemory);
 	UpdateFitness(m_fitness, m_treeEntropy, &m_rootNode);
 }
 
@@ -864,6 +909,29 @@ void ndScene::UpdateTransformNotify(ndInt32 threadIndex, ndBodyKinematic* const
 	}
 }
 
+void ndScene::UpdateParentAabb(ndSceneBodyNode* const bodyNode)
+{
+	if (!m_rootNode->GetAsSceneBodyNode())
+	{
+		const ndSceneNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? nullptr : m_rootNode;
+		dAssert(root == nullptr);
+		for (ndSceneNode* parent = bodyNode->m_parent; parent != root; parent = parent->m_parent)
+		{
+			ndScopeSpinLock lock(parent->m_lock);
+			ndVector minBox;
+			ndVector maxBox;
+			ndFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
+			if (dBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox))
+			{
+				break;
+			}
+			parent->m_minBox = minBox;
+			parent->m_maxBox = maxBox;
+			parent->m_surfaceArea = area;
+		}
+	}
+}
+
 void ndScene::UpdateAabb(ndInt32, ndBodyKinematic* const body)
 {
 	if (!body->m_equilibrium | body->m_sceneForceUpdate)
@@ -878,25 +946,17 @@ void ndScene::UpdateAabb(ndInt32, ndBodyKinematic* const body)
 		const ndInt32 test = dBoxInclusionTest(body->m_minAabb, body->m_maxAabb, bodyNode->m_minBox, bodyNode->m_maxBox);
 		if (!test)
 		{
-			bodyNode->SetAabb(body->m_minAabb, body->m_maxAabb);
-			if (!m_rootNode->GetAsSceneBodyNode())
+			// fatten the node box by a small margin plus the distance the body 
+			// is expected to travel in the next few steps, so that bodies that 
+			// jitter or move slowly stay inside their node and out of the pair search. 
+			const ndVector margin(D_AABB_FAT_MARGIN, D_AABB_FAT_MARGIN, D_AABB_FAT_MARGIN, ndFloat32(0.0f));
+			const ndVector step(body->m_veloc.Scale(m_timestep * D_AABB_FAT_PREDICTION) & ndVector::m_triplexMask);
+			const ndVector minBox(body->m_minAabb - margin + step.GetMin(ndVector::m_zero));
+			const ndVector maxBox(body->m_maxAabb + margin + step.GetMax(ndVector::m_zero));
+			bodyNode->SetAabb(minBox, maxBox);
+			if (!m_deterministic)
 			{
-				const ndSceneNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? nullptr : m_rootNode;
-				dAssert(root == nullptr);
-				for (ndSceneNode* parent = bodyNode->m_parent; parent != root; parent = parent->m_parent)
-				{
-					ndScopeSpinLock lock(parent->m_lock);
-					ndVector minBox;
-					ndVector maxBox;
-					ndFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
-					if (dBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox))
-					{
-						break;
-					}
-					parent->m_minBox = minBox;
-					parent->m_maxBox = maxBox;
-					parent->m_surfaceArea = area;
-				}
+				UpdateParentAabb(bodyNode);
 			}
 		}
 		body->m_sceneEquilibrium = !body->m_sceneForceUpdate & (test != 0);
@@ -1198,7 +1258,7 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 }
 
 //void ndScene::SubmitPairs(ndSceneNode* const leafNode, ndSceneNode* const node)
-void ndScene::SubmitPairs(ndSceneBodyNode* const leafNode, ndSceneNode* const node)
+void ndScene::SubmitPairs(ndInt32 threadIndex, ndSceneBodyNode* const leafNode, ndSceneNode* const node)
 {
 	ndBodyKinematic* const body0 = leafNode->GetBody() ? leafNode->GetBody() : nullptr;
 	//const ndVector boxP0(body0 ? body0->m_minAabb : leafNode->m_minBox);
@@ -1238,7 +1298,7 @@ void ndScene::SubmitPairs(ndSceneBodyNode* const leafNode, ndSceneNode* const no
 							bool test = test0 | test1;
 							if (test)
 							{
-								AddPair(body0, body1);
+								AddPair(threadIndex, body0, body1);
 							}
 						}
 					}
@@ -1302,21 +1362,24 @@ ndJointBilateralConstraint* ndScene::FindBilateralJoint(ndBodyKinematic* const b
 
 ndContact* ndScene::FindContactJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const
 {
+	// contacts maps are read only while pairs are been found, 
+	// new contacts are attached after all threads are done. 
 	if (body1->GetInvMass() != ndFloat32(0.0f))
 	{
-		ndContact* const contact = body1->FindContact(body0);
-		dAssert(!contact || (body0->FindContact(body1) == contact));
+		ndContact* const contact = body1->m_contactList.FindContact(body0, body1);
+		dAssert(!contact || (body0->m_contactList.FindContact(body0, body1) == contact));
 		return contact;
 	}
 
 	dAssert(body0->GetInvMass() != ndFloat32(0.0f));
-	ndContact* const contact = body0->FindContact(body1);
-	dAssert(!contact || (body1->FindContact(body0) == contact));
+	ndContact* const contact = body0->m_contactList.FindContact(body0, body1);
+	dAssert(!contact || (body1->m_contactList.FindContact(body0, body1) == contact));
 	return contact;
 }
 
-void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
+void ndScene::AddPair(ndInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1)
 {
+	ndMemoryScope memoryScope(m_contactMemory);
 	ndContact* const contact = FindContactJoint(body0, body1);
 	if (!contact) 
 	{
@@ -1325,8 +1388,78 @@ void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1
 		const bool isCollidable = bilateral ? bilateral->IsCollidable() : true;
 		if (isCollidable) 
 		{
-			ndContact* const newContact = m_contactArray.CreateContact(body0, body1);
-			newContact->m_material = m_contactNotifyCallback->GetMaterial(newContact, body0->GetCollisionShape(), body1->GetCollisionShape());
+			m_newPairs[threadIndex]->PushBack(ndContactPairs(body0, body1));
+		}
+	}
+}
+
+void ndScene::CreateNewContacts()
+{
+	D_TRACKTIME();
+	const ndInt32 threadCount = GetThreadCount();
+	ndInt32* const scans = dAlloca(ndInt32, threadCount + 1);
+
+	ndInt32 newPairsCount = 0;
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		scans[i] = newPairsCount;
+		newPairsCount += m_newPairs[i]->GetCount();
+	}
+	scans[threadCount] = newPairsCount;
+
+	if (newPairsCount)
+	{
+		const ndInt32 baseIndex = m_contactArray.GetCount();
+		m_contactArray.SetCount(baseIndex + newPairsCount);
+
+		// each thread creates the contacts it found into its own slice of the array
+		auto CreateContacts = ndMakeObject::ndFunction([this, baseIndex, scans](ndInt32 threadIndex, ndInt32)
+		{
+			D_TRACKTIME();
+			ndArray<ndContactPairs>& pairs = *m_newPairs[threadIndex];
+			ndContact** const contacts = &m_contactArray[baseIndex + scans[threadIndex]];
+			for (ndInt32 i = 0; i < pairs.GetCount(); ++i)
+			{
+				ndBodyKinematic* const body0 = pairs[i].m_body0;
+				ndBodyKinematic* const body1 = pairs[i].m_body1;
+				ndContact* const contact = new ndContact;
+				contact->SetBodies(body0, body1);
+				contact->m_material = m_contactNotifyCallback->GetMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
+				contacts[i] = contact;
+			}
+			pairs.SetCount(0);
+		});
+		ParallelExecute(CreateContacts);
+
+		if (m_deterministic)
+		{
+			// which thread finds a pair depends on scheduling, sorting the new 
+			// contacts by body id makes the contact array independent of it.
+			class ndCompareContacts
+			{
+				public:
+				ndInt32 Compare(const ndContact* const contactA, const ndContact* const contactB, void* const) const
+				{
+					const ndUnsigned64 keyA = (ndUnsigned64(contactA->GetBody0()->GetId()) << 32) + contactA->GetBody1()->GetId();
+					const ndUnsigned64 keyB = (ndUnsigned64(contactB->GetBody0()->GetId()) << 32) + contactB->GetBody1()->GetId();
+					if (keyA < keyB)
+					{
+						return -1;
+					}
+					else if (keyA > keyB)
+					{
+						return 1;
+					}
+					return 0;
+				}
+			};
+			ndSort<ndContact*, ndCompareContacts>(&m_contactArray[baseIndex], newPairsCount);
+		}
+
+		// two new contacts can share a body, so the attachment is serial.
+		for (ndInt32 i = baseIndex; i < m_contactArray.GetCount(); ++i)
+		{
+			m_contactArray[i]->AttachToBodies();
 		}
 	}
 }
@@ -1361,13 +1494,15 @@ void ndScene::UpdateBodyList()
 void ndScene::InitBodyArray()
 {
 	D_TRACKTIME();
-	ndInt32 scans[D_MAX_THREADS_COUNT][2];
-	auto BuildBodyArray = ndMakeObject::ndFunction([this, &scans](ndInt32 threadIndex, ndInt32 threadCount)
+	const ndInt32 threadCount = GetThreadCount();
+	ndFrameArena::ndScope scope(*m_frameArena);
+	ndInt32* const scans = m_frameArena->Alloc<ndInt32>(threadCount * 2);
+	auto BuildBodyArray = ndMakeObject::ndFunction([this, scans](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
 		const ndArray<ndBodyKinematic*>& view = GetActiveBodyArray();
 		
-		ndInt32* const scan = &scans[threadIndex][0];
+		ndInt32* const scan = &scans[threadIndex * 2];
 		scan[0] = 0;
 		scan[1] = 0;
 		
@@ -1386,14 +1521,14 @@ void ndScene::InitBodyArray()
 		}
 	});
 
-	auto CompactMovingBodies = ndMakeObject::ndFunction([this, &scans](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CompactMovingBodies = ndMakeObject::ndFunction([this, scans](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
 		const ndArray<ndBodyKinematic*>& activeBodyArray = GetActiveBodyArray();
 		ndBodyKinematic** const sceneBodyArray = &m_sceneBodyArray[0];
 
 		const ndArray<ndBodyKinematic*>& view = m_bodyList.m_view;
-		ndInt32* const scan = &scans[threadIndex][0];
+		ndInt32* const scan = &scans[threadIndex * 2];
 
 		//const ndStartEnd startEnd(view.GetCount(), threadIndex, threadCount);
 		const ndStartEnd startEnd(view.GetCount() - 1, threadIndex, threadCount);
@@ -1409,18 +1544,17 @@ void ndScene::InitBodyArray()
 
 	ParallelExecute(BuildBodyArray);
 	ndInt32 sum = 0;
-	ndInt32 threadCount = GetThreadCount();
 	for (ndInt32 j = 0; j < 2; j++)
 	{
 		for (ndInt32 i = 0; i < threadCount; ++i)
 		{
-			const ndInt32 count = scans[i][j];
-			scans[i][j] = sum;
+			const ndInt32 count = scans[i * 2 + j];
+			scans[i * 2 + j] = sum;
 			sum += count;
 		}
 	}
 
-	ndInt32 movingBodyCount = scans[0][1] - scans[0][0];
+	ndInt32 movingBodyCount = scans[1] - scans[0];
 	m_sceneBodyArray.SetCount(m_bodyList.GetCount());
 	if (movingBodyCount)
 	{
@@ -1429,6 +1563,24 @@ void ndScene::InitBodyArray()
 
 	m_sceneBodyArray.SetCount(movingBodyCount);
 
+	if (m_deterministic)
+	{
+		// concurrent refits leave parent boxes that are valid but depend on 
+		// thread timing, and the tree balance reads them, so refit in body order.
+		D_TRACKTIME();
+		for (ndInt32 i = 0; i < movingBodyCount; ++i)
+		{
+			UpdateParentAabb(m_sceneBodyArray[i]->GetSceneBodyNode());
+		}
+	}
+
+	// only bodies that left their node change the tree boxes, 
+	// the query tree is rebuilt by the first query that needs it.
+	if (movingBodyCount)
+	{
+		m_queryTree.Invalidate();
+	}
+
 	ndBodyKinematic* const sentinelBody = m_sentinelBody;
 	sentinelBody->PrepareStep(GetActiveBodyArray().GetCount() - 1);
 
@@ -1446,19 +1598,37 @@ void ndScene::InitBodyArray()
 void ndScene::CalculateContacts()
 {
 	D_TRACKTIME();
-	ndInt32 digitScan[D_MAX_THREADS_COUNT][4];
+	ndMemoryScope memoryScope(m_contactMemory);
 	m_activeConstraintArray.SetCount(0);
 	if (m_contactArray.GetCount())
 	{
-		m_scratchBuffer.SetCount(m_contactArray.GetCount() * sizeof (ndContact*));
+		const ndInt32 threadCount = GetThreadCount();
+		ndFrameArena::ndScope scope(*m_frameArena);
+		ndContact** const scratchContacts = m_frameArena->Alloc<ndContact*>(m_contactArray.GetCount());
+		ndInt32* const digitScan = m_frameArena->Alloc<ndInt32>(threadCount * 4);
 		m_activeConstraintArray.SetCount(m_contactArray.GetCount());
 
-		auto CalculateNewContacts = ndMakeObject::ndFunction([this, &digitScan](ndInt32 threadIndex, ndInt32 threadCount)
+		auto CalculateNewContacts = ndMakeObject::ndFunction([this, scratchContacts](ndInt32 threadIndex, ndInt32 start, ndInt32 end)
 		{
-			D_TRACKTIME();
 			ndContactArray& activeContacts = m_contactArray;
-			ndContact** const dstContacts = (ndContact**)&m_scratchBuffer[0];
-			ndInt32* const scan = &digitScan[threadIndex][0];
+			ndContact** const dstContacts = scratchContacts;
+			for (ndInt32 i = start; i < end; ++i)
+			{
+				ndContact* const contact = activeContacts[i]->GetAsContact();
+				dAssert(contact);
+				if (!contact->m_isDead)
+				{
+					CalculateContacts(threadIndex, contact);
+				}
+				dstContacts[i] = contact;
+			}
+		});
+
+		auto CountContacts = ndMakeObject::ndFunction([this, digitScan, scratchContacts](ndInt32 threadIndex, ndInt32 threadCount)
+		{
+			D_TRACKTIME();
+			ndContact** const srcContacts = scratchContacts;
+			ndInt32* const scan = &digitScan[threadIndex * 4];
 
 			ndInt32 keyLookUp[4];
 			scan[0] = 0;
@@ -1470,45 +1640,41 @@ void ndScene::CalculateContacts()
 			keyLookUp[2] = 2;
 			keyLookUp[3] = 2;
 
-			const ndStartEnd startEnd(activeContacts.GetCount(), threadIndex, threadCount);
+			const ndStartEnd startEnd(m_contactArray.GetCount(), threadIndex, threadCount);
 			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
-				ndContact* const contact = activeContacts[i]->GetAsContact();
-				dAssert(contact);
-				if (!contact->m_isDead)
-				{
-					CalculateContacts(threadIndex, contact);
-				}
-				dstContacts[i] = contact;
+				ndContact* const contact = srcContacts[i];
 				const ndInt32 entry = (!contact->IsActive() | !contact->m_maxDOF) + contact->m_isDead * 2;
 				const ndInt32 key = keyLookUp[entry];
 				scan[key] ++;
 			}
 		});
 
-		ParallelExecute(CalculateNewContacts);
+		// narrow phase cost varies wildly from pair to pair, so it is 
+		// executed as a stealing range and counted in a separate pass.
+		ParallelExecuteRange(m_contactArray.GetCount(), CalculateNewContacts);
+		ParallelExecute(CountContacts);
 
 		ndInt32 sum = 0;
-		ndInt32 threadCount = GetThreadCount();
 		for (ndInt32 j = 0; j < 4; j++)
 		{
 			for (ndInt32 i = 0; i < threadCount; ++i)
 			{
-				const ndInt32 count = digitScan[i][j];
-				digitScan[i][j] = sum;
+				const ndInt32 count = digitScan[i * 4 + j];
+				digitScan[i * 4 + j] = sum;
 				sum += count;
 			}
 		}
 
-		ndInt32 activeJoints = digitScan[0][1] - digitScan[0][0];
-		ndInt32 inactiveJoints = digitScan[0][2] - digitScan[0][1];
-		ndInt32 deadContacts = digitScan[0][3] - digitScan[0][2];
+		ndInt32 activeJoints = digitScan[1] - digitScan[0];
+		ndInt32 inactiveJoints = digitScan[2] - digitScan[1];
+		ndInt32 deadContacts = digitScan[3] - digitScan[2];
 
-		auto CompactContacts = ndMakeObject::ndFunction([this, &digitScan](ndInt32 threadIndex, ndInt32 threadCount)
+		auto CompactContacts = ndMakeObject::ndFunction([this, digitScan, scratchContacts](ndInt32 threadIndex, ndInt32 threadCount)
 		{
 			D_TRACKTIME();
 			ndContactArray& dstContacts = m_contactArray;
-			ndContact** const srcContacts = (ndContact**)&m_scratchBuffer[0];
+			ndContact** const srcContacts = scratchContacts;
 			ndArray<ndConstraint*>& activeConstraintArray = m_activeConstraintArray;
 
 			ndInt32 keyLookUp[4];
@@ -1516,7 +1682,7 @@ void ndScene::CalculateContacts()
 			keyLookUp[1] = 1;
 			keyLookUp[2] = 2;
 			keyLookUp[3] = 2;
-			ndInt32* const scan = &digitScan[threadIndex][0];
+			ndInt32* const scan = &digitScan[threadIndex * 4];
 
 			const ndStartEnd startEnd(dstContacts.GetCount(), threadIndex, threadCount);
 			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
@@ -1550,7 +1716,7 @@ void ndScene::CalculateContacts()
 	}
 }
 
-void ndScene::FindCollidingPairs(ndBodyKinematic* const body)
+void ndScene::FindCollidingPairs(ndInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	for (ndSceneNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
@@ -1560,12 +1726,12 @@ void ndScene::FindCollidingPairs(ndBodyKinematic* const body)
 		ndSceneNode* const sibling = parent->m_right;
 		if (sibling != ptr)
 		{
-			SubmitPairs(bodyNode, sibling);
+			SubmitPairs(threadIndex, bodyNode, sibling);
 		}
 	}
 }
 
-void ndScene::FindCollidingPairsForward(ndBodyKinematic* const body)
+void ndScene::FindCollidingPairsForward(ndInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	for (ndSceneNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
@@ -1575,12 +1741,12 @@ void ndScene::FindCollidingPairsForward(ndBodyKinematic* const body)
 		ndSceneNode* const sibling = parent->m_right;
 		if (sibling != ptr)
 		{
-			SubmitPairs(bodyNode, sibling);
+			SubmitPairs(threadIndex, bodyNode, sibling);
 		}
 	}
 }
 
-void ndScene::FindCollidingPairsBackward(ndBodyKinematic* const body)
+void ndScene::FindCollidingPairsBackward(ndInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	for (ndSceneNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
@@ -1590,7 +1756,7 @@ void ndScene::FindCollidingPairsBackward(ndBodyKinematic* const body)
 		ndSceneNode* const sibling = parent->m_left;
 		if (sibling != ptr)
 		{
-			SubmitPairs(bodyNode, sibling);
+			SubmitPairs(threadIndex, bodyNode, sibling);
 		}
 	}
 }
@@ -1598,39 +1764,40 @@ void ndScene::FindCollidingPairsBackward(ndBodyKinematic* const body)
 void ndScene::FindCollidingPairs()
 {
 	D_TRACKTIME();
-	auto FindPairs = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 threadCount)
+	ndMemoryScope memoryScope(m_broadphaseMemory);
+	// one buffer of new pairs for each worker
+	for (ndInt32 i = m_newPairs.GetCount(); i < GetThreadCount(); ++i)
+	{
+		m_newPairs.PushBack(new ndArray<ndContactPairs>);
+	}
+
+	auto FindPairs = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndBodyKinematic*>& bodyArray = GetActiveBodyArray();
-		const ndStartEnd startEnd(bodyArray.GetCount() - 1, threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndBodyKinematic* const body = bodyArray[i];
-			FindCollidingPairs(body);
+			FindCollidingPairs(threadIndex, body);
 		}
 	});
 
-	auto FindPairsForward = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 threadCount)
+	auto FindPairsForward = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndBodyKinematic*>& bodyArray = m_sceneBodyArray;
-		const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndBodyKinematic* const body = bodyArray[i];
-			FindCollidingPairsForward(body);
+			FindCollidingPairsForward(threadIndex, body);
 		}
 	});
 
-	auto FindPairsBackward = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 threadCount)
+	auto FindPairsBackward = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndBodyKinematic*>& bodyArray = m_sceneBodyArray;
-		const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndBodyKinematic* const body = bodyArray[i];
-			FindCollidingPairsBackward(body);
+			FindCollidingPairsBackward(threadIndex, body);
 		}
 	});
 
@@ -1638,30 +1805,32 @@ void ndScene::FindCollidingPairs()
 	bool fullScan = (2 * m_sceneBodyArray.GetCount()) > activeBodies.GetCount();
 	if (fullScan)
 	{
-		ParallelExecute(FindPairs);
+		ParallelExecuteRange(activeBodies.GetCount() - 1, FindPairs);
+		CreateNewContacts();
 	}
 	else
 	{
-		ParallelExecute(FindPairsForward);
-		ParallelExecute(FindPairsBackward);
+		// the backward pass has to see the contacts created by the forward pass
+		ParallelExecuteRange(m_sceneBodyArray.GetCount(), FindPairsForward);
+		CreateNewContacts();
+		ParallelExecuteRange(m_sceneBodyArray.GetCount(), FindPairsBackward);
+		CreateNewContacts();
 	}
 }
 
 void ndScene::UpdateTransform()
 {
 	D_TRACKTIME();
-	auto TransformUpdate = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 threadCount)
+	auto TransformUpdate = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndBodyKinematic*>& bodyArray = GetActiveBodyArray();
-		const ndStartEnd startEnd(bodyArray.GetCount() - 1, threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndBodyKinematic* const body = bodyArray[i];
 			UpdateTransformNotify(threadIndex, body);
 		}
 	});
-	ParallelExecute(TransformUpdate);
+	ParallelExecuteRange(GetActiveBodyArray().GetCount() - 1, TransformUpdate);
 }
 
 void ndScene::CalculateContacts(ndInt32 threadIndex, ndContact* const contact)
@@ -1766,6 +1935,67 @@ void ndScene::UpdateSpecial()
 	}
 }
 
+void ndScene::ConvexCastBody(ndConvexCastNotify& callback, ndBodyKinematic* const body, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const
+{
+	if (callback.OnRayPrecastAction (body, &convexShape)) 
+	{
+		// save contacts and try new set
+		ndConvexCastNotify savedNotification(callback);
+		callback.m_contacts.SetCount(0);
+		if (callback.CastShape(convexShape, globalOrigin, globalDest, body))
+		{
+			// found new contacts, see how the are managed
+			if (dAbs(savedNotification.m_param - callback.m_param) < ndFloat32(-1.0e-3f))
+			{
+				// merge contact
+				for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
+				{
+					const ndContactPoint& contact = savedNotification.m_contacts[i];
+					bool newPoint = true;
+					for (ndInt32 j = callback.m_contacts.GetCount() - 1; j >= 0; j++)
+					{
+						const ndVector diff(callback.m_contacts[j].m_point - contact.m_point);
+						ndFloat32 mag2 = diff.DotProduct(diff & ndVector::m_triplexMask).GetScalar();
+						newPoint = newPoint & (mag2 > ndFloat32(1.0e-5f));
+					}
+					if (newPoint && (callback.m_contacts.GetCount() < callback.m_contacts.GetCapacity()))
+					{
+						callback.m_contacts.PushBack(contact);
+					}
+				}
+			}
+			else if (callback.m_param > savedNotification.m_param)
+			{
+				// restore contacts
+				callback.m_normal = savedNotification.m_normal;
+				callback.m_closestPoint0 = savedNotification.m_closestPoint0;
+				callback.m_closestPoint1 = savedNotification.m_closestPoint1;
+				callback.m_param = savedNotification.m_param;
+				callback.m_contacts.SetCount(savedNotification.m_contacts.GetCount());
+				for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
+				{
+					callback.m_contacts[i] = savedNotification.m_contacts[i];
+				}
+			}
+		}
+		else
+		{
+			// no new contacts restore old ones,
+			// in theory it should no copy, by the notification may change
+			// the previous found contacts
+			callback.m_normal = savedNotification.m_normal;
+			callback.m_closestPoint0 = savedNotification.m_closestPoint0;
+			callback.m_closestPoint1 = savedNotification.m_closestPoint1;
+			callback.m_param = savedNotification.m_param;
+			callback.m_contacts.SetCount(savedNotification.m_contacts.GetCount());
+			for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
+			{
+				callback.m_contacts[i] = savedNotification.m_contacts[i];
+			}
+		}
+	}
+}
+
 bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndSceneNode** stackPool, ndFloat32* const stackDistance, ndInt32 stack, const ndFastRay& ray, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const
 {
 	ndVector boxP0;
@@ -1792,66 +2022,10 @@ bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndSceneNode** stack
 			ndBody* const body = me->GetBody();
 			if (body) 
 			{
-				if (callback.OnRayPrecastAction (body, &convexShape)) 
+				ConvexCastBody(callback, body->GetAsBodyKinematic(), convexShape, globalOrigin, globalDest);
+				if (callback.m_param < ndFloat32 (1.0e-8f)) 
 				{
-					// save contacts and try new set
-					ndConvexCastNotify savedNotification(callback);
-					ndBodyKinematic* const kinBody = body->GetAsBodyKinematic();
-					callback.m_contacts.SetCount(0);
-					if (callback.CastShape(convexShape, globalOrigin, globalDest, kinBody))
-					{
-						// found new contacts, see how the are managed
-						if (dAbs(savedNotification.m_param - callback.m_param) < ndFloat32(-1.0e-3f))
-						{
-							// merge contact
-							for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
-							{
-								const ndContactPoint& contact = savedNotification.m_contacts[i];
-								bool newPoint = true;
-								for (ndInt32 j = callback.m_contacts.GetCount() - 1; j >= 0; j++)
-								{
-									const ndVector diff(callback.m_contacts[j].m_point - contact.m_point);
-									ndFloat32 mag2 = diff.DotProduct(diff & ndVector::m_triplexMask).GetScalar();
-									newPoint = newPoint & (mag2 > ndFloat32(1.0e-5f));
-								}
-								if (newPoint && (callback.m_contacts.GetCount() < callback.m_contacts.GetCapacity()))
-								{
-									callback.m_contacts.PushBack(contact);
-								}
-							}
-						}
-						else if (callback.m_param > savedNotification.m_param)
-						{
-							// restore contacts
-							callback.m_normal = savedNotification.m_normal;
-							callback.m_closestPoint0 = savedNotification.m_closestPoint0;
-							callback.m_closestPoint1 = savedNotification.m_closestPoint1;
-							callback.m_param = savedNotification.m_param;
-							for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
-							{
-								callback.m_contacts[i] = savedNotification.m_contacts[i];
-							}
-						}
-					}
-					else
-					{
-						// no new contacts restore old ones,
-						// in theory it should no copy, by the notification may change
-						// the previous found contacts
-						callback.m_normal = savedNotification.m_normal;
-						callback.m_closestPoint0 = savedNotification.m_closestPoint0;
-						callback.m_closestPoint1 = savedNotification.m_closestPoint1;
-						callback.m_param = savedNotification.m_param;
-						for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
-						{
-							callback.m_contacts[i] = savedNotification.m_contacts[i];
-						}
-					}
-
-					if (callback.m_param < ndFloat32 (1.0e-8f)) 
-					{
-						break;
-					}
+					break;
 				}
 			}
 			else 
@@ -1975,6 +2149,123 @@ bool ndScene::RayCast(ndRayCastNotify& callback, const ndSceneNode** stackPool,
 	return state;
 }
 
+bool ndScene::RayCast(ndRayCastNotify& callback, const ndFastRay& ray, ndInt32 rootIndex) const
+{
+	ndInt32 stackPool[D_SCENE_MAX_STACK_DEPTH];
+	ndFloat32 stackDistance[D_SCENE_MAX_STACK_DEPTH];
+	const ndSceneQueryTree::ndFastRay4 ray4(ray, ndVector::m_zero, ndVector::m_zero);
+
+	bool state = false;
+	ndInt32 stack = 1;
+	stackPool[0] = rootIndex;
+	stackDistance[0] = ndFloat32(0.0f);
+	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - 4)))
+	{
+		stack--;
+		if (stackDistance[stack] > callback.m_param)
+		{
+			break;
+		}
+
+		const ndInt32 index = stackPool[stack];
+		if (index < 0)
+		{
+			ndBodyKinematic* const body = m_queryTree.GetBody(index);
+			if (body->RayCast(callback, ray, callback.m_param))
+			{
+				state = true;
+				if (callback.m_param < ndFloat32(1.0e-8f))
+				{
+					break;
+				}
+			}
+		}
+		else
+		{
+			const ndSceneQueryTree::ndNode& node = m_queryTree.GetNode(index);
+			const ndVector dist(ray4.BoxIntersect(node));
+			for (ndInt32 i = 0; i < node.m_count; ++i)
+			{
+				const ndFloat32 dist1 = dist[i];
+				if (dist1 < callback.m_param)
+				{
+					ndInt32 j = stack;
+					for (; j && (dist1 > stackDistance[j - 1]); j--)
+					{
+						stackPool[j] = stackPool[j - 1];
+						stackDistance[j] = stackDistance[j - 1];
+					}
+					stackPool[j] = node.m_child[i];
+					stackDistance[j] = dist1;
+					stack++;
+					dAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+				}
+			}
+		}
+	}
+	return state;
+}
+
+bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndFastRay& ray, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const
+{
+	ndVector boxP0;
+	ndVector boxP1;
+	dAssert(globalOrigin.TestOrthogonal());
+	convexShape.CalculateAabb(globalOrigin, boxP0, boxP1);
+
+	ndInt32 stackPool[D_SCENE_MAX_STACK_DEPTH];
+	ndFloat32 stackDistance[D_SCENE_MAX_STACK_DEPTH];
+	const ndSceneQueryTree::ndFastRay4 ray4(ray, boxP0, boxP1);
+
+	callback.m_contacts.SetCount(0);
+	callback.m_param = ndFloat32(1.2f);
+
+	ndInt32 stack = 1;
+	stackPool[0] = 0;
+	stackDistance[0] = ndFloat32(0.0f);
+	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - 4)))
+	{
+		stack--;
+		if (stackDistance[stack] > callback.m_param)
+		{
+			break;
+		}
+
+		const ndInt32 index = stackPool[stack];
+		if (index < 0)
+		{
+			ConvexCastBody(callback, m_queryTree.GetBody(index), convexShape, globalOrigin, globalDest);
+			if (callback.m_param < ndFloat32(1.0e-8f))
+			{
+				break;
+			}
+		}
+		else
+		{
+			const ndSceneQueryTree::ndNode& node = m_queryTree.GetNode(index);
+			const ndVector dist(ray4.BoxIntersect(node));
+			for (ndInt32 i = 0; i < node.m_count; ++i)
+			{
+				const ndFloat32 dist1 = dist[i];
+				if (dist1 < callback.m_param)
+				{
+					ndInt32 j = stack;
+					for (; j && (dist1 > stackDistance[j - 1]); j--)
+					{
+						stackPool[j] = stackPool[j - 1];
+						stackDistance[j] = stackDistance[j - 1];
+					}
+					stackPool[j] = node.m_child[i];
+					stackDistance[j] = dist1;
+					stack++;
+					dAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+				}
+			}
+		}
+	}
+	return callback.m_contacts.GetCount() > 0;
+}
+
 void ndScene::BodiesInAabb(ndBodiesInAabbNotify& callback, const ndSceneNode** stackPool, ndInt32 stack) const
 {
 	callback.m_bodyArray.SetCount(0);
@@ -2017,6 +2308,7 @@ void ndScene::Cleanup()
 	m_backgroundThread.Terminate();
 
 	m_bodyListChanged = 1;
+	m_queryTree.Invalidate();
 	while (m_bodyList.GetFirst())
 	{
 		ndBodyKinematic* const body = m_bodyList.GetFirst()->GetInfo();
@@ -2034,10 +2326,8 @@ void ndScene::Cleanup()
 	m_contactArray.Resize(1024);
 	m_sceneBodyArray.Resize(1024);
 	m_activeConstraintArray.Resize(1024);
-	m_scratchBuffer.Resize(1024 * sizeof(void*));
 
 	m_contactArray.SetCount(0);
-	m_scratchBuffer.SetCount(0);
 	m_sceneBodyArray.SetCount(0);
 	m_activeConstraintArray.SetCount(0);
 }
@@ -2146,14 +2436,9 @@ bool ndScene::RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, c
 		ndFloat32 dist2 = segment.DotProduct(segment).GetScalar();
 		if (dist2 > ndFloat32(1.0e-8f))
 		{
-			ndFloat32 distance[D_SCENE_MAX_STACK_DEPTH];
-			const ndSceneNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
-
 			ndFastRay ray(p0, p1);
-
-			stackPool[0] = m_rootNode;
-			distance[0] = ray.BoxIntersect(m_rootNode->m_minBox, m_rootNode->m_maxBox);
-			state = RayCast(callback, stackPool, distance, 1, ray);
+			BuildQueryTree();
+			state = RayCast(callback, ray, 0);
 		}
 	}
 	return state;
@@ -2165,40 +2450,368 @@ bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& co
 	callback.m_param = ndFloat32(1.2f);
 	if (m_rootNode)
 	{
-		ndVector boxP0;
-		ndVector boxP1;
 		dAssert(globalOrigin.TestOrthogonal());
-		convexShape.CalculateAabb(globalOrigin, boxP0, boxP1);
-
-		ndFloat32 distance[D_SCENE_MAX_STACK_DEPTH];
-		const ndSceneNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
-
-		const ndVector velocB(ndVector::m_zero);
 		const ndVector velocA((globalDest - globalOrigin.m_posit) & ndVector::m_triplexMask);
-		const ndVector minBox(m_rootNode->m_minBox - boxP1);
-		const ndVector maxBox(m_rootNode->m_maxBox - boxP0);
 		ndFastRay ray(ndVector::m_zero, velocA);
-
-		stackPool[0] = m_rootNode;
-		distance[0] = ray.BoxIntersect(minBox, maxBox);
-		state = ConvexCast(callback, stackPool, distance, 1, ray, convexShape, globalOrigin, globalDest);
+		BuildQueryTree();
+		state = ConvexCast(callback, ray, convexShape, globalOrigin, globalDest);
 	}
 	return state;
 }
 
+class ndBatchRayCastNotify: public ndRayCastNotify
+{
+	public:
+	ndBatchRayCastNotify()
+		:ndRayCastNotify()
+		,m_filterMask(0)
+	{
+	}
+
+	ndUnsigned32 OnRayPrecastAction(const ndBody* const, const ndShapeInstance* const instance)
+	{
+		return (!m_filterMask || (m_filterMask & instance->GetUserDataID())) ? 1 : 0;
+	}
+
+	ndFloat32 OnRayCastAction(const ndContactPoint& contact, ndFloat32 intersetParam)
+	{
+		if (intersetParam < m_param)
+		{
+			m_contact = contact;
+			m_param = intersetParam;
+		}
+		return intersetParam;
+	}
+
+	ndUnsigned64 m_filterMask;
+};
+
+void ndScene::RayCast(const ndRayCastQuery* const rays, ndRayCastResult* const results, ndInt32 count, ndUnsigned64 filterMask)
+{
+	D_TRACKTIME();
+	class ndRayKey
+	{
+		public:
+		ndUnsigned32 m_key;
+		ndInt32 m_index;
+	};
+
+	class ndRayKeyDigit
+	{
+		public:
+		ndRayKeyDigit(void* const context)
+			:m_shift(*((ndInt32*)context))
+		{
+		}
+
+		ndInt32 GetKey(const ndRayKey& entry) const
+		{
+			return (entry.m_key >> m_shift) & 0xff;
+		}
+
+		ndInt32 m_shift;
+	};
+
+	if (!count)
+	{
+		return;
+	}
+
+	Sync();
+	BuildQueryTree();
+
+	// sort the rays by the morton code of the origin and then by direction octant,
+	// so that consecutive rays, and the rays of each thread, visit the same nodes.
+	ndVector minBox(ndFloat32(1.0e15f));
+	ndVector maxBox(ndFloat32(-1.0e15f));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		minBox = minBox.GetMin(rays[i].m_origin);
+		maxBox = maxBox.GetMax(rays[i].m_origin);
+	}
+	const ndVector size((maxBox - minBox) & ndVector::m_triplexMask);
+	const ndVector scale(size.GetMax(ndVector(ndFloat32(1.0e-3f))).Reciproc().Scale(ndFloat32(31.99f)));
+
+	ndArray<ndRayKey> keys;
+	ndArray<ndRayKey> scratch;
+	keys.SetCount(count);
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndRayCastQuery& query = rays[i];
+		const ndVector cell(((query.m_origin - minBox) * scale).GetInt());
+		const ndVector dir(query.m_dest - query.m_origin);
+		ndUnsigned32 morton = 0;
+		for (ndInt32 j = 0; j < 5; ++j)
+		{
+			morton |= ((ndUnsigned32(cell.m_ix) >> j) & 1) << (j * 3 + 0);
+			morton |= ((ndUnsigned32(cell.m_iy) >> j) & 1) << (j * 3 + 1);
+			morton |= ((ndUnsigned32(cell.m_iz) >> j) & 1) << (j * 3 + 2);
+		}
+		const ndUnsigned32 octant = (dir.m_x < ndFloat32(0.0f) ? 1 : 0) | (dir.m_y < ndFloat32(0.0f) ? 2 : 0) | (dir.m_z < ndFloat32(0.0f) ? 4 : 0);
+		keys[i].m_key = (morton << 3) | octant;
+		keys[i].m_index = i;
+	}
+
+	Begin();
+	for (ndInt32 shift = 0; shift < 24; shift += 8)
+	{
+		ndCountingSort<ndRayKey, ndRayKeyDigit, 8>(*this, keys, scratch, &shift);
+	}
+
+	const bool emptyTree = m_queryTree.IsEmpty();
+	auto CastRays = ndMakeObject::ndFunction([this, rays, results, &keys, filterMask, emptyTree](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		D_TRACKTIME();
+		ndBatchRayCastNotify callback;
+		callback.m_filterMask = filterMask;
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			const ndInt32 index = keys[i].m_index;
+			const ndRayCastQuery& query = rays[index];
+			const ndVector p0(query.m_origin & ndVector::m_triplexMask);
+			const ndVector p1(query.m_dest & ndVector::m_triplexMask);
+			const ndVector segment(p1 - p0);
+
+			callback.m_param = ndFloat32(1.2f);
+			if (!emptyTree && (segment.DotProduct(segment).GetScalar() > ndFloat32(1.0e-8f)))
+			{
+				const ndFastRay ray(p0, p1);
+				RayCast(callback, ray, 0);
+			}
+
+			ndRayCastResult& result = results[index];
+			if (callback.m_param < ndFloat32(1.0f))
+			{
+				result.m_point = callback.m_contact.m_point;
+				result.m_normal = callback.m_contact.m_normal;
+				result.m_body = callback.m_contact.m_body0;
+				result.m_shapeInstance = callback.m_contact.m_shapeInstance0;
+				result.m_param = callback.m_param;
+			}
+			else
+			{
+				result.m_point = ndVector::m_zero;
+				result.m_normal = ndVector::m_zero;
+				result.m_body = nullptr;
+				result.m_shapeInstance = nullptr;
+				result.m_param = ndFloat32(1.2f);
+			}
+		}
+	});
+	ParallelExecuteRange(count, CastRays);
+	End();
+}
+
+class ndBatchConvexCastNotify: public ndConvexCastNotify
+{
+	public:
+	ndBatchConvexCastNotify()
+		:ndConvexCastNotify()
+		,m_ignoreBody(nullptr)
+		,m_filterMask(0)
+	{
+	}
+
+	ndUnsigned32 OnRayPrecastAction(const ndBody* const body, const ndShapeInstance* const)
+	{
+		if (body == m_ignoreBody)
+		{
+			return 0;
+		}
+		const ndShapeInstance& instance = ((ndBody*)body)->GetAsBodyKinematic()->GetCollisionShape();
+		return (!m_filterMask || (m_filterMask & instance.GetUserDataID())) ? 1 : 0;
+	}
+
+	const ndBodyKinematic* m_ignoreBody;
+	ndUnsigned64 m_filterMask;
+};
+
+void ndScene::ConvexCast(const ndConvexCastQuery* const casts, ndConvexCastResult* const results, ndInt32 count, ndUnsigned64 filterMask)
+{
+	D_TRACKTIME();
+	if (!count)
+	{
+		return;
+	}
+
+	Sync();
+	BuildQueryTree();
+
+	// all sweeps share the flattened tree, so there is no per cast setup other than the cast itself
+	const bool emptyTree = m_queryTree.IsEmpty();
+	auto CastShapes = ndMakeObject::ndFunction([this, casts, results, filterMask, emptyTree](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		D_TRACKTIME();
+		ndBatchConvexCastNotify callback;
+		callback.m_filterMask = filterMask;
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			const ndConvexCastQuery& query = casts[i];
+			callback.m_ignoreBody = query.m_ignoreBody;
+			callback.m_contacts.SetCount(0);
+			callback.m_param = ndFloat32(1.2f);
+			if (!emptyTree)
+			{
+				const ndVector velocA((query.m_dest - query.m_origin.m_posit) & ndVector::m_triplexMask);
+				const ndFastRay ray(ndVector::m_zero, velocA);
+				ConvexCast(callback, ray, *query.m_shape, query.m_origin, query.m_dest);
+			}
+
+			ndConvexCastResult& result = results[i];
+			if (callback.m_contacts.GetCount())
+			{
+				const ndContactPoint& contact = callback.m_contacts[0];
+				result.m_point = contact.m_point;
+				result.m_normal = contact.m_normal;
+				result.m_body = contact.m_body1;
+				result.m_param = callback.m_param;
+			}
+			else
+			{
+				result.m_point = ndVector::m_zero;
+				result.m_normal = ndVector::m_zero;
+				result.m_body = nullptr;
+				result.m_param = ndFloat32(1.2f);
+			}
+		}
+	});
+
+	Begin();
+	ParallelExecuteRange(count, CastShapes);
+	End();
+}
+
 void ndScene::BodiesInAabb(ndBodiesInAabbNotify& callback) const
 {
 	callback.m_bodyArray.SetCount(0);
 
-	if (m_rootNode)
+	// the notify does not carry a box, so every leaf is reported
+	BuildQueryTree();
+	const ndArray<ndBodyKinematic*>& bodies = m_queryTree.GetBodies();
+	for (ndInt32 i = 0; i < bodies.GetCount(); ++i)
+	{
+		ndBodyKinematic* const body = bodies[i];
+		if (callback.OnOverlap(body))
+		{
+			callback.m_bodyArray.PushBack(body);
+		}
+	}
+}
+
+void ndScene::BuildQueryTree() const
+{
+	// queries are const and may run concurrently, so the first one builds the tree under the lock
+	if (!m_queryTree.IsValid())
 	{
-		const ndSceneNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
-		stackPool[0] = m_rootNode;
-		ndScene::BodiesInAabb(callback, stackPool, 1);
+		ndScopeSpinLock lock(m_queryTreeLock);
+		if (!m_queryTree.IsValid())
+		{
+			m_queryTree.Build(m_rootNode);
+		}
 	}
 }
 
 void ndScene::SendBackgroundTask(ndBackgroundTask* const job)
 {
 	m_backgroundThread.SendTask(job);
-}
\ No newline at end of file
+}
+
+void ndScene::UpdateElevationRegion(ndBodyKinematic* const body, ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1, const ndReal* const elevation)
+{
+	// the edit is queued and applied at the beginning of the next update, so a region 
+	// with elevations can be posted from any thread, including while the scene updates.
+	// a null elevation means the map was edited in place, which is only safe between updates.
+	dAssert(x0 <= x1);
+	dAssert(z0 <= z1);
+	dAssert(((ndShape*)body->GetCollisionShape().GetShape())->GetAsShapeHeightfield());
+
+	ndScopeSpinLock lock(m_lock);
+	ndElevationRegion& region = m_elevationRegions.Append()->GetInfo();
+	region.m_body = body;
+	region.m_x0 = x0;
+	region.m_z0 = z0;
+	region.m_x1 = x1;
+	region.m_z1 = z1;
+	if (elevation)
+	{
+		const ndInt32 count = (x1 - x0 + 1) * (z1 - z0 + 1);
+		region.m_elevation.SetCount(count);
+		memcpy(&region.m_elevation[0], elevation, count * sizeof(ndReal));
+	}
+}
+
+void ndScene::ApplyElevationRegions()
+{
+	D_TRACKTIME();
+	// take the queued edits under the lock and apply them outside of it, 
+	// so that threads posting new edits do not wait for the terrain updates.
+	ndList<ndElevationRegion> regions;
+	{
+		ndScopeSpinLock lock(m_lock);
+		while (m_elevationRegions.GetCount())
+		{
+			ndList<ndElevationRegion>::ndNode* const node = m_elevationRegions.GetFirst();
+			m_elevationRegions.Unlink(node);
+			regions.Append(node);
+		}
+	}
+
+	while (regions.GetCount())
+	{
+		ndList<ndElevationRegion>::ndNode* const node = regions.GetFirst();
+		const ndElevationRegion& region = node->GetInfo();
+		ndBodyKinematic* const body = region.m_body;
+		ndShapeInstance& shapeInstance = body->GetCollisionShape();
+		ndShapeHeightfield* const heightfield = shapeInstance.GetShape()->GetAsShapeHeightfield();
+		const ndShapeInfo info(shapeInstance.GetShapeInfo());
+
+		const ndInt32 width = info.m_heightfield.m_width;
+		const ndInt32 x0 = dMax(region.m_x0, 0);
+		const ndInt32 z0 = dMax(region.m_z0, 0);
+		const ndInt32 x1 = dMin(region.m_x1, width - 1);
+		const ndInt32 z1 = dMin(region.m_z1, info.m_heightfield.m_height - 1);
+		if ((x0 <= x1) && (z0 <= z1))
+		{
+			if (region.m_elevation.GetCount())
+			{
+				const ndInt32 stride = region.m_x1 - region.m_x0 + 1;
+				heightfield->SetElevationRegion(region.m_x0, region.m_z0, region.m_x1, region.m_z1, &region.m_elevation[0], stride);
+			}
+			else
+			{
+				heightfield->UpdateElevationRegion(x0, z0, x1, z1);
+			}
+
+			// refit the terrain box and let the broad phase look for new pairs
+			body->m_sceneForceUpdate = 1;
+
+			// bodies touching the terrain over the region must recalculate their contacts
+			const ndVector padding(D_AABB_FAT_MARGIN, ndFloat32(0.0f), D_AABB_FAT_MARGIN, ndFloat32(0.0f));
+			const ndVector scale(info.m_heightfield.m_horizonalScale_x, ndFloat32(0.0f), info.m_heightfield.m_horizonalScale_z, ndFloat32(0.0f));
+			const ndVector regionP0(ndVector(ndFloat32(x0), ndFloat32(0.0f), ndFloat32(z0), ndFloat32(0.0f)) * scale - padding);
+			const ndVector regionP1(ndVector(ndFloat32(x1), ndFloat32(0.0f), ndFloat32(z1), ndFloat32(0.0f)) * scale + padding);
+			const ndMatrix invMatrix(shapeInstance.GetGlobalMatrix().Inverse());
+			const ndVector invScale(shapeInstance.GetInvScale());
+
+			const ndVector invalidateVeloc(ndFloat32(10.0f));
+			ndBodyKinematic::ndContactMap::Iterator it(body->GetContactMap());
+			for (it.Begin(); it; it++)
+			{
+				ndContact* const contact = *it;
+				ndBodyKinematic* const otherBody = (contact->GetBody0() == body) ? contact->GetBody1() : contact->GetBody0();
+
+				ndVector boxP0;
+				ndVector boxP1;
+				invMatrix.TransformBBox(otherBody->m_minAabb, otherBody->m_maxAabb, boxP0, boxP1);
+				const ndVector p0((boxP0 * invScale).GetMin(boxP1 * invScale));
+				const ndVector p1((boxP0 * invScale).GetMax(boxP1 * invScale));
+				if ((p0.m_x <= regionP1.m_x) && (p1.m_x >= regionP0.m_x) && (p0.m_z <= regionP1.m_z) && (p1.m_z >= regionP0.m_z))
+				{
+					contact->m_positAcc = invalidateVeloc;
+					otherBody->SetSleepState(false);
+				}
+			}
+		}
+		regions.Remove(node);
+	}
+}
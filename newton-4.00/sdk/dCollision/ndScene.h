@@ -26,6 +26,7 @@
 #include "ndBodyList.h"
 #include "ndSceneNode.h"
 #include "ndContactArray.h"
+#include "ndSceneQueryTree.h"
 
 #define D_SCENE_MAX_STACK_DEPTH		256
 #define D_PRUNE_CONTACT_TOLERANCE	ndFloat32 (5.0e-2f)
@@ -34,6 +35,10 @@ class ndWorld;
 class ndScene;
 class ndContact;
 class ndRayCastNotify;
+class ndRayCastQuery;
+class ndRayCastResult;
+class ndConvexCastQuery;
+class ndConvexCastResult;
 class ndContactNotify;
 class ndConvexCastNotify;
 class ndBodiesInAabbNotify;
@@ -76,6 +81,40 @@ class ndScene : public ndThreadPool
 		ndInt32 m_index;
 	};
 
+	class ndContactPairs
+	{
+		public:
+		ndContactPairs(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
+			:m_body0(body0)
+			,m_body1(body1)
+		{
+		}
+
+		ndBodyKinematic* m_body0;
+		ndBodyKinematic* m_body1;
+	};
+
+	class ndElevationRegion
+	{
+		public:
+		ndElevationRegion()
+			:m_elevation()
+			,m_body(nullptr)
+			,m_x0(0)
+			,m_z0(0)
+			,m_x1(0)
+			,m_z1(0)
+		{
+		}
+
+		ndArray<ndReal> m_elevation;
+		ndBodyKinematic* m_body;
+		ndInt32 m_x0;
+		ndInt32 m_z0;
+		ndInt32 m_x1;
+		ndInt32 m_z1;
+	};
+
 	public:
 	D_COLLISION_API virtual ~ndScene();
 
@@ -89,11 +128,14 @@ class ndScene : public ndThreadPool
 	ndArray<ndBodyKinematic*>& GetActiveBodyArray();
 	const ndArray<ndBodyKinematic*>& GetActiveBodyArray() const;
 
-	ndArray<ndUnsigned8>& GetScratchBuffer();
+	ndFrameArena& GetFrameArena();
 
 	ndFloat32 GetTimestep() const;
 	void SetTimestep(ndFloat32 timestep);
 
+	bool IsDeterministic() const;
+	void SetDeterministic(bool state);
+
 	ndBodyKinematic* GetSentinelBody() const;
 
 	D_COLLISION_API virtual bool AddBody(ndBodyKinematic* const body);
@@ -115,8 +157,11 @@ class ndScene : public ndThreadPool
 	D_COLLISION_API virtual void BodiesInAabb(ndBodiesInAabbNotify& callback) const;
 	D_COLLISION_API virtual bool RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, const ndVector& globalDest) const;
 	D_COLLISION_API virtual bool ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
+	D_COLLISION_API virtual void RayCast(const ndRayCastQuery* const rays, ndRayCastResult* const results, ndInt32 count, ndUnsigned64 filterMask);
+	D_COLLISION_API virtual void ConvexCast(const ndConvexCastQuery* const casts, ndConvexCastResult* const results, ndInt32 count, ndUnsigned64 filterMask);
 
 	D_COLLISION_API void SendBackgroundTask(ndBackgroundTask* const job);
+	D_COLLISION_API void UpdateElevationRegion(ndBodyKinematic* const body, ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1, const ndReal* const elevation);
 
 	protected:
 	D_COLLISION_API ndScene();
@@ -125,9 +170,9 @@ class ndScene : public ndThreadPool
 	bool ValidateContactCache(ndContact* const contact, const ndVector& timestep) const;
 	ndFloat32 CalculateSurfaceArea(const ndSceneNode* const node0, const ndSceneNode* const node1, ndVector& minBox, ndVector& maxBox) const;
 
-	D_COLLISION_API virtual void FindCollidingPairs(ndBodyKinematic* const body);
-	D_COLLISION_API virtual void FindCollidingPairsForward(ndBodyKinematic* const body);
-	D_COLLISION_API virtual void FindCollidingPairsBackward(ndBodyKinematic* const body);
+	D_COLLISION_API virtual void FindCollidingPairs(ndInt32 threadIndex, ndBodyKinematic* const body);
+	D_COLLISION_API virtual void FindCollidingPairsForward(ndInt32 threadIndex, ndBodyKinematic* const body);
+	D_COLLISION_API virtual void FindCollidingPairsBackward(ndInt32 threadIndex, ndBodyKinematic* const body);
 	void AddNode(ndSceneNode* const newNode);
 	void RemoveNode(ndSceneNode* const newNode);
 
@@ -152,13 +197,20 @@ class ndScene : public ndThreadPool
 	ndContact* FindContactJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const;
 	ndJointBilateralConstraint* FindBilateralJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const;
 
+	D_COLLISION_API void ApplyElevationRegions();
 	void UpdateFitness(ndFitnessList& fitness, ndFloat64& oldEntropy, ndSceneNode** const root);
-	void AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
-	void SubmitPairs(ndSceneBodyNode* const bodyNode, ndSceneNode* const node);
+	void UpdateParentAabb(ndSceneBodyNode* const bodyNode);
+	void CreateNewContacts();
+	void AddPair(ndInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1);
+	void SubmitPairs(ndInt32 threadIndex, ndSceneBodyNode* const bodyNode, ndSceneNode* const node);
 
 	void BodiesInAabb(ndBodiesInAabbNotify& callback, const ndSceneNode** stackPool, ndInt32 stack) const;
 	bool RayCast(ndRayCastNotify& callback, const ndSceneNode** stackPool, ndFloat32* const distance, ndInt32 stack, const ndFastRay& ray) const;
 	bool ConvexCast(ndConvexCastNotify& callback, const ndSceneNode** stackPool, ndFloat32* const distance, ndInt32 stack, const ndFastRay& ray, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
+	bool RayCast(ndRayCastNotify& callback, const ndFastRay& ray, ndInt32 rootIndex) const;
+	bool ConvexCast(ndConvexCastNotify& callback, const ndFastRay& ray, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
+	void ConvexCastBody(ndConvexCastNotify& callback, ndBodyKinematic* const body, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
+	void BuildQueryTree() const;
 
 	// claed from world updatee
 	D_COLLISION_API virtual void UpdateBodyList();
@@ -175,22 +227,28 @@ class ndScene : public ndThreadPool
 	ndBodyList m_bodyList;
 	ndContactArray m_contactArray;
 
-	ndArray<ndUnsigned8> m_scratchBuffer;
 	ndArray<ndBodyKinematic*> m_sceneBodyArray;
 	ndArray<ndConstraint*> m_activeConstraintArray;
 	ndList<ndBodyKinematic*> m_specialUpdateList;
+	ndList<ndElevationRegion> m_elevationRegions;
+	ndArray<ndArray<ndContactPairs>*> m_newPairs;
 	ndThreadBackgroundWorker m_backgroundThread;
+	ndFrameArena m_localFrameArena;
 	ndSpinLock m_lock;
+	mutable ndSpinLock m_queryTreeLock;
 	ndSceneNode* m_rootNode;
 	ndBodyKinematic* m_sentinelBody;
 	ndContactNotify* m_contactNotifyCallback;
+	ndFrameArena* m_frameArena;
 	ndFloat64 m_treeEntropy;
 	ndFitnessList m_fitness;
+	mutable ndSceneQueryTree m_queryTree;
 	ndFloat32 m_timestep;
 	ndUnsigned32 m_lru;
 	ndUnsigned32 m_forceBalanceSceneCounter;
 	ndUnsigned8 m_bodyListChanged;
 	ndUnsigned8 m_forceBalanceScene;
+	ndUnsigned8 m_deterministic;
 
 	static ndVector m_velocTol;
 	static ndVector m_linearContactError2;
@@ -201,6 +259,7 @@ class ndScene : public ndThreadPool
 	friend class ndRayCastNotify;
 	friend class ndConvexCastNotify;
 	friend class ndSkeletonContainer;
+	friend class ndWorldCheckpoint;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 inline bool ndScene::IsValid() const
@@ -219,9 +278,9 @@ inline ndInt32 ndScene::GetThreadCount() const
 	return pool.GetThreadCount();
 }
 
-inline ndArray<ndUnsigned8>& ndScene::GetScratchBuffer()
+inline ndFrameArena& ndScene::GetFrameArena()
 {
-	return m_scratchBuffer;
+	return *m_frameArena;
 }
 
 inline const ndBodyList& ndScene::GetBodyList() const
@@ -264,6 +323,16 @@ inline void ndScene::SetTimestep(ndFloat32 timestep)
 	m_timestep = timestep;
 }
 
+inline bool ndScene::IsDeterministic() const
+{
+	return m_deterministic ? true : false;
+}
+
+inline void ndScene::SetDeterministic(bool state)
+{
+	m_deterministic = state ? 1 : 0;
+}
+
 inline ndFloat32 ndScene::CalculateSurfaceArea(const ndSceneNode* const node0, const ndSceneNode* const node1, ndVector& minBox, ndVector& maxBox) const
 {
 	minBox = node0->m_minBox.GetMin(node1->m_minBox);
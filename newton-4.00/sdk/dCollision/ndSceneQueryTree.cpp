@@ -0,0 +1,128 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndCollisionStdafx.h"
+#include "ndSceneNode.h"
+#include "ndBodyKinematic.h"
+#include "ndSceneQueryTree.h"
+
+ndSceneQueryTree::ndSceneQueryTree()
+	:ndClassAlloc()
+	,m_nodes(256)
+	,m_bodies(256)
+	,m_valid(false)
+{
+}
+
+void ndSceneQueryTree::Build(const ndSceneNode* const root)
+{
+	D_TRACKTIME();
+	m_nodes.SetCount(0);
+	m_bodies.SetCount(0);
+	if (root)
+	{
+		BuildNode(root);
+	}
+	m_valid = true;
+}
+
+ndInt32 ndSceneQueryTree::BuildNode(const ndSceneNode* const node)
+{
+	ndInt32 count = 0;
+	const ndSceneNode* children[4];
+	if (node->GetBody())
+	{
+		children[0] = node;
+		count = 1;
+	}
+	else
+	{
+		// collapse the binary tree by opening the child with the largest area
+		// until the node has four children or all children are bodies.
+		children[0] = node->GetLeft();
+		children[1] = node->GetRight();
+		count = 2;
+		while (count < 4)
+		{
+			ndInt32 bestIndex = -1;
+			ndFloat32 bestArea = ndFloat32(-1.0f);
+			for (ndInt32 i = 0; i < count; ++i)
+			{
+				if (!children[i]->GetBody() && (children[i]->m_surfaceArea > bestArea))
+				{
+					bestIndex = i;
+					bestArea = children[i]->m_surfaceArea;
+				}
+			}
+			if (bestIndex < 0)
+			{
+				break;
+			}
+			const ndSceneNode* const parent = children[bestIndex];
+			children[bestIndex] = parent->GetLeft();
+			children[count] = parent->GetRight();
+			count++;
+		}
+	}
+
+	const ndInt32 index = m_nodes.GetCount();
+	m_nodes.PushBack(ndNode());
+
+	ndInt32 childIndex[4];
+	ndFloat32 boxes[6][4];
+	memset(boxes, 0, sizeof(boxes));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndSceneNode* const child = children[i];
+		dAssert(child);
+		ndBodyKinematic* const body = child->GetBody();
+		if (body)
+		{
+			childIndex[i] = -(m_bodies.GetCount() + 1);
+			m_bodies.PushBack(body);
+		}
+		else
+		{
+			childIndex[i] = BuildNode(child);
+		}
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			boxes[j][i] = child->m_minBox[j];
+			boxes[j + 3][i] = child->m_maxBox[j];
+		}
+	}
+
+	// the array may have been resized by the recursion
+	ndNode& flatNode = m_nodes[index];
+	flatNode.m_minX = ndVector(&boxes[0][0]);
+	flatNode.m_minY = ndVector(&boxes[1][0]);
+	flatNode.m_minZ = ndVector(&boxes[2][0]);
+	flatNode.m_maxX = ndVector(&boxes[3][0]);
+	flatNode.m_maxY = ndVector(&boxes[4][0]);
+	flatNode.m_maxZ = ndVector(&boxes[5][0]);
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		flatNode.m_child[i] = (i < count) ? childIndex[i] : 0;
+	}
+	flatNode.m_count = count;
+	return index;
+}
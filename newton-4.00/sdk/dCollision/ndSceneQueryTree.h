@@ -0,0 +1,167 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __ND_SCENE_QUERY_TREE_H__
+#define __ND_SCENE_QUERY_TREE_H__
+
+#include "ndCollisionStdafx.h"
+
+class ndSceneNode;
+class ndBodyKinematic;
+
+// flattened copy of the scene tree used by ray cast, convex cast and aabb queries.
+// each node stores the boxes of up to four children in struct of array form, 
+// so that a query can test all four with a few simd instructions.
+D_MSV_NEWTON_ALIGN_32
+class ndSceneQueryTree: public ndClassAlloc
+{
+	public:
+	D_MSV_NEWTON_ALIGN_32
+	class ndNode
+	{
+		public:
+		ndVector m_minX;
+		ndVector m_minY;
+		ndVector m_minZ;
+		ndVector m_maxX;
+		ndVector m_maxY;
+		ndVector m_maxZ;
+
+		// children >= 0 are node indices, children < 0 are body indices (-child - 1)
+		ndInt32 m_child[4];
+		ndInt32 m_count;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_MSV_NEWTON_ALIGN_32
+	class ndFastRay4
+	{
+		public:
+		// boxes are expanded by [boxP0, boxP1] before the ray test, for convex casting
+		ndFastRay4(const ndFastRay& ray, const ndVector& boxP0, const ndVector& boxP1);
+		ndVector BoxIntersect(const ndNode& node) const;
+
+		ndVector m_minOriginX;
+		ndVector m_minOriginY;
+		ndVector m_minOriginZ;
+		ndVector m_maxOriginX;
+		ndVector m_maxOriginY;
+		ndVector m_maxOriginZ;
+		ndVector m_dpInvX;
+		ndVector m_dpInvY;
+		ndVector m_dpInvZ;
+		ndVector m_isParallelX;
+		ndVector m_isParallelY;
+		ndVector m_isParallelZ;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_COLLISION_API ndSceneQueryTree();
+
+	D_COLLISION_API void Build(const ndSceneNode* const root);
+	void Invalidate();
+	bool IsValid() const;
+	bool IsEmpty() const;
+
+	const ndNode& GetNode(ndInt32 index) const;
+	ndBodyKinematic* GetBody(ndInt32 child) const;
+	const ndArray<ndBodyKinematic*>& GetBodies() const;
+
+	private:
+	ndInt32 BuildNode(const ndSceneNode* const node);
+
+	ndArray<ndNode> m_nodes;
+	ndArray<ndBodyKinematic*> m_bodies;
+	ndAtomic<bool> m_valid;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline void ndSceneQueryTree::Invalidate()
+{
+	m_valid = false;
+}
+
+inline bool ndSceneQueryTree::IsValid() const
+{
+	return m_valid;
+}
+
+inline bool ndSceneQueryTree::IsEmpty() const
+{
+	return m_nodes.GetCount() == 0;
+}
+
+inline const ndSceneQueryTree::ndNode& ndSceneQueryTree::GetNode(ndInt32 index) const
+{
+	dAssert(index >= 0);
+	return m_nodes[index];
+}
+
+inline ndBodyKinematic* ndSceneQueryTree::GetBody(ndInt32 child) const
+{
+	dAssert(child < 0);
+	return m_bodies[-child - 1];
+}
+
+inline const ndArray<ndBodyKinematic*>& ndSceneQueryTree::GetBodies() const
+{
+	return m_bodies;
+}
+
+inline ndSceneQueryTree::ndFastRay4::ndFastRay4(const ndFastRay& ray, const ndVector& boxP0, const ndVector& boxP1)
+{
+	// the minimum faces of the box are displaced by boxP1 and the maximum faces by boxP0,
+	// which is the same as moving the ray origin the opposite way.
+	const ndVector minOrigin(ray.m_p0 + boxP1);
+	const ndVector maxOrigin(ray.m_p0 + boxP0);
+	m_minOriginX = ndVector(minOrigin.m_x);
+	m_minOriginY = ndVector(minOrigin.m_y);
+	m_minOriginZ = ndVector(minOrigin.m_z);
+	m_maxOriginX = ndVector(maxOrigin.m_x);
+	m_maxOriginY = ndVector(maxOrigin.m_y);
+	m_maxOriginZ = ndVector(maxOrigin.m_z);
+	m_dpInvX = ndVector(ray.m_dpInv.m_x);
+	m_dpInvY = ndVector(ray.m_dpInv.m_y);
+	m_dpInvZ = ndVector(ray.m_dpInv.m_z);
+	m_isParallelX = ndVector(dAbs(ray.m_diff.m_x)) < ndVector(ndFloat32(1.0e-8f));
+	m_isParallelY = ndVector(dAbs(ray.m_diff.m_y)) < ndVector(ndFloat32(1.0e-8f));
+	m_isParallelZ = ndVector(dAbs(ray.m_diff.m_z)) < ndVector(ndFloat32(1.0e-8f));
+}
+
+inline ndVector ndSceneQueryTree::ndFastRay4::BoxIntersect(const ndNode& node) const
+{
+	// same slab test as ndFastRay::BoxIntersect, four boxes at the time
+	const ndVector tx0(m_dpInvX * (node.m_minX - m_minOriginX));
+	const ndVector tx1(m_dpInvX * (node.m_maxX - m_maxOriginX));
+	const ndVector ty0(m_dpInvY * (node.m_minY - m_minOriginY));
+	const ndVector ty1(m_dpInvY * (node.m_maxY - m_maxOriginY));
+	const ndVector tz0(m_dpInvZ * (node.m_minZ - m_minOriginZ));
+	const ndVector tz1(m_dpInvZ * (node.m_maxZ - m_maxOriginZ));
+
+	const ndVector t0(ndVector::m_zero.GetMax(tx0.GetMin(tx1)).GetMax(ty0.GetMin(ty1)).GetMax(tz0.GetMin(tz1)));
+	const ndVector t1(ndVector::m_one.GetMin(tx0.GetMax(tx1)).GetMin(ty0.GetMax(ty1)).GetMin(tz0.GetMax(tz1)));
+
+	const ndVector parallelX(((m_minOriginX <= node.m_minX) | (m_maxOriginX >= node.m_maxX)) & m_isParallelX);
+	const ndVector parallelY(((m_minOriginY <= node.m_minY) | (m_maxOriginY >= node.m_maxY)) & m_isParallelY);
+	const ndVector parallelZ(((m_minOriginZ <= node.m_minZ) | (m_maxOriginZ >= node.m_maxZ)) & m_isParallelZ);
+	const ndVector mask((t0 < t1).AndNot(parallelX | parallelY | parallelZ));
+	return ndVector(ndFloat32(1.2f)).Select(t0, mask);
+}
+
+#endif
@@ -50,6 +50,59 @@ ndInt32 ndShapeHeightfield::m_verticalEdgeMap[][7] =
 	{ 1 * 9 + 0, 0 * 9 + 1, 1 * 9 + 4, 1 * 9 + 7, 0 * 9 + 7, 1 * 9 + 4, 0 * 9 + 4 }
 };
 
+ndHeightfieldTile::ndHeightfieldTile()
+	:ndClassAlloc()
+	,m_elevation()
+	,m_atributes()
+	,m_offset(ndFloat32(0.0f))
+	,m_scale(ndFloat32(0.0f))
+	,m_atribute(0)
+{
+}
+
+void ndHeightfieldTile::Quantize(const ndReal* const elevation, const ndInt8* const atributes, ndInt32 count_x, ndInt32 count_z, ndInt32 stride)
+{
+	dAssert((count_x >= 1) && (count_x <= D_HEIGHTFIELD_TILE_SIZE));
+	dAssert((count_z >= 1) && (count_z <= D_HEIGHTFIELD_TILE_SIZE));
+
+	ndFloat32 minHeight = ndFloat32(1.0e10f);
+	ndFloat32 maxHeight = ndFloat32(-1.0e10f);
+	bool uniformAtribute = true;
+	for (ndInt32 z = 0; z < count_z; ++z)
+	{
+		for (ndInt32 x = 0; x < count_x; ++x)
+		{
+			const ndFloat32 height = ndFloat32(elevation[z * stride + x]);
+			minHeight = dMin(height, minHeight);
+			maxHeight = dMax(height, maxHeight);
+			uniformAtribute = uniformAtribute && (!atributes || (atributes[z * stride + x] == atributes[0]));
+		}
+	}
+
+	m_offset = minHeight;
+	m_scale = (maxHeight - minHeight) / ndFloat32(0xffff);
+	const ndFloat32 invScale = (m_scale > ndFloat32(0.0f)) ? ndFloat32(1.0f) / m_scale : ndFloat32(0.0f);
+
+	// vertices past the end of the map repeat the last row and column
+	m_elevation.SetCount(D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE);
+	m_atributes.SetCount(uniformAtribute ? 0 : D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE);
+	m_atribute = atributes ? atributes[0] : 0;
+	for (ndInt32 z = 0; z < D_HEIGHTFIELD_TILE_SIZE; ++z)
+	{
+		const ndInt32 row = dMin(z, count_z - 1) * stride;
+		for (ndInt32 x = 0; x < D_HEIGHTFIELD_TILE_SIZE; ++x)
+		{
+			const ndInt32 index = row + dMin(x, count_x - 1);
+			const ndInt32 value = ndInt32((ndFloat32(elevation[index]) - m_offset) * invScale + ndFloat32(0.5f));
+			m_elevation[(z << D_HEIGHTFIELD_TILE_SHIFT) + x] = ndUnsigned16(dClamp(value, 0, 0xffff));
+			if (!uniformAtribute)
+			{
+				m_atributes[(z << D_HEIGHTFIELD_TILE_SHIFT) + x] = atributes[index];
+			}
+		}
+	}
+}
+
 ndShapeHeightfield::ndShapeHeightfield(
 	ndInt32 width, ndInt32 height, ndGridConstruction constructionMode,
 	ndFloat32 horizontalScale_x, ndFloat32 horizontalScale_z)
@@ -58,6 +111,15 @@ ndShapeHeightfield::ndShapeHeightfield(
 	,m_maxBox(ndVector::m_zero)
 	,m_atributeMap(width * height)
 	,m_elevationMap(width * height)
+	,m_elevationPyramid()
+	,m_pyramidLevelsCount(0)
+	,m_tiles()
+	,m_tileLoader(nullptr)
+	,m_tileLock()
+	,m_tileCount_x(0)
+	,m_tileCount_z(0)
+	,m_tileLru(0)
+	,m_assetRevision(0)
 	,m_horizontalScale_x(horizontalScale_x)
 	,m_horizontalScale_z(horizontalScale_z)
 	,m_horizontalScaleInv_x(ndFloat32(1.0f) / horizontalScale_x)
@@ -84,6 +146,15 @@ ndShapeHeightfield::ndShapeHeightfield(const ndLoadSaveBase::ndLoadDescriptor& d
 	,m_maxBox(ndVector::m_zero)
 	,m_atributeMap(0)
 	,m_elevationMap(0)
+	,m_elevationPyramid()
+	,m_pyramidLevelsCount(0)
+	,m_tiles()
+	,m_tileLoader(nullptr)
+	,m_tileLock()
+	,m_tileCount_x(0)
+	,m_tileCount_z(0)
+	,m_tileLru(0)
+	,m_assetRevision(0)
 	,m_horizontalScale_x(ndFloat32(0.0f))
 	,m_horizontalScale_z(ndFloat32(0.0f))
 	,m_horizontalScaleInv_x(ndFloat32(0.0f))
@@ -124,6 +195,7 @@ ndShapeHeightfield::ndShapeHeightfield(const ndLoadSaveBase::ndLoadDescriptor& d
 
 ndShapeHeightfield::~ndShapeHeightfield(void)
 {
+	ReleaseTiles();
 }
 
 void ndShapeHeightfield::Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const
@@ -144,17 +216,47 @@ void ndShapeHeightfield::Save(const ndLoadSaveBase::ndSaveDescriptor& desc) cons
 	xmlSaveParam(childNode, "height", m_height);
 	xmlSaveParam(childNode, "diagonalMode", ndInt32 (m_diagonalMode));
 
-	char filePathName[1024 * 2];
-	sprintf(filePathName, "%s/%s", desc.m_assetPath, fileName);
 	desc.m_assetIndex++;
+	if (desc.m_saveAssets)
+	{
+		char filePathName[1024 * 2];
+		sprintf(filePathName, "%s/%s", desc.m_assetPath, fileName);
+		ndArray<char> data;
+		GetAssetData(data);
+		SaveBinaryFile(filePathName, &data[0], size_t(data.GetCount()));
+	}
+}
 
-	FILE* const file = fopen(filePathName, "wb");
-	if (file) 
+bool ndShapeHeightfield::GetAssetData(ndArray<char>& data) const
+{
+	// the elevation rows followed by the attributes
+	const ndInt32 elevationSize = ndInt32(m_width * m_height * sizeof(ndReal));
+	data.SetCount(elevationSize + m_width * m_height * ndInt32(sizeof(ndInt8)));
+	ndReal* const elevation = (ndReal*)&data[0];
+	ndInt8* const atributes = (ndInt8*)&data[elevationSize];
+	if (m_tiles.GetCount())
 	{
-		fwrite(&m_elevationMap[0], sizeof(ndReal), m_elevationMap.GetCount(), file);
-		fwrite(&m_atributeMap[0], sizeof(ndInt8), m_atributeMap.GetCount(), file);
-		fclose(file);
+		// tiled maps are saved expanded, so they load as a regular elevation map
+		for (ndInt32 z = 0; z < m_height; ++z)
+		{
+			for (ndInt32 x = 0; x < m_width; ++x)
+			{
+				elevation[z * m_width + x] = ndReal(GetElevation(x, z));
+				atributes[z * m_width + x] = GetAtribute(x, z);
+			}
+		}
 	}
+	else
+	{
+		memcpy(elevation, &m_elevationMap[0], m_elevationMap.GetCount() * sizeof(ndReal));
+		memcpy(atributes, &m_atributeMap[0], m_atributeMap.GetCount() * sizeof(ndInt8));
+	}
+	return true;
+}
+
+ndUnsigned32 ndShapeHeightfield::GetAssetRevision() const
+{
+	return m_assetRevision;
 }
 
 ndShapeInfo ndShapeHeightfield::GetShapeInfo() const
@@ -166,34 +268,452 @@ ndShapeInfo ndShapeHeightfield::GetShapeInfo() const
 	info.m_heightfield.m_gridsDiagonals = m_diagonalMode;
 	info.m_heightfield.m_horizonalScale_x = m_horizontalScale_x;
 	info.m_heightfield.m_horizonalScale_z = m_horizontalScale_z;
-	info.m_heightfield.m_elevation = (ndReal*)&m_elevationMap[0];
-	info.m_heightfield.m_atributes = (ndInt8*)&m_atributeMap[0];
+	// tiled maps have no flat elevation map, they are read with GetElevation and GetAtribute
+	info.m_heightfield.m_elevation = m_tiles.GetCount() ? nullptr : (ndReal*)&m_elevationMap[0];
+	info.m_heightfield.m_atributes = m_tiles.GetCount() ? nullptr : (ndInt8*)&m_atributeMap[0];
 
 	return info;
 }
 
 void ndShapeHeightfield::CalculateLocalObb()
 {
-	ndReal y0 = ndReal (1.0e10f);
-	ndReal y1 = -ndReal(1.0e10f);
-	for (ndInt32 i = m_elevationMap.GetCount()-1; i >= 0; --i)
-	{
-		y0 = dMin(y0, m_elevationMap[i]);
-		y1 = dMax(y1, m_elevationMap[i]);
-	}
+	BuildElevationPyramid();
+	UpdateLocalObb();
+}
 
-	m_minBox = ndVector(ndFloat32(0.0f), ndFloat32 (y0), ndFloat32(0.0f), ndFloat32(0.0f));
-	m_maxBox = ndVector(ndFloat32(m_width-1) * m_horizontalScale_x, ndFloat32(y1), ndFloat32(m_height-1) * m_horizontalScale_z, ndFloat32(0.0f));
+void ndShapeHeightfield::UpdateLocalObb()
+{
+	const ndPyramidLevel& root = m_pyramidLevels[m_pyramidLevelsCount - 1];
+	const ndElevationBound& bound = m_elevationPyramid[root.m_start];
+
+	m_minBox = ndVector(ndFloat32(0.0f), ndFloat32 (bound.m_min), ndFloat32(0.0f), ndFloat32(0.0f));
+	m_maxBox = ndVector(ndFloat32(m_width-1) * m_horizontalScale_x, ndFloat32(bound.m_max), ndFloat32(m_height-1) * m_horizontalScale_z, ndFloat32(0.0f));
 
 	m_boxSize = (m_maxBox - m_minBox) * ndVector::m_half;
 	m_boxOrigin = (m_maxBox + m_minBox) * ndVector::m_half;
 }
 
+void ndShapeHeightfield::BuildElevationPyramid()
+{
+	// each leaf bounds a block of (1 << D_HEIGHTFIELD_PYRAMID_SHIFT) square cells, 
+	// each level above merges 2 x 2 nodes until a single root remains
+	ndInt32 width = (m_width - 1 + (1 << D_HEIGHTFIELD_PYRAMID_SHIFT) - 1) >> D_HEIGHTFIELD_PYRAMID_SHIFT;
+	ndInt32 height = (m_height - 1 + (1 << D_HEIGHTFIELD_PYRAMID_SHIFT) - 1) >> D_HEIGHTFIELD_PYRAMID_SHIFT;
+
+	ndInt32 start = 0;
+	m_pyramidLevelsCount = 0;
+	do
+	{
+		dAssert(m_pyramidLevelsCount < D_HEIGHTFIELD_PYRAMID_LEVELS);
+		ndPyramidLevel& level = m_pyramidLevels[m_pyramidLevelsCount];
+		level.m_start = start;
+		level.m_width = width;
+		level.m_height = height;
+		m_pyramidLevelsCount++;
+		start += width * height;
+		width = (width + 1) >> 1;
+		height = (height + 1) >> 1;
+	} while ((m_pyramidLevels[m_pyramidLevelsCount - 1].m_width > 1) || (m_pyramidLevels[m_pyramidLevelsCount - 1].m_height > 1));
+
+	m_elevationPyramid.SetCount(start);
+	UpdateElevationPyramid(0, 0, m_width - 1, m_height - 1);
+}
+
+void ndShapeHeightfield::UpdateElevationPyramid(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1)
+{
+	// a vertex on a block boundary is shared by the blocks on both sides
+	const ndPyramidLevel& leafLevel = m_pyramidLevels[0];
+	ndInt32 nx0 = dMax(x0 - 1, 0) >> D_HEIGHTFIELD_PYRAMID_SHIFT;
+	ndInt32 nz0 = dMax(z0 - 1, 0) >> D_HEIGHTFIELD_PYRAMID_SHIFT;
+	ndInt32 nx1 = dMin(x1 >> D_HEIGHTFIELD_PYRAMID_SHIFT, leafLevel.m_width - 1);
+	ndInt32 nz1 = dMin(z1 >> D_HEIGHTFIELD_PYRAMID_SHIFT, leafLevel.m_height - 1);
+
+	for (ndInt32 nz = nz0; nz <= nz1; ++nz)
+	{
+		const ndInt32 vz0 = nz << D_HEIGHTFIELD_PYRAMID_SHIFT;
+		const ndInt32 vz1 = dMin((nz + 1) << D_HEIGHTFIELD_PYRAMID_SHIFT, m_height - 1);
+		for (ndInt32 nx = nx0; nx <= nx1; ++nx)
+		{
+			const ndInt32 vx0 = nx << D_HEIGHTFIELD_PYRAMID_SHIFT;
+			const ndInt32 vx1 = dMin((nx + 1) << D_HEIGHTFIELD_PYRAMID_SHIFT, m_width - 1);
+
+			ndReal minVal = ndReal(1.0e10f);
+			ndReal maxVal = -ndReal(1.0e10f);
+			ScanElevation(vx0, vx1, vz0, vz1, minVal, maxVal);
+			ndElevationBound& bound = m_elevationPyramid[leafLevel.m_start + nz * leafLevel.m_width + nx];
+			bound.m_min = minVal;
+			bound.m_max = maxVal;
+		}
+	}
+
+	for (ndInt32 i = 1; i < m_pyramidLevelsCount; ++i)
+	{
+		const ndPyramidLevel& childLevel = m_pyramidLevels[i - 1];
+		const ndPyramidLevel& level = m_pyramidLevels[i];
+		nx0 = nx0 >> 1;
+		nz0 = nz0 >> 1;
+		nx1 = nx1 >> 1;
+		nz1 = nz1 >> 1;
+		for (ndInt32 nz = nz0; nz <= nz1; ++nz)
+		{
+			for (ndInt32 nx = nx0; nx <= nx1; ++nx)
+			{
+				ndReal minVal = ndReal(1.0e10f);
+				ndReal maxVal = -ndReal(1.0e10f);
+				const ndInt32 cz1 = dMin(nz * 2 + 1, childLevel.m_height - 1);
+				const ndInt32 cx1 = dMin(nx * 2 + 1, childLevel.m_width - 1);
+				for (ndInt32 cz = nz * 2; cz <= cz1; ++cz)
+				{
+					for (ndInt32 cx = nx * 2; cx <= cx1; ++cx)
+					{
+						const ndElevationBound& child = m_elevationPyramid[childLevel.m_start + cz * childLevel.m_width + cx];
+						minVal = dMin(child.m_min, minVal);
+						maxVal = dMax(child.m_max, maxVal);
+					}
+				}
+				ndElevationBound& bound = m_elevationPyramid[level.m_start + nz * level.m_width + nx];
+				bound.m_min = minVal;
+				bound.m_max = maxVal;
+			}
+		}
+	}
+}
+
 void ndShapeHeightfield::UpdateElevationMapAabb()
 {
+	m_assetRevision++;
 	CalculateLocalObb();
 }
 
+void ndShapeHeightfield::UpdateElevationRegion(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1)
+{
+	// only the pyramid nodes over the edited vertices are rebuilt
+	dAssert(x0 <= x1);
+	dAssert(z0 <= z1);
+	m_assetRevision++;
+	x0 = dMax(x0, 0);
+	z0 = dMax(z0, 0);
+	x1 = dMin(x1, m_width - 1);
+	z1 = dMin(z1, m_height - 1);
+	if ((x0 <= x1) && (z0 <= z1))
+	{
+		UpdateElevationPyramid(x0, z0, x1, z1);
+		UpdateLocalObb();
+	}
+}
+
+void ndShapeHeightfield::SetElevationRegion(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1, const ndReal* const elevation, ndInt32 stride)
+{
+	dAssert(x0 <= x1);
+	dAssert(z0 <= z1);
+	const ndInt32 cx0 = dMax(x0, 0);
+	const ndInt32 cz0 = dMax(z0, 0);
+	const ndInt32 cx1 = dMin(x1, m_width - 1);
+	const ndInt32 cz1 = dMin(z1, m_height - 1);
+	if ((cx0 > cx1) || (cz0 > cz1))
+	{
+		return;
+	}
+
+	if (!m_tiles.GetCount())
+	{
+		for (ndInt32 z = cz0; z <= cz1; ++z)
+		{
+			memcpy(&m_elevationMap[z * m_width + cx0], &elevation[(z - z0) * stride + cx0 - x0], (cx1 - cx0 + 1) * sizeof(ndReal));
+		}
+		UpdateElevationRegion(cx0, cz0, cx1, cz1);
+		return;
+	}
+
+	// edited tiles are expanded, modified and quantized again over their new range,
+	// since that moves all the tile elevations the bounds are updated for the whole tiles.
+	ndReal heights[D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE];
+	ndInt8 atributes[D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE];
+	const ndInt32 tx0 = cx0 >> D_HEIGHTFIELD_TILE_SHIFT;
+	const ndInt32 tz0 = cz0 >> D_HEIGHTFIELD_TILE_SHIFT;
+	const ndInt32 tx1 = cx1 >> D_HEIGHTFIELD_TILE_SHIFT;
+	const ndInt32 tz1 = cz1 >> D_HEIGHTFIELD_TILE_SHIFT;
+	for (ndInt32 tz = tz0; tz <= tz1; ++tz)
+	{
+		for (ndInt32 tx = tx0; tx <= tx1; ++tx)
+		{
+			ndHeightfieldTile* const tile = (ndHeightfieldTile*)GetTile(tx, tz);
+			for (ndInt32 i = 0; i < D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE; ++i)
+			{
+				heights[i] = ndReal(tile->GetElevation(i));
+				atributes[i] = tile->GetAtribute(i);
+			}
+
+			const ndInt32 baseX = tx << D_HEIGHTFIELD_TILE_SHIFT;
+			const ndInt32 baseZ = tz << D_HEIGHTFIELD_TILE_SHIFT;
+			const ndInt32 xEnd = dMin(cx1, baseX + D_HEIGHTFIELD_TILE_SIZE - 1);
+			const ndInt32 zEnd = dMin(cz1, baseZ + D_HEIGHTFIELD_TILE_SIZE - 1);
+			for (ndInt32 z = dMax(cz0, baseZ); z <= zEnd; ++z)
+			{
+				for (ndInt32 x = dMax(cx0, baseX); x <= xEnd; ++x)
+				{
+					heights[((z - baseZ) << D_HEIGHTFIELD_TILE_SHIFT) + x - baseX] = elevation[(z - z0) * stride + x - x0];
+				}
+			}
+			tile->Quantize(heights, atributes, D_HEIGHTFIELD_TILE_SIZE, D_HEIGHTFIELD_TILE_SIZE, D_HEIGHTFIELD_TILE_SIZE);
+
+			ndTileEntry& entry = m_tiles[tz * m_tileCount_x + tx];
+			entry.m_minHeight = ndReal(tile->m_offset);
+			entry.m_maxHeight = ndReal(tile->m_offset + tile->m_scale * ndFloat32(0xffff));
+			entry.m_pinned = 1;
+		}
+	}
+
+	const ndInt32 ex1 = dMin(((tx1 + 1) << D_HEIGHTFIELD_TILE_SHIFT) - 1, m_width - 1);
+	const ndInt32 ez1 = dMin(((tz1 + 1) << D_HEIGHTFIELD_TILE_SHIFT) - 1, m_height - 1);
+	UpdateElevationRegion(tx0 << D_HEIGHTFIELD_TILE_SHIFT, tz0 << D_HEIGHTFIELD_TILE_SHIFT, ex1, ez1);
+}
+
+void ndShapeHeightfield::ScanElevation(ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndReal& minHeight, ndReal& maxHeight) const
+{
+	if (!m_tiles.GetCount())
+	{
+		for (ndInt32 z = z0; z <= z1; ++z)
+		{
+			const ndReal* const row = &m_elevationMap[z * m_width];
+			for (ndInt32 x = x0; x <= x1; ++x)
+			{
+				minHeight = dMin(row[x], minHeight);
+				maxHeight = dMax(row[x], maxHeight);
+			}
+		}
+		return;
+	}
+
+	// resident tiles are scanned, tiles not yet loaded contribute the bounds reported by the loader
+	for (ndInt32 tz = z0 >> D_HEIGHTFIELD_TILE_SHIFT; tz <= (z1 >> D_HEIGHTFIELD_TILE_SHIFT); ++tz)
+	{
+		for (ndInt32 tx = x0 >> D_HEIGHTFIELD_TILE_SHIFT; tx <= (x1 >> D_HEIGHTFIELD_TILE_SHIFT); ++tx)
+		{
+			const ndTileEntry& entry = m_tiles[tz * m_tileCount_x + tx];
+			const ndHeightfieldTile* const tile = entry.m_tile.load(std::memory_order_acquire);
+			if (tile)
+			{
+				const ndInt32 baseX = tx << D_HEIGHTFIELD_TILE_SHIFT;
+				const ndInt32 baseZ = tz << D_HEIGHTFIELD_TILE_SHIFT;
+				const ndInt32 xStart = dMax(x0 - baseX, 0);
+				const ndInt32 xEnd = dMin(x1 - baseX, D_HEIGHTFIELD_TILE_SIZE - 1);
+				const ndInt32 zEnd = dMin(z1 - baseZ, D_HEIGHTFIELD_TILE_SIZE - 1);
+
+				ndUnsigned16 minValue = 0xffff;
+				ndUnsigned16 maxValue = 0;
+				for (ndInt32 z = dMax(z0 - baseZ, 0); z <= zEnd; ++z)
+				{
+					const ndUnsigned16* const row = &tile->m_elevation[z << D_HEIGHTFIELD_TILE_SHIFT];
+					for (ndInt32 x = xStart; x <= xEnd; ++x)
+					{
+						minValue = dMin(row[x], minValue);
+						maxValue = dMax(row[x], maxValue);
+					}
+				}
+				minHeight = dMin(ndReal(tile->m_offset + tile->m_scale * ndFloat32(minValue)), minHeight);
+				maxHeight = dMax(ndReal(tile->m_offset + tile->m_scale * ndFloat32(maxValue)), maxHeight);
+			}
+			else
+			{
+				minHeight = dMin(entry.m_minHeight, minHeight);
+				maxHeight = dMax(entry.m_maxHeight, maxHeight);
+			}
+		}
+	}
+}
+
+const ndHeightfieldTile* ndShapeHeightfield::PageTile(ndInt32 tile_x, ndInt32 tile_z) const
+{
+	ndTileEntry& entry = m_tiles[tile_z * m_tileCount_x + tile_x];
+	ndHeightfieldTile* tile = entry.m_tile.load(std::memory_order_acquire);
+	if (!tile)
+	{
+		// the loader runs outside the lock, so the other collision threads are 
+		// not stalled by the load, the tile is published only after it is filled. 
+		dAssert(m_tileLoader);
+		ndHeightfieldTile* const newTile = new ndHeightfieldTile();
+		m_tileLoader->LoadTile(tile_x, tile_z, *newTile);
+		dAssert(newTile->m_elevation.GetCount() == D_HEIGHTFIELD_TILE_SIZE * D_HEIGHTFIELD_TILE_SIZE);
+		{
+			ndScopeSpinLock lock(m_tileLock);
+			tile = entry.m_tile.load(std::memory_order_relaxed);
+			if (!tile)
+			{
+				entry.m_tile.store(newTile, std::memory_order_release);
+				tile = newTile;
+			}
+		}
+		if (tile != newTile)
+		{
+			// another thread loaded the same tile first
+			delete newTile;
+		}
+	}
+	return tile;
+}
+
+void ndShapeHeightfield::ReleaseTiles()
+{
+	for (ndInt32 i = 0; i < m_tiles.GetCount(); ++i)
+	{
+		ndHeightfieldTile* const tile = m_tiles[i].m_tile;
+		if (tile)
+		{
+			delete tile;
+		}
+	}
+	m_tiles.SetCount(0);
+	if (m_tileLoader)
+	{
+		delete m_tileLoader;
+		m_tileLoader = nullptr;
+	}
+}
+
+void ndShapeHeightfield::QuantizeElevationMap()
+{
+	if (m_tiles.GetCount())
+	{
+		return;
+	}
+
+	m_assetRevision++;
+	m_tileCount_x = (m_width + D_HEIGHTFIELD_TILE_SIZE - 1) >> D_HEIGHTFIELD_TILE_SHIFT;
+	m_tileCount_z = (m_height + D_HEIGHTFIELD_TILE_SIZE - 1) >> D_HEIGHTFIELD_TILE_SHIFT;
+	m_tiles.SetCount(m_tileCount_x * m_tileCount_z);
+	for (ndInt32 tz = 0; tz < m_tileCount_z; ++tz)
+	{
+		for (ndInt32 tx = 0; tx < m_tileCount_x; ++tx)
+		{
+			const ndInt32 x0 = tx << D_HEIGHTFIELD_TILE_SHIFT;
+			const ndInt32 z0 = tz << D_HEIGHTFIELD_TILE_SHIFT;
+			const ndInt32 base = z0 * m_width + x0;
+			ndHeightfieldTile* const tile = new ndHeightfieldTile();
+			tile->Quantize(&m_elevationMap[base], &m_atributeMap[base], dMin(D_HEIGHTFIELD_TILE_SIZE, m_width - x0), dMin(D_HEIGHTFIELD_TILE_SIZE, m_height - z0), m_width);
+
+			// tiles without a loader can not be paged out
+			ndTileEntry& entry = m_tiles[tz * m_tileCount_x + tx];
+			entry.m_tile = tile;
+			entry.m_minHeight = ndReal(tile->m_offset);
+			entry.m_maxHeight = ndReal(tile->m_offset + tile->m_scale * ndFloat32(0xffff));
+			entry.m_lru = m_tileLru;
+			entry.m_pinned = 1;
+		}
+	}
+
+	ndArray<ndReal> elevationMap;
+	ndArray<ndInt8> atributeMap;
+	m_elevationMap.Swap(elevationMap);
+	m_atributeMap.Swap(atributeMap);
+	CalculateLocalObb();
+}
+
+void ndShapeHeightfield::SetTileLoader(ndHeightfieldTileLoader* const loader)
+{
+	dAssert(loader);
+	ReleaseTiles();
+	m_tileLoader = loader;
+	m_assetRevision++;
+
+	m_tileCount_x = (m_width + D_HEIGHTFIELD_TILE_SIZE - 1) >> D_HEIGHTFIELD_TILE_SHIFT;
+	m_tileCount_z = (m_height + D_HEIGHTFIELD_TILE_SIZE - 1) >> D_HEIGHTFIELD_TILE_SHIFT;
+	m_tiles.SetCount(m_tileCount_x * m_tileCount_z);
+	for (ndInt32 tz = 0; tz < m_tileCount_z; ++tz)
+	{
+		for (ndInt32 tx = 0; tx < m_tileCount_x; ++tx)
+		{
+			ndFloat32 minHeight = ndFloat32(0.0f);
+			ndFloat32 maxHeight = ndFloat32(0.0f);
+			m_tileLoader->GetTileBounds(tx, tz, minHeight, maxHeight);
+			dAssert(minHeight <= maxHeight);
+
+			ndTileEntry& entry = m_tiles[tz * m_tileCount_x + tx];
+			entry.m_tile = nullptr;
+			entry.m_minHeight = ndReal(minHeight);
+			entry.m_maxHeight = ndReal(maxHeight);
+			entry.m_lru = m_tileLru;
+			entry.m_pinned = 0;
+		}
+	}
+
+	ndArray<ndReal> elevationMap;
+	ndArray<ndInt8> atributeMap;
+	m_elevationMap.Swap(elevationMap);
+	m_atributeMap.Swap(atributeMap);
+	CalculateLocalObb();
+}
+
+ndInt32 ndShapeHeightfield::GetResidentTilesCount() const
+{
+	ndInt32 count = 0;
+	for (ndInt32 i = 0; i < m_tiles.GetCount(); ++i)
+	{
+		count += m_tiles[i].m_tile ? 1 : 0;
+	}
+	return count;
+}
+
+ndInt32 ndShapeHeightfield::EvictTiles(ndInt32 maxResidentTiles)
+{
+	class ndCompareTiles
+	{
+		public:
+		ndInt32 Compare(const ndInt32 indexA, const ndInt32 indexB, void* const context) const
+		{
+			const ndTileEntry* const tiles = (ndTileEntry*)context;
+			const ndUnsigned32 lruA = tiles[indexA].m_lru;
+			const ndUnsigned32 lruB = tiles[indexB].m_lru;
+			if (lruA < lruB)
+			{
+				return -1;
+			}
+			else if (lruA > lruB)
+			{
+				return 1;
+			}
+			return indexA - indexB;
+		}
+	};
+
+	ndInt32 evicted = 0;
+	if (m_tileLoader)
+	{
+		ndInt32 residentCount = 0;
+		ndArray<ndInt32> candidates;
+		for (ndInt32 i = 0; i < m_tiles.GetCount(); ++i)
+		{
+			const ndTileEntry& entry = m_tiles[i];
+			if (entry.m_tile)
+			{
+				residentCount++;
+				if (!entry.m_pinned)
+				{
+					candidates.PushBack(i);
+				}
+			}
+		}
+
+		if ((residentCount > maxResidentTiles) && candidates.GetCount())
+		{
+			ndSort<ndInt32, ndCompareTiles>(&candidates[0], candidates.GetCount(), &m_tiles[0]);
+			for (ndInt32 i = 0; (i < candidates.GetCount()) && (residentCount > maxResidentTiles); ++i)
+			{
+				ndTileEntry& entry = m_tiles[candidates[i]];
+				ndHeightfieldTile* const tile = entry.m_tile;
+				entry.m_tile.store(nullptr, std::memory_order_release);
+				delete tile;
+				residentCount--;
+				evicted++;
+			}
+		}
+	}
+
+	// each call starts a new period for the tiles usage
+	m_tileLru++;
+	return evicted;
+}
+
 const ndInt32* ndShapeHeightfield::GetIndexList() const
 {
 	return &m_cellIndices[(m_diagonalMode == m_normalDiagonals) ? 0 : 1][0];
@@ -213,19 +733,18 @@ void ndShapeHeightfield::DebugShape(const ndMatrix& matrix, ndShapeDebugNotify&
 	const ndInt32 i2 = indirectIndex[2];
 	const ndInt32 i3 = indirectIndex[3];
 
-	ndInt32 base = 0;
 	for (ndInt32 z = 0; z < m_height - 1; ++z)
 	{
-		const ndVector p0 ((0 + 0) * m_horizontalScale_x, ndFloat32(m_elevationMap[base + 0]),               (z + 0) * m_horizontalScale_z, ndFloat32(0.0f));
-		const ndVector p1 ((0 + 0) * m_horizontalScale_x, ndFloat32(m_elevationMap[base + 0 + m_width + 0]), (z + 1) * m_horizontalScale_z, ndFloat32(0.0f));
+		const ndVector p0 ((0 + 0) * m_horizontalScale_x, GetElevation(0, z + 0), (z + 0) * m_horizontalScale_z, ndFloat32(0.0f));
+		const ndVector p1 ((0 + 0) * m_horizontalScale_x, GetElevation(0, z + 1), (z + 1) * m_horizontalScale_z, ndFloat32(0.0f));
 
 		points[0 * 2 + 0] = matrix.TransformVector(p0);
 		points[1 * 2 + 0] = matrix.TransformVector(p1);
 
 		for (ndInt32 x = 0; x < m_width - 1; ++x) 
 		{
-			const ndVector p2 ((x + 1) * m_horizontalScale_x, ndFloat32(m_elevationMap[base + x + 1]),			(z + 0) * m_horizontalScale_z, ndFloat32(0.0f));
-			const ndVector p3 ((x + 1) * m_horizontalScale_x, ndFloat32(m_elevationMap[base + x + m_width + 1]), (z + 1) * m_horizontalScale_z, ndFloat32(0.0f));
+			const ndVector p2 ((x + 1) * m_horizontalScale_x, GetElevation(x + 1, z + 0), (z + 0) * m_horizontalScale_z, ndFloat32(0.0f));
+			const ndVector p3 ((x + 1) * m_horizontalScale_x, GetElevation(x + 1, z + 1), (z + 1) * m_horizontalScale_z, ndFloat32(0.0f));
 
 			points[0 * 2 + 1] = matrix.TransformVector(p2);
 			points[1 * 2 + 1] = matrix.TransformVector(p3);
@@ -243,7 +762,6 @@ void ndShapeHeightfield::DebugShape(const ndMatrix& matrix, ndShapeDebugNotify&
 			points[0 * 2 + 0] = points[0 * 2 + 1];
 			points[1 * 2 + 0] = points[1 * 2 + 1];
 		}
-		base += m_width;
 	}
 }
 
@@ -333,12 +851,10 @@ ndFloat32 ndShapeHeightfield::RayCastCell(const ndFastRay& ray, ndInt32 xIndex0,
 
 	dAssert(maxT <= 1.0);
 
-	ndInt32 base = zIndex0 * m_width + xIndex0;
-
-	points[0 * 2 + 0] = ndVector((xIndex0 + 0) * m_horizontalScale_x, ndFloat32 (m_elevationMap[base + 0]),			  (zIndex0 + 0) * m_horizontalScale_z, ndFloat32(0.0f));
-	points[0 * 2 + 1] = ndVector((xIndex0 + 1) * m_horizontalScale_x, ndFloat32 (m_elevationMap[base + 1]),			  (zIndex0 + 0) * m_horizontalScale_z, ndFloat32(0.0f));
-	points[1 * 2 + 1] = ndVector((xIndex0 + 1) * m_horizontalScale_x, ndFloat32 (m_elevationMap[base + m_width + 1]), (zIndex0 + 1) * m_horizontalScale_z, ndFloat32(0.0f));
-	points[1 * 2 + 0] = ndVector((xIndex0 + 0) * m_horizontalScale_x, ndFloat32 (m_elevationMap[base + m_width + 0]), (zIndex0 + 1) * m_horizontalScale_z, ndFloat32(0.0f));
+	points[0 * 2 + 0] = ndVector((xIndex0 + 0) * m_horizontalScale_x, GetElevation(xIndex0 + 0, zIndex0 + 0), (zIndex0 + 0) * m_horizontalScale_z, ndFloat32(0.0f));
+	points[0 * 2 + 1] = ndVector((xIndex0 + 1) * m_horizontalScale_x, GetElevation(xIndex0 + 1, zIndex0 + 0), (zIndex0 + 0) * m_horizontalScale_z, ndFloat32(0.0f));
+	points[1 * 2 + 1] = ndVector((xIndex0 + 1) * m_horizontalScale_x, GetElevation(xIndex0 + 1, zIndex0 + 1), (zIndex0 + 1) * m_horizontalScale_z, ndFloat32(0.0f));
+	points[1 * 2 + 0] = ndVector((xIndex0 + 0) * m_horizontalScale_x, GetElevation(xIndex0 + 0, zIndex0 + 1), (zIndex0 + 1) * m_horizontalScale_z, ndFloat32(0.0f));
 
 	ndFloat32 t = ndFloat32(1.2f);
 	if (m_diagonalMode == m_normalDiagonals)
@@ -485,17 +1001,64 @@ ndFloat32 ndShapeHeightfield::RayCast(ndRayCastNotify&, const ndVector& localP0,
 		ndInt32 zIndex0 = iz0;
 		ndFastRay ray(localP0, localP1);
 	
+		// cells inside the skip rectangle belong to a pyramid node the ray passes over or under,
+		// cells inside the leaf rectangle belong to a block already known to straddle the ray 
+		ndInt32 skipX0 = 1;
+		ndInt32 skipX1 = 0;
+		ndInt32 skipZ0 = 1;
+		ndInt32 skipZ1 = 0;
+		ndInt32 leafX0 = 1;
+		ndInt32 leafX1 = 0;
+		ndInt32 leafZ0 = 1;
+		ndInt32 leafZ1 = 0;
+
 		// for each cell touched by the line
 		do 
 		{
-			ndFloat32 t = RayCastCell(ray, xIndex0, zIndex0, normalOut, maxT);
+			bool testCell = true;
+			if ((xIndex0 >= skipX0) && (xIndex0 <= skipX1) && (zIndex0 >= skipZ0) && (zIndex0 <= skipZ1))
+			{
+				testCell = false;
+			}
+			else if ((xIndex0 >= 0) && (zIndex0 >= 0) && (xIndex0 < (m_width - 1)) && (zIndex0 < (m_height - 1)) &&
+					 !((xIndex0 >= leafX0) && (xIndex0 <= leafX1) && (zIndex0 >= leafZ0) && (zIndex0 <= leafZ1)))
+			{
+				ndInt32 level = 0;
+				ndInt32 xNode = xIndex0 >> D_HEIGHTFIELD_PYRAMID_SHIFT;
+				ndInt32 zNode = zIndex0 >> D_HEIGHTFIELD_PYRAMID_SHIFT;
+				if (RayMissNode(p0, dp, level, xNode, zNode))
+				{
+					// climb to the largest empty node and skip all its cells
+					while (((level + 1) < m_pyramidLevelsCount) && RayMissNode(p0, dp, level + 1, xNode >> 1, zNode >> 1))
+					{
+						level++;
+						xNode = xNode >> 1;
+						zNode = zNode >> 1;
+					}
+					const ndInt32 shift = level + D_HEIGHTFIELD_PYRAMID_SHIFT;
+					skipX0 = xNode << shift;
+					skipZ0 = zNode << shift;
+					skipX1 = skipX0 + (1 << shift) - 1;
+					skipZ1 = skipZ0 + (1 << shift) - 1;
+					testCell = false;
+				}
+				else
+				{
+					leafX0 = xNode << D_HEIGHTFIELD_PYRAMID_SHIFT;
+					leafZ0 = zNode << D_HEIGHTFIELD_PYRAMID_SHIFT;
+					leafX1 = leafX0 + (1 << D_HEIGHTFIELD_PYRAMID_SHIFT) - 1;
+					leafZ1 = leafZ0 + (1 << D_HEIGHTFIELD_PYRAMID_SHIFT) - 1;
+				}
+			}
+
+			ndFloat32 t = testCell ? RayCastCell(ray, xIndex0, zIndex0, normalOut, maxT) : ndFloat32(1.2f);
 			if (t < maxT) 
 			{
 				// bail out at the first intersection and copy the data into the descriptor
 				dAssert(normalOut.m_w == ndFloat32(0.0f));
 				contactOut.m_normal = normalOut.Normalize();
-				contactOut.m_shapeId0 = m_atributeMap[zIndex0 * m_width + xIndex0];
-				contactOut.m_shapeId1 = m_atributeMap[zIndex0 * m_width + xIndex0];
+				contactOut.m_shapeId0 = GetAtribute(xIndex0, zIndex0);
+				contactOut.m_shapeId1 = GetAtribute(xIndex0, zIndex0);
 	
 				return t;
 			}
@@ -524,22 +1087,118 @@ void ndShapeHeightfield::CalculateMinAndMaxElevation(ndInt32 x0, ndInt32 x1, ndI
 	ndReal minVal = ndReal(1.0e10f);
 	ndReal maxVal = -ndReal(1.0e10f);
 
-	ndInt32 base = z0 * m_width;
-	for (ndInt32 z = z0; z <= z1; ++z) 
+	x0 = dMax(x0, 0);
+	z0 = dMax(z0, 0);
+	x1 = dMin(x1, m_width - 1);
+	z1 = dMin(z1, m_height - 1);
+
+	if (((x1 - x0) <= (1 << D_HEIGHTFIELD_PYRAMID_SHIFT)) && ((z1 - z0) <= (1 << D_HEIGHTFIELD_PYRAMID_SHIFT)))
 	{
-		for (ndInt32 x = x0; x <= x1; ++x) 
+		// small ranges are cheaper to scan directly
+		ScanElevation(x0, x1, z0, z1, minVal, maxVal);
+		minHeight = minVal;
+		maxHeight = maxVal;
+		return;
+	}
+
+	// descend the pyramid, nodes fully inside the range contribute their bound,
+	// only the leaf blocks straddling the range border read the elevation map
+	ndInt32 stack = 1;
+	ndInt32 stackPool[D_HEIGHTFIELD_PYRAMID_LEVELS * 4][3];
+	stackPool[0][0] = m_pyramidLevelsCount - 1;
+	stackPool[0][1] = 0;
+	stackPool[0][2] = 0;
+	while (stack)
+	{
+		stack--;
+		const ndInt32 level = stackPool[stack][0];
+		const ndInt32 nx = stackPool[stack][1];
+		const ndInt32 nz = stackPool[stack][2];
+		const ndInt32 shift = level + D_HEIGHTFIELD_PYRAMID_SHIFT;
+
+		const ndInt32 vx0 = nx << shift;
+		const ndInt32 vz0 = nz << shift;
+		const ndInt32 vx1 = dMin((nx + 1) << shift, m_width - 1);
+		const ndInt32 vz1 = dMin((nz + 1) << shift, m_height - 1);
+		if ((vx0 > x1) || (vz0 > z1) || (vx1 < x0) || (vz1 < z0))
+		{
+			continue;
+		}
+
+		const ndPyramidLevel& pyramidLevel = m_pyramidLevels[level];
+		if ((vx0 >= x0) && (vz0 >= z0) && (vx1 <= x1) && (vz1 <= z1))
+		{
+			const ndElevationBound& bound = m_elevationPyramid[pyramidLevel.m_start + nz * pyramidLevel.m_width + nx];
+			minVal = dMin(bound.m_min, minVal);
+			maxVal = dMax(bound.m_max, maxVal);
+		}
+		else if (level == 0)
 		{
-			ndReal high = m_elevationMap[base + x];
-			minVal = dMin(high, minVal);
-			maxVal = dMax(high, maxVal);
+			ScanElevation(dMax(vx0, x0), dMin(vx1, x1), dMax(vz0, z0), dMin(vz1, z1), minVal, maxVal);
+		}
+		else
+		{
+			const ndPyramidLevel& childLevel = m_pyramidLevels[level - 1];
+			const ndInt32 cz1 = dMin(nz * 2 + 1, childLevel.m_height - 1);
+			const ndInt32 cx1 = dMin(nx * 2 + 1, childLevel.m_width - 1);
+			for (ndInt32 cz = nz * 2; cz <= cz1; ++cz)
+			{
+				for (ndInt32 cx = nx * 2; cx <= cx1; ++cx)
+				{
+					dAssert(stack < ndInt32(sizeof(stackPool) / sizeof(stackPool[0])));
+					stackPool[stack][0] = level - 1;
+					stackPool[stack][1] = cx;
+					stackPool[stack][2] = cz;
+					stack++;
+				}
+			}
 		}
-		base += m_width;
 	}
 
 	minHeight = minVal;
 	maxHeight = maxVal;
 }
 
+bool ndShapeHeightfield::RayMissNode(const ndVector& p0, const ndVector& dp, ndInt32 level, ndInt32 xNode, ndInt32 zNode) const
+{
+	const ndInt32 shift = level + D_HEIGHTFIELD_PYRAMID_SHIFT;
+	const ndFloat32 x0 = ndFloat32(xNode << shift) * m_horizontalScale_x;
+	const ndFloat32 z0 = ndFloat32(zNode << shift) * m_horizontalScale_z;
+	const ndFloat32 x1 = ndFloat32(dMin((xNode + 1) << shift, m_width - 1)) * m_horizontalScale_x;
+	const ndFloat32 z1 = ndFloat32(dMin((zNode + 1) << shift, m_height - 1)) * m_horizontalScale_z;
+
+	// clip the segment to the node column and test its elevation span against the node bound 
+	ndFloat32 t0 = ndFloat32(0.0f);
+	ndFloat32 t1 = ndFloat32(1.0f);
+	if (dp.m_x != ndFloat32(0.0f))
+	{
+		const ndFloat32 invDx = ndFloat32(1.0f) / dp.m_x;
+		const ndFloat32 ta = (x0 - p0.m_x) * invDx;
+		const ndFloat32 tb = (x1 - p0.m_x) * invDx;
+		t0 = dMax(t0, dMin(ta, tb));
+		t1 = dMin(t1, dMax(ta, tb));
+	}
+	if (dp.m_z != ndFloat32(0.0f))
+	{
+		const ndFloat32 invDz = ndFloat32(1.0f) / dp.m_z;
+		const ndFloat32 ta = (z0 - p0.m_z) * invDz;
+		const ndFloat32 tb = (z1 - p0.m_z) * invDz;
+		t0 = dMax(t0, dMin(ta, tb));
+		t1 = dMin(t1, dMax(ta, tb));
+	}
+	if (t0 > t1)
+	{
+		return false;
+	}
+
+	const ndPyramidLevel& pyramidLevel = m_pyramidLevels[level];
+	const ndElevationBound& bound = m_elevationPyramid[pyramidLevel.m_start + zNode * pyramidLevel.m_width + xNode];
+	const ndFloat32 y0 = p0.m_y + dp.m_y * t0;
+	const ndFloat32 y1 = p0.m_y + dp.m_y * t1;
+	const ndFloat32 padding = ndFloat32(1.0e-3f);
+	return (dMin(y0, y1) > (ndFloat32(bound.m_max) + padding)) || (dMax(y0, y1) < (ndFloat32(bound.m_min) - padding));
+}
+
 void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 {
 	ndVector boxP0;
@@ -596,17 +1255,15 @@ void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 		vertex.SetCount(vertexCount);
 	
 		ndInt32 vertexIndex = 0;
-		ndInt32 base = z0 * m_width;
 		for (ndInt32 z = z0; z <= z1; ++z) 
 		{
 			ndFloat32 zVal = m_horizontalScale_z * z;
 			for (ndInt32 x = x0; x <= x1; ++x) 
 			{
-				vertex[vertexIndex] = ndVector(m_horizontalScale_x * x, ndFloat32(m_elevationMap[base + x]), zVal, ndFloat32(0.0f));
+				vertex[vertexIndex] = ndVector(m_horizontalScale_x * x, GetElevation(x, z), zVal, ndFloat32(0.0f));
 				vertexIndex++;
 				dAssert(vertexIndex <= vertex.GetCount());
 			}
-			base += m_width;
 		}
 
 		ndInt32 normalBase = vertexIndex;
@@ -621,7 +1278,6 @@ void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 		const ndInt32* const indirectIndex = GetIndexList();
 		for (ndInt32 z = z0; (z < z1) && (faceCount < D_MAX_COLLIDING_FACES); ++z) 
 		{
-			ndInt32 zStep = z * m_width;
 			for (ndInt32 x = x0; (x < x1) && (faceCount < D_MAX_COLLIDING_FACES); ++x) 
 			{
 				ndInt32 vIndex[4];
@@ -656,7 +1312,8 @@ void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 				indices[index + 0 + 0] = i2;
 				indices[index + 0 + 1] = i1;
 				indices[index + 0 + 2] = i0;
-				indices[index + 0 + 3] = m_atributeMap[zStep + x];
+				const ndInt32 atribute = GetAtribute(x, z);
+				indices[index + 0 + 3] = atribute;
 				indices[index + 0 + 4] = normalIndex0;
 				indices[index + 0 + 5] = normalIndex0;
 				indices[index + 0 + 6] = normalIndex0;
@@ -667,7 +1324,7 @@ void ndShapeHeightfield::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 				indices[index + 9 + 0] = i1;
 				indices[index + 9 + 1] = i2;
 				indices[index + 9 + 2] = i3;
-				indices[index + 9 + 3] = m_atributeMap[zStep + x];
+				indices[index + 9 + 3] = atribute;
 				indices[index + 9 + 4] = normalIndex1;
 				indices[index + 9 + 5] = normalIndex1;
 				indices[index + 9 + 6] = normalIndex1;
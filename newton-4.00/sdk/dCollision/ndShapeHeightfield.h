@@ -25,6 +25,49 @@
 #include "ndCollisionStdafx.h"
 #include "ndShapeStaticMesh.h"
 
+#define D_HEIGHTFIELD_PYRAMID_LEVELS	32
+#define D_HEIGHTFIELD_PYRAMID_SHIFT		3
+#define D_HEIGHTFIELD_TILE_SHIFT		6
+#define D_HEIGHTFIELD_TILE_SIZE			(1 << D_HEIGHTFIELD_TILE_SHIFT)
+
+// a square block of D_HEIGHTFIELD_TILE_SIZE x D_HEIGHTFIELD_TILE_SIZE vertices,
+// with elevations quantized to 16 bits over the tile range
+class ndHeightfieldTile: public ndClassAlloc
+{
+	public:
+	D_COLLISION_API ndHeightfieldTile();
+	D_COLLISION_API void Quantize(const ndReal* const elevation, const ndInt8* const atributes, ndInt32 count_x, ndInt32 count_z, ndInt32 stride);
+
+	ndFloat32 GetElevation(ndInt32 index) const;
+	ndInt8 GetAtribute(ndInt32 index) const;
+
+	ndArray<ndUnsigned16> m_elevation;
+	ndArray<ndInt8> m_atributes;
+	ndFloat32 m_offset;
+	ndFloat32 m_scale;
+	ndInt8 m_atribute;
+};
+
+class ndHeightfieldTileLoader: public ndClassAlloc
+{
+	public:
+	ndHeightfieldTileLoader()
+	{
+	}
+
+	virtual ~ndHeightfieldTileLoader()
+	{
+	}
+
+	// elevation range of the tile data, asked once for every tile when the loader is set.
+	virtual void GetTileBounds(ndInt32 tile_x, ndInt32 tile_z, ndFloat32& minHeight, ndFloat32& maxHeight) = 0;
+
+	// fills the tile the first time a query touches it. this is called from the collision threads 
+	// without any lock held, so different tiles load concurrently, and two threads touching the 
+	// same tile at the same time can both load it, only one of the two copies is kept.
+	virtual void LoadTile(ndInt32 tile_x, ndInt32 tile_z, ndHeightfieldTile& tile) = 0;
+};
+
 class ndShapeHeightfield: public ndShapeStaticMesh
 {
 	public:
@@ -45,6 +88,22 @@ class ndShapeHeightfield: public ndShapeStaticMesh
 	const ndArray<ndReal>& GetElevationMap() const;
 
 	D_COLLISION_API void UpdateElevationMapAabb();
+	D_COLLISION_API void UpdateElevationRegion(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1);
+	D_COLLISION_API void SetElevationRegion(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1, const ndReal* const elevation, ndInt32 stride);
+
+	// after any of these two calls the elevation map is empty and the elevations are stored 
+	// in 16 bit tiles read with GetElevation, the shape info elevation and attribute pointers are null
+	D_COLLISION_API void QuantizeElevationMap();
+	D_COLLISION_API void SetTileLoader(ndHeightfieldTileLoader* const loader);
+
+	// releases the least recently used streamed tiles until at most maxResidentTiles remain,
+	// tiles edited with SetElevationRegion are kept. the collision threads read the tiles without 
+	// a lock, so this must only be called between world updates, never from a contact or query callback.
+	D_COLLISION_API ndInt32 EvictTiles(ndInt32 maxResidentTiles);
+	D_COLLISION_API ndInt32 GetResidentTilesCount() const;
+
+	ndFloat32 GetElevation(ndInt32 x, ndInt32 z) const;
+	ndInt8 GetAtribute(ndInt32 x, ndInt32 z) const;
 	D_COLLISION_API void GetLocalAabb(const ndVector& p0, const ndVector& p1, ndVector& boxP0, ndVector& boxP1) const;
 
 	protected:
@@ -54,8 +113,35 @@ class ndShapeHeightfield: public ndShapeStaticMesh
 	virtual ndFloat32 RayCast(ndRayCastNotify& callback, const ndVector& localP0, const ndVector& localP1, ndFloat32 maxT, const ndBody* const body, ndContactPoint& contactOut) const;
 	virtual void GetCollidingFaces(ndPolygonMeshDesc* const data) const;
 	virtual void Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const;
+	virtual bool GetAssetData(ndArray<char>& data) const;
+	virtual ndUnsigned32 GetAssetRevision() const;
 
 	private: 
+	class ndElevationBound
+	{
+		public:
+		ndReal m_min;
+		ndReal m_max;
+	};
+
+	class ndPyramidLevel
+	{
+		public:
+		ndInt32 m_start;
+		ndInt32 m_width;
+		ndInt32 m_height;
+	};
+
+	class ndTileEntry
+	{
+		public:
+		ndAtomic<ndHeightfieldTile*> m_tile;
+		ndReal m_minHeight;
+		ndReal m_maxHeight;
+		ndAtomic<ndUnsigned32> m_lru;
+		ndUnsigned32 m_pinned;
+	};
+
 	class ndLocalThreadData
 	{
 		public:
@@ -69,17 +155,37 @@ class ndShapeHeightfield: public ndShapeStaticMesh
 	};
 
 	void CalculateLocalObb();
+	void UpdateLocalObb();
 	ndInt32 FastInt(ndFloat32 x) const;
 	const ndInt32* GetIndexList() const;
 	void CalculateMinExtend2d(const ndVector& p0, const ndVector& p1, ndVector& boxP0, ndVector& boxP1) const;
 	void CalculateMinExtend3d(const ndVector& p0, const ndVector& p1, ndVector& boxP0, ndVector& boxP1) const;
 	ndFloat32 RayCastCell(const ndFastRay& ray, ndInt32 xIndex0, ndInt32 zIndex0, ndVector& normalOut, ndFloat32 maxT) const;
 	void CalculateMinAndMaxElevation(ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndFloat32& minHeight, ndFloat32& maxHeight) const;
+	bool RayMissNode(const ndVector& p0, const ndVector& dp, ndInt32 level, ndInt32 xNode, ndInt32 zNode) const;
+
+	void ScanElevation(ndInt32 x0, ndInt32 x1, ndInt32 z0, ndInt32 z1, ndReal& minHeight, ndReal& maxHeight) const;
+	const ndHeightfieldTile* GetTile(ndInt32 tile_x, ndInt32 tile_z) const;
+	const ndHeightfieldTile* PageTile(ndInt32 tile_x, ndInt32 tile_z) const;
+	void ReleaseTiles();
+
+	void BuildElevationPyramid();
+	void UpdateElevationPyramid(ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1);
 
 	ndVector m_minBox;
 	ndVector m_maxBox;
 	ndArray<ndInt8> m_atributeMap;
 	ndArray<ndReal> m_elevationMap;
+	ndArray<ndElevationBound> m_elevationPyramid;
+	ndPyramidLevel m_pyramidLevels[D_HEIGHTFIELD_PYRAMID_LEVELS];
+	ndInt32 m_pyramidLevelsCount;
+	mutable ndArray<ndTileEntry> m_tiles;
+	ndHeightfieldTileLoader* m_tileLoader;
+	mutable ndSpinLock m_tileLock;
+	ndInt32 m_tileCount_x;
+	ndInt32 m_tileCount_z;
+	ndUnsigned32 m_tileLru;
+	ndUnsigned32 m_assetRevision;
 	ndFloat32 m_horizontalScale_x;
 	ndFloat32 m_horizontalScale_z;
 	ndFloat32 m_horizontalScaleInv_x;
@@ -108,6 +214,49 @@ inline const ndArray<ndReal>& ndShapeHeightfield::GetElevationMap() const
 	return m_elevationMap;
 }
 
+inline ndFloat32 ndHeightfieldTile::GetElevation(ndInt32 index) const
+{
+	return m_offset + m_scale * ndFloat32(m_elevation[index]);
+}
+
+inline ndInt8 ndHeightfieldTile::GetAtribute(ndInt32 index) const
+{
+	return m_atributes.GetCount() ? m_atributes[index] : m_atribute;
+}
+
+inline const ndHeightfieldTile* ndShapeHeightfield::GetTile(ndInt32 tile_x, ndInt32 tile_z) const
+{
+	// the tile pointer is published with release order by PageTile, 
+	// the usage stamp is only a hint for EvictTiles so it is relaxed
+	ndTileEntry& entry = m_tiles[tile_z * m_tileCount_x + tile_x];
+	if (entry.m_lru.load(std::memory_order_relaxed) != m_tileLru)
+	{
+		entry.m_lru.store(m_tileLru, std::memory_order_relaxed);
+	}
+	const ndHeightfieldTile* const tile = entry.m_tile.load(std::memory_order_acquire);
+	return tile ? tile : PageTile(tile_x, tile_z);
+}
+
+inline ndFloat32 ndShapeHeightfield::GetElevation(ndInt32 x, ndInt32 z) const
+{
+	if (!m_tiles.GetCount())
+	{
+		return ndFloat32(m_elevationMap[z * m_width + x]);
+	}
+	const ndHeightfieldTile* const tile = GetTile(x >> D_HEIGHTFIELD_TILE_SHIFT, z >> D_HEIGHTFIELD_TILE_SHIFT);
+	return tile->GetElevation(((z & (D_HEIGHTFIELD_TILE_SIZE - 1)) << D_HEIGHTFIELD_TILE_SHIFT) + (x & (D_HEIGHTFIELD_TILE_SIZE - 1)));
+}
+
+inline ndInt8 ndShapeHeightfield::GetAtribute(ndInt32 x, ndInt32 z) const
+{
+	if (!m_tiles.GetCount())
+	{
+		return m_atributeMap[z * m_width + x];
+	}
+	const ndHeightfieldTile* const tile = GetTile(x >> D_HEIGHTFIELD_TILE_SHIFT, z >> D_HEIGHTFIELD_TILE_SHIFT);
+	return tile->GetAtribute(((z & (D_HEIGHTFIELD_TILE_SIZE - 1)) << D_HEIGHTFIELD_TILE_SHIFT) + (x & (D_HEIGHTFIELD_TILE_SIZE - 1)));
+}
+
 inline ndInt32 ndShapeHeightfield::FastInt(ndFloat32 x) const
 {
 	ndInt32 i = ndInt32(x);
@@ -126,6 +126,13 @@ class ndShapeStaticMesh: public ndShape
 	virtual void GetCollidingFaces(ndPolygonMeshDesc* const data) const;
 	D_COLLISION_API void Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const;
 
+	// meshes saved with a binary asset file copy its content to data and return true, 
+	// the copy can then be written on another thread while the shape keeps changing.
+	virtual bool GetAssetData(ndArray<char>& data) const;
+
+	// changes every time the asset content does, so a saved copy can be checked for being current.
+	virtual ndUnsigned32 GetAssetRevision() const;
+
 	protected:
 	virtual ndFloat32 GetVolume() const;
 	virtual ndFloat32 GetBoxMinRadius() const;
@@ -154,6 +161,16 @@ class ndShapeStaticMesh: public ndShape
 	} D_GCC_NEWTON_ALIGN_32;
 };
 
+inline bool ndShapeStaticMesh::GetAssetData(ndArray<char>&) const
+{
+	return false;
+}
+
+inline ndUnsigned32 ndShapeStaticMesh::GetAssetRevision() const
+{
+	return 0;
+}
+
 inline ndFloat32 ndShapeStaticMesh::GetVolume() const
 {
 	return ndFloat32(0.0f);
@@ -55,6 +55,7 @@ ndShapeStaticProceduralMesh::ndShapeStaticProceduralMesh(ndFloat32 sizex, ndFloa
 	,m_maxFaceCount(64)
 	,m_maxVertexCount(256)
 {
+	memset(m_localData, 0, sizeof(m_localData));
 	CalculateLocalObb();
 }
 
@@ -67,11 +68,19 @@ ndShapeStaticProceduralMesh::ndShapeStaticProceduralMesh(const ndLoadSaveBase::n
 	m_maxBox = xmlGetVector3(xmlNode, "maxBox");
 	m_maxFaceCount = xmlGetInt(xmlNode, "maxFaceCount");
 	m_maxVertexCount = xmlGetInt(xmlNode, "maxVertexCount");
+	memset(m_localData, 0, sizeof(m_localData));
 	CalculateLocalObb();
 }
 
 ndShapeStaticProceduralMesh::~ndShapeStaticProceduralMesh(void)
 {
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		if (m_localData[i])
+		{
+			delete m_localData[i];
+		}
+	}
 }
 
 void ndShapeStaticProceduralMesh::Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const
@@ -106,6 +115,17 @@ void ndShapeStaticProceduralMesh::CalculateLocalObb()
 	m_boxOrigin = (m_maxBox + m_minBox) * ndVector::m_half;
 }
 
+ndArray<ndVector>& ndShapeStaticProceduralMesh::GetLocalVertexBuffer(ndInt32 threadIndex) const
+{
+	dAssert(threadIndex >= 0);
+	dAssert(threadIndex < D_MAX_THREADS_COUNT);
+	if (!m_localData[threadIndex])
+	{
+		m_localData[threadIndex] = new ndLocalData;
+	}
+	return m_localData[threadIndex]->m_vertex;
+}
+
 void ndShapeStaticProceduralMesh::GetCollidingFaces(ndPolygonMeshDesc* const data) const
 {
 	ndVector* const vertexBuffer = dAlloca(ndVector, m_maxVertexCount);
@@ -129,7 +149,7 @@ void ndShapeStaticProceduralMesh::GetCollidingFaces(ndPolygonMeshDesc* const dat
 	}
 
 	// scan the vertices's intersected by the box extend
-	ndArray<ndVector>& vertex = m_localData[data->m_threadId].m_vertex;
+	ndArray<ndVector>& vertex = GetLocalVertexBuffer(data->m_threadId);
 	vertex.SetCount(vertexList.GetCount() + faceList.GetCount());
 	
 	ndEdgeMap edgeMap;
@@ -72,7 +72,7 @@ class ndShapeStaticProceduralMesh: public ndShapeStaticMesh
 	private:
 	D_COLLISION_API virtual void GetCollidingFaces(ndPolygonMeshDesc* const data) const;
 
-	class ndLocalData
+	class ndLocalData: public ndClassAlloc
 	{
 		public:
 		ndLocalData()
@@ -83,10 +83,12 @@ class ndShapeStaticProceduralMesh: public ndShapeStaticMesh
 	};
 
 	void CalculateLocalObb();
+	ndArray<ndVector>& GetLocalVertexBuffer(ndInt32 threadIndex) const;
 	
 	ndVector m_minBox;
 	ndVector m_maxBox;
-	mutable ndLocalData m_localData[D_MAX_THREADS_COUNT];
+	// per thread scratch, allocated by the thread that first uses it
+	mutable ndLocalData* m_localData[D_MAX_THREADS_COUNT];
 	ndInt32 m_maxFaceCount;
 	ndInt32 m_maxVertexCount;
 
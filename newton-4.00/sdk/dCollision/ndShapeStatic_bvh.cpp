@@ -54,13 +54,14 @@ class ndBvhRay: public ndFastRay
 	const ndShapeStatic_bvh* m_me;
 } D_GCC_NEWTON_ALIGN_32;
 
-ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder)
+ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder, ndThreadPool* const threadPool)
 	:ndShapeStaticMesh(m_boundingBoxHierachy)
 	,ndAabbPolygonSoup()
 	,m_trianglesCount(0)
 {
-	Create(builder);
-	CalculateAdjacendy();
+	ndMemoryScope memoryScope(m_staticMeshMemory);
+	Create(builder, threadPool);
+	CalculateAdjacendy(threadPool);
 
 	ndVector p0;
 	ndVector p1;
@@ -84,27 +85,21 @@ ndShapeStatic_bvh::ndShapeStatic_bvh(const ndLoadSaveBase::ndLoadDescriptor& des
 	,ndAabbPolygonSoup()
 	,m_trianglesCount(0)
 {
+	ndMemoryScope memoryScope(m_staticMeshMemory);
 	const nd::TiXmlNode* const xmlNode = desc.m_rootNode;
 	const char* const assetName = xmlGetString(xmlNode, "assetName");
 	char pathCopy[1024];
 	sprintf(pathCopy, "%s/%s", desc.m_assetPath, assetName);
-	Deserialize(pathCopy);
-
-	ndVector p0;
-	ndVector p1;
-	GetAABB(p0, p1);
-	m_boxSize = (p1 - p0) * ndVector::m_half;
-	m_boxOrigin = (p1 + p0) * ndVector::m_half;
+	Load(pathCopy);
+}
 
-	ndMeshVertexListIndexList data;
-	data.m_indexList = nullptr;
-	data.m_userDataList = nullptr;
-	data.m_maxIndexCount = 1000000000;
-	data.m_triangleCount = 0;
-	ndVector zero(ndVector::m_zero);
-	ndFastAabb box(dGetIdentityMatrix(), ndVector(ndFloat32(1.0e15f)));
-	ForAllSectors(box, zero, ndFloat32(1.0f), GetTriangleCount, &data);
-	m_trianglesCount = data.m_triangleCount;
+ndShapeStatic_bvh::ndShapeStatic_bvh(const char* const pathName)
+	:ndShapeStaticMesh(m_boundingBoxHierachy)
+	,ndAabbPolygonSoup()
+	,m_trianglesCount(0)
+{
+	ndMemoryScope memoryScope(m_staticMeshMemory);
+	Load(pathName);
 }
 
 ndShapeStatic_bvh::~ndShapeStatic_bvh(void)
@@ -122,10 +117,54 @@ void ndShapeStatic_bvh::Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const
 	sprintf(fileName, "%s_%d.bin", desc.m_assetName, desc.m_assetIndex);
 	xmlSaveParam(childNode, "assetName", "string", fileName);
 
-	char filePathName[2 * 1024];
-	sprintf(filePathName, "%s/%s", desc.m_assetPath, fileName);
 	desc.m_assetIndex++;
-	Serialize(filePathName);
+	if (desc.m_saveAssets)
+	{
+		char filePathName[2 * 1024];
+		sprintf(filePathName, "%s/%s", desc.m_assetPath, fileName);
+		Serialize(filePathName);
+	}
+}
+
+bool ndShapeStatic_bvh::GetAssetData(ndArray<char>& data) const
+{
+	SerializeToMemory(data);
+	return true;
+}
+
+void ndShapeStatic_bvh::Load(const char* const pathName)
+{
+	if (!MapFile(pathName) && !Deserialize(pathName))
+	{
+		dTrace(("failed to load mesh %s\n", pathName));
+	}
+
+	ndVector p0;
+	ndVector p1;
+	GetAABB(p0, p1);
+	m_boxSize = (p1 - p0) * ndVector::m_half;
+	m_boxOrigin = (p1 + p0) * ndVector::m_half;
+	m_trianglesCount = CalculateTrianglesCount();
+}
+
+ndInt32 ndShapeStatic_bvh::CalculateTrianglesCount() const
+{
+	// count from the leaves, so that the faces and vertices of a mapped file are not paged in
+	ndInt32 count = 0;
+	const ndNode* const nodes = GetRootNode();
+	for (ndInt32 i = GetNodesCount() - 1; i >= 0; --i)
+	{
+		const ndNode& node = nodes[i];
+		if (node.m_left.IsLeaf() && (node.m_left.GetCount() >= 3))
+		{
+			count += ndInt32(node.m_left.GetCount()) - 2;
+		}
+		if (node.m_right.IsLeaf() && (node.m_right.GetCount() >= 3))
+		{
+			count += ndInt32(node.m_right.GetCount()) - 2;
+		}
+	}
+	return count;
 }
 
 dIntersectStatus ndShapeStatic_bvh::GetTriangleCount(void* const context, const ndFloat32* const, ndInt32, const ndInt32* const, ndInt32 indexCount, ndFloat32)
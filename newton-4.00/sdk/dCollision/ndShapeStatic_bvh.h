@@ -29,8 +29,14 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 {
 	public:
 	D_CLASS_REFLECTION(ndShapeStatic_bvh);
-	D_COLLISION_API ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder);
+	// the tree is built on the calling thread, or by the threads of threadPool when one is 
+	// passed, the pool must not be running another job. the tree is the same either way.
+	D_COLLISION_API ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder, ndThreadPool* const threadPool = nullptr);
 	D_COLLISION_API ndShapeStatic_bvh(const ndLoadSaveBase::ndLoadDescriptor& desc);
+
+	// loads a mesh saved with Serialize, files in the current format are mapped 
+	// and used in place, so every shape loaded from the same file shares its memory.
+	D_COLLISION_API ndShapeStatic_bvh(const char* const pathName);
 	D_COLLISION_API virtual ~ndShapeStatic_bvh();
 
 	void *operator new (size_t size);
@@ -43,6 +49,7 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 	virtual ndFloat32 RayCast(ndRayCastNotify& callback, const ndVector& localP0, const ndVector& localP1, ndFloat32 maxT, const ndBody* const body, ndContactPoint& contactOut) const;
 	virtual void GetCollidingFaces(ndPolygonMeshDesc* const data) const;
 	virtual void Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const;
+	virtual bool GetAssetData(ndArray<char>& data) const;
 	
 	static ndFloat32 RayHit(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount);
 	static dIntersectStatus ShowDebugPolygon(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
@@ -50,6 +57,9 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 	static dIntersectStatus GetPolygon(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
 
 	private: 
+	void Load(const char* const pathName);
+	ndInt32 CalculateTrianglesCount() const;
+
 	ndInt32 m_trianglesCount;
 
 	friend class ndContactSolver;
@@ -24,13 +24,97 @@
 #include "ndHeap.h"
 #include "ndStack.h"
 #include "ndList.h"
+#include "ndSort.h"
 #include "ndMatrix.h"
-#include "ndPolyhedra.h"
+#include "ndThreadPool.h"
+#include "ndMappedFile.h"
+#include "ndSaveLoadSytem.h"
 #include "ndAabbPolygonSoup.h"
 #include "ndPolygonSoupBuilder.h"
 
 #define DG_STACK_DEPTH 512
 
+#define D_AABB_SOUP_SAH_BINS		16
+#define D_AABB_SOUP_PARALLEL_SPLIT	(1024 * 16)
+
+#define D_AABB_SOUP_FILE_VERSION	1
+#define D_AABB_SOUP_FILE_ENDIAN		0x01020304
+#define D_AABB_SOUP_FILE_ALIGNMENT	64
+
+// the layout is tied to the build that wrote it, the size of the floats, the node 
+// layout and the byte order are checked so that a mismatched file is rejected.
+class ndAabbPolygonSoup::ndFileHeader
+{
+	public:
+	ndFileHeader()
+	{
+		memset(this, 0, sizeof(ndFileHeader));
+	}
+
+	ndFileHeader(ndInt32 vertexCount, ndInt32 indexCount, ndInt32 nodesCount)
+	{
+		memset(this, 0, sizeof(ndFileHeader));
+		memcpy(m_magic, "ndBvhMsh", sizeof(m_magic));
+		m_version = D_AABB_SOUP_FILE_VERSION;
+		m_endian = D_AABB_SOUP_FILE_ENDIAN;
+		m_floatSize = sizeof(ndFloat32);
+		m_nodeSize = sizeof(ndNode);
+		m_vertexCount = vertexCount;
+		m_indexCount = indexCount;
+		m_nodesCount = nodesCount;
+		m_vertexOffset = Align(sizeof(ndFileHeader));
+		m_indexOffset = Align(m_vertexOffset + sizeof(ndTriplex) * vertexCount);
+		m_nodesOffset = Align(m_indexOffset + sizeof(ndInt32) * indexCount);
+		m_fileSize = nodesCount ? m_nodesOffset + sizeof(ndNode) * nodesCount : sizeof(ndFileHeader);
+	}
+
+	bool HasMagic() const
+	{
+		return !memcmp(m_magic, "ndBvhMsh", sizeof(m_magic));
+	}
+
+	bool IsValid(ndUnsigned64 fileSize) const
+	{
+		bool valid = HasMagic();
+		valid = valid && (m_version == D_AABB_SOUP_FILE_VERSION);
+		valid = valid && (m_endian == D_AABB_SOUP_FILE_ENDIAN);
+		valid = valid && (m_floatSize == sizeof(ndFloat32));
+		valid = valid && (m_nodeSize == sizeof(ndNode));
+		valid = valid && (m_vertexCount >= 0) && (m_indexCount >= 0) && (m_nodesCount >= 0);
+		if (valid)
+		{
+			// the sections are mapped in place, so every offset must be exactly 
+			// the one the writer computes from the counts, and fit in the file.
+			const ndFileHeader expected(m_vertexCount, m_indexCount, m_nodesCount);
+			valid = valid && (m_vertexOffset == expected.m_vertexOffset);
+			valid = valid && (m_indexOffset == expected.m_indexOffset);
+			valid = valid && (m_nodesOffset == expected.m_nodesOffset);
+			valid = valid && (m_fileSize == expected.m_fileSize);
+			valid = valid && (m_fileSize <= fileSize);
+		}
+		return valid;
+	}
+
+	static ndUnsigned64 Align(ndUnsigned64 offset)
+	{
+		return (offset + D_AABB_SOUP_FILE_ALIGNMENT - 1) & ~ndUnsigned64(D_AABB_SOUP_FILE_ALIGNMENT - 1);
+	}
+
+	char m_magic[8];
+	ndUnsigned32 m_version;
+	ndUnsigned32 m_endian;
+	ndUnsigned32 m_floatSize;
+	ndUnsigned32 m_nodeSize;
+	ndInt32 m_vertexCount;
+	ndInt32 m_indexCount;
+	ndInt32 m_nodesCount;
+	ndInt32 m_reserved;
+	ndUnsigned64 m_vertexOffset;
+	ndUnsigned64 m_indexOffset;
+	ndUnsigned64 m_nodesOffset;
+	ndUnsigned64 m_fileSize;
+};
+
 D_MSV_NEWTON_ALIGN_32
 class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 {
@@ -134,135 +218,266 @@ class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 	const ndInt32* m_faceIndices;
 } D_GCC_NEWTON_ALIGN_32;
 
+// leaf box moved around by the tree builder, smaller than the leaf node
+class ndAabbPolygonSoup::ndBuildBox
+{
+	public:
+	ndVector m_p0;
+	ndVector m_p1;
+	ndInt32 m_leaf;
+};
+
+// one edge of a face, sorted by its lowest vertex to find the twin edges
+class ndAabbPolygonSoup::ndAdjacencyEdge
+{
+	public:
+	ndInt32 m_minVertex;
+	ndInt32 m_maxVertex;
+	ndInt32 m_face;
+	ndInt32 m_count;
+	ndInt32 m_slot;
+};
+
+// binned surface area heuristic split. the boxes are binned by their centers along
+// each axis and the plane with the lowest area weighted count is selected, large 
+// ranges are binned in parallel. the partition does not depend on the thread count.
 class ndAabbPolygonSoup::ndSpliteInfo
 {
 	public:
-	ndSpliteInfo (ndNodeBuilder* const boxArray, ndInt32 boxCount)
+	class ndBounds
 	{
-		ndVector minP ( ndFloat32 (1.0e15f)); 
-		ndVector maxP (-ndFloat32 (1.0e15f)); 
+		public:
+		ndBounds()
+			:m_p0(ndFloat32(1.0e15f))
+			,m_p1(ndFloat32(-1.0e15f))
+			,m_center0(ndFloat32(1.0e15f))
+			,m_center1(ndFloat32(-1.0e15f))
+		{
+		}
 
-		if (boxCount == 2) 
+		void Add(const ndBuildBox& box)
 		{
-			m_axis = 1;
-			for (ndInt32 i = 0; i < boxCount; i ++) 
-			{
-				const ndNodeBuilder& box = boxArray[i];
-				const ndVector& p0 = box.m_p0;
-				const ndVector& p1 = box.m_p1;
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
-			}
+			// centers are kept doubled, it does not change the split
+			const ndVector center(box.m_p0 + box.m_p1);
+			m_p0 = m_p0.GetMin(box.m_p0);
+			m_p1 = m_p1.GetMax(box.m_p1);
+			m_center0 = m_center0.GetMin(center);
+			m_center1 = m_center1.GetMax(center);
+		}
 
-		} 
-		else 
+		ndVector m_p0;
+		ndVector m_p1;
+		ndVector m_center0;
+		ndVector m_center1;
+	};
+
+	class ndBin
+	{
+		public:
+		ndBin()
+			:m_p0(ndFloat32(1.0e15f))
+			,m_p1(ndFloat32(-1.0e15f))
+			,m_count(0)
 		{
-			ndVector median (ndVector::m_zero);
-			ndVector varian (ndVector::m_zero);
-			for (ndInt32 i = 0; i < boxCount; i ++) 
-			{
-				const ndNodeBuilder& box = boxArray[i];
+		}
+
+		void Add(const ndBin& bin)
+		{
+			m_p0 = m_p0.GetMin(bin.m_p0);
+			m_p1 = m_p1.GetMax(bin.m_p1);
+			m_count += bin.m_count;
+		}
 
-				const ndVector& p0 = box.m_p0;
-				const ndVector& p1 = box.m_p1;
+		ndFloat32 CalculateCost() const
+		{
+			const ndVector size((m_p1 - m_p0) & ndVector::m_triplexMask);
+			return size.DotProduct(size.ShiftTripleRight()).GetScalar() * ndFloat32(m_count);
+		}
 
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
-				ndVector p (ndVector::m_half * (p0 + p1));
+		ndVector m_p0;
+		ndVector m_p1;
+		ndInt32 m_count;
+	};
+
+	class ndBinSet
+	{
+		public:
+		ndBin m_bins[3][D_AABB_SOUP_SAH_BINS];
+	};
 
-				median += p;
-				varian += p * p;
+	ndSpliteInfo (ndBuildBox* const boxArray, ndInt32 boxCount, const ndBounds& bounds, ndThreadPool* const threadPool)
+	{
+		dAssert(boxCount >= 2);
+		m_axis = boxCount / 2;
+		const ndVector extent(bounds.m_center1 - bounds.m_center0);
+		if ((boxCount == 2) || (extent.GetMax().GetScalar() <= ndFloat32(0.0f)))
+		{
+			// all centers are at the same place
+			for (ndInt32 i = 0; i < boxCount; ++i)
+			{
+				(i < m_axis) ? m_left.Add(boxArray[i]) : m_right.Add(boxArray[i]);
 			}
+			return;
+		}
 
-			varian = varian.Scale (ndFloat32 (boxCount)) - median * median;
+		const bool parallel = threadPool && (boxCount >= D_AABB_SOUP_PARALLEL_SPLIT);
+		const ndInt32 threadCount = parallel ? threadPool->GetThreadCount() : 1;
 
-			ndInt32 index = 0;
-			ndFloat32 maxVarian = ndFloat32 (-1.0e10f);
-			for (ndInt32 i = 0; i < 3; i ++) 
+		// a bin set is a few kilobytes, the per thread sets go to the heap 
+		// so that worker threads with small stacks can build large meshes.
+		ndBinSet serialBinSet;
+		ndArray<ndBinSet> parallelBinSets;
+		if (parallel)
+		{
+			parallelBinSets.SetCount(threadCount);
+		}
+		ndBinSet* const binSets = parallel ? &parallelBinSets[0] : &serialBinSet;
+		for (ndInt32 i = 0; i < threadCount; ++i)
+		{
+			new (&binSets[i]) ndBinSet();
+		}
+
+		const ndVector center0(bounds.m_center0);
+		const ndVector scale(ndVector(ndFloat32(D_AABB_SOUP_SAH_BINS) * ndFloat32(0.9999f)) * extent.GetMax(ndVector(ndFloat32(1.0e-12f))).Reciproc());
+		auto BinBoxes = ndMakeObject::ndFunction([boxArray, boxCount, binSets, &center0, &scale](ndInt32 threadIndex, ndInt32 threadCount)
+		{
+			ndBinSet& binSet = binSets[threadIndex];
+			const ndStartEnd startEnd(boxCount, threadIndex, threadCount);
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
-				if (varian[i] > maxVarian) 
+				const ndBuildBox& box = boxArray[i];
+				const ndVector binIndex((box.m_p0 + box.m_p1 - center0) * scale);
+				for (ndInt32 axis = 0; axis < 3; ++axis)
 				{
-					index = i;
-					maxVarian = varian[i];
+					ndBin& bin = binSet.m_bins[axis][dClamp(ndInt32(binIndex[axis]), 0, D_AABB_SOUP_SAH_BINS - 1)];
+					bin.m_p0 = bin.m_p0.GetMin(box.m_p0);
+					bin.m_p1 = bin.m_p1.GetMax(box.m_p1);
+					bin.m_count++;
 				}
 			}
+		});
+		if (parallel)
+		{
+			threadPool->ParallelExecute(BinBoxes);
+		}
+		else
+		{
+			BinBoxes(0, 1);
+		}
 
-			ndVector center = median.Scale (ndFloat32 (1.0f) / ndFloat32 (boxCount));
-			ndFloat32 test = center[index];
-			ndInt32 i0 = 0;
-			ndInt32 i1 = boxCount - 1;
-			do 
-			{    
-				for (; i0 <= i1; i0 ++) 
+		ndBinSet& bins = binSets[0];
+		for (ndInt32 i = 1; i < threadCount; ++i)
+		{
+			for (ndInt32 axis = 0; axis < 3; ++axis)
+			{
+				for (ndInt32 j = 0; j < D_AABB_SOUP_SAH_BINS; ++j)
 				{
-					const ndNodeBuilder& box = boxArray[i0];
-					ndFloat32 val = (box.m_p0[index] + box.m_p1[index]) * ndFloat32 (0.5f);
-					if (val > test) 
-					{
-						break;
-					}
+					bins.m_bins[axis][j].Add(binSets[i].m_bins[axis][j]);
 				}
+			}
+		}
+
+		ndInt32 bestAxis = -1;
+		ndInt32 bestPlane = 0;
+		ndFloat32 bestCost = ndFloat32(1.0e30f);
+		for (ndInt32 axis = 0; axis < 3; ++axis)
+		{
+			if (extent[axis] <= ndFloat32(0.0f))
+			{
+				continue;
+			}
+
+			ndBin right;
+			ndFloat32 rightCost[D_AABB_SOUP_SAH_BINS];
+			for (ndInt32 j = D_AABB_SOUP_SAH_BINS - 1; j > 0; --j)
+			{
+				right.Add(bins.m_bins[axis][j]);
+				rightCost[j] = right.m_count ? right.CalculateCost() : ndFloat32(0.0f);
+			}
 
-				for (; i1 >= i0; i1 --) 
+			ndBin left;
+			for (ndInt32 j = 0; j < D_AABB_SOUP_SAH_BINS - 1; ++j)
+			{
+				left.Add(bins.m_bins[axis][j]);
+				if (left.m_count && (left.m_count < boxCount))
 				{
-					const ndNodeBuilder& box = boxArray[i1];
-					ndFloat32 val = (box.m_p0[index] + box.m_p1[index]) * ndFloat32 (0.5f);
-					if (val < test) 
+					const ndFloat32 cost = left.CalculateCost() + rightCost[j + 1];
+					if (cost < bestCost)
 					{
-						break;
+						bestCost = cost;
+						bestAxis = axis;
+						bestPlane = j + 1;
 					}
 				}
-
-				if (i0 < i1)
-				{
-					dSwap(boxArray[i0], boxArray[i1]);
-					i0++; 
-					i1--;
-				}
-			} while (i0 <= i1);
-
-			if (i0 > 0)
+			}
+		}
+		dAssert(bestAxis >= 0);
+
+		// the bounds of both sides are collected while partitioning
+		ndInt32 i0 = 0;
+		ndInt32 i1 = boxCount - 1;
+		const ndFloat32 origin = center0[bestAxis];
+		const ndFloat32 binScale = scale[bestAxis];
+		while (i0 <= i1)
+		{
+			const ndBuildBox& box = boxArray[i0];
+			const ndInt32 binIndex = dClamp(ndInt32((box.m_p0[bestAxis] + box.m_p1[bestAxis] - origin) * binScale), 0, D_AABB_SOUP_SAH_BINS - 1);
+			if (binIndex < bestPlane)
 			{
-				i0 --;
+				m_left.Add(box);
+				i0++;
 			}
-			if ((i0 + 1) >= boxCount) 
+			else
 			{
-				i0 = boxCount - 2;
+				m_right.Add(box);
+				dSwap(boxArray[i0], boxArray[i1]);
+				i1--;
 			}
-
-			m_axis = i0 + 1;
 		}
-
-		dAssert (maxP.m_x - minP.m_x >= ndFloat32 (0.0f));
-		dAssert (maxP.m_y - minP.m_y >= ndFloat32 (0.0f));
-		dAssert (maxP.m_z - minP.m_z >= ndFloat32 (0.0f));
-		m_p0 = minP;
-		m_p1 = maxP;
+		dAssert((i0 > 0) && (i0 < boxCount));
+		m_axis = i0;
 	}
 
+	ndBounds m_left;
+	ndBounds m_right;
 	ndInt32 m_axis;
-	ndVector m_p0;
-	ndVector m_p1;
 };
 
 ndAabbPolygonSoup::ndAabbPolygonSoup ()
 	:ndPolygonSoupDatabase()
 	,m_aabb(nullptr)
 	,m_indices(nullptr)
+	,m_wideNodes(nullptr)
+	,m_mappedFile(nullptr)
 	,m_nodesCount(0)
 	,m_indexCount(0)
+	,m_wideNodesCount(0)
 {
 }
 
 ndAabbPolygonSoup::~ndAabbPolygonSoup ()
 {
-	if (m_aabb) 
+	ReleaseWideNodes();
+	if (m_mappedFile)
+	{
+		// the arrays are views of the file
+		m_mappedFile->Release();
+		m_aabb = nullptr;
+		m_indices = nullptr;
+		m_localVertex = nullptr;
+	}
+	else if (m_aabb) 
 	{
 		ndMemory::Free(m_aabb);
 		ndMemory::Free(m_indices);
 	}
 }
 
+bool ndAabbPolygonSoup::IsMapped() const
+{
+	return m_mappedFile ? true : false;
+}
+
 void ndAabbPolygonSoup::ImproveNodeFitness (ndNodeBuilder* const node) const
 {
 	dAssert (node->m_left);
@@ -485,176 +700,167 @@ void ndAabbPolygonSoup::GetAABB (ndVector& p0, ndVector& p1) const
 	}
 }
 
-void ndAabbPolygonSoup::CalculateAdjacendy ()
+void ndAabbPolygonSoup::CalculateAdjacendy (ndThreadPool* const threadPool)
 {
-	ndVector p0;
-	ndVector p1;
-	GetAABB (p0, p1);
-	ndFastAabb box (p0, p1);
-
-	ndPolyhedra adjacenyMesh;
-	adjacenyMesh.BeginFace();
-	ForAllSectors(box, ndVector::m_zero, ndFloat32(1.0f), CalculateAllFaceEdgeNormals, &adjacenyMesh);
-	adjacenyMesh.EndFace();
-
-	ndInt32 mark = adjacenyMesh.IncLRU();
-	ndPolyhedra::Iterator iter(adjacenyMesh);
+	D_TRACKTIME();
+	// the edges of all faces are sorted by their lowest vertex index, so that twin edges 
+	// end up next to each other. an edge shared by exactly two faces, one in each direction, 
+	// is a twin pair, edges with more faces are left alone, so the result does not depend 
+	// on the face order or the thread count.
+	ndArray<ndAdjacencyEdge> edges;
+	ndArray<ndAdjacencyEdge> scratch;
+	ndStack<ndInt32> faceStart (2 * m_nodesCount + 1);
+	ndStack<ndInt32> edgeStart (2 * m_nodesCount + 1);
+
+	ndInt32 faceCount = 0;
+	ndInt32 edgeCount = 0;
+	for (ndInt32 i = 0; i < m_nodesCount; i ++) 
+	{
+		const ndNode* const node = &m_aabb[i];
+		if (node->m_left.IsLeaf() && node->m_left.GetCount()) 
+		{
+			faceStart[faceCount] = ndInt32 (node->m_left.GetIndex());
+			edgeStart[faceCount] = edgeCount;
+			edgeCount += ndInt32 (node->m_left.GetCount());
+			faceCount ++;
+		}
+		if (node->m_right.IsLeaf() && node->m_right.GetCount()) 
+		{
+			faceStart[faceCount] = ndInt32 (node->m_right.GetIndex());
+			edgeStart[faceCount] = edgeCount;
+			edgeCount += ndInt32 (node->m_right.GetCount());
+			faceCount ++;
+		}
+	}
+	edgeStart[faceCount] = edgeCount;
+	edges.SetCount(edgeCount);
+
+	ndInt32* const indices = m_indices;
 	const ndTriplex* const vertexArray = (ndTriplex*)GetLocalVertexPool();
-	for (iter.Begin(); iter; iter++)
+	auto AddEdges = ndMakeObject::ndFunction([indices, &faceStart, &edgeStart, &edges, faceCount](ndInt32 threadIndex, ndInt32 threadCount)
 	{
-		ndEdge* const edge = &(*iter);
-		if ((edge->m_mark != mark) && (edge->m_incidentFace >= 0) && (edge->m_twin->m_incidentFace >= 0))
+		D_TRACKTIME();
+		const ndStartEnd startEnd(faceCount, threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; i ++) 
 		{
-			#if 0
+			const ndInt32* const face = &indices[faceStart[i]];
+			const ndInt32 count = edgeStart[i + 1] - edgeStart[i];
+
+			// faces that repeat an edge or a vertex get no neighbors
+			bool valid = true;
+			for (ndInt32 j = 0; valid && (j < count); j ++) 
 			{
-				dInt32 indexCount0 = 0;
-				dEdge* ptr = edge;
-				do
+				const ndInt32 i0 = face[j];
+				const ndInt32 i1 = face[(j + 1) % count];
+				valid = (i0 != i1);
+				for (ndInt32 k = j + 1; valid && (k < count); k ++) 
 				{
-					indexCount0++;
-					ptr = ptr->m_next;
-				} while (ptr != edge);
-
-				dInt32* const indexArray0 = (dInt32*)edge->m_userData;
-				dVector n0(&vertexArray[indexArray0[indexCount0 + 1]].m_x);
-				dVector q0(&vertexArray[indexArray0[0]].m_x);
-				n0 = n0 & dVector::m_triplexMask;
-				q0 = q0 & dVector::m_triplexMask;
-
-				dInt32 indexCount1 = 0;
-				ptr = edge->m_twin;
-				do
-				{
-					indexCount1++;
-					ptr = ptr->m_next;
-				} while (ptr != edge->m_twin);
-
-				dInt32* const indexArray1 = (dInt32*)edge->m_twin->m_userData;
-				dVector n1(&vertexArray[indexArray1[indexCount1 + 1]].m_x);
-				dVector q1(&vertexArray[indexArray1[0]].m_x);
-				n1 = n1 & dVector::m_triplexMask;
-				q1 = q1 & dVector::m_triplexMask;
-
-				dPlane plane0(n0, -n0.DotProduct(q0).GetScalar());
-				dFloat32 maxDist0 = dFloat32(-1.0f);
-				dInt32 offsetIndex1 = -1;
-				for (dInt32 i = 0; i < indexCount1; i++)
-				{
-					if (edge->m_twin->m_incidentVertex == indexArray1[i])
-					{
-						offsetIndex1 = i;
-					}
-					dVector point(&vertexArray[indexArray1[i]].m_x);
-					dFloat32 dist(plane0.Evalue(point & dVector::m_triplexMask));
-					if (dist > maxDist0)
-					{
-						maxDist0 = dist;
-					}
-				}
-				if (maxDist0 < dFloat32(1.0e-3f))
-				{
-					dPlane plane1(n1, -n1.DotProduct(q1).GetScalar());
-					dFloat32 maxDist1 = dFloat32(-1.0f);
-					dInt32 offsetIndex0 = -1;
-					for (dInt32 i = 0; i < indexCount0; i++)
-					{
-						if (edge->m_incidentVertex == indexArray0[i])
-						{
-							offsetIndex0 = i;
-						}
-
-						dVector point(&vertexArray[indexArray0[i]].m_x);
-						dFloat32 dist(plane1.Evalue(point & dVector::m_triplexMask));
-						if (dist > maxDist1)
-						{
-							maxDist1 = dist;
-						}
-					}
-					if (maxDist1 < dFloat32(1.0e-3f))
-					{
-						dAssert(offsetIndex0 >= 0);
-						dAssert(offsetIndex1 >= 0);
-						indexArray0[indexCount0 + 2 + offsetIndex0] = indexArray1[indexCount1 + 1];
-						indexArray1[indexCount1 + 2 + offsetIndex1] = indexArray0[indexCount0 + 1];
-					}
+					const ndInt32 k0 = face[k];
+					const ndInt32 k1 = face[(k + 1) % count];
+					valid = !(((i0 == k0) && (i1 == k1)) || ((i0 == k1) && (i1 == k0)));
 				}
 			}
-			#endif
-
-			ndInt32 indexCount0 = 0;
-			ndInt32 indexCount1 = 0;
-			ndInt32 offsetIndex0 = -1;
-			ndInt32 offsetIndex1 = -1;
-			ndInt32* const indexArray0 = (ndInt32*)edge->m_userData;
-			ndInt32* const indexArray1 = (ndInt32*)edge->m_twin->m_userData;
-			ndEdge* ptr = edge;
-			do
-			{
-				indexCount0++;
-				ptr = ptr->m_next;
-			} while (ptr != edge);
 
-			ptr = edge->m_twin;
-			do
+			for (ndInt32 j = 0; j < count; j ++) 
 			{
-				indexCount1++;
-				ptr = ptr->m_next;
-			} while (ptr != edge->m_twin);
-
-			ndVector n0(&vertexArray[indexArray0[indexCount0 + 1]].m_x);
-			ndVector q0(&vertexArray[indexArray0[0]].m_x);
-			n0 = n0 & ndVector::m_triplexMask;
-			q0 = q0 & ndVector::m_triplexMask;
-
-			ndVector n1(&vertexArray[indexArray1[indexCount1 + 1]].m_x);
-			ndVector q1(&vertexArray[indexArray1[0]].m_x);
-			n1 = n1 & ndVector::m_triplexMask;
-			q1 = q1 & ndVector::m_triplexMask;
-
-			ndPlane plane0(n0, -n0.DotProduct(q0).GetScalar());
-			ndPlane plane1(n1, -n1.DotProduct(q1).GetScalar());
+				const ndInt32 i0 = face[j];
+				const ndInt32 i1 = face[(j + 1) % count];
+				ndAdjacencyEdge& edge = edges[edgeStart[i] + j];
+				edge.m_minVertex = dMin(i0, i1);
+				edge.m_maxVertex = dMax(i0, i1);
+				edge.m_face = faceStart[i];
+				edge.m_count = valid ? count : 0;
+				edge.m_slot = j;
+			}
+		}
+	});
 
-			ndFloat32 maxDist0 = ndFloat32(-1.0f);
-			for (ndInt32 i = 0; i < indexCount1; i++)
+	auto PairEdges = ndMakeObject::ndFunction([this, indices, vertexArray, &edges](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		// each run of edges with the same lowest vertex is done by the thread owning its first edge
+		const ndInt32 count = edges.GetCount();
+		const ndStartEnd startEnd(count, threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; i ++) 
+		{
+			const ndAdjacencyEdge& edge0 = edges[i];
+			if (i && (edges[i - 1].m_minVertex == edge0.m_minVertex))
 			{
-				if (edge->m_twin->m_incidentVertex == indexArray1[i])
-				{
-					offsetIndex1 = i;
-				}
-				ndVector point(&vertexArray[indexArray1[i]].m_x);
-				ndFloat32 dist(plane0.Evalue(point & ndVector::m_triplexMask));
-				maxDist0 = dMax(maxDist0, dist);
+				continue;
 			}
 
-			ndFloat32 maxDist1 = ndFloat32(-1.0f);
-			for (ndInt32 i = 0; i < indexCount0; i++)
+			ndInt32 end = i + 1;
+			for (; (end < count) && (edges[end].m_minVertex == edge0.m_minVertex); end ++);
+			for (ndInt32 j = i; j < end; j ++) 
 			{
-				if (edge->m_incidentVertex == indexArray0[i])
+				ndInt32 twin = -1;
+				ndInt32 shared = 0;
+				const ndAdjacencyEdge& edge = edges[j];
+				for (ndInt32 k = i; edge.m_count && (k < end); k ++) 
+				{
+					if ((k != j) && edges[k].m_count && (edges[k].m_maxVertex == edge.m_maxVertex))
+					{
+						twin = k;
+						shared ++;
+					}
+				}
+				if ((shared == 1) && (twin > j))
 				{
-					offsetIndex0 = i;
+					const ndAdjacencyEdge& edge1 = edges[twin];
+					const ndInt32 start0 = indices[edge.m_face + edge.m_slot];
+					const ndInt32 start1 = indices[edge1.m_face + edge1.m_slot];
+					if (start0 != start1)
+					{
+						SetAdjacentEdge(vertexArray, &indices[edge.m_face], edge.m_count, edge.m_slot, &indices[edge1.m_face], edge1.m_count, edge1.m_slot);
+					}
 				}
-				ndVector point(&vertexArray[indexArray0[i]].m_x);
-				ndFloat32 dist(plane1.Evalue(point & ndVector::m_triplexMask));
-				maxDist1 = dMax(maxDist1, dist);
 			}
+		}
+	});
 
-			bool edgeIsConvex = (maxDist0 <= ndFloat32(1.0e-3f));
-			edgeIsConvex = edgeIsConvex && (maxDist1 <= ndFloat32(1.0e-3f));
-			edgeIsConvex = edgeIsConvex || (n0.DotProduct(n1).GetScalar() > ndFloat32(0.9991f));
+	class ndEvaluateKey
+	{
+		public:
+		ndEvaluateKey(void* const context)
+			:m_shift(*((ndInt32*)context))
+		{
+		}
 
-			//hacks for testing adjacency
-			//edgeIsConvex = edgeIsConvex || (n0.DotProduct(n1).GetScalar() > ndFloat32(0.5f));
-			//edgeIsConvex = true;
-			if (edgeIsConvex)
-			{
-				dAssert(offsetIndex0 >= 0);
-				dAssert(offsetIndex1 >= 0);
-				indexArray0[indexCount0 + 2 + offsetIndex0] = indexArray1[indexCount1 + 1];
-				indexArray1[indexCount1 + 2 + offsetIndex1] = indexArray0[indexCount0 + 1];
-			}
+		ndInt32 GetKey(const ndAdjacencyEdge& edge) const
+		{
+			return (edge.m_minVertex >> m_shift) & 0xff;
+		}
+
+		ndInt32 m_shift;
+	};
+
+	ndInt32 passes = 1;
+	for (ndUnsigned32 bits = ndUnsigned32 (dMax (GetVertexCount() - 1, 0)) >> 8; bits; bits >>= 8)
+	{
+		passes ++;
+	}
+
+	if (threadPool && edgeCount)
+	{
+		threadPool->Begin();
+		threadPool->ParallelExecute(AddEdges);
+		for (ndInt32 pass = 0; pass < passes; pass ++) 
+		{
+			ndInt32 shift = pass * 8;
+			ndCountingSort<ndAdjacencyEdge, ndEvaluateKey, 8>(*threadPool, edges, scratch, &shift);
+		}
+		threadPool->ParallelExecute(PairEdges);
+		threadPool->End();
+	}
+	else if (edgeCount)
+	{
+		AddEdges(0, 1);
+		for (ndInt32 pass = 0; pass < passes; pass ++) 
+		{
+			ndInt32 shift = pass * 8;
+			ndCountingSort<ndAdjacencyEdge, ndEvaluateKey, 8>(edges, scratch, &shift);
 		}
-		edge->m_mark = mark;
-		edge->m_twin->m_mark = mark;
+		PairEdges(0, 1);
 	}
 
 	ndStack<ndTriplex> pool ((m_indexCount / 2) - 1);
@@ -806,18 +1012,51 @@ void ndAabbPolygonSoup::CalculateAdjacendy ()
 	}
 }
 
-dIntersectStatus ndAabbPolygonSoup::CalculateAllFaceEdgeNormals(void* const context, const ndFloat32* const, ndInt32, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32)
+void ndAabbPolygonSoup::SetAdjacentEdge(const ndTriplex* const vertexArray, ndInt32* const indexArray0, ndInt32 indexCount0, ndInt32 slot0, ndInt32* const indexArray1, ndInt32 indexCount1, ndInt32 slot1)
 {
-	ndInt32 face[256];
-	ndInt64 data[256];
-	ndPolyhedra& adjacency = *((ndPolyhedra*)context);
-	for (ndInt32 i = 0; i < indexCount; i++)
+	// the edge is slot0 of face 0 and slot1 of face 1, when the two faces make 
+	// a convex or flat edge each face takes the normal of the other as the edge normal.
+	ndVector n0(&vertexArray[indexArray0[indexCount0 + 1]].m_x);
+	ndVector q0(&vertexArray[indexArray0[0]].m_x);
+	n0 = n0 & ndVector::m_triplexMask;
+	q0 = q0 & ndVector::m_triplexMask;
+
+	ndVector n1(&vertexArray[indexArray1[indexCount1 + 1]].m_x);
+	ndVector q1(&vertexArray[indexArray1[0]].m_x);
+	n1 = n1 & ndVector::m_triplexMask;
+	q1 = q1 & ndVector::m_triplexMask;
+
+	ndPlane plane0(n0, -n0.DotProduct(q0).GetScalar());
+	ndPlane plane1(n1, -n1.DotProduct(q1).GetScalar());
+
+	ndFloat32 maxDist0 = ndFloat32(-1.0f);
+	for (ndInt32 i = 0; i < indexCount1; i++)
 	{
-		face[i] = indexArray[i];
-		data[i] = ndInt64(indexArray);
+		ndVector point(&vertexArray[indexArray1[i]].m_x);
+		ndFloat32 dist(plane0.Evalue(point & ndVector::m_triplexMask));
+		maxDist0 = dMax(maxDist0, dist);
+	}
+
+	ndFloat32 maxDist1 = ndFloat32(-1.0f);
+	for (ndInt32 i = 0; i < indexCount0; i++)
+	{
+		ndVector point(&vertexArray[indexArray0[i]].m_x);
+		ndFloat32 dist(plane1.Evalue(point & ndVector::m_triplexMask));
+		maxDist1 = dMax(maxDist1, dist);
+	}
+
+	bool edgeIsConvex = (maxDist0 <= ndFloat32(1.0e-3f));
+	edgeIsConvex = edgeIsConvex && (maxDist1 <= ndFloat32(1.0e-3f));
+	edgeIsConvex = edgeIsConvex || (n0.DotProduct(n1).GetScalar() > ndFloat32(0.9991f));
+
+	//hacks for testing adjacency
+	//edgeIsConvex = edgeIsConvex || (n0.DotProduct(n1).GetScalar() > ndFloat32(0.5f));
+	//edgeIsConvex = true;
+	if (edgeIsConvex)
+	{
+		indexArray0[indexCount0 + 2 + slot0] = indexArray1[indexCount1 + 1];
+		indexArray1[indexCount1 + 2 + slot1] = indexArray0[indexCount0 + 1];
 	}
-	adjacency.AddFace(indexCount, face, data);
-	return t_ContinueSearh;
 }
 
 dIntersectStatus ndAabbPolygonSoup::CalculateDisjointedFaceEdgeNormals (void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32)
@@ -929,33 +1168,117 @@ dIntersectStatus ndAabbPolygonSoup::CalculateDisjointedFaceEdgeNormals (void* co
 	return t_ContinueSearh;
 }
 
-ndAabbPolygonSoup::ndNodeBuilder* ndAabbPolygonSoup::BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator) const
+ndAabbPolygonSoup::ndNodeBuilder* ndAabbPolygonSoup::BuildTopDown (ndNodeBuilder* const leafArray, ndBuildBox* const boxArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder* const nodeArray, ndThreadPool* const threadPool) const
 {
-	dAssert (firstBox >= 0);
-	dAssert (lastBox >= 0);
+	class ndBuildRange
+	{
+		public:
+		ndSpliteInfo::ndBounds m_bounds;
+		ndNodeBuilder* m_parent;
+		ndInt32 m_firstBox;
+		ndInt32 m_lastBox;
+		ndInt32 m_isLeft;
+	};
 
-	if (lastBox == firstBox) 
+	dAssert (firstBox >= 0);
+	dAssert (lastBox >= firstBox);
+
+	// the parent of boxes [first, last] split at m goes to nodeArray[m - 1], 
+	// so that separate ranges can be built by different threads.
+	const ndInt32 threadCount = threadPool ? threadPool->GetThreadCount() : 1;
+	const ndInt32 grainSize = (threadCount > 1) ? dMax((lastBox - firstBox + 1) / (threadCount * 8), 256) : 0;
+
+	ndBuildRange range;
+	range.m_parent = nullptr;
+	range.m_firstBox = firstBox;
+	range.m_lastBox = lastBox;
+	range.m_isLeft = 0;
+	for (ndInt32 i = firstBox; i <= lastBox; ++i)
 	{
-		return &leafArray[firstBox];
-	} 
-	else 
+		range.m_bounds.Add(boxArray[i]);
+	}
+
+	ndNodeBuilder* root = nullptr;
+	ndArray<ndBuildRange> deferred;
+	ndArray<ndBuildRange> stack;
+	stack.PushBack(range);
+	while (stack.GetCount())
 	{
-		ndSpliteInfo info (&leafArray[firstBox], lastBox - firstBox + 1);
+		range = stack[stack.GetCount() - 1];
+		stack.SetCount(stack.GetCount() - 1);
 
-		ndNodeBuilder* const parent = new (*allocator) ndNodeBuilder (info.m_p0, info.m_p1);
-		*allocator = *allocator + 1;
+		ndNodeBuilder* node = nullptr;
+		if (range.m_lastBox == range.m_firstBox)
+		{
+			node = &leafArray[boxArray[range.m_firstBox].m_leaf];
+		}
+		else if ((range.m_lastBox - range.m_firstBox) < grainSize)
+		{
+			deferred.PushBack(range);
+			continue;
+		}
+		else
+		{
+			const ndSpliteInfo info (&boxArray[range.m_firstBox], range.m_lastBox - range.m_firstBox + 1, range.m_bounds, threadPool);
+			const ndInt32 split = range.m_firstBox + info.m_axis;
+			node = new (&nodeArray[split - 1]) ndNodeBuilder (range.m_bounds.m_p0, range.m_bounds.m_p1);
+
+			ndBuildRange right (range);
+			right.m_bounds = info.m_right;
+			right.m_parent = node;
+			right.m_firstBox = split;
+			right.m_isLeft = 0;
+			stack.PushBack(right);
+
+			ndBuildRange left (range);
+			left.m_bounds = info.m_left;
+			left.m_parent = node;
+			left.m_lastBox = split - 1;
+			left.m_isLeft = 1;
+			stack.PushBack(left);
+		}
 
-		dAssert (parent);
-		parent->m_right = BuildTopDown (leafArray, firstBox + info.m_axis, lastBox, allocator);
-		parent->m_right->m_parent = parent;
+		node->m_parent = range.m_parent;
+		if (!range.m_parent)
+		{
+			root = node;
+		}
+		else if (range.m_isLeft)
+		{
+			range.m_parent->m_left = node;
+		}
+		else
+		{
+			range.m_parent->m_right = node;
+		}
+	}
 
-		parent->m_left = BuildTopDown (leafArray, firstBox, firstBox + info.m_axis - 1, allocator);
-		parent->m_left->m_parent = parent;
-		return parent;
+	if (deferred.GetCount())
+	{
+		auto BuildSubTrees = ndMakeObject::ndFunction([this, leafArray, boxArray, nodeArray, &deferred](ndInt32, ndInt32 start, ndInt32 end)
+		{
+			D_TRACKTIME();
+			for (ndInt32 i = start; i < end; ++i)
+			{
+				const ndBuildRange& subTree = deferred[i];
+				ndNodeBuilder* const node = BuildTopDown (leafArray, boxArray, subTree.m_firstBox, subTree.m_lastBox, nodeArray, nullptr);
+				node->m_parent = subTree.m_parent;
+				if (subTree.m_isLeft)
+				{
+					subTree.m_parent->m_left = node;
+				}
+				else
+				{
+					subTree.m_parent->m_right = node;
+				}
+			}
+		});
+		threadPool->ParallelExecuteRange(deferred.GetCount(), BuildSubTrees);
 	}
+	return root;
 }
 
-void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
+void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder, ndThreadPool* const threadPool)
 {
 	if (builder.m_faceVertexCount.GetCount() == 0) 
 	{
@@ -989,7 +1312,6 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	const ndInt32* const indices = &builder.m_vertexIndex[0];
 	ndStack<ndNodeBuilder> constructor (builder.m_faceVertexCount.GetCount() * 2 + 16); 
 
-	ndInt32 polygonIndex = 0;
 	ndInt32 allocatorIndex = 0;
 	if (builder.m_faceVertexCount.GetCount() == 1) 
 	{
@@ -997,16 +1319,51 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 		new (&constructor[allocatorIndex]) ndNodeBuilder (&tmpVertexArray[0], 0, indexCount, &indices[0]);
 		allocatorIndex ++;
 	}
-	for (ndInt32 i = 0; i < builder.m_faceVertexCount.GetCount(); i ++) 
+
+	const ndInt32 faceCount = builder.m_faceVertexCount.GetCount();
+	ndStack<ndInt32> faceStart (faceCount);
+	ndInt32 polygonIndex = 0;
+	for (ndInt32 i = 0; i < faceCount; i ++) 
 	{
-		ndInt32 indexCount = builder.m_faceVertexCount[i] - 1;
-		new (&constructor[allocatorIndex]) ndNodeBuilder (&tmpVertexArray[0], i, indexCount, &indices[polygonIndex]);
-		allocatorIndex ++;
-		polygonIndex += (indexCount + 1);
+		faceStart[i] = polygonIndex;
+		polygonIndex += builder.m_faceVertexCount[i];
 	}
 
-	ndNodeBuilder* contructorAllocator = &constructor[allocatorIndex];
-	ndNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator);
+	ndNodeBuilder* const leafArray = &constructor[allocatorIndex];
+	allocatorIndex += faceCount;
+	ndStack<ndBuildBox> boxArray (allocatorIndex);
+	auto BuildLeafs = ndMakeObject::ndFunction([&builder, &faceStart, &constructor, &boxArray, leafArray, tmpVertexArray, indices, faceCount, allocatorIndex](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		const ndStartEnd startEnd(faceCount, threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; i ++) 
+		{
+			ndInt32 indexCount = builder.m_faceVertexCount[i] - 1;
+			new (&leafArray[i]) ndNodeBuilder (&tmpVertexArray[0], i, indexCount, &indices[faceStart[i]]);
+		}
+
+		const ndStartEnd boxStartEnd(allocatorIndex, threadIndex, threadCount);
+		for (ndInt32 i = boxStartEnd.m_start; i < boxStartEnd.m_end; i ++) 
+		{
+			boxArray[i].m_p0 = constructor[i].m_p0;
+			boxArray[i].m_p1 = constructor[i].m_p1;
+			boxArray[i].m_leaf = i;
+		}
+	});
+
+	ndNodeBuilder* root = nullptr;
+	if (threadPool)
+	{
+		threadPool->Begin();
+		threadPool->ParallelExecute(BuildLeafs);
+		root = BuildTopDown (&constructor[0], &boxArray[0], 0, allocatorIndex - 1, &constructor[allocatorIndex], threadPool);
+		threadPool->End();
+	}
+	else
+	{
+		BuildLeafs(0, 1);
+		root = BuildTopDown (&constructor[0], &boxArray[0], 0, allocatorIndex - 1, &constructor[allocatorIndex], nullptr);
+	}
 
 	dAssert (root);
 	dTrace(("*****->this is broken\n"));
@@ -1057,24 +1414,24 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	//	}
 	//}
 
-	ndList<ndNodeBuilder*> list;
-	list.Append(root);
+	// breadth first enumeration, the queue holds every node once
+	ndStack<ndNodeBuilder*> queue (allocatorIndex * 2);
+	ndInt32 queueHead = 0;
+	ndInt32 queueTail = 0;
+	queue[queueTail++] = root;
 	ndInt32 nodeIndex = 0;
-	while (list.GetCount())
+	while (queueHead < queueTail)
 	{
-		ndNodeBuilder* const node = list.GetFirst()->GetInfo();
-		list.Remove(list.GetFirst());
-
+		ndNodeBuilder* const node = queue[queueHead++];
 		if (node->m_left) 
 		{
 			node->m_enumeration = nodeIndex;
 			nodeIndex ++;
 			dAssert (node->m_right);
-			list.Append(node->m_left);
-			list.Append(node->m_right);
+			queue[queueTail++] = node->m_left;
+			queue[queueTail++] = node->m_right;
 		}
 	}
-	dAssert(!list.GetCount());
 
 	ndInt32 aabbBase = builder.m_vertexPoints.GetCount() + builder.m_normalPoints.GetCount();
 
@@ -1082,12 +1439,10 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 
 	ndInt32 vertexIndex = 0;
 	ndInt32 aabbNodeIndex = 0;
-	list.Append(root);
 	ndInt32 indexMap = 0;
-	while (list.GetCount())
+	for (ndInt32 i = 0; i < queueTail; ++i)
 	{
-		ndNodeBuilder* const node = list.GetFirst()->GetInfo();
-		list.Remove(list.GetFirst());
+		ndNodeBuilder* const node = queue[i];
 
 		if (node->m_enumeration >= 0)
 		{
@@ -1152,13 +1507,6 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 
 			indexMap += node->m_indexCount * 2 + 3;
 		}
-
-		if (node->m_left) 
-		{
-			dAssert (node->m_right);
-			list.Append(node->m_left);
-			list.Append(node->m_right);
-		}
 	}
 
 	ndStack<ndInt32> indexArray (vertexIndex);
@@ -1192,53 +1540,575 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	}
 }
 
+void ndAabbPolygonSoup::SerializeToMemory (ndArray<char>& data) const
+{
+	const ndFileHeader header(m_vertexCount, m_indexCount, m_aabb ? m_nodesCount : 0);
+	data.SetCount(ndInt32(header.m_fileSize));
+	memset(&data[0], 0, size_t(header.m_fileSize));
+	memcpy(&data[0], &header, sizeof(ndFileHeader));
+	if (m_aabb)
+	{
+		// sections are aligned so that they can be used in place once the file is mapped
+		memcpy(&data[ndInt32(header.m_vertexOffset)], m_localVertex, sizeof(ndTriplex) * m_vertexCount);
+		memcpy(&data[ndInt32(header.m_indexOffset)], m_indices, sizeof(ndInt32) * m_indexCount);
+		memcpy(&data[ndInt32(header.m_nodesOffset)], m_aabb, sizeof(ndNode) * m_nodesCount);
+	}
+}
+
 void ndAabbPolygonSoup::Serialize (const char* const path) const
 {
-	FILE* const file = fopen(path, "wb");
-	if (file)
+	// the file is written next to the destination and renamed over it, so a soup 
+	// mapping the path keeps its view of the old file instead of seeing it truncated.
+	ndArray<char> data;
+	SerializeToMemory(data);
+	SaveBinaryFile(path, &data[0], size_t(data.GetCount()));
+}
+
+bool ndAabbPolygonSoup::Deserialize (const char* const path)
+{
+	dAssert(!m_aabb);
+	dAssert(!m_mappedFile);
+	FILE* const file = fopen(path, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	m_strideInBytes = sizeof(ndTriplex);
+
+	ndFileHeader header;
+	fseek(file, 0, SEEK_END);
+	const ndUnsigned64 fileSize = ndUnsigned64(ftell(file));
+	fseek(file, 0, SEEK_SET);
+	bool valid = fread(&header, sizeof(ndFileHeader), 1, file) == 1;
+	if (valid && header.HasMagic())
+	{
+		valid = header.IsValid(fileSize);
+		m_vertexCount = header.m_vertexCount;
+		m_indexCount = header.m_indexCount;
+		m_nodesCount = header.m_nodesCount;
+	}
+	else
+	{
+		// files saved before the format had a header
+		fseek(file, 0, SEEK_SET);
+		valid = fread(&m_vertexCount, sizeof(ndInt32), 1, file) == 1;
+		valid = valid && (fread(&m_indexCount, sizeof(ndInt32), 1, file) == 1);
+		valid = valid && (fread(&m_nodesCount, sizeof(ndInt32), 1, file) == 1);
+		valid = valid && (m_vertexCount >= 0) && (m_indexCount >= 0) && (m_nodesCount >= 0);
+		header.m_vertexOffset = 3 * sizeof(ndInt32);
+		header.m_indexOffset = header.m_vertexOffset + sizeof(ndTriplex) * m_vertexCount;
+		header.m_nodesOffset = header.m_indexOffset + sizeof(ndInt32) * m_indexCount;
+	}
+
+	m_localVertex = nullptr;
+	m_indices = nullptr;
+	m_aabb = nullptr;
+	if (valid && m_vertexCount && m_nodesCount) 
 	{
-		fwrite(&m_vertexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_indexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_nodesCount, sizeof(ndInt32), 1, file);
+		m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
+		m_indices = (ndInt32*)ndMemory::Malloc(sizeof(ndInt32) * m_indexCount);
+		m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode) * m_nodesCount);
+
+		fseek(file, long(header.m_vertexOffset), SEEK_SET);
+		valid = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file) == 1;
+		fseek(file, long(header.m_indexOffset), SEEK_SET);
+		valid = valid && (fread(m_indices, sizeof(ndInt32) * m_indexCount, 1, file) == 1);
+		fseek(file, long(header.m_nodesOffset), SEEK_SET);
+		valid = valid && (fread(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file) == 1);
+	}
+	fclose(file);
+
+	if (!valid)
+	{
+		// a truncated or incompatible file leaves an empty soup
 		if (m_aabb)
 		{
-			fwrite(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
-			fwrite(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
-			fwrite(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file);
+			ndMemory::Free(m_localVertex);
+			ndMemory::Free(m_indices);
+			ndMemory::Free(m_aabb);
 		}
-		fclose(file);
+		m_localVertex = nullptr;
+		m_indices = nullptr;
+		m_aabb = nullptr;
+		m_vertexCount = 0;
+		m_indexCount = 0;
+		m_nodesCount = 0;
 	}
+	return valid;
 }
 
-void ndAabbPolygonSoup::Deserialize (const char* const path)
+bool ndAabbPolygonSoup::MapFile (const char* const path)
 {
-	FILE* const file = fopen(path, "rb");
-	if (file)
+	dAssert(!m_aabb);
+	dAssert(!m_mappedFile);
+	ndMappedFile* const file = ndMappedFile::Open(path);
+	if (!file)
+	{
+		return false;
+	}
+
+	const ndFileHeader* const header = (ndFileHeader*)file->GetData();
+	if ((file->GetSize() < sizeof(ndFileHeader)) || !header->IsValid(file->GetSize()))
 	{
-		size_t readValues = 0; 
-		m_strideInBytes = sizeof(ndTriplex);
-		readValues = fread(&m_vertexCount, sizeof(ndInt32), 1, file);
-		readValues = fread(&m_indexCount, sizeof(ndInt32), 1, file);
-		readValues = fread(&m_nodesCount, sizeof(ndInt32), 1, file);
+		file->Release();
+		return false;
+	}
 
-		if (m_vertexCount) 
+	const char* const data = (char*)file->GetData();
+	m_mappedFile = file;
+	m_strideInBytes = sizeof(ndTriplex);
+	m_vertexCount = header->m_vertexCount;
+	m_indexCount = header->m_indexCount;
+	m_nodesCount = header->m_nodesCount;
+	if (m_nodesCount)
+	{
+		m_localVertex = (ndFloat32*)(data + header->m_vertexOffset);
+		m_indices = (ndInt32*)(data + header->m_indexOffset);
+		m_aabb = (ndNode*)(data + header->m_nodesOffset);
+	}
+	return true;
+}
+
+void ndAabbPolygonSoup::GetChildAabb (const ndNode::ndLeafNodePtr& child, ndVector& p0, ndVector& p1) const
+{
+	if (child.IsLeaf())
+	{
+		// same padding the builder gives to the face boxes
+		const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+		const ndInt32 index = ndInt32 (child.GetIndex());
+		const ndInt32 vCount = ndInt32 (child.GetCount());
+		p0 = ndVector (ndFloat32 (1.0e15f));
+		p1 = ndVector (ndFloat32 (-1.0e15f));
+		for (ndInt32 i = 0; i < vCount; ++i)
 		{
-			m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
-			m_indices = (ndInt32*)ndMemory::Malloc(sizeof(ndInt32) * m_indexCount);
-			m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode) * m_nodesCount);
+			const ndVector p (ndVector (&vertexArray[m_indices[index + i]].m_x) & ndVector::m_triplexMask);
+			p0 = p0.GetMin(p);
+			p1 = p1.GetMax(p);
+		}
+		p0 = (p0 - ndVector (ndFloat32 (1.0e-3f))) & ndVector::m_triplexMask;
+		p1 = (p1 + ndVector (ndFloat32 (1.0e-3f))) & ndVector::m_triplexMask;
+	}
+	else
+	{
+		GetNodeAabb(child.GetNode(m_aabb), p0, p1);
+	}
+}
+
+void ndAabbPolygonSoup::ReleaseWideNodes ()
+{
+	if (m_wideNodes)
+	{
+		ndMemory::Free(m_wideNodes);
+		m_wideNodes = nullptr;
+		m_wideNodesCount = 0;
+	}
+}
+
+void ndAabbPolygonSoup::SetWideNodes (bool state)
+{
+	ReleaseWideNodes();
+	if (state && m_aabb)
+	{
+		BuildWideNodes();
+	}
+}
 
-			readValues = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
-			readValues = fread(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
-			readValues = fread(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file);
+void ndAabbPolygonSoup::BuildWideNodes ()
+{
+	D_TRACKTIME();
+	// each wide node takes the children of a binary node and keeps opening 
+	// the largest inner child until it has four, leaves are the same faces.
+	ndArray<const ndNode*> binaryNodes;
+	ndArray<ndWideNode> wideNodes;
+	binaryNodes.PushBack(m_aabb);
+	for (ndInt32 nodeIndex = 0; nodeIndex < binaryNodes.GetCount(); ++nodeIndex)
+	{
+		const ndNode* const node = binaryNodes[nodeIndex];
+
+		ndInt32 count = 2;
+		ndVector p0[4];
+		ndVector p1[4];
+		ndNode::ndLeafNodePtr children[4] = { node->m_left, node->m_right, node->m_left, node->m_right };
+		GetChildAabb(children[0], p0[0], p1[0]);
+		GetChildAabb(children[1], p0[1], p1[1]);
+		while (count < 4)
+		{
+			ndInt32 best = -1;
+			ndFloat32 bestArea = ndFloat32 (-1.0f);
+			for (ndInt32 i = 0; i < count; ++i)
+			{
+				if (!children[i].IsLeaf())
+				{
+					const ndVector size (p1[i] - p0[i]);
+					const ndFloat32 area = size.DotProduct(size.ShiftTripleRight()).GetScalar();
+					if (area > bestArea)
+					{
+						best = i;
+						bestArea = area;
+					}
+				}
+			}
+			if (best < 0)
+			{
+				break;
+			}
+			const ndNode* const child = children[best].GetNode(m_aabb);
+			children[best] = child->m_left;
+			children[count] = child->m_right;
+			GetChildAabb(children[best], p0[best], p1[best]);
+			GetChildAabb(children[count], p0[count], p1[count]);
+			count++;
 		}
-		else 
+
+		ndVector boxP0 (p0[0]);
+		ndVector boxP1 (p1[0]);
+		for (ndInt32 i = 1; i < count; ++i)
 		{
-			m_localVertex = nullptr;
-			m_indices = nullptr;
-			m_aabb = nullptr;
+			boxP0 = boxP0.GetMin(p0[i]);
+			boxP1 = boxP1.GetMax(p1[i]);
+		}
+
+		// the steps leave some room at the top and are never smaller than the 
+		// precision of the box position, so that the rounding can always cover.
+		ndWideNode wideNode;
+		const ndVector magnitude ((boxP0.Abs() + boxP1.Abs()) * ndVector (ndFloat32 (1.0f / (1 << 20))));
+		wideNode.m_origin = boxP0;
+		wideNode.m_scale = ((boxP1 - boxP0) * ndVector (ndFloat32 (1.0f / 65000.0f))).GetMax(magnitude).GetMax(ndVector (ndFloat32 (1.0e-6f))) & ndVector::m_triplexMask;
+		const ndVector invScale (wideNode.m_scale.Reciproc() & ndVector::m_triplexMask);
+
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			if (i >= count)
+			{
+				for (ndInt32 j = 0; j < 3; ++j)
+				{
+					wideNode.m_min[j][i] = 0xffff;
+					wideNode.m_max[j][i] = 0;
+				}
+				wideNode.m_child[i] = ndNode::ndLeafNodePtr (0, 0);
+				continue;
+			}
+
+			const ndVector q0 (((p0[i] - boxP0) * invScale).Floor());
+			const ndVector q1 (((p1[i] - boxP0) * invScale).Floor() + ndVector::m_one);
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				const ndVector origin (wideNode.m_origin[j]);
+				const ndVector scale (wideNode.m_scale[j]);
+				ndInt32 qMin = dClamp (ndInt32 (q0[j]), 0, 0xffff);
+				ndInt32 qMax = dClamp (ndInt32 (q1[j]), 0, 0xffff);
+				while ((qMin > 0) && ((origin + scale * ndVector (ndFloat32 (qMin))).GetScalar() > p0[i][j]))
+				{
+					qMin--;
+				}
+				while ((qMax < 0xffff) && ((origin + scale * ndVector (ndFloat32 (qMax))).GetScalar() < p1[i][j]))
+				{
+					qMax++;
+				}
+				dAssert ((origin + scale * ndVector (ndFloat32 (qMin))).GetScalar() <= p0[i][j]);
+				dAssert ((origin + scale * ndVector (ndFloat32 (qMax))).GetScalar() >= p1[i][j]);
+				wideNode.m_min[j][i] = ndUnsigned16 (qMin);
+				wideNode.m_max[j][i] = ndUnsigned16 (qMax);
+			}
+
+			if (children[i].IsLeaf())
+			{
+				wideNode.m_child[i] = children[i];
+			}
+			else
+			{
+				wideNode.m_child[i] = ndNode::ndLeafNodePtr (ndUnsigned32 (binaryNodes.GetCount()));
+				binaryNodes.PushBack(children[i].GetNode(m_aabb));
+			}
 		}
+		wideNodes.PushBack(wideNode);
+	}
+
+	m_wideNodesCount = wideNodes.GetCount();
+	m_wideNodes = (ndWideNode*)ndMemory::Malloc(sizeof(ndWideNode) * m_wideNodesCount);
+	memcpy(m_wideNodes, &wideNodes[0], sizeof(ndWideNode) * m_wideNodesCount);
+}
 
-		fclose(file);
+// ray distance to the four children boxes of a wide node, misses and 
+// empty children return 1.2 like ndFastRay::BoxIntersect
+static inline ndVector ndWideRayDistance (const ndFastRay& ray, const ndVector* const minBox, const ndVector* const maxBox, const ndVector& empty)
+{
+	ndVector t0 (ndVector::m_zero);
+	ndVector t1 (ndVector::m_one);
+	ndVector reject (empty);
+	const ndInt32 parallel = ray.m_isParallel.GetSignMask();
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		const ndVector p (ray.m_p0[i]);
+		if (parallel & (1 << i))
+		{
+			reject = reject | (p <= minBox[i]) | (p >= maxBox[i]);
+		}
+		const ndVector dpInv (ray.m_dpInv[i]);
+		const ndVector tt0 (dpInv * (minBox[i] - p));
+		const ndVector tt1 (dpInv * (maxBox[i] - p));
+		t0 = t0.GetMax(tt0.GetMin(tt1));
+		t1 = t1.GetMin(tt0.GetMax(tt1));
+	}
+	const ndVector mask ((t0 < t1).AndNot(reject));
+	return ndVector (ndFloat32 (1.2f)).Select(t0, mask);
+}
+
+void ndAabbPolygonSoup::ForAllSectorsRayHitWide (const ndFastRay& ray, ndFloat32 maxParam, dRayIntersectCallback callback, void* const context) const
+{
+	const ndWideNode* stackPool[DG_STACK_DEPTH];
+	ndFloat32 distance[DG_STACK_DEPTH];
+	const ndTriplex* const vertexArray = (ndTriplex*) m_localVertex;
+
+	ndInt32 stack = 1;
+	stackPool[0] = m_wideNodes;
+	distance[0] = m_aabb->RayDistance(ray, vertexArray);
+	while (stack) 
+	{
+		stack --;
+		if (distance[stack] > maxParam) 
+		{
+			break;
+		} 
+
+		ndVector minBox[3];
+		ndVector maxBox[3];
+		const ndWideNode* const me = stackPool[stack];
+		me->GetChildrenBoxes(minBox, maxBox);
+		const ndVector dist (ndWideRayDistance (ray, minBox, maxBox, minBox[0] > maxBox[0]));
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			const ndFloat32 dist1 = dist[i];
+			if (dist1 < maxParam)
+			{
+				const ndNode::ndLeafNodePtr& child = me->m_child[i];
+				if (child.IsLeaf()) 
+				{
+					ndInt32 vCount = ndInt32 (child.GetCount());
+					if (vCount > 0) 
+					{
+						ndInt32 index = ndInt32 (child.GetIndex());
+						ndFloat32 param = callback(context, &vertexArray[0].m_x, sizeof (ndTriplex), &m_indices[index], vCount);
+						dAssert (param >= ndFloat32 (0.0f));
+						if (param < maxParam) 
+						{
+							maxParam = param;
+							if (maxParam == ndFloat32 (0.0f)) 
+							{
+								return;
+							}
+						}
+					}
+				}
+				else
+				{
+					ndInt32 j = stack;
+					for ( ; j && (dist1 > distance[j - 1]); j --) 
+					{
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+					}
+					dAssert (stack < DG_STACK_DEPTH);
+					stackPool[j] = &m_wideNodes[child.m_node];
+					distance[j] = dist1;
+					stack++;
+				}
+			}
+		}
+	}
+}
+
+void ndAabbPolygonSoup::ForAllSectorsWide (const ndFastAabb& obbAabbInfo, const ndVector& boxDistanceTravel, dAaabbIntersectCallback callback, void* const context) const
+{
+	ndFloat32 distance[DG_STACK_DEPTH];
+	const ndWideNode* stackPool[DG_STACK_DEPTH];
+
+	const ndInt32 stride = sizeof (ndTriplex) / sizeof (ndFloat32);
+	const ndTriplex* const vertexArray = (ndTriplex*) m_localVertex;
+
+	if (boxDistanceTravel.DotProduct(boxDistanceTravel).GetScalar() < ndFloat32 (1.0e-8f)) 
+	{
+		ndInt32 stack = 1;
+		stackPool[0] = m_wideNodes;
+		distance[0] = m_aabb->BoxPenetration(obbAabbInfo, vertexArray);
+		if (distance[0] <= ndFloat32(0.0f)) 
+		{
+			obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], -distance[0]);
+		}
+		while (stack) 
+		{
+			stack --;
+			if (distance[stack] <= ndFloat32 (0.0f)) 
+			{
+				continue;
+			}
+
+			// the aabb test of the four children, the same as ndNode::BoxPenetration before 
+			// its oriented box refinement, which only the overlapping children go through.
+			ndVector minBox[3];
+			ndVector maxBox[3];
+			const ndWideNode* const me = stackPool[stack];
+			me->GetChildrenBoxes(minBox, maxBox);
+			ndVector dist (ndFloat32 (1.0e15f));
+			ndVector separation2 (ndVector::m_zero);
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				const ndVector minDist (minBox[j] - ndVector (obbAabbInfo.m_p1[j]));
+				const ndVector maxDist (maxBox[j] - ndVector (obbAabbInfo.m_p0[j]));
+				const ndVector mask ((minDist * maxDist) < ndVector::m_zero);
+				dist = dist.GetMin(maxDist.GetMin(minDist.Abs()) & mask);
+				const ndVector gap ((minDist.Abs()).GetMin(maxDist.Abs()).AndNot(mask));
+				separation2 += gap * gap;
+			}
+			const ndVector separation (separation2.Sqrt());
+			const ndInt32 emptyMask = (minBox[0] > maxBox[0]).GetSignMask();
+
+			for (ndInt32 i = 0; i < 4; ++i)
+			{
+				if (emptyMask & (1 << i))
+				{
+					continue;
+				}
+				if (dist[i] <= ndFloat32 (0.0f))
+				{
+					obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], separation[i]);
+					continue;
+				}
+
+				const ndNode::ndLeafNodePtr& child = me->m_child[i];
+				if (child.IsLeaf()) 
+				{
+					ndInt32 index = ndInt32 (child.GetIndex());
+					ndInt32 vCount = ndInt32 (child.GetCount());
+					if (vCount > 0) 
+					{
+						const ndInt32* const indices = &m_indices[index];
+						ndInt32 normalIndex = indices[vCount + 1];
+						ndVector faceNormal (&vertexArray[normalIndex].m_x);
+						faceNormal = faceNormal & ndVector::m_triplexMask;
+						ndFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
+						if (dist1 > ndFloat32 (0.0f)) 
+						{
+							obbAabbInfo.m_separationDistance = ndFloat32(0.0f);
+							dAssert (vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof (ndTriplex), indices, vCount, dist1) == t_StopSearh) 
+							{
+								return;
+							}
+						} 
+						else 
+						{
+							obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], -dist1);
+						}
+					}
+				} 
+				else 
+				{
+					const ndVector p0 (minBox[0][i], minBox[1][i], minBox[2][i], ndFloat32 (0.0f));
+					const ndVector p1 (maxBox[0][i], maxBox[1][i], maxBox[2][i], ndFloat32 (0.0f));
+					ndFloat32 dist1 = ndNode::BoxPenetration(obbAabbInfo, p0, p1);
+					if (dist1 > ndFloat32 (0.0f)) 
+					{
+						ndInt32 j = stack;
+						for ( ; j && (dist1 > distance[j - 1]); j --) 
+						{
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
+						}
+						dAssert (stack < DG_STACK_DEPTH);
+						stackPool[j] = &m_wideNodes[child.m_node];
+						distance[j] = dist1;
+						stack++;
+					} 
+					else 
+					{
+						obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], -dist1);
+					}
+				}
+			}
+		}
+	} 
+	else 
+	{
+		ndFastRay ray (ndVector::m_zero, boxDistanceTravel);
+		ndFastRay obbRay (ndVector::m_zero, obbAabbInfo.UnrotateVector(boxDistanceTravel));
+		ndInt32 stack = 1;
+		stackPool[0] = m_wideNodes;
+		distance [0] = m_aabb->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+
+		while (stack) 
+		{
+			stack --;
+			if (distance[stack] >= ndFloat32 (1.0f)) 
+			{
+				continue;
+			}
+
+			// the ray against the four children boxes grown by the box size first
+			ndVector minBox[3];
+			ndVector maxBox[3];
+			ndVector sweptMinBox[3];
+			ndVector sweptMaxBox[3];
+			const ndWideNode* const me = stackPool[stack];
+			me->GetChildrenBoxes(minBox, maxBox);
+			for (ndInt32 j = 0; j < 3; ++j)
+			{
+				sweptMinBox[j] = minBox[j] - ndVector (obbAabbInfo.m_p1[j]);
+				sweptMaxBox[j] = maxBox[j] - ndVector (obbAabbInfo.m_p0[j]);
+			}
+			const ndVector dist (ndWideRayDistance (ray, sweptMinBox, sweptMaxBox, minBox[0] > maxBox[0]));
+
+			for (ndInt32 i = 0; i < 4; ++i)
+			{
+				if (dist[i] >= ndFloat32 (1.0f))
+				{
+					continue;
+				}
+
+				const ndNode::ndLeafNodePtr& child = me->m_child[i];
+				if (child.IsLeaf()) 
+				{
+					ndInt32 index = ndInt32 (child.GetIndex());
+					ndInt32 vCount = ndInt32 (child.GetCount());
+					if (vCount > 0) 
+					{
+						const ndInt32* const indices = &m_indices[index];
+						ndInt32 normalIndex = indices[vCount + 1];
+						ndVector faceNormal (&vertexArray[normalIndex].m_x);
+						faceNormal = faceNormal & ndVector::m_triplexMask;
+						ndFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
+						if (hitDistance < ndFloat32 (1.0f)) 
+						{
+							dAssert (vCount >= 3);
+							if (callback(context, &vertexArray[0].m_x, sizeof (ndTriplex), indices, vCount, hitDistance) == t_StopSearh) 
+							{
+								return;
+							}
+						}
+					}
+				} 
+				else 
+				{
+					const ndVector p0 (minBox[0][i], minBox[1][i], minBox[2][i], ndFloat32 (0.0f));
+					const ndVector p1 (maxBox[0][i], maxBox[1][i], maxBox[2][i], ndFloat32 (0.0f));
+					ndFloat32 dist1 = ndNode::BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
+					if (dist1 < ndFloat32 (1.0f)) 
+					{
+						ndInt32 j = stack;
+						for ( ; j && (dist1 > distance[j - 1]); j --) 
+						{
+							stackPool[j] = stackPool[j - 1];
+							distance[j] = distance[j - 1];
+						}
+						dAssert (stack < DG_STACK_DEPTH);
+						stackPool[j] = &m_wideNodes[child.m_node];
+						distance[j] = dist1;
+						stack ++;
+					}
+				}
+			}
+		}
 	}
 }
 
@@ -1392,6 +2262,12 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 
 void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32 maxParam, dRayIntersectCallback callback, void* const context) const
 {
+	if (m_wideNodes)
+	{
+		ForAllSectorsRayHitWide(raySrc, maxParam, callback, context);
+		return;
+	}
+
 	const ndNode *stackPool[DG_STACK_DEPTH];
 	ndFloat32 distance[DG_STACK_DEPTH];
 	ndFastRay ray (raySrc);
@@ -1500,7 +2376,12 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 	dAssert (dAbs(dAbs(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < ndFloat32 (1.0e-4f));
 	dAssert (dAbs(dAbs(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < ndFloat32 (1.0e-4f));
 
-	if (m_aabb) 
+	if (m_wideNodes)
+	{
+		dAssert (boxDistanceTravel.m_w == ndFloat32 (0.0f));
+		ForAllSectorsWide(obbAabbInfo, boxDistanceTravel, callback, context);
+	}
+	else if (m_aabb) 
 	{
 		ndFloat32 distance[DG_STACK_DEPTH];
 		const ndNode* stackPool[DG_STACK_DEPTH];
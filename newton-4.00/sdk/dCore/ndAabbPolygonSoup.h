@@ -25,11 +25,14 @@
 #include "ndCoreStdafx.h"
 #include "ndTypes.h"
 #include "ndUtils.h"
+#include "ndArray.h"
 #include "ndFastRay.h"
 #include "ndFastAabb.h"
 #include "ndIntersections.h"
 #include "ndPolygonSoupDatabase.h"
 
+class ndMappedFile;
+class ndThreadPool;
 class ndPolygonSoupBuilder;
 
 // index format: i0, i1, i2, ... , id, normal, e0Normal, e1Normal, e2Normal, ..., faceSize
@@ -117,6 +120,11 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			ndVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & ndVector::m_triplexMask;
 			p1 = p1 & ndVector::m_triplexMask;
+			return BoxPenetration (obb, p0, p1);
+		}
+
+		inline static ndFloat32 BoxPenetration (const ndFastAabb& obb, const ndVector& p0, const ndVector& p1)
+		{
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			dAssert(maxBox.m_x >= minBox.m_x);
@@ -163,7 +171,11 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			ndVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & ndVector::m_triplexMask;
 			p1 = p1 & ndVector::m_triplexMask;
+			return BoxIntersect (ray, obbRay, obb, p0, p1);
+		}
 
+		inline static ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndVector& p0, const ndVector& p1)
+		{
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			ndFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -191,19 +203,66 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 		ndLeafNodePtr m_right;
 	};
 
+	// four children per node with their boxes quantized to 16 bits inside the node box, 
+	// an alternative layout of the same tree that the ray and box queries walk testing 
+	// the four children at once. empty children have an inverted box.
+	class ndWideNode
+	{
+		public:
+		// x, y and z of the four children boxes, one child per lane
+		inline void GetChildrenBoxes (ndVector* const minBox, ndVector* const maxBox) const
+		{
+			for (ndInt32 i = 0; i < 3; ++i)
+			{
+				const ndVector origin (m_origin[i]);
+				const ndVector scale (m_scale[i]);
+				minBox[i] = origin + scale * ndVector (ndFloat32 (m_min[i][0]), ndFloat32 (m_min[i][1]), ndFloat32 (m_min[i][2]), ndFloat32 (m_min[i][3]));
+				maxBox[i] = origin + scale * ndVector (ndFloat32 (m_max[i][0]), ndFloat32 (m_max[i][1]), ndFloat32 (m_max[i][2]), ndFloat32 (m_max[i][3]));
+			}
+		}
+
+		ndVector m_origin;
+		ndVector m_scale;
+		ndUnsigned16 m_min[3][4];
+		ndUnsigned16 m_max[3][4];
+		ndNode::ndLeafNodePtr m_child[4];
+	} D_GCC_NEWTON_ALIGN_32;
+
+	class ndBuildBox;
 	class ndSpliteInfo;
 	class ndNodeBuilder;
+	class ndFileHeader;
+	class ndAdjacencyEdge;
 
 	D_CORE_API virtual void GetAABB (ndVector& p0, ndVector& p1) const;
+	// reads the arrays of a file written by Serialize into memory, returns false and 
+	// leaves the soup empty if the file is missing, truncated or not compatible.
+	D_CORE_API virtual bool Deserialize (const char* const path);
+
+	// writes a temporary file and replaces path with it in one step, soups already mapping 
+	// the old file keep using it, and mapping the path again maps the new file.
 	D_CORE_API virtual void Serialize (const char* const path) const;
-	D_CORE_API virtual void Deserialize (const char* const path);
+
+	// the same bytes Serialize writes to the file.
+	D_CORE_API void SerializeToMemory (ndArray<char>& data) const;
+
+	// uses the arrays of a file written by Serialize in place, without copying them.
+	// the file view is shared by every soup mapping the same path and it is read only, 
+	// faces tags can not be changed. returns false if the file is missing or not compatible.
+	D_CORE_API virtual bool MapFile (const char* const path);
+
+	// builds or releases the wide node layout, ray casts and box queries use it when it is 
+	// present. it is built from the binary tree, which is kept for the other queries.
+	D_CORE_API void SetWideNodes (bool state);
+	bool GetWideNodes () const;
 
 	protected:
 	D_CORE_API ndAabbPolygonSoup ();
 	D_CORE_API virtual ~ndAabbPolygonSoup ();
 
-	D_CORE_API void Create (const ndPolygonSoupBuilder& builder);
-	D_CORE_API void CalculateAdjacendy ();
+	D_CORE_API void Create (const ndPolygonSoupBuilder& builder, ndThreadPool* const threadPool = nullptr);
+	D_CORE_API void CalculateAdjacendy (ndThreadPool* const threadPool = nullptr);
+	D_CORE_API virtual bool IsMapped() const;
 	D_CORE_API virtual ndVector ForAllSectorsSupportVectex(const ndVector& dir) const;
 	D_CORE_API virtual void ForAllSectorsRayHit (const ndFastRay& ray, ndFloat32 maxT, dRayIntersectCallback callback, void* const context) const;
 	D_CORE_API virtual void ForAllSectors (const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndFloat32 maxT, dAaabbIntersectCallback callback, void* const context) const;
@@ -215,6 +274,11 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 		return m_aabb;
 	}
 
+	inline ndInt32 GetNodesCount() const
+	{
+		return m_nodesCount;
+	}
+
 	inline ndNode* GetBackNode(const ndNode* const node) const
 	{
 		return node->m_left.IsLeaf() ? nullptr : node->m_left.GetNode(m_aabb);
@@ -234,19 +298,32 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 	}
 
 	private:
-	ndNodeBuilder* BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator) const;
+	ndNodeBuilder* BuildTopDown (ndNodeBuilder* const leafArray, ndBuildBox* const boxArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder* const nodeArray, ndThreadPool* const threadPool) const;
 	ndFloat32 CalculateFaceMaxSize (const ndVector* const vertex, ndInt32 indexCount, const ndInt32* const indexArray) const;
 	static dIntersectStatus CalculateDisjointedFaceEdgeNormals (void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
-	static dIntersectStatus CalculateAllFaceEdgeNormals(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
+	static void SetAdjacentEdge(const ndTriplex* const vertexArray, ndInt32* const indexArray0, ndInt32 indexCount0, ndInt32 slot0, ndInt32* const indexArray1, ndInt32 indexCount1, ndInt32 slot1);
 	void ImproveNodeFitness (ndNodeBuilder* const node) const;
+	void GetChildAabb (const ndNode::ndLeafNodePtr& child, ndVector& p0, ndVector& p1) const;
+	void BuildWideNodes ();
+	void ReleaseWideNodes ();
+	void ForAllSectorsRayHitWide (const ndFastRay& ray, ndFloat32 maxT, dRayIntersectCallback callback, void* const context) const;
+	void ForAllSectorsWide (const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, dAaabbIntersectCallback callback, void* const context) const;
 
 	ndNode* m_aabb;
 	ndInt32* m_indices;
+	ndWideNode* m_wideNodes;
+	ndMappedFile* m_mappedFile;
 	ndInt32 m_nodesCount;
 	ndInt32 m_indexCount;
+	ndInt32 m_wideNodesCount;
 	friend class ndContactSolver;
 };
 
+inline bool ndAabbPolygonSoup::GetWideNodes () const
+{
+	return m_wideNodes ? true : false;
+}
+
 #endif
 
 
@@ -20,17 +20,28 @@
 */
 
 #include "ndCoreStdafx.h"
+#include "ndUtils.h"
 #include "ndMemory.h"
 #include "ndClassAlloc.h"
 #include "ndFixSizeArray.h"
 #include "ndContainersAlloc.h"
 
-#define D_FREELIST_DICTIONARY_SIZE 64
+#define D_FREELIST_DICTIONARY_SIZE		64
+#define D_FREELIST_CLASS_GRANULARITY	16
+#define D_FREELIST_CLASS_COUNT			64
+#define D_FREELIST_MAGAZINE_SIZE		32
 
 class dFreeListEntry
 {
 	public:
 	dFreeListEntry* m_next;
+	union
+	{
+		// the head of a magazine in the depot links the next magazine, 
+		// the blocks in a thread cache remember the tag they are charged to.
+		dFreeListEntry* m_nextMagazine;
+		ndUnsigned32 m_tag;
+	};
 };
 
 class dFreeListHeader
@@ -182,26 +193,316 @@ class dFreeListDictionary: public ndFixSizeArray<dFreeListHeader, D_FREELIST_DIC
 	ndSpinLock m_lock;
 };
 
+// small blocks are served from size classes, each thread keeps a loaded and a previous 
+// magazine of free blocks per class, and only goes to the shared depot to trade full 
+// magazines, so the lock is taken once every few dozen allocations. 
+// blocks larger than the biggest class use the dictionary above.
+class dFreeListDepot
+{
+	public:
+	class dBucket
+	{
+		public:
+		dBucket()
+			:m_lock()
+			,m_magazines(nullptr)
+		{
+		}
+
+		ndSpinLock m_lock;
+		dFreeListEntry* m_magazines;
+	};
+
+	dFreeListDepot()
+	{
+	}
+
+	~dFreeListDepot()
+	{
+		Flush();
+	}
+
+	static dFreeListDepot& GetDepot()
+	{
+		static dFreeListDepot depot;
+		return depot;
+	}
+
+	static ndInt32 GetClass(ndInt32 size)
+	{
+		return (size + D_FREELIST_CLASS_GRANULARITY - 1) / D_FREELIST_CLASS_GRANULARITY - 1;
+	}
+
+	static ndInt32 GetClassSize(ndInt32 classIndex)
+	{
+		return (classIndex + 1) * D_FREELIST_CLASS_GRANULARITY;
+	}
+
+	static void FreeMagazine(dFreeListEntry* const magazine)
+	{
+		dFreeListEntry* next;
+		for (dFreeListEntry* node = magazine; node; node = next)
+		{
+			next = node->m_next;
+			ndMemory::Free(node);
+		}
+	}
+
+	dFreeListEntry* PopMagazine(ndInt32 classIndex)
+	{
+		dBucket& bucket = m_buckets[classIndex];
+		ndScopeSpinLock lock(bucket.m_lock);
+		dFreeListEntry* const magazine = bucket.m_magazines;
+		if (magazine)
+		{
+			bucket.m_magazines = magazine->m_nextMagazine;
+		}
+		return magazine;
+	}
+
+	void PushMagazine(ndInt32 classIndex, dFreeListEntry* const magazine)
+	{
+		dBucket& bucket = m_buckets[classIndex];
+		ndScopeSpinLock lock(bucket.m_lock);
+		magazine->m_nextMagazine = bucket.m_magazines;
+		bucket.m_magazines = magazine;
+	}
+
+	void Flush(ndInt32 classIndex)
+	{
+		dBucket& bucket = m_buckets[classIndex];
+		dFreeListEntry* magazines;
+		{
+			ndScopeSpinLock lock(bucket.m_lock);
+			magazines = bucket.m_magazines;
+			bucket.m_magazines = nullptr;
+		}
+
+		dFreeListEntry* next;
+		for (dFreeListEntry* magazine = magazines; magazine; magazine = next)
+		{
+			next = magazine->m_nextMagazine;
+			FreeMagazine(magazine);
+		}
+	}
+
+	void Flush()
+	{
+		for (ndInt32 i = 0; i < D_FREELIST_CLASS_COUNT; ++i)
+		{
+			Flush(i);
+		}
+	}
+
+	dBucket m_buckets[D_FREELIST_CLASS_COUNT];
+};
+
+class dFreeListThreadCache
+{
+	public:
+	class dMagazines
+	{
+		public:
+		dFreeListEntry* m_loaded;
+		dFreeListEntry* m_previous;
+		ndInt32 m_loadedCount;
+		ndInt32 m_previousCount;
+	};
+
+	dFreeListThreadCache()
+	{
+		memset(m_classes, 0, sizeof(m_classes));
+		ndMemory::ShareCurrentTag(&m_tag);
+	}
+
+	~dFreeListThreadCache()
+	{
+		ndMemory::ShareCurrentTag(nullptr);
+
+		// full magazines go back to the depot, what is left is released.
+		dFreeListDepot& depot = dFreeListDepot::GetDepot();
+		for (ndInt32 i = 0; i < D_FREELIST_CLASS_COUNT; ++i)
+		{
+			dMagazines& magazines = m_classes[i];
+			if (magazines.m_previousCount)
+			{
+				depot.PushMagazine(i, magazines.m_previous);
+			}
+			if (magazines.m_loadedCount == D_FREELIST_MAGAZINE_SIZE)
+			{
+				depot.PushMagazine(i, magazines.m_loaded);
+			}
+			else
+			{
+				dFreeListDepot::FreeMagazine(magazines.m_loaded);
+			}
+		}
+		m_threadCache = nullptr;
+		m_threadCacheReleased = true;
+	}
+
+	static dFreeListThreadCache* GetCache()
+	{
+		// after the cache of a thread was destroyed, the blocks 
+		// it allocates or frees go straight to the system.
+		if (!m_threadCache && !m_threadCacheReleased)
+		{
+			static thread_local dFreeListThreadCache cache;
+			m_threadCache = &cache;
+		}
+		return m_threadCache;
+	}
+
+	void* Malloc(ndInt32 classIndex)
+	{
+		// the previous magazine is always either full or empty
+		dMagazines& magazines = m_classes[classIndex];
+		if (!magazines.m_loadedCount)
+		{
+			if (magazines.m_previousCount)
+			{
+				dSwap(magazines.m_loaded, magazines.m_previous);
+				dSwap(magazines.m_loadedCount, magazines.m_previousCount);
+			}
+			else
+			{
+				dFreeListEntry* const magazine = dFreeListDepot::GetDepot().PopMagazine(classIndex);
+				if (!magazine)
+				{
+					return ndMemory::Malloc(size_t(dFreeListDepot::GetClassSize(classIndex)));
+				}
+				// the head lost its tag to the depot link
+				ndMemory::Retag(magazine);
+				magazine->m_tag = m_tag;
+				magazines.m_loaded = magazine;
+				magazines.m_loadedCount = D_FREELIST_MAGAZINE_SIZE;
+			}
+		}
+
+		dFreeListEntry* const self = magazines.m_loaded;
+		magazines.m_loaded = self->m_next;
+		magazines.m_loadedCount--;
+		if (self->m_tag != m_tag)
+		{
+			// the block was last charged to another account or category
+			ndMemory::Retag(self);
+		}
+		return self;
+	}
+
+	void Free(void* const ptr, ndInt32 classIndex, ndUnsigned32 tag)
+	{
+		dMagazines& magazines = m_classes[classIndex];
+		if (magazines.m_loadedCount == D_FREELIST_MAGAZINE_SIZE)
+		{
+			if (magazines.m_previousCount)
+			{
+				dFreeListDepot::GetDepot().PushMagazine(classIndex, magazines.m_previous);
+			}
+			magazines.m_previous = magazines.m_loaded;
+			magazines.m_previousCount = magazines.m_loadedCount;
+			magazines.m_loaded = nullptr;
+			magazines.m_loadedCount = 0;
+		}
+
+		dFreeListEntry* const self = (dFreeListEntry*)ptr;
+		self->m_next = magazines.m_loaded;
+		self->m_tag = tag;
+		magazines.m_loaded = self;
+		magazines.m_loadedCount++;
+	}
+
+	void Flush(ndInt32 classIndex)
+	{
+		dMagazines& magazines = m_classes[classIndex];
+		dFreeListDepot::FreeMagazine(magazines.m_loaded);
+		dFreeListDepot::FreeMagazine(magazines.m_previous);
+		memset(&magazines, 0, sizeof(magazines));
+	}
+
+	dMagazines m_classes[D_FREELIST_CLASS_COUNT];
+	ndUnsigned32 m_tag;
+	static thread_local dFreeListThreadCache* m_threadCache;
+	static thread_local bool m_threadCacheReleased;
+};
+
+thread_local dFreeListThreadCache* dFreeListThreadCache::m_threadCache = nullptr;
+thread_local bool dFreeListThreadCache::m_threadCacheReleased = false;
+
 void ndFreeListAlloc::Flush()
 {
+	// the caches of other threads are not touched, they hold at most two 
+	// magazines per class and are released when their threads exit.
+	dFreeListThreadCache* const cache = dFreeListThreadCache::GetCache();
+	if (cache)
+	{
+		for (ndInt32 i = 0; i < D_FREELIST_CLASS_COUNT; ++i)
+		{
+			cache->Flush(i);
+		}
+	}
+	dFreeListDepot::GetDepot().Flush();
+
 	dFreeListDictionary& dictionary = dFreeListDictionary::GetHeader();
 	dictionary.Flush();
 }
 
 void* ndFreeListAlloc::operator new (size_t size)
 {
-	dFreeListDictionary& dictionary = dFreeListDictionary::GetHeader();
-	return dictionary.Malloc(ndInt32 (size));
+	void* ptr;
+	const ndInt32 classIndex = dFreeListDepot::GetClass(ndInt32(size));
+	if (classIndex < D_FREELIST_CLASS_COUNT)
+	{
+		dFreeListThreadCache* const cache = dFreeListThreadCache::GetCache();
+		ptr = cache ? cache->Malloc(classIndex) : ndMemory::Malloc(size_t(dFreeListDepot::GetClassSize(classIndex)));
+	}
+	else
+	{
+		dFreeListDictionary& dictionary = dFreeListDictionary::GetHeader();
+		ptr = dictionary.Malloc(ndInt32(size));
+		// cached blocks stay charged to their last user until they are recycled
+		ndMemory::Retag(ptr);
+	}
+	return ptr;
 }
 
 void ndFreeListAlloc::operator delete (void* ptr)
 {
+	static const ndInt32 blockOverhead = ndMemory::CalculateBufferSize(0);
+	ndUnsigned32 tag;
+	const ndInt32 size = ndMemory::GetSize(ptr, tag) - blockOverhead;
+	const ndInt32 classIndex = dFreeListDepot::GetClass(size);
+	if (classIndex < D_FREELIST_CLASS_COUNT)
+	{
+		dAssert(size == dFreeListDepot::GetClassSize(classIndex));
+		dFreeListThreadCache* const cache = dFreeListThreadCache::GetCache();
+		if (cache)
+		{
+			cache->Free(ptr, classIndex, tag);
+		}
+		else
+		{
+			ndMemory::Free(ptr);
+		}
+		return;
+	}
 	dFreeListDictionary& dictionary = dFreeListDictionary::GetHeader();
 	dictionary.Free(ptr);
 }
 
 void ndFreeListAlloc::Flush(ndInt32 size)
 {
+	const ndInt32 classIndex = dFreeListDepot::GetClass(size);
+	if (classIndex < D_FREELIST_CLASS_COUNT)
+	{
+		dFreeListThreadCache* const cache = dFreeListThreadCache::GetCache();
+		if (cache)
+		{
+			cache->Flush(classIndex);
+		}
+		dFreeListDepot::GetDepot().Flush(classIndex);
+		return;
+	}
 	dFreeListDictionary& dictionary = dFreeListDictionary::GetHeader();
 	dictionary.Flush(size);
 }
@@ -38,6 +38,7 @@
 #include <ndMatrix.h>
 #include <ndThread.h>
 #include <ndMemory.h>
+#include <ndMappedFile.h>
 #include <ndGoogol.h>
 #include <ndString.h>
 #include <ndFastRay.h>
@@ -46,6 +47,7 @@
 #include <ndPolyhedra.h>
 #include <ndSyncMutex.h>
 #include <ndSemaphore.h>
+#include <ndFrameArena.h>
 #include <ndClassAlloc.h>
 #include <ndRefCounter.h>
 #include <ndThreadPool.h>
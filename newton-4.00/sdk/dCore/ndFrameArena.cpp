@@ -0,0 +1,121 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "ndCoreStdafx.h"
+#include "ndUtils.h"
+#include "ndMemory.h"
+#include "ndFrameArena.h"
+
+#define D_FRAME_ARENA_ALIGNMENT	32
+#define D_FRAME_ARENA_MIN_BLOCK	(1024 * 64)
+
+ndFrameArena::ndFrameArena()
+	:ndClassAlloc()
+	,m_buffer(nullptr)
+	,m_overflow(nullptr)
+	,m_capacity(0)
+	,m_offset(0)
+	,m_overflowSize(0)
+	,m_highWaterMark(0)
+	,m_heapAllocationCount(0)
+{
+}
+
+ndFrameArena::~ndFrameArena()
+{
+	ReleaseOverflow(nullptr);
+	if (m_buffer)
+	{
+		ndMemory::Free(m_buffer);
+	}
+}
+
+void* ndFrameArena::Alloc(ndInt32 sizeInBytes)
+{
+	dAssert(sizeInBytes >= 0);
+	const ndInt32 size = (sizeInBytes + D_FRAME_ARENA_ALIGNMENT - 1) & -D_FRAME_ARENA_ALIGNMENT;
+	void* ptr = nullptr;
+	if ((m_offset + size) <= m_capacity)
+	{
+		ptr = &m_buffer[m_offset];
+		m_offset += size;
+	}
+	else
+	{
+		// ndMemory::Malloc returns 32 byte aligned buffers, 
+		// so the header is padded to keep the payload aligned.
+		const ndInt32 headerSize = (ndInt32(sizeof(ndOverflowBlock)) + D_FRAME_ARENA_ALIGNMENT - 1) & -D_FRAME_ARENA_ALIGNMENT;
+		ndMemoryScope memoryScope(m_scratchMemory);
+		ndOverflowBlock* const block = (ndOverflowBlock*)ndMemory::Malloc(size_t(headerSize + size));
+		block->m_next = m_overflow;
+		block->m_size = size;
+		m_overflow = block;
+		m_overflowSize += size;
+		m_heapAllocationCount++;
+		ptr = ((ndUnsigned8*)block) + headerSize;
+	}
+	m_highWaterMark = dMax(m_highWaterMark, m_offset + m_overflowSize);
+	return ptr;
+}
+
+void ndFrameArena::ReleaseOverflow(void* const marker)
+{
+	while (m_overflow != marker)
+	{
+		ndOverflowBlock* const block = m_overflow;
+		m_overflow = block->m_next;
+		m_overflowSize -= block->m_size;
+		ndMemory::Free(block);
+	}
+}
+
+void ndFrameArena::Reset()
+{
+	ReleaseOverflow(nullptr);
+	dAssert(!m_overflowSize);
+	m_offset = 0;
+	if (m_highWaterMark > m_capacity)
+	{
+		Reserve(m_highWaterMark);
+	}
+}
+
+void ndFrameArena::Reserve(ndInt32 sizeInBytes)
+{
+	dAssert(!m_offset && !m_overflow);
+	if (sizeInBytes > m_capacity)
+	{
+		// grow by at least half, so that a slowly rising 
+		// high water mark does not reallocate every update.
+		ndInt32 capacity = dMax(sizeInBytes, m_capacity + m_capacity / 2);
+		capacity = dMax(capacity, D_FRAME_ARENA_MIN_BLOCK);
+		capacity = (capacity + D_FRAME_ARENA_ALIGNMENT - 1) & -D_FRAME_ARENA_ALIGNMENT;
+		if (m_buffer)
+		{
+			ndMemory::Free(m_buffer);
+		}
+		ndMemoryScope memoryScope(m_scratchMemory);
+		m_buffer = (ndUnsigned8*)ndMemory::Malloc(size_t(capacity));
+		m_capacity = capacity;
+		m_heapAllocationCount++;
+	}
+}
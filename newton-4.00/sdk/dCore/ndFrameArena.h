@@ -0,0 +1,139 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __ND_FRAME_ARENA_H__
+#define __ND_FRAME_ARENA_H__
+
+#include "ndCoreStdafx.h"
+#include "ndTypes.h"
+#include "ndClassAlloc.h"
+
+/// Bump pointer allocator for memory that only lives for one update.
+/// \brief allocations are never freed individually, the whole arena is rewound 
+/// by calling Reset, or back to a marker by a ndScope. when a request does not fit,
+/// the arena takes an overflow block from the heap, and the next Reset replaces the
+/// main block with one as large as the high water mark, so after a few updates 
+/// an arena stops touching the heap.
+/// \brief the arena is not thread safe, allocations must be made from a single thread,
+/// the memory can be read and written by any thread.
+class ndFrameArena: public ndClassAlloc
+{
+	public:
+	/// Rewind the arena to the marker it had when the scope was created.
+	class ndScope
+	{
+		public:
+		ndScope(ndFrameArena& arena);
+		~ndScope();
+
+		private:
+		ndFrameArena& m_arena;
+		void* m_overflow;
+		ndInt32 m_offset;
+	};
+
+	D_CORE_API ndFrameArena();
+	D_CORE_API ~ndFrameArena();
+
+	/// Return an uninitialized buffer aligned to 32 bytes that is valid until the next Reset.
+	D_CORE_API void* Alloc(ndInt32 sizeInBytes);
+
+	/// Typed version of Alloc, the items are not constructed.
+	template<class T>
+	T* Alloc(ndInt32 count);
+
+	/// Release all allocations, and consolidate the overflow blocks if there are any.
+	D_CORE_API void Reset();
+
+	/// Make sure the arena can serve sizeInBytes with no heap allocations.
+	/// \brief an application that knows the high water mark of its simulation can call 
+	/// this once at load time, so that the simulation never allocates transient memory.
+	D_CORE_API void Reserve(ndInt32 sizeInBytes);
+
+	/// Size of the main block.
+	ndInt32 GetCapacity() const;
+
+	/// Largest number of bytes that were in use at any time since the arena was created.
+	ndInt32 GetHighWaterMark() const;
+
+	/// Number of times the arena had to go to the heap.
+	ndInt32 GetHeapAllocationCount() const;
+
+	private:
+	D_CORE_API void ReleaseOverflow(void* const marker);
+
+	class ndOverflowBlock
+	{
+		public:
+		ndOverflowBlock* m_next;
+		ndInt32 m_size;
+	};
+
+	ndUnsigned8* m_buffer;
+	ndOverflowBlock* m_overflow;
+	ndInt32 m_capacity;
+	ndInt32 m_offset;
+	ndInt32 m_overflowSize;
+	ndInt32 m_highWaterMark;
+	ndInt32 m_heapAllocationCount;
+};
+
+inline ndFrameArena::ndScope::ndScope(ndFrameArena& arena)
+	:m_arena(arena)
+	,m_overflow(arena.m_overflow)
+	,m_offset(arena.m_offset)
+{
+}
+
+inline ndFrameArena::ndScope::~ndScope()
+{
+	dAssert(m_offset <= m_arena.m_offset);
+	m_arena.m_offset = m_offset;
+	if (m_arena.m_overflow != m_overflow)
+	{
+		m_arena.ReleaseOverflow(m_overflow);
+	}
+}
+
+template<class T>
+inline T* ndFrameArena::Alloc(ndInt32 count)
+{
+	return (T*)Alloc(ndInt32(count * sizeof(T)));
+}
+
+inline ndInt32 ndFrameArena::GetCapacity() const
+{
+	return m_capacity;
+}
+
+inline ndInt32 ndFrameArena::GetHighWaterMark() const
+{
+	return m_highWaterMark;
+}
+
+inline ndInt32 ndFrameArena::GetHeapAllocationCount() const
+{
+	return m_heapAllocationCount;
+}
+
+#endif
+
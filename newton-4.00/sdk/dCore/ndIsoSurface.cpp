@@ -26,6 +26,7 @@
 #include "ndMatrix.h"
 #include "ndProfiler.h"
 #include "ndIsoSurface.h"
+#include "ndThreadPool.h"
 
 // adapted from code by written by Paul Bourke may 1994
 //http://paulbourke.net/geometry/polygonise/
@@ -52,7 +53,7 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 
 	void Clear();
 	ndVector GetOrigin() const;
-	void BuildLowResolutionMesh(ndIsoSurface* const me, const ndArray<ndVector>& pointCloud, ndFloat32 gridSize);
+	void BuildLowResolutionMesh(ndIsoSurface* const me, const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndThreadPool* const threadPool);
 	void BuildHighResolutionMesh(ndIsoSurface* const me, const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue);
 
 	ndInt32 GenerateLowResIndexList(const ndIsoSurface* const me, 
@@ -75,7 +76,7 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 
 		ndGridHash(ndInt32 x, ndInt32 y, ndInt32 z)
 		{
-			m_gridCellHash = 0;
+			m_gridFullHash = 0;
 			m_x = ndInt16(x);
 			m_y = ndInt16(y);
 			m_z = ndInt16(z);
@@ -91,7 +92,7 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 			dAssert(grid.m_z < ndFloat32(256.0f * 256.0f));
 			
 			ndVector hash(grid.GetInt());
-			m_gridCellHash = 0;
+			m_gridFullHash = 0;
 			m_x = ndInt16(hash.m_ix);
 			m_y = ndInt16(hash.m_iy);
 			m_z = ndInt16(hash.m_iz);
@@ -166,7 +167,17 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 	void ClearBuffers();
 	void SortCellBuckects();
 	void GenerateLowResIsoSurface();
-	void ProcessLowResCell(ndIsoCell& cell);
+	void ProcessLowResCell(const ndIsoCell& cell, ndInt32 tableIndex, ndInt32 index);
+	ndInt32 GetCellStart(ndInt32 index, ndInt32 gridCount) const;
+	ndInt32 GetCellTableIndex(ndInt32 start, ndInt32& tableIndex) const;
+
+	ndInt32 GetThreadCount() const;
+
+	template <typename Function>
+	void ParallelExecute(const Function& function);
+
+	template <class ndEvaluateKey>
+	void SortCells(ndArray<ndGridHash>& array, ndArray<ndGridHash>& scratchBuffer);
 	void MakeTriangleList(ndIsoSurface* const me);
 	void CalculateNormals(ndIsoSurface* const me);
 	
@@ -186,6 +197,8 @@ class ndIsoSurface::ndImplementation : public ndClassAlloc
 	ndArray<ndGridHash> m_hashGridMapScratchBuffer;
 	ndArray<ndVector> m_triangles;
 	ndArray<ndVector> m_trianglesScratchBuffer;
+	ndArray<ndInt32> m_surfaceCells;
+	ndThreadPool* m_threadPool;
 
 	ndFloat32 m_isoValue;
 	ndInt32 m_volumeSizeX;
@@ -2591,6 +2604,8 @@ inline ndIsoSurface::ndImplementation::ndImplementation()
 	,m_hashGridMapScratchBuffer(256)
 	,m_triangles(256)
 	,m_trianglesScratchBuffer(256)
+	,m_surfaceCells(256)
+	,m_threadPool(nullptr)
 	,m_isoValue(ndFloat32 (0.5f))
 	//,m_worlToGridOrigin(ndFloat32(1.0f))
 	//,m_worlToGridScale(ndFloat32(1.0f))
@@ -2616,6 +2631,7 @@ void ndIsoSurface::ndImplementation::Clear()
 	m_triangles.Resize(256);
 	m_hashGridMap.Resize(256);
 	m_trianglesScratchBuffer.Resize(256);
+	m_surfaceCells.Resize(256);
 	m_hashGridMapScratchBuffer.Resize(256);
 }
 
@@ -2625,6 +2641,37 @@ ndIsoSurface::ndImplementation& ndIsoSurface::GetImplementation() const
 	return implementation;
 }
 
+ndInt32 ndIsoSurface::ndImplementation::GetThreadCount() const
+{
+	return m_threadPool ? m_threadPool->GetThreadCount() : 1;
+}
+
+template <typename Function>
+void ndIsoSurface::ndImplementation::ParallelExecute(const Function& function)
+{
+	if (m_threadPool)
+	{
+		m_threadPool->ParallelExecute(function);
+	}
+	else
+	{
+		function(0, 1);
+	}
+}
+
+template <class ndEvaluateKey>
+void ndIsoSurface::ndImplementation::SortCells(ndArray<ndGridHash>& array, ndArray<ndGridHash>& scratchBuffer)
+{
+	if (m_threadPool)
+	{
+		ndCountingSort<ndGridHash, ndEvaluateKey, 8>(*m_threadPool, array, scratchBuffer);
+	}
+	else
+	{
+		ndCountingSort<ndGridHash, ndEvaluateKey, 8>(array, scratchBuffer);
+	}
+}
+
 void ndIsoSurface::ndImplementation::CalculateAabb(const ndArray<ndVector>& points, ndFloat32 gridSize)
 {
 	D_TRACKTIME();
@@ -2633,12 +2680,29 @@ void ndIsoSurface::ndImplementation::CalculateAabb(const ndArray<ndVector>& poin
 	m_gridSize = ndVector::m_triplexMask & ndVector(gridSize);
 	m_invGridSize = ndVector::m_triplexMask & ndVector(ndFloat32(1.0f) / gridSize);
 
+	ndVector* const boxes = dAlloca(ndVector, 2 * GetThreadCount());
+	auto CalculateBoxes = ndMakeObject::ndFunction([&points, boxes](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		ndVector minP(ndFloat32(1.0e10f));
+		ndVector maxP(ndFloat32(-1.0e10f));
+		const ndStartEnd startEnd(points.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			minP = minP.GetMin(points[i]);
+			maxP = maxP.GetMax(points[i]);
+		}
+		boxes[threadIndex * 2 + 0] = minP;
+		boxes[threadIndex * 2 + 1] = maxP;
+	});
+	ParallelExecute(CalculateBoxes);
+
 	ndVector boxP0(ndFloat32(1.0e10f));
 	ndVector boxP1(ndFloat32(-1.0e10f));
-	for (ndInt32 i = 0; i < points.GetCount(); ++i)
+	for (ndInt32 i = 0; i < GetThreadCount(); ++i)
 	{
-		boxP0 = boxP0.GetMin(points[i]);
-		boxP1 = boxP1.GetMax(points[i]);
+		boxP0 = boxP0.GetMin(boxes[i * 2 + 0]);
+		boxP1 = boxP1.GetMax(boxes[i * 2 + 1]);
 	}
 	boxP0 -= m_gridSize;
 	boxP1 += (m_gridSize + m_gridSize);
@@ -2683,14 +2747,8 @@ ndVector ndIsoSurface::ndImplementation::InterpolateHighResVertex(ndFloat32, con
 	return ndVector(p0 + p1p0 * ndVector::m_half);
 }
 
-void ndIsoSurface::ndImplementation::ProcessLowResCell(ndIsoCell& cell)
+void ndIsoSurface::ndImplementation::ProcessLowResCell(const ndIsoCell& cell, ndInt32 tableIndex, ndInt32 index)
 {
-	ndInt32 tableIndex = 0;
-	for (ndInt32 i = 0; i < 8; ++i)
-	{
-		tableIndex |= (cell.m_isoValues[i].m_w > m_isoValue) << i;
-	}
-
 	ndVector vertlist[12];
 	const ndInt32 start = m_edgeScan[tableIndex];
 	const ndInt32 edgeCount = m_edgeScan[tableIndex + 1] - start;
@@ -2703,11 +2761,9 @@ void ndIsoSurface::ndImplementation::ProcessLowResCell(ndIsoCell& cell)
 		vertlist[midPoint] = InterpolateLowResVertex(cell.m_isoValues[p0], cell.m_isoValues[p1]);
 	}
 	
-	const ndInt32 index = m_triangles.GetCount();
 	const ndInt32 faceStart = m_facesScan[tableIndex];
 	const ndInt32 faceVertexCount = m_facesScan[tableIndex + 1] - faceStart;
 	
-	m_triangles.SetCount(index + faceVertexCount * 3);
 	ndVector* const triangle = &m_triangles[index];
 	for (ndInt32 i = 0; i < faceVertexCount; ++i)
 	{
@@ -2868,22 +2924,22 @@ void ndIsoSurface::ndImplementation::SortCellBuckects()
 		}
 	};
 
-	ndCountingSort<ndGridHash, ndKey_xlow, 8>(m_hashGridMap, m_hashGridMapScratchBuffer);
+	SortCells<ndKey_xlow>(m_hashGridMap, m_hashGridMapScratchBuffer);
 	if (m_upperDigitsIsValid.m_x)
 	{
-		ndCountingSort<ndGridHash, ndKey_xhigh, 8>(m_hashGridMap, m_hashGridMapScratchBuffer);
+		SortCells<ndKey_xhigh>(m_hashGridMap, m_hashGridMapScratchBuffer);
 	}
 
-	ndCountingSort<ndGridHash, ndKey_ylow, 8>(m_hashGridMap, m_hashGridMapScratchBuffer);
+	SortCells<ndKey_ylow>(m_hashGridMap, m_hashGridMapScratchBuffer);
 	if (m_upperDigitsIsValid.m_y)
 	{
-		ndCountingSort<ndGridHash, ndKey_yhigh, 8>(m_hashGridMap, m_hashGridMapScratchBuffer);
+		SortCells<ndKey_yhigh>(m_hashGridMap, m_hashGridMapScratchBuffer);
 	}
 
-	ndCountingSort<ndGridHash, ndKey_zlow, 8>(m_hashGridMap, m_hashGridMapScratchBuffer);
+	SortCells<ndKey_zlow>(m_hashGridMap, m_hashGridMapScratchBuffer);
 	if (m_upperDigitsIsValid.m_z)
 	{
-		ndCountingSort<ndGridHash, ndKey_zhigh, 8>(m_hashGridMap, m_hashGridMapScratchBuffer);
+		SortCells<ndKey_zhigh>(m_hashGridMap, m_hashGridMapScratchBuffer);
 	}
 }
 
@@ -2953,87 +3009,204 @@ void ndIsoSurface::ndImplementation::RemoveDuplicates(const ndArray<ndVector>& p
 	const ndVector origin(m_boxP0);
 	const ndVector invGridSize(m_invGridSize);
 
-	const ndVector rounding(ndVector::m_zero);
-	ndUpperDigit upperDigits;
-	const ndGridHashSteps steps;
+	ndUpperDigit* const upperDigits = dAlloca(ndUpperDigit, GetThreadCount());
 	m_hashGridMapScratchBuffer.SetCount(points.GetCount());
-	for (ndInt32 i = 0; i < points.GetCount(); ++i)
+	auto CalculateHashes = ndMakeObject::ndFunction([this, &points, upperDigits, &origin, &invGridSize](ndInt32 threadIndex, ndInt32 threadCount)
 	{
-		const ndVector r(points[i] - origin);
-		const ndVector p(r * invGridSize + rounding);
-		const ndGridHash hashKey(p);
-		m_hashGridMapScratchBuffer[i] = hashKey;
+		D_TRACKTIME();
+		const ndVector rounding(ndVector::m_zero);
+		ndUpperDigit& digits = upperDigits[threadIndex];
+		digits = ndUpperDigit();
+		ndGridHash* const hashes = &m_hashGridMapScratchBuffer[0];
+		const ndStartEnd startEnd(points.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndVector r(points[i] - origin);
+			const ndVector p(r * invGridSize + rounding);
+			const ndGridHash hashKey(p);
+			hashes[i] = hashKey;
+
+			digits.m_x = dMax(digits.m_x, ndInt32(hashKey.m_xHigh));
+			digits.m_y = dMax(digits.m_y, ndInt32(hashKey.m_yHigh));
+			digits.m_z = dMax(digits.m_z, ndInt32(hashKey.m_zHigh));
+		}
+	});
+	ParallelExecute(CalculateHashes);
 
-		upperDigits.m_x = dMax(upperDigits.m_x, ndInt32(hashKey.m_xHigh));
-		upperDigits.m_y = dMax(upperDigits.m_y, ndInt32(hashKey.m_yHigh));
-		upperDigits.m_z = dMax(upperDigits.m_z, ndInt32(hashKey.m_zHigh));
+	ndUpperDigit digits;
+	for (ndInt32 i = 0; i < GetThreadCount(); ++i)
+	{
+		digits.m_x = dMax(digits.m_x, upperDigits[i].m_x);
+		digits.m_y = dMax(digits.m_y, upperDigits[i].m_y);
+		digits.m_z = dMax(digits.m_z, upperDigits[i].m_z);
 	}
-	m_upperDigitsIsValid = upperDigits;
+	m_upperDigitsIsValid = digits;
 
-	ndCountingSort<ndGridHash, ndKey_xlow, 8>(m_hashGridMapScratchBuffer, m_hashGridMap);
+	SortCells<ndKey_xlow>(m_hashGridMapScratchBuffer, m_hashGridMap);
 	if (m_upperDigitsIsValid.m_x)
 	{
-		ndCountingSort<ndGridHash, ndKey_xhigh, 8>(m_hashGridMapScratchBuffer, m_hashGridMap);
+		SortCells<ndKey_xhigh>(m_hashGridMapScratchBuffer, m_hashGridMap);
 	}
 
-	ndCountingSort<ndGridHash, ndKey_ylow, 8>(m_hashGridMapScratchBuffer, m_hashGridMap);
+	SortCells<ndKey_ylow>(m_hashGridMapScratchBuffer, m_hashGridMap);
 	if (m_upperDigitsIsValid.m_y)
 	{
-		ndCountingSort<ndGridHash, ndKey_yhigh, 8>(m_hashGridMapScratchBuffer, m_hashGridMap);
+		SortCells<ndKey_yhigh>(m_hashGridMapScratchBuffer, m_hashGridMap);
 	}
 
-	ndCountingSort<ndGridHash, ndKey_zlow, 8>(m_hashGridMapScratchBuffer, m_hashGridMap);
+	SortCells<ndKey_zlow>(m_hashGridMapScratchBuffer, m_hashGridMap);
 	if (m_upperDigitsIsValid.m_z)
 	{
-		ndCountingSort<ndGridHash, ndKey_zhigh, 8>(m_hashGridMapScratchBuffer, m_hashGridMap);
+		SortCells<ndKey_zhigh>(m_hashGridMapScratchBuffer, m_hashGridMap);
 	}
 
+	// the first point of each run of equal hashes is kept, each thread 
+	// counts the runs that start in its slice and copies them after a prefix sum.
+	ndInt32* const scans = dAlloca(ndInt32, GetThreadCount());
+	auto CountCells = ndMakeObject::ndFunction([this, scans](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		ndInt32 count = 0;
+		const ndGridHash* const hashes = &m_hashGridMapScratchBuffer[0];
+		const ndStartEnd startEnd(m_hashGridMapScratchBuffer.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			count += (i == 0) || (hashes[i].m_gridFullHash != hashes[i - 1].m_gridFullHash);
+		}
+		scans[threadIndex] = count;
+	});
+
+	auto CopyCells = ndMakeObject::ndFunction([this, scans](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		ndInt32 index = scans[threadIndex];
+		ndGridHash* const cells = &m_hashGridMap[0];
+		const ndGridHash* const hashes = &m_hashGridMapScratchBuffer[0];
+		const ndStartEnd startEnd(m_hashGridMapScratchBuffer.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			if ((i == 0) || (hashes[i].m_gridFullHash != hashes[i - 1].m_gridFullHash))
+			{
+				cells[index] = hashes[i];
+				index++;
+			}
+		}
+	});
+
+	ParallelExecute(CountCells);
 	ndInt32 gridCount = 0;
-	for (ndInt32 i = 1; i < m_hashGridMapScratchBuffer.GetCount(); ++i)
+	for (ndInt32 i = 0; i < GetThreadCount(); ++i)
 	{
-		const ndGridHash cell(m_hashGridMapScratchBuffer[i]);
-		gridCount += (cell.m_gridFullHash != m_hashGridMapScratchBuffer[i - 1].m_gridFullHash);
-		m_hashGridMapScratchBuffer[gridCount] = cell;
+		const ndInt32 count = scans[i];
+		scans[i] = gridCount;
+		gridCount += count;
 	}
-	gridCount++;
-	m_hashGridMapScratchBuffer.SetCount(gridCount);
+	m_hashGridMap.SetCount(m_hashGridMapScratchBuffer.GetCount());
+	ParallelExecute(CopyCells);
+	m_hashGridMap.SetCount(gridCount);
+	m_hashGridMap.Swap(m_hashGridMapScratchBuffer);
 }
 	
+ndInt32 ndIsoSurface::ndImplementation::GetCellStart(ndInt32 index, ndInt32 gridCount) const
+{
+	// moves a slice boundary forward to the first entry of a cell
+	const ndGridHash* const cells = &m_hashGridMap[0];
+	while ((index > 0) && (index < gridCount) && (ndGridHash(cells[index], 0).m_gridCellHash == ndGridHash(cells[index - 1], 0).m_gridCellHash))
+	{
+		index++;
+	}
+	return index;
+}
+
+ndInt32 ndIsoSurface::ndImplementation::GetCellTableIndex(ndInt32 start, ndInt32& tableIndex) const
+{
+	// the corners of a cell are the particles that touch it, there are no duplicates, 
+	// so the case index is the set of corner bits, and a full cell is inside the volume.
+	const ndGridHash* const cells = &m_hashGridMap[0];
+	const ndGridHash startGrid(cells[start], 0);
+	ndInt32 corners = 0;
+	ndInt32 end = start;
+	do
+	{
+		corners |= 1 << cells[end].m_cellType;
+		end++;
+	} while (startGrid.m_gridCellHash == ndGridHash(cells[end], 0).m_gridCellHash);
+	tableIndex = corners;
+	return end;
+}
+
 void ndIsoSurface::ndImplementation::GenerateLowResIsoSurface()
 {
 	D_TRACKTIME();
-	ndInt32 end = 0;
 	const ndInt32 gridCount = m_hashGridMap.GetCount();
 	m_hashGridMap.PushBack(ndGridHash(0xffff, 0xffff, 0xffff));
 
-	m_triangles.SetCount(0);
-	for (ndInt32 i = 0; i < gridCount; i = end)
+	// each thread lists the cells with a surface that start in its slice and counts their vertices, 
+	// after a prefix sum it writes their triangles at the same place the serial loop would.
+	// a slice has no more cells than entries, so its list fits at the slice start.
+	ndInt32* const scans = dAlloca(ndInt32, GetThreadCount());
+	ndInt32* const surfaceCellsCount = dAlloca(ndInt32, GetThreadCount());
+	m_surfaceCells.SetCount(gridCount);
+	auto CountVertices = ndMakeObject::ndFunction([this, gridCount, scans, surfaceCellsCount](ndInt32 threadIndex, ndInt32 threadCount)
 	{
-		end = i + 1;
-		ndInt32 start = i;
-		const ndGridHash startGrid(m_hashGridMap[start], 0);
-		while (startGrid.m_gridCellHash == ndGridHash(m_hashGridMap[end], 0).m_gridCellHash)
+		D_TRACKTIME();
+		ndInt32 cellCount = 0;
+		ndInt32 vertexCount = 0;
+		const ndStartEnd startEnd(gridCount, threadIndex, threadCount);
+		ndInt32* const surfaceCells = &m_surfaceCells[startEnd.m_start];
+		const ndInt32 end = GetCellStart(startEnd.m_end, gridCount);
+		for (ndInt32 i = GetCellStart(startEnd.m_start, gridCount); i < end; )
 		{
-			end++;
+			ndInt32 tableIndex;
+			const ndInt32 start = i;
+			i = GetCellTableIndex(i, tableIndex);
+			if (tableIndex != 0xff)
+			{
+				surfaceCells[cellCount] = start;
+				cellCount++;
+				vertexCount += (m_facesScan[tableIndex + 1] - m_facesScan[tableIndex]) * 3;
+			}
 		}
-		ndInt32 count = end - start;
-		if (count < 8)
+		scans[threadIndex] = vertexCount;
+		surfaceCellsCount[threadIndex] = cellCount;
+	});
+
+	auto GenerateTriangles = ndMakeObject::ndFunction([this, gridCount, scans, surfaceCellsCount](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		ndInt32 index = scans[threadIndex];
+		const ndStartEnd startEnd(gridCount, threadIndex, threadCount);
+		const ndInt32* const surfaceCells = &m_surfaceCells[startEnd.m_start];
+		for (ndInt32 j = 0; j < surfaceCellsCount[threadIndex]; ++j)
 		{
+			ndInt32 tableIndex;
+			const ndInt32 start = surfaceCells[j];
+			const ndGridHash startGrid(m_hashGridMap[start], 0);
+			GetCellTableIndex(start, tableIndex);
+
 			ndIsoCell cell;
 			ndVector* const isoValue = &cell.m_isoValues[0];
-			ndVector origin(ndFloat32(startGrid.m_x + 1), ndFloat32(startGrid.m_y + 1), ndFloat32(startGrid.m_z + 1), ndFloat32(0.0f));
-			for (ndInt32 j = 0; j < 8; j++)
-			{
-				isoValue[j] = origin + m_gridCorners[j];
-			}
-			for (ndInt32 j = 0; j < count; j++)
+			const ndVector origin(ndFloat32(startGrid.m_x + 1), ndFloat32(startGrid.m_y + 1), ndFloat32(startGrid.m_z + 1), ndFloat32(0.0f));
+			for (ndInt32 k = 0; k < 8; k++)
 			{
-				ndInt32 index = m_hashGridMap[start + j].m_cellType;
-				isoValue[index].m_w = ndFloat32(1.0f);
+				isoValue[k] = origin + m_gridCorners[k];
+				isoValue[k].m_w = ndFloat32((tableIndex >> k) & 1);
 			}
-			ProcessLowResCell(cell);
+			ProcessLowResCell(cell, tableIndex, index);
+			index += (m_facesScan[tableIndex + 1] - m_facesScan[tableIndex]) * 3;
 		}
+	});
+
+	ParallelExecute(CountVertices);
+	ndInt32 vertexCount = 0;
+	for (ndInt32 i = 0; i < GetThreadCount(); ++i)
+	{
+		const ndInt32 count = scans[i];
+		scans[i] = vertexCount;
+		vertexCount += count;
 	}
+	m_triangles.SetCount(vertexCount);
+	ParallelExecute(GenerateTriangles);
 }
 
 void ndIsoSurface::ndImplementation::GenerateHighResIsoSurface(ndCalculateIsoValue* const computeIsoValue)
@@ -3317,10 +3490,16 @@ void ndIsoSurface::ndImplementation::MakeTriangleList(ndIsoSurface* const me)
 	ndArray<ndVector>& points = me->m_points;
 	points.SetCount(m_triangles.GetCount());
 
-	for (ndInt32 i = 0; i < m_triangles.GetCount(); ++i)
+	auto ScalePoints = ndMakeObject::ndFunction([this, &points](ndInt32 threadIndex, ndInt32 threadCount)
 	{
-		points[i] = m_triangles[i] * m_gridSize;
-	}
+		D_TRACKTIME();
+		const ndStartEnd startEnd(points.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			points[i] = m_triangles[i] * m_gridSize;
+		}
+	});
+	ParallelExecute(ScalePoints);
 }
 
 //void ndIsoSurface::ndImplementation::GenerateHighResIndexList(ndIsoSurface* const me)
@@ -3333,21 +3512,28 @@ void ndIsoSurface::ndImplementation::GenerateHighResIndexList(ndIsoSurface* cons
 void ndIsoSurface::ndImplementation::CreateGrids()
 {
 	D_TRACKTIME();
-	const ndGridHashSteps steps;
 	m_hashGridMap.SetCount(m_hashGridMapScratchBuffer.GetCount() * 8);
-	for (ndInt32 i = 0; i < m_hashGridMapScratchBuffer.GetCount(); ++i)
+	auto ExpandCells = ndMakeObject::ndFunction([this](ndInt32 threadIndex, ndInt32 threadCount)
 	{
-		const ndGridHash hashKey(m_hashGridMapScratchBuffer[i]);
-		for (ndInt32 j = 0; j < 8; ++j)
+		D_TRACKTIME();
+		const ndGridHashSteps steps;
+		ndGridHash* const cells = &m_hashGridMap[0];
+		const ndStartEnd startEnd(m_hashGridMapScratchBuffer.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 		{
-			ndGridHash cell(hashKey);
-			cell.m_x += steps.m_steps[j].m_x;
-			cell.m_y += steps.m_steps[j].m_y;
-			cell.m_z += steps.m_steps[j].m_z;
-			cell.m_cellType = steps.m_cellType[j];
-			m_hashGridMap[i * 8 + j] = cell;
+			const ndGridHash hashKey(m_hashGridMapScratchBuffer[i]);
+			for (ndInt32 j = 0; j < 8; ++j)
+			{
+				ndGridHash cell(hashKey);
+				cell.m_x += steps.m_steps[j].m_x;
+				cell.m_y += steps.m_steps[j].m_y;
+				cell.m_z += steps.m_steps[j].m_z;
+				cell.m_cellType = steps.m_cellType[j];
+				cells[i * 8 + j] = cell;
+			}
 		}
-	}
+	});
+	ParallelExecute(ExpandCells);
 }
 
 void ndIsoSurface::ndImplementation::ClearBuffers()
@@ -3357,6 +3543,7 @@ void ndIsoSurface::ndImplementation::ClearBuffers()
 	m_hashGridMap.SetCount(0);
 	m_trianglesScratchBuffer.SetCount(0);
 	m_hashGridMapScratchBuffer.SetCount(0);
+	m_surfaceCells.SetCount(0);
 }
 
 //void ndIsoSurface::ndImplementation::BuildHighResolutionMesh(ndIsoSurface* const me, const ndArray<ndVector>& points, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue)
@@ -3374,9 +3561,14 @@ void ndIsoSurface::ndImplementation::BuildHighResolutionMesh(ndIsoSurface* const
 	//ClearBuffers();
 }
 
-void ndIsoSurface::ndImplementation::BuildLowResolutionMesh(ndIsoSurface* const me, const ndArray<ndVector>& points, ndFloat32 gridSize)
+void ndIsoSurface::ndImplementation::BuildLowResolutionMesh(ndIsoSurface* const me, const ndArray<ndVector>& points, ndFloat32 gridSize, ndThreadPool* const threadPool)
 {
 	D_TRACKTIME();
+	m_threadPool = threadPool;
+	if (m_threadPool)
+	{
+		m_threadPool->Begin();
+	}
 	CalculateAabb(points, gridSize);
 	RemoveDuplicates(points);
 	CreateGrids();
@@ -3386,6 +3578,11 @@ void ndIsoSurface::ndImplementation::BuildLowResolutionMesh(ndIsoSurface* const
 	//GenerateLowResIndexList(me);
 	//CalculateNormals(me);
 	ClearBuffers();
+	if (m_threadPool)
+	{
+		m_threadPool->End();
+	}
+	m_threadPool = nullptr;
 }
 
 ndIsoSurface::~ndIsoSurface()
@@ -3393,13 +3590,13 @@ ndIsoSurface::~ndIsoSurface()
 	GetImplementation().Clear();
 }
 
-void ndIsoSurface::GenerateMesh(const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue)
+void ndIsoSurface::GenerateMesh(const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue, ndThreadPool* const threadPool)
 {
 	ndImplementation& implementation = GetImplementation();
 	if (!computeIsoValue)
 	{
 		m_isLowRes = true;
-		implementation.BuildLowResolutionMesh(this, pointCloud, gridSize);
+		implementation.BuildLowResolutionMesh(this, pointCloud, gridSize, threadPool);
 	}
 	else
 	{
@@ -27,6 +27,8 @@
 #include "ndArray.h"
 #include "ndTree.h"
 
+class ndThreadPool;
+
 class ndIsoSurface: public ndClassAlloc
 {
 	public:
@@ -52,7 +54,7 @@ class ndIsoSurface: public ndClassAlloc
 	ndVector GetOrigin() const;
 	const ndArray<ndVector>& GetPoints() const;
 
-	D_CORE_API void GenerateMesh(const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue = nullptr);
+	D_CORE_API void GenerateMesh(const ndArray<ndVector>& pointCloud, ndFloat32 gridSize, ndCalculateIsoValue* const computeIsoValue = nullptr, ndThreadPool* const threadPool = nullptr);
 	D_CORE_API ndInt32 GenerateListIndexList(ndInt32 * const indexList, ndInt32 strideInFloat32, ndReal* const posit, ndReal* const normals) const;
 
 	private:
@@ -0,0 +1,214 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndTree.h"
+#include "ndMappedFile.h"
+
+#if !(defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	#include <fcntl.h>
+	#include <sys/mman.h>
+#endif
+
+class ndMappedFileCache: public ndTree<ndMappedFile*, ndString>
+{
+	public:
+	ndSpinLock m_lock;
+};
+
+static ndMappedFileCache& GetMappedFileCache()
+{
+	static ndMappedFileCache cache;
+	return cache;
+}
+
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+static bool GetHandleIdentity(HANDLE file, ndUnsigned64& device, ndUnsigned64& index, ndUnsigned64& time, ndUnsigned64& size)
+{
+	BY_HANDLE_FILE_INFORMATION info;
+	if (!GetFileInformationByHandle(file, &info))
+	{
+		return false;
+	}
+	device = info.dwVolumeSerialNumber;
+	index = (ndUnsigned64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+	time = (ndUnsigned64(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+	size = (ndUnsigned64(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+	return true;
+}
+#else
+static void GetStatIdentity(const struct stat& info, ndUnsigned64& device, ndUnsigned64& index, ndUnsigned64& time, ndUnsigned64& size)
+{
+	device = ndUnsigned64(info.st_dev);
+	index = ndUnsigned64(info.st_ino);
+	#if defined(__APPLE__)
+		time = ndUnsigned64(info.st_mtimespec.tv_sec) * 1000000000ULL + ndUnsigned64(info.st_mtimespec.tv_nsec);
+	#else
+		time = ndUnsigned64(info.st_mtim.tv_sec) * 1000000000ULL + ndUnsigned64(info.st_mtim.tv_nsec);
+	#endif
+	size = ndUnsigned64(info.st_size);
+}
+#endif
+
+bool ndMappedFile::ndIdentity::operator== (const ndIdentity& src) const
+{
+	return (m_device == src.m_device) && (m_index == src.m_index) && (m_time == src.m_time) && (m_size == src.m_size);
+}
+
+bool ndMappedFile::GetIdentity(const char* const path, ndIdentity& identity)
+{
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	const HANDLE file = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	const bool state = GetHandleIdentity(file, identity.m_device, identity.m_index, identity.m_time, identity.m_size);
+	CloseHandle(file);
+	return state;
+#else
+	struct stat info;
+	if (stat(path, &info))
+	{
+		return false;
+	}
+	GetStatIdentity(info, identity.m_device, identity.m_index, identity.m_time, identity.m_size);
+	return true;
+#endif
+}
+
+ndMappedFile::ndMappedFile(const char* const path)
+	:ndClassAlloc()
+	,m_path(path)
+	,m_identity()
+	,m_data(nullptr)
+	,m_size(0)
+	,m_refCount(1)
+	,m_cached(false)
+{
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	m_mapping = nullptr;
+	m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		GetHandleIdentity(m_file, m_identity.m_device, m_identity.m_index, m_identity.m_time, m_identity.m_size);
+		if (GetFileSizeEx(m_file, &size) && size.QuadPart)
+		{
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping)
+			{
+				m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+				m_size = m_data ? ndUnsigned64(size.QuadPart) : 0;
+			}
+		}
+	}
+#else
+	const int file = open(path, O_RDONLY);
+	if (file >= 0)
+	{
+		struct stat info;
+		if (!fstat(file, &info) && info.st_size)
+		{
+			GetStatIdentity(info, m_identity.m_device, m_identity.m_index, m_identity.m_time, m_identity.m_size);
+			void* const data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+			if (data != MAP_FAILED)
+			{
+				m_data = data;
+				m_size = ndUnsigned64(info.st_size);
+			}
+		}
+		// the mapping keeps its own reference to the file
+		close(file);
+	}
+#endif
+}
+
+ndMappedFile::~ndMappedFile()
+{
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+#else
+	if (m_data)
+	{
+		munmap((void*)m_data, size_t(m_size));
+	}
+#endif
+}
+
+ndMappedFile* ndMappedFile::Open(const char* const path)
+{
+	ndMappedFileCache& cache = GetMappedFileCache();
+	ndScopeSpinLock lock(cache.m_lock);
+	const ndString key(path);
+	ndMappedFileCache::ndNode* const node = cache.Find(key);
+	if (node)
+	{
+		ndIdentity identity;
+		ndMappedFile* const file = node->GetInfo();
+		if (GetIdentity(path, identity) && (identity == file->m_identity))
+		{
+			file->m_refCount++;
+			return file;
+		}
+		// the file changed on disk, the old view stays valid for the 
+		// objects still using it but it is no longer handed out.
+		file->m_cached = false;
+		cache.Remove(node);
+	}
+
+	ndMappedFile* const file = new ndMappedFile(path);
+	if (!file->m_data)
+	{
+		delete file;
+		return nullptr;
+	}
+	file->m_cached = true;
+	cache.Insert(file, key);
+	return file;
+}
+
+void ndMappedFile::Release()
+{
+	ndMappedFileCache& cache = GetMappedFileCache();
+	ndScopeSpinLock lock(cache.m_lock);
+	dAssert(m_refCount > 0);
+	m_refCount--;
+	if (!m_refCount)
+	{
+		if (m_cached)
+		{
+			cache.Remove(m_path);
+		}
+		delete this;
+	}
+}
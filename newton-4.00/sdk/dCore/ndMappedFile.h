@@ -0,0 +1,87 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_MAPPED_FILE_H__
+#define __ND_MAPPED_FILE_H__
+
+#include "ndCoreStdafx.h"
+#include "ndClassAlloc.h"
+#include "ndString.h"
+
+/// Read only view of a whole file mapped in the process address space.
+/// \brief opening the same path again returns the same view with its reference count 
+/// incremented, as long as the file on disk is still the one that was mapped, the pages 
+/// are backed by the file so they are also shared with every other process mapping it. 
+class ndMappedFile: public ndClassAlloc
+{
+	public:
+	/// Map the file, returns nullptr if it can not be opened. 
+	/// \brief each successful call must be paired with a call to Release.
+	D_CORE_API static ndMappedFile* Open(const char* const path);
+
+	/// Decrement the reference count, unmapping the file when it reaches zero.
+	D_CORE_API void Release();
+
+	const void* GetData() const;
+	ndUnsigned64 GetSize() const;
+
+	private:
+	// device and inode, or volume and file index on windows, and the last write time, 
+	// a file replaced by a rename or rewritten in place gets a different identity.
+	class ndIdentity
+	{
+		public:
+		bool operator== (const ndIdentity& src) const;
+
+		ndUnsigned64 m_device;
+		ndUnsigned64 m_index;
+		ndUnsigned64 m_time;
+		ndUnsigned64 m_size;
+	};
+
+	ndMappedFile(const char* const path);
+	~ndMappedFile();
+
+	static bool GetIdentity(const char* const path, ndIdentity& identity);
+
+	ndString m_path;
+	ndIdentity m_identity;
+	const void* m_data;
+	ndUnsigned64 m_size;
+	ndInt32 m_refCount;
+	bool m_cached;
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	HANDLE m_file;
+	HANDLE m_mapping;
+#endif
+};
+
+inline const void* ndMappedFile::GetData() const
+{
+	return m_data;
+}
+
+inline ndUnsigned64 ndMappedFile::GetSize() const
+{
+	return m_size;
+}
+
+#endif
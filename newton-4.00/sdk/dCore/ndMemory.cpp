@@ -21,18 +21,228 @@
 
 #include "ndCoreStdafx.h"
 #include "ndTypes.h"
+#include "ndUtils.h"
 #include "ndMemory.h"
 
-ndAtomic<ndUnsigned64> ndMemory::m_memoryUsed(0);
-
 static ndMemFreeCallback m_freeMemory = free;
 static ndMemAllocCallback m_allocMemory = malloc;
 
+// the id of an account takes the 24 bits of the tag above the category, 
+// the slot and the generation of the slot.
+#define D_MEMORY_ACCOUNT_SLOT_BITS	10
+#define D_MEMORY_ACCOUNT_SLOTS		(1 << D_MEMORY_ACCOUNT_SLOT_BITS)
+#define D_MEMORY_ACCOUNT_GENERATIONS	(1 << (24 - D_MEMORY_ACCOUNT_SLOT_BITS))
+#define D_MEMORY_ACCOUNT_NO_ID		ndUnsigned32(0xffffffff)
+
+// the counters of one thread for one account slot, only the owner thread writes them.
+// the rows belong to the threads and are linked to an account under the lock of the 
+// account table, when the account of a row is destroyed the row is linked to the process 
+// account, so a thread that still holds it never writes to freed memory.
+// each account also has a shared row, updated atomically by threads that 
+// already released their counters, and where the rows of exiting threads are folded.
+class ndMemoryAccountRow
+{
+	public:
+	ndMemoryAccountRow()
+		:m_next(nullptr)
+		,m_prev(nullptr)
+		,m_owner(nullptr)
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+		{
+			m_bytes[i].store(0, std::memory_order_relaxed);
+			m_blocks[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	static ndMemoryAccountRow* Create()
+	{
+		// rows are not counted, so they are not allocated with ndMemory::Malloc
+		return new (m_allocMemory(sizeof(ndMemoryAccountRow))) ndMemoryAccountRow();
+	}
+
+	static void Destroy(ndMemoryAccountRow* const row)
+	{
+		row->~ndMemoryAccountRow();
+		m_freeMemory(row);
+	}
+
+	void Add(ndUnsigned32 category, ndInt64 bytes, ndInt64 blocks)
+	{
+		m_bytes[category].store(m_bytes[category].load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+		m_blocks[category].store(m_blocks[category].load(std::memory_order_relaxed) + blocks, std::memory_order_relaxed);
+	}
+
+	void AddShared(ndUnsigned32 category, ndInt64 bytes, ndInt64 blocks)
+	{
+		m_bytes[category].fetch_add(bytes);
+		m_blocks[category].fetch_add(blocks);
+	}
+
+	ndAtomic<ndInt64> m_bytes[m_memoryCategoryCount];
+	ndAtomic<ndInt64> m_blocks[m_memoryCategoryCount];
+	ndMemoryAccountRow* m_next;
+	ndMemoryAccountRow* m_prev;
+	ndMemoryAccount* m_owner;
+};
+
+// the live accounts by slot, the id of an account is its slot and the generation of the slot, 
+// so that blocks tagged with an account that was destroyed are not charged to the next one.
+class ndMemoryAccountTable
+{
+	public:
+	ndMemoryAccountTable()
+		:m_lock()
+		,m_nextSlot(1)
+	{
+		for (ndInt32 i = 0; i < D_MEMORY_ACCOUNT_SLOTS; ++i)
+		{
+			m_accounts[i] = nullptr;
+			m_ids[i].store(D_MEMORY_ACCOUNT_NO_ID);
+			m_generations[i] = 0;
+		}
+	}
+
+	static ndMemoryAccountTable& GetTable()
+	{
+		// never destroyed, blocks can be freed during the destruction of other statics.
+		static ndUnsigned64 buffer[sizeof(ndMemoryAccountTable) / sizeof(ndUnsigned64) + 1];
+		static ndMemoryAccountTable* const table = new (buffer) ndMemoryAccountTable();
+		return *table;
+	}
+
+	ndSpinLock m_lock;
+	ndMemoryAccount* m_accounts[D_MEMORY_ACCOUNT_SLOTS];
+	ndAtomic<ndUnsigned32> m_ids[D_MEMORY_ACCOUNT_SLOTS];
+	ndUnsigned16 m_generations[D_MEMORY_ACCOUNT_SLOTS];
+	ndInt32 m_nextSlot;
+};
+
+class ndMemoryCounter;
+
+// everything the accounting needs from the calling thread, kept in 
+// one thread local, so that an allocation does only one lookup.
+class ndMemoryThreadState
+{
+	public:
+	ndMemoryCounter* m_counter;
+	ndUnsigned32* m_tagCopy;
+	ndUnsigned32 m_tag;
+	bool m_counterReleased;
+};
+
+static thread_local ndMemoryThreadState m_threadState = { nullptr, nullptr, 0, false };
+
+// the rows of the calling thread by account slot
+class ndMemoryCounter
+{
+	public:
+	class ndEntry
+	{
+		public:
+		ndMemoryAccountRow* m_row;
+		ndUnsigned32 m_id;
+	};
+
+	ndMemoryCounter()
+		:m_table(ndMemoryAccountTable::GetTable())
+		,m_entries((ndEntry*)m_allocMemory(sizeof(ndEntry) * D_MEMORY_ACCOUNT_SLOTS))
+	{
+		for (ndInt32 i = 0; i < D_MEMORY_ACCOUNT_SLOTS; ++i)
+		{
+			m_entries[i].m_row = nullptr;
+			m_entries[i].m_id = D_MEMORY_ACCOUNT_NO_ID;
+		}
+	}
+
+	~ndMemoryCounter()
+	{
+		// the counts of this thread move to the shared rows of the accounts
+		for (ndInt32 i = 0; i < D_MEMORY_ACCOUNT_SLOTS; ++i)
+		{
+			if (m_entries[i].m_row)
+			{
+				ndMemoryAccount::ReleaseThreadRow(m_entries[i].m_row);
+			}
+		}
+		m_freeMemory(m_entries);
+		m_threadState.m_counter = nullptr;
+		m_threadState.m_counterReleased = true;
+	}
+
+	ndMemoryAccountRow* GetRow(ndUnsigned32 id)
+	{
+		const ndInt32 slot = ndInt32(id & (D_MEMORY_ACCOUNT_SLOTS - 1));
+		ndEntry& entry = m_entries[slot];
+		if ((entry.m_id != id) || (m_table.m_ids[slot].load(std::memory_order_relaxed) != id))
+		{
+			// the row of the slot moves to the account of the tag
+			if (!ndMemoryAccount::AttachThreadRow(entry.m_row, id))
+			{
+				// the account is gone, its blocks are charged to the process account
+				return GetRow(0);
+			}
+			entry.m_id = id;
+		}
+		return entry.m_row;
+	}
+
+	static ndMemoryCounter* GetCounter(ndMemoryThreadState& state)
+	{
+		if (!state.m_counter && !state.m_counterReleased)
+		{
+			static thread_local ndMemoryCounter counter;
+			state.m_counter = &counter;
+		}
+		return state.m_counter;
+	}
+
+	static void Add(ndMemoryThreadState& state, ndUnsigned32 tag, ndInt64 bytes, ndInt64 blocks)
+	{
+		ndMemoryCounter* const counter = GetCounter(state);
+		if (counter)
+		{
+			counter->GetRow(tag >> 8)->Add(tag & 0xff, bytes, blocks);
+		}
+		else
+		{
+			ndMemoryAccount::AddShared(tag >> 8, tag & 0xff, bytes, blocks);
+		}
+	}
+
+	static void Move(ndMemoryThreadState& state, ndUnsigned32 srcTag, ndUnsigned32 dstTag, ndInt64 bytes)
+	{
+		ndMemoryCounter* const counter = GetCounter(state);
+		if (counter)
+		{
+			// recycled blocks mostly move between categories of the same account
+			ndMemoryAccountRow* const srcRow = counter->GetRow(srcTag >> 8);
+			ndMemoryAccountRow* const dstRow = ((srcTag ^ dstTag) >> 8) ? counter->GetRow(dstTag >> 8) : srcRow;
+			srcRow->Add(srcTag & 0xff, -bytes, -1);
+			dstRow->Add(dstTag & 0xff, bytes, 1);
+		}
+		else
+		{
+			ndMemoryAccount::AddShared(srcTag >> 8, srcTag & 0xff, -bytes, -1);
+			ndMemoryAccount::AddShared(dstTag >> 8, dstTag & 0xff, bytes, 1);
+		}
+	}
+
+	const ndMemoryAccountTable& m_table;
+	ndEntry* m_entries;
+};
+
 class dMemoryHeader
 {
 	public:
 	void* m_ptr;
 	ndInt32 m_size;
+	ndUnsigned32 m_tag;
 };
 
 #define D_MEMORY_ALIGMNET 32
@@ -54,7 +264,9 @@ void* ndMemory::Malloc(size_t size)
 	dMemoryHeader* const info = ret - 1;
 	info->m_ptr = ptr;
 	info->m_size = ndInt32 (size);
-	m_memoryUsed.fetch_add(size);
+	ndMemoryThreadState& state = m_threadState;
+	info->m_tag = state.m_tag;
+	ndMemoryCounter::Add(state, info->m_tag, ndInt64(size), 1);
 	return ret;
 }
 
@@ -63,7 +275,7 @@ void ndMemory::Free(void* const ptr)
 	if (ptr)
 	{
 		dMemoryHeader* const ret = ((dMemoryHeader*)ptr) - 1;
-		m_memoryUsed.fetch_sub(ret->m_size);
+		ndMemoryCounter::Add(m_threadState, ret->m_tag, -ndInt64(ret->m_size), -1);
 		m_freeMemory(ret->m_ptr);
 	}
 }
@@ -74,9 +286,34 @@ ndInt32 ndMemory::GetSize(void* const ptr)
 	return ret->m_size;
 }
 
+ndInt32 ndMemory::GetSize(void* const ptr, ndUnsigned32& tag)
+{
+	dMemoryHeader* const ret = ((dMemoryHeader*)ptr) - 1;
+	tag = ret->m_tag;
+	return ret->m_size;
+}
+
 ndUnsigned64 ndMemory::GetMemoryUsed()
 {
-	return m_memoryUsed.load();
+	ndInt64 sum = 0;
+	ndMemoryAccount::GetProcessAccount();
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	for (ndInt32 i = 0; i < D_MEMORY_ACCOUNT_SLOTS; ++i)
+	{
+		const ndMemoryAccount* const account = table.m_accounts[i];
+		if (account)
+		{
+			ndInt64 bytes[m_memoryCategoryCount];
+			ndInt64 blocks[m_memoryCategoryCount];
+			account->Accumulate(bytes, blocks);
+			for (ndInt32 j = 0; j < m_memoryCategoryCount; ++j)
+			{
+				sum += bytes[j];
+			}
+		}
+	}
+	return ndUnsigned64(sum);
 }
 
 void ndMemory::SetMemoryAllocators(ndMemAllocCallback alloc, ndMemFreeCallback free)
@@ -84,3 +321,347 @@ void ndMemory::SetMemoryAllocators(ndMemAllocCallback alloc, ndMemFreeCallback f
 	m_allocMemory = alloc;
 	m_freeMemory = free;
 }
+
+ndUnsigned32 ndMemory::GetCurrentTag()
+{
+	return m_threadState.m_tag;
+}
+
+void ndMemory::SetCurrentTag(ndUnsigned32 tag)
+{
+	ndMemoryThreadState& state = m_threadState;
+	state.m_tag = tag;
+	if (state.m_tagCopy)
+	{
+		*state.m_tagCopy = tag;
+	}
+}
+
+void ndMemory::ShareCurrentTag(ndUnsigned32* const copy)
+{
+	// the free list cache of the thread keeps a copy of the tag, 
+	// so that it can check recycled blocks without calling in here.
+	ndMemoryThreadState& state = m_threadState;
+	state.m_tagCopy = copy;
+	if (copy)
+	{
+		*copy = state.m_tag;
+	}
+}
+
+void ndMemory::Retag(void* const ptr)
+{
+	ndMemoryThreadState& state = m_threadState;
+	dMemoryHeader* const info = ((dMemoryHeader*)ptr) - 1;
+	if (info->m_tag != state.m_tag)
+	{
+		ndMemoryCounter::Move(state, info->m_tag, state.m_tag, ndInt64(info->m_size));
+		info->m_tag = state.m_tag;
+	}
+}
+
+ndMemoryAccount::ndMemoryAccount()
+	:m_rows(nullptr)
+	,m_sharedRow(ndMemoryAccountRow::Create())
+	,m_peakTotal(0)
+	,m_id(0)
+{
+	SetName("process");
+	memset(m_peakBytes, 0, sizeof(m_peakBytes));
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	Register(0);
+}
+
+ndMemoryAccount::ndMemoryAccount(const char* const name)
+	:m_rows(nullptr)
+	,m_sharedRow(ndMemoryAccountRow::Create())
+	,m_peakTotal(0)
+	,m_id(0)
+{
+	SetName(name);
+	memset(m_peakBytes, 0, sizeof(m_peakBytes));
+
+	GetProcessAccount();
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	for (ndInt32 i = 1; i < D_MEMORY_ACCOUNT_SLOTS; ++i)
+	{
+		const ndInt32 slot = table.m_nextSlot;
+		table.m_nextSlot = (slot == (D_MEMORY_ACCOUNT_SLOTS - 1)) ? 1 : slot + 1;
+		if (!table.m_accounts[slot])
+		{
+			Register(slot);
+			return;
+		}
+	}
+	// out of slots, the memory of this account is charged to the process account
+	dAssert(0);
+}
+
+ndMemoryAccount::~ndMemoryAccount()
+{
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	{
+		ndScopeSpinLock lock(table.m_lock);
+		const ndInt32 slot = ndInt32(m_id & (D_MEMORY_ACCOUNT_SLOTS - 1));
+		if (slot && (table.m_accounts[slot] == this))
+		{
+			table.m_accounts[slot] = nullptr;
+			table.m_ids[slot].store(D_MEMORY_ACCOUNT_NO_ID);
+			table.m_generations[slot] = ndUnsigned16((table.m_generations[slot] + 1) & (D_MEMORY_ACCOUNT_GENERATIONS - 1));
+
+			// the blocks that are still alive will be debited from the process account, 
+			// the rows of the threads go with them and count for the process account.
+			ndMemoryAccount* const processAccount = table.m_accounts[0];
+			for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+			{
+				processAccount->m_sharedRow->AddShared(ndUnsigned32(i), m_sharedRow->m_bytes[i].load(), m_sharedRow->m_blocks[i].load());
+			}
+			while (m_rows)
+			{
+				ndMemoryAccountRow* const row = m_rows;
+				m_rows = row->m_next;
+				processAccount->LinkRow(row);
+			}
+		}
+	}
+	dAssert(!m_rows);
+	ndMemoryAccountRow::Destroy(m_sharedRow);
+}
+
+void ndMemoryAccount::SetName(const char* const name)
+{
+	strncpy(m_name, name ? name : "", sizeof(m_name) - 1);
+	m_name[sizeof(m_name) - 1] = 0;
+}
+
+void ndMemoryAccount::Register(ndInt32 slot)
+{
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	m_id = (ndUnsigned32(table.m_generations[slot]) << D_MEMORY_ACCOUNT_SLOT_BITS) | ndUnsigned32(slot);
+	table.m_accounts[slot] = this;
+	table.m_ids[slot].store(m_id);
+}
+
+ndMemoryAccount& ndMemoryAccount::GetProcessAccount()
+{
+	// never destroyed, like the account table.
+	static ndUnsigned64 buffer[sizeof(ndMemoryAccount) / sizeof(ndUnsigned64) + 1];
+	static ndMemoryAccount* const account = new (buffer) ndMemoryAccount();
+	return *account;
+}
+
+void ndMemoryAccount::LinkRow(ndMemoryAccountRow* const row)
+{
+	row->m_owner = this;
+	row->m_prev = nullptr;
+	row->m_next = m_rows;
+	if (m_rows)
+	{
+		m_rows->m_prev = row;
+	}
+	m_rows = row;
+}
+
+void ndMemoryAccount::UnlinkRow(ndMemoryAccountRow* const row)
+{
+	// the counts stay with the account, in its shared row
+	ndMemoryAccount* const owner = row->m_owner;
+	for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+	{
+		owner->m_sharedRow->AddShared(ndUnsigned32(i), row->m_bytes[i].load(std::memory_order_relaxed), row->m_blocks[i].load(std::memory_order_relaxed));
+	}
+	row->Reset();
+
+	if (row->m_prev)
+	{
+		row->m_prev->m_next = row->m_next;
+	}
+	else
+	{
+		owner->m_rows = row->m_next;
+	}
+	if (row->m_next)
+	{
+		row->m_next->m_prev = row->m_prev;
+	}
+	row->m_next = nullptr;
+	row->m_prev = nullptr;
+	row->m_owner = nullptr;
+}
+
+bool ndMemoryAccount::AttachThreadRow(ndMemoryAccountRow*& row, ndUnsigned32 id)
+{
+	GetProcessAccount();
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	ndMemoryAccount* const account = table.m_accounts[id & (D_MEMORY_ACCOUNT_SLOTS - 1)];
+	if (!account || (account->m_id != id))
+	{
+		return false;
+	}
+	if (!row)
+	{
+		row = ndMemoryAccountRow::Create();
+	}
+	else if (row->m_owner == account)
+	{
+		return true;
+	}
+	else
+	{
+		UnlinkRow(row);
+	}
+	account->LinkRow(row);
+	return true;
+}
+
+void ndMemoryAccount::ReleaseThreadRow(ndMemoryAccountRow* const row)
+{
+	{
+		ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+		ndScopeSpinLock lock(table.m_lock);
+		UnlinkRow(row);
+	}
+	ndMemoryAccountRow::Destroy(row);
+}
+
+void ndMemoryAccount::AddShared(ndUnsigned32 id, ndUnsigned32 category, ndInt64 bytes, ndInt64 blocks)
+{
+	ndMemoryAccount& processAccount = GetProcessAccount();
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	ndMemoryAccount* account = table.m_accounts[id & (D_MEMORY_ACCOUNT_SLOTS - 1)];
+	if (!account || (account->m_id != id))
+	{
+		account = &processAccount;
+	}
+	account->m_sharedRow->AddShared(category, bytes, blocks);
+}
+
+void ndMemoryAccount::Accumulate(ndInt64* const bytes, ndInt64* const blocks) const
+{
+	for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+	{
+		bytes[i] = m_sharedRow->m_bytes[i].load();
+		blocks[i] = m_sharedRow->m_blocks[i].load();
+	}
+	for (const ndMemoryAccountRow* row = m_rows; row; row = row->m_next)
+	{
+		for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+		{
+			bytes[i] += row->m_bytes[i].load(std::memory_order_relaxed);
+			blocks[i] += row->m_blocks[i].load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void ndMemoryAccount::UpdatePeaks(const ndInt64* const bytes) const
+{
+	ndInt64 total = 0;
+	for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+	{
+		total += bytes[i];
+		m_peakBytes[i] = dMax(m_peakBytes[i], bytes[i]);
+	}
+	m_peakTotal = dMax(m_peakTotal, total);
+}
+
+void ndMemoryAccount::UpdatePeaks()
+{
+	ndInt64 bytes[m_memoryCategoryCount];
+	ndInt64 blocks[m_memoryCategoryCount];
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	Accumulate(bytes, blocks);
+	UpdatePeaks(bytes);
+}
+
+ndMemoryStats ndMemoryAccount::GetStats(ndMemoryCategory category) const
+{
+	ndInt64 bytes[m_memoryCategoryCount];
+	ndInt64 blocks[m_memoryCategoryCount];
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	Accumulate(bytes, blocks);
+	UpdatePeaks(bytes);
+
+	ndMemoryStats stats;
+	stats.m_bytes = bytes[category];
+	stats.m_blocks = blocks[category];
+	stats.m_peakBytes = m_peakBytes[category];
+	return stats;
+}
+
+ndMemoryStats ndMemoryAccount::GetTotal() const
+{
+	ndInt64 bytes[m_memoryCategoryCount];
+	ndInt64 blocks[m_memoryCategoryCount];
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	Accumulate(bytes, blocks);
+	UpdatePeaks(bytes);
+
+	ndMemoryStats stats;
+	stats.m_bytes = 0;
+	stats.m_blocks = 0;
+	stats.m_peakBytes = m_peakTotal;
+	for (ndInt32 i = 0; i < m_memoryCategoryCount; ++i)
+	{
+		stats.m_bytes += bytes[i];
+		stats.m_blocks += blocks[i];
+	}
+	return stats;
+}
+
+const char* ndMemoryAccount::GetCategoryName(ndMemoryCategory category)
+{
+	static const char* const names[] =
+	{
+		"general",
+		"broadphase",
+		"contacts",
+		"static meshes",
+		"skeletons",
+		"solver",
+		"particles",
+		"scratch",
+	};
+	dAssert(sizeof(names) / sizeof(names[0]) == m_memoryCategoryCount);
+	return ((category >= 0) && (category < m_memoryCategoryCount)) ? names[category] : "unknown";
+}
+
+void ndMemoryAccount::Dump(FILE* const file)
+{
+	GetProcessAccount();
+	ndMemoryAccountTable& table = ndMemoryAccountTable::GetTable();
+	ndScopeSpinLock lock(table.m_lock);
+	for (ndInt32 i = 0; i < D_MEMORY_ACCOUNT_SLOTS; ++i)
+	{
+		const ndMemoryAccount* const account = table.m_accounts[i];
+		if (account)
+		{
+			ndInt64 bytes[m_memoryCategoryCount];
+			ndInt64 blocks[m_memoryCategoryCount];
+			account->Accumulate(bytes, blocks);
+			account->UpdatePeaks(bytes);
+
+			ndInt64 totalBytes = 0;
+			ndInt64 totalBlocks = 0;
+			for (ndInt32 j = 0; j < m_memoryCategoryCount; ++j)
+			{
+				totalBytes += bytes[j];
+				totalBlocks += blocks[j];
+			}
+			fprintf(file, "%s: %lld bytes, peak %lld, %lld blocks\n", account->m_name, (long long)totalBytes, (long long)account->m_peakTotal, (long long)totalBlocks);
+			for (ndInt32 j = 0; j < m_memoryCategoryCount; ++j)
+			{
+				if (bytes[j] || account->m_peakBytes[j])
+				{
+					fprintf(file, "  %-14s %12lld bytes, peak %12lld, %8lld blocks\n", GetCategoryName(ndMemoryCategory(j)), (long long)bytes[j], (long long)account->m_peakBytes[j], (long long)blocks[j]);
+				}
+			}
+		}
+	}
+}
@@ -28,6 +28,29 @@
 typedef void* (*ndMemAllocCallback) (size_t size);
 typedef void (*ndMemFreeCallback) (void* const ptr);
 
+/// Subsystems the memory of the engine is charged to.
+enum ndMemoryCategory
+{
+	m_generalMemory = 0,
+	m_broadphaseMemory,
+	m_contactMemory,
+	m_staticMeshMemory,
+	m_skeletonMemory,
+	m_solverMemory,
+	m_particleMemory,
+	m_scratchMemory,
+	m_memoryCategoryCount,
+};
+
+/// Live blocks and bytes charged to one category of an account.
+class ndMemoryStats
+{
+	public:
+	ndInt64 m_bytes;
+	ndInt64 m_peakBytes;
+	ndInt64 m_blocks;
+};
+
 class ndMemory
 {
 	public:
@@ -42,11 +65,15 @@ class ndMemory
 	/// Get memory buffer size previously allocated by Malloc.
 	D_CORE_API static ndInt32 GetSize(void* const ptr);
 
+	/// Get memory buffer size and the account and category the buffer is charged to.
+	D_CORE_API static ndInt32 GetSize(void* const ptr, ndUnsigned32& tag);
+
 	/// Calculate buffer size.
 	D_CORE_API static ndInt32 CalculateBufferSize(size_t size);
 
 
 	/// Return the total memory allocated by the newton engine and tools.
+	/// \brief this is the sum of all accounts, see ndMemoryAccount.
 	D_CORE_API static ndUnsigned64 GetMemoryUsed();
 
 	/// Install low level system memory allocation functions.
@@ -64,8 +91,125 @@ class ndMemory
 	/// application or just before start using the engine.
 	D_CORE_API static void SetMemoryAllocators(ndMemAllocCallback alloc, ndMemFreeCallback free);
 
+	/// Return the account and category the calling thread charges its allocations to.
+	D_CORE_API static ndUnsigned32 GetCurrentTag();
+
+	/// Set the account and category the calling thread charges its allocations to.
+	/// \brief applications should use a ndMemoryScope instead.
+	D_CORE_API static void SetCurrentTag(ndUnsigned32 tag);
+
+	/// Move a live block to the account and category of the calling thread.
+	/// \brief used by allocators that recycle blocks, so that a recycled 
+	/// block is charged to its new user and not to the one that freed it.
+	D_CORE_API static void Retag(void* const ptr);
+
+	private:
+	static void ShareCurrentTag(ndUnsigned32* const copy);
+
+	friend class dFreeListThreadCache;
+};
+
+class ndMemoryAccountRow;
+
+/// A named owner of memory, usually one per world.
+/// \brief every block is tagged with the account and the category that were current 
+/// in the allocating thread, freeing a block debits the account it is tagged with.
+/// each thread counts into its own row of the account, so the accounting is a couple
+/// of stores per allocation. the rows are added when the account is queried. 
+/// \brief the peaks are sampled, at the end of each world update and on each query.
+/// \brief blocks cached by the free lists stay charged to the account that freed them until 
+/// they are reused, blocks that outlive their account are moved to the process account.
+class ndMemoryAccount
+{
+	public:
+	D_CORE_API ndMemoryAccount(const char* const name);
+	D_CORE_API ~ndMemoryAccount();
+
+	const char* GetName() const;
+	D_CORE_API void SetName(const char* const name);
+
+	/// The tag of this account for a category, see ndMemory::SetCurrentTag.
+	ndUnsigned32 GetTag(ndMemoryCategory category) const;
+
+	D_CORE_API ndMemoryStats GetStats(ndMemoryCategory category) const;
+	D_CORE_API ndMemoryStats GetTotal() const;
+	D_CORE_API void UpdatePeaks();
+
+	/// The account of all memory allocated outside of a ndMemoryScope.
+	D_CORE_API static ndMemoryAccount& GetProcessAccount();
+	D_CORE_API static const char* GetCategoryName(ndMemoryCategory category);
+
+	/// Write the stats of every live account.
+	D_CORE_API static void Dump(FILE* const file);
+
 	private:
-	static ndAtomic<ndUnsigned64> m_memoryUsed;
+	ndMemoryAccount();
+	void Register(ndInt32 slot);
+	void UpdatePeaks(const ndInt64* const bytes) const;
+	void Accumulate(ndInt64* const bytes, ndInt64* const blocks) const;
+	void LinkRow(ndMemoryAccountRow* const row);
+	static void UnlinkRow(ndMemoryAccountRow* const row);
+	static bool AttachThreadRow(ndMemoryAccountRow*& row, ndUnsigned32 id);
+	static void ReleaseThreadRow(ndMemoryAccountRow* const row);
+	static void AddShared(ndUnsigned32 id, ndUnsigned32 category, ndInt64 bytes, ndInt64 blocks);
+
+	char m_name[32];
+	ndMemoryAccountRow* m_rows;
+	ndMemoryAccountRow* m_sharedRow;
+	mutable ndInt64 m_peakBytes[m_memoryCategoryCount];
+	mutable ndInt64 m_peakTotal;
+	ndUnsigned32 m_id;
+
+	friend class ndMemory;
+	friend class ndMemoryCounter;
 };
 
+/// Charges the allocations of the calling thread to an account and 
+/// category until the scope ends. scopes can be nested.
+/// \brief the tasks of a ndThreadPool inherit the scope of the thread that submits them.
+class ndMemoryScope
+{
+	public:
+	ndMemoryScope(ndMemoryCategory category);
+	ndMemoryScope(const ndMemoryAccount& account);
+	ndMemoryScope(const ndMemoryAccount& account, ndMemoryCategory category);
+	~ndMemoryScope();
+
+	private:
+	ndUnsigned32 m_savedTag;
+};
+
+inline const char* ndMemoryAccount::GetName() const
+{
+	return m_name;
+}
+
+inline ndUnsigned32 ndMemoryAccount::GetTag(ndMemoryCategory category) const
+{
+	return (m_id << 8) | ndUnsigned32(category);
+}
+
+inline ndMemoryScope::ndMemoryScope(ndMemoryCategory category)
+	:m_savedTag(ndMemory::GetCurrentTag())
+{
+	ndMemory::SetCurrentTag((m_savedTag & ~0xff) | ndUnsigned32(category));
+}
+
+inline ndMemoryScope::ndMemoryScope(const ndMemoryAccount& account)
+	:m_savedTag(ndMemory::GetCurrentTag())
+{
+	ndMemory::SetCurrentTag(account.GetTag(ndMemoryCategory(m_savedTag & 0xff)));
+}
+
+inline ndMemoryScope::ndMemoryScope(const ndMemoryAccount& account, ndMemoryCategory category)
+	:m_savedTag(ndMemory::GetCurrentTag())
+{
+	ndMemory::SetCurrentTag(account.GetTag(category));
+}
+
+inline ndMemoryScope::~ndMemoryScope()
+{
+	ndMemory::SetCurrentTag(m_savedTag);
+}
+
 #endif
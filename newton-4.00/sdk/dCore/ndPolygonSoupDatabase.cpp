@@ -44,8 +44,14 @@ ndPolygonSoupDatabase::~ndPolygonSoupDatabase ()
 	}
 }
 
+bool ndPolygonSoupDatabase::IsMapped() const
+{
+	return false;
+}
+
 void ndPolygonSoupDatabase::SetTagId(const ndInt32* const facePtr, ndInt32 indexCount, ndUnsigned32 newID) const
 {
+	dAssert(!IsMapped());
 	ndUnsigned32* const face = (ndUnsigned32*) facePtr;
 	face[indexCount] = newID;
 }
@@ -41,6 +41,9 @@ class ndPolygonSoupDatabase: public ndClassAlloc
 	ndPolygonSoupDatabase(const char* const name = nullptr);
 	virtual ~ndPolygonSoupDatabase ();
 
+	// the faces of a soup that uses a file in place are read only
+	virtual bool IsMapped() const;
+
 	ndInt32 m_vertexCount;
 	ndInt32 m_strideInBytes;
 	ndFloat32* m_localVertex;
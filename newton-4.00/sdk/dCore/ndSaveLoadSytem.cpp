@@ -138,3 +138,38 @@ void* LoadClass(const char* const className, const ndLoadSaveBase::ndLoadDescrip
 	return nullptr;
 }
 
+
+bool SaveBinaryFile(const char* const path, const void* const data, size_t size)
+{
+	char tmpPath[1024 * 2];
+	snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+	FILE* const file = fopen(tmpPath, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	const size_t written = size ? fwrite(data, 1, size, file) : 0;
+	bool flushed = (fflush(file) == 0);
+	// the data must be on disk before the rename replaces the old file
+	#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	flushed = flushed && (_commit(_fileno(file)) == 0);
+	#else
+	flushed = flushed && (fsync(fileno(file)) == 0);
+	#endif
+	fclose(file);
+
+	// the destination is replaced in one step, it is never deleted first
+	#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	// crt rename fails when the destination exists
+	const bool replaced = (written == size) && flushed && MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+	#else
+	const bool replaced = (written == size) && flushed && !rename(tmpPath, path);
+	#endif
+	if (!replaced)
+	{
+		dTrace(("failed to write %s\n", path));
+		remove(tmpPath);
+	}
+	return replaced;
+}
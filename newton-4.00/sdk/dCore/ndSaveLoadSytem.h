@@ -101,6 +101,7 @@ class ndLoadSaveBase: public ndClassAlloc
 			,m_body0NodeHash(0)
 			,m_body1NodeHash(0)
 			,m_assetIndex(0)
+			,m_saveAssets(true)
 			,m_shapeMap(nullptr)
 			,m_bodyMap(nullptr)
 			,m_jointMap(nullptr)
@@ -116,6 +117,7 @@ class ndLoadSaveBase: public ndClassAlloc
 			,m_body0NodeHash(desc.m_body0NodeHash)
 			,m_body1NodeHash(desc.m_body1NodeHash)
 			,m_assetIndex(desc.m_assetIndex)
+			,m_saveAssets(desc.m_saveAssets)
 			,m_shapeMap(desc.m_shapeMap)
 			,m_bodyMap(desc.m_bodyMap)
 			,m_jointMap(desc.m_jointMap)
@@ -130,6 +132,8 @@ class ndLoadSaveBase: public ndClassAlloc
 		ndInt32 m_body0NodeHash;
 		ndInt32 m_body1NodeHash;
 		mutable ndInt32 m_assetIndex;
+		// when false, shapes with a binary asset only write the xml node that names it
+		bool m_saveAssets;
 		ndTree<ndInt32, const ndShape*>* m_shapeMap;
 		ndTree<ndInt32, const ndBodyKinematic*>* m_bodyMap;
 		ndTree<ndInt32, const ndJointBilateralConstraint*>* m_jointMap;
@@ -145,6 +149,10 @@ class ndLoadSaveBase: public ndClassAlloc
 D_CORE_API void* LoadClass(const char* const className, const ndLoadSaveBase::ndLoadDescriptor& desc);
 D_CORE_API void RegisterLoaderClass(const char* const className, ndLoadSaveBase* const loaderClass);
 
+// writes the data to a temporary file, flushes it to disk and renames it over path, 
+// so a reader sees either the old or the new file. returns false if any step fails.
+D_CORE_API bool SaveBinaryFile(const char* const path, const void* const data, size_t size);
+
 template<class T>
 class ndLoadSaveClass: public ndLoadSaveBase
 {
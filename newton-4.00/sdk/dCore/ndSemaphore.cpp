@@ -71,6 +71,15 @@ void ndSemaphore::Signal()
 #endif
 }
 
+void ndSemaphore::Reset()
+{
+#ifndef D_USE_THREAD_EMULATION
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_count = 0;
+	m_terminate.store(false);
+#endif
+}
+
 void ndSemaphore::Terminate()
 {
 #ifndef D_USE_THREAD_EMULATION
@@ -53,6 +53,10 @@ class ndSemaphore
 	/// Notify a waiting thread on member function Wait that is time to exit the thread loop.
 	D_CORE_API void Terminate();
 
+	/// Set the counter to zero and clear the terminate flag.
+	/// \brief this lets a new thread wait on a semaphore that was terminated.
+	D_CORE_API void Reset();
+
 #ifndef D_USE_THREAD_EMULATION
 	private:
 	mutable std::mutex m_mutex;
@@ -83,8 +83,28 @@ void ndThread::SetName(const char* const name)
 void ndThread::Finish()
 {
 #ifndef D_USE_THREAD_EMULATION
-	Terminate();
-	join();
+	if (joinable())
+	{
+		Terminate();
+		join();
+	}
+#endif
+}
+
+void ndThread::Restart()
+{
+#ifndef D_USE_THREAD_EMULATION
+	// a thread stopped by Finish gets a new system thread
+	if (!joinable())
+	{
+		ndSemaphore::Reset();
+		store(true);
+		std::thread::operator=(std::thread(&ndThread::ThreadFunctionCallback, this));
+		while (load())
+		{
+			ndYield();
+		}
+	}
 #endif
 }
 
@@ -42,6 +42,7 @@ class ndThread
 	D_CORE_API void SetName(const char* const name);
 
 	D_CORE_API void Finish();
+	D_CORE_API void Restart();
 	D_CORE_API void Signal();
 
 	virtual void ThreadFunction() = 0;
@@ -33,6 +33,7 @@ ndThreadBackgroundWorker::ndThreadBackgroundWorker()
 	,m_lock()
 	,m_inLoop(false)
 	,m_teminate(false)
+	,m_stopped(false)
 	,m_queueSemaphore()
 {
 	Signal();
@@ -57,6 +58,45 @@ void ndThreadBackgroundWorker::Terminate()
 	}
 }
 
+void ndThreadBackgroundWorker::Stop()
+{
+	if (!m_stopped.load())
+	{
+		m_teminate = true;
+		m_queueSemaphore.Terminate();
+		Finish();
+		m_stopped.store(true);
+
+		// the tasks that were still queued run here
+		while (GetFirst())
+		{
+			ndBackgroundTask* const task = GetFirst()->GetInfo();
+			Remove(GetFirst());
+			ExecuteTask(task);
+		}
+	}
+}
+
+void ndThreadBackgroundWorker::Restart()
+{
+	if (m_stopped.load())
+	{
+		m_teminate = false;
+		m_queueSemaphore.Reset();
+		m_stopped.store(false);
+		ndThread::Restart();
+		Signal();
+	}
+}
+
+void ndThreadBackgroundWorker::ExecuteTask(ndBackgroundTask* const task)
+{
+	Begin();
+	task->Execute(this);
+	End();
+	task->m_taskState.store(ndBackgroundTask::m_taskCompleted);
+}
+
 void ndBackgroundTask::Sync() const
 {
 	while (m_taskState == m_taskInProccess)
@@ -75,6 +115,12 @@ void ndThreadBackgroundWorker::SendTask(ndBackgroundTask* const task)
 		task->m_taskState = ndBackgroundTask::m_taskCompleted;
 	}
 	#else
+	if (m_stopped.load())
+	{
+		task->m_taskState.store(ndBackgroundTask::m_taskInProccess);
+		ExecuteTask(task);
+		return;
+	}
 	{
 		ndScopeSpinLock lock(m_lock);
 		task->m_taskState.store(ndBackgroundTask::m_taskInProccess);
@@ -96,10 +142,7 @@ void ndThreadBackgroundWorker::ThreadFunction()
 			task = node->GetInfo();
 			Remove(node);
 		}
-		Begin();
-		task->Execute(this);
-		End();
-		task->m_taskState.store(ndBackgroundTask::m_taskCompleted);
+		ExecuteTask(task);
 	}
 	m_inLoop.store(false);
 }
\ No newline at end of file
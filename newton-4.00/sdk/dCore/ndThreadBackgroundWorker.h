@@ -70,13 +70,20 @@ class ndThreadBackgroundWorker: public ndThreadPool, public ndList<ndBackgroundT
 
 	D_CORE_API void Terminate();
 	D_CORE_API void SendTask(ndBackgroundTask* const job);
+
+	// stop the thread of the worker, until it is restarted 
+	// the tasks are executed by the thread that sends them.
+	D_CORE_API void Stop();
+	D_CORE_API void Restart();
 	
 	private:
 	virtual void ThreadFunction();
+	void ExecuteTask(ndBackgroundTask* const task);
 
 	ndSpinLock m_lock;
 	ndAtomic<bool> m_inLoop;
 	ndAtomic<bool> m_teminate;
+	ndAtomic<bool> m_stopped;
 	ndSemaphore m_queueSemaphore;
 };
 
@@ -29,6 +29,7 @@ ndThreadPool::ndWorker::ndWorker()
 	:ndThread()
 	,m_owner(nullptr)
 	,m_begin(false)
+	,m_parked(false)
 	,m_stillLooping(true)
 	,m_task(nullptr)
 	,m_threadIndex(0)
@@ -40,24 +41,65 @@ ndThreadPool::ndWorker::~ndWorker()
 	Finish();
 }
 
+void ndThreadPool::ndWorker::SubmitTask(ndTask* const task)
+{
+	m_task.store(task);
+	WakeUp();
+}
+
+void ndThreadPool::ndWorker::WakeUp()
+{
+#ifndef	D_USE_THREAD_EMULATION
+	if (m_parked.load())
+	{
+		std::unique_lock<std::mutex> lock(m_parkMutex);
+		m_parkCondition.notify_one();
+	}
+#endif
+}
+
+void ndThreadPool::ndWorker::Park()
+{
+#ifndef	D_USE_THREAD_EMULATION
+	// block the thread until a new task arrives, so that idle 
+	// workers do not burn cpu cycles between simulation updates.
+	std::unique_lock<std::mutex> lock(m_parkMutex);
+	m_parked.store(true);
+	while (!m_task.load() && m_begin.load())
+	{
+		m_parkCondition.wait(lock);
+	}
+	m_parked.store(false);
+#endif
+}
+
 void ndThreadPool::ndWorker::ThreadFunction()
 {
 #ifndef	D_USE_THREAD_EMULATION
 	D_SET_TRACK_NAME(m_name);
-	m_begin.store(true);
 	m_stillLooping.store(true);
+	ndInt32 spinCount = 0;
 	while (m_begin.load())
 	{
 		ndTask* const task = m_task.load();
 		if (task)
 		{
+			ndMemory::SetCurrentTag(task->m_memoryTag);
 			task->Execute();
 			m_task.store(nullptr);
+			m_owner->WorkerTaskCompleted();
+			spinCount = 0;
 		}
-		else
+		else if (spinCount < D_WORKER_SPIN_COUNT)
 		{
+			spinCount++;
 			ndYield();
 		}
+		else
+		{
+			Park();
+			spinCount = 0;
+		}
 	}
 	m_stillLooping.store(false);
 #endif
@@ -67,6 +109,9 @@ ndThreadPool::ndThreadPool(const char* const baseName)
 	:ndSyncMutex()
 	,ndThread()
 	,m_workers(nullptr)
+	,m_queues(new ndWorkQueue[1])
+	,m_pendingTasks(0)
+	,m_parked(false)
 	,m_count(0)
 {
 	char name[256];
@@ -78,12 +123,29 @@ ndThreadPool::ndThreadPool(const char* const baseName)
 ndThreadPool::~ndThreadPool()
 {
 	SetThreadCount(0);
+	delete[] m_queues;
+}
+
+ndInt32 ndThreadPool::GetMaxThreads()
+{
+#ifdef	D_USE_THREAD_EMULATION
+	return D_MAX_THREADS_COUNT;
+#else
+	const ndInt32 hardwareThreads = ndInt32(std::thread::hardware_concurrency());
+	return dClamp(hardwareThreads, 1, D_MAX_THREADS_COUNT);
+#endif
 }
 
 void ndThreadPool::SetThreadCount(ndInt32 count)
 {
 #ifdef	D_USE_THREAD_EMULATION
-	m_count = dClamp(count, 1, D_MAX_THREADS_COUNT) - 1;
+	count = dClamp(count, 1, D_MAX_THREADS_COUNT) - 1;
+	if (count != m_count)
+	{
+		m_count = count;
+		delete[] m_queues;
+		m_queues = new ndWorkQueue[count + 1];
+	}
 #else
 	count = dClamp(count, 1, D_MAX_THREADS_COUNT) - 1;
 	if (count != m_count)
@@ -94,6 +156,8 @@ void ndThreadPool::SetThreadCount(ndInt32 count)
 			delete[] m_workers;
 			m_workers = nullptr;
 		}
+		delete[] m_queues;
+		m_queues = new ndWorkQueue[count + 1];
 		if (count)
 		{
 			m_count = count;
@@ -116,6 +180,7 @@ void ndThreadPool::Begin()
 	D_TRACKTIME();
 	for (ndInt32 i = 0; i < m_count; ++i)
 	{
+		m_workers[i].m_begin.store(true);
 		m_workers[i].Signal();
 	}
 }
@@ -126,6 +191,7 @@ void ndThreadPool::End()
 	for (ndInt32 i = 0; i < m_count; ++i)
 	{
 		m_workers[i].m_begin.store(false);
+		m_workers[i].WakeUp();
 	}
 
 	bool stillLooping = true;
@@ -141,6 +207,70 @@ void ndThreadPool::End()
 	#endif
 }
 
+void ndThreadPool::WorkerTaskCompleted()
+{
+#ifndef	D_USE_THREAD_EMULATION
+	const ndInt32 pending = m_pendingTasks.fetch_sub(1) - 1;
+	if (!pending && m_parked.load())
+	{
+		std::unique_lock<std::mutex> lock(m_parkMutex);
+		m_parkCondition.notify_one();
+	}
+#endif
+}
+
+void ndThreadPool::WaitForWorkers()
+{
+#ifndef	D_USE_THREAD_EMULATION
+	for (ndInt32 i = 0; (i < D_WORKER_SPIN_COUNT) && m_pendingTasks.load(); ++i)
+	{
+		ndYield();
+	}
+
+	if (m_pendingTasks.load())
+	{
+		std::unique_lock<std::mutex> lock(m_parkMutex);
+		m_parked.store(true);
+		while (m_pendingTasks.load())
+		{
+			m_parkCondition.wait(lock);
+		}
+		m_parked.store(false);
+	}
+#endif
+}
+
+bool ndThreadPool::GetWork(ndInt32 threadIndex, ndInt32 chunkSize, ndInt32& start, ndInt32& end)
+{
+	const ndInt32 threadCount = GetThreadCount();
+	for (;;)
+	{
+		if (m_queues[threadIndex].Pop(chunkSize, start, end))
+		{
+			return true;
+		}
+
+		// local queue is empty, try stealing from the other workers
+		bool stolen = false;
+		for (ndInt32 i = 1; (i < threadCount) && !stolen; ++i)
+		{
+			ndInt32 victim = threadIndex + i;
+			victim = (victim >= threadCount) ? victim - threadCount : victim;
+			ndInt32 stealStart;
+			ndInt32 stealEnd;
+			if (m_queues[victim].Steal(stealStart, stealEnd))
+			{
+				m_queues[threadIndex].Set(stealStart, stealEnd);
+				stolen = true;
+			}
+		}
+		if (!stolen)
+		{
+			return false;
+		}
+	}
+}
+
 void ndThreadPool::Release()
 {
 	ndSyncMutex::Release();
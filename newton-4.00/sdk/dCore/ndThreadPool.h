@@ -26,11 +26,14 @@
 #include "ndTypes.h"
 #include "ndArray.h"
 #include "ndThread.h"
+#include "ndProfiler.h"
 #include "ndSyncMutex.h"
 #include "ndSemaphore.h"
 #include "ndClassAlloc.h"
 
-#define	D_MAX_THREADS_COUNT	16
+#define	D_MAX_THREADS_COUNT			256
+#define	D_WORKER_SPIN_COUNT			1024
+#define	D_WORKER_CHUNKS_PER_THREAD	16
 
 class ndThreadPool;
 
@@ -51,9 +54,16 @@ class ndStartEnd
 class ndTask
 {
 	public:
-	ndTask(){}
+	ndTask()
+		:m_memoryTag(ndMemory::GetCurrentTag())
+	{
+	}
 	virtual ~ndTask(){}
 	virtual void Execute() const = 0;
+
+	private:
+	// workers charge their allocations to the scope of the thread that submitted the task
+	ndUnsigned32 m_memoryTag;
 	friend class ndThreadPool;
 };
 
@@ -67,21 +77,46 @@ class ndThreadPool: public ndSyncMutex, public ndThread
 
 		private:
 		virtual void ThreadFunction();
+		void SubmitTask(ndTask* const task);
+		void WakeUp();
+		void Park();
 
 		ndThreadPool* m_owner;
 		ndAtomic<bool> m_begin;
+		ndAtomic<bool> m_parked;
 		ndAtomic<bool> m_stillLooping;
 		ndAtomic<ndTask*> m_task;
 		ndInt32 m_threadIndex;
+		#ifndef D_USE_THREAD_EMULATION
+		std::mutex m_parkMutex;
+		std::condition_variable m_parkCondition;
+		#endif
 		friend class ndThreadPool;
 	};
 
+	// range of items owned by one worker. the owner pops small chunks 
+	// from the front, idle workers steal half of the remainder from the back.
+	class ndWorkQueue: public ndClassAlloc
+	{
+		public:
+		ndWorkQueue();
+
+		void Set(ndInt32 start, ndInt32 end);
+		bool Pop(ndInt32 chunkSize, ndInt32& start, ndInt32& end);
+		bool Steal(ndInt32& start, ndInt32& end);
+
+		private:
+		ndAtomic<ndUnsigned64> m_range;
+		char m_padding[64 - sizeof(ndAtomic<ndUnsigned64>)];
+	};
+
 	public:
 	D_CORE_API ndThreadPool(const char* const baseName);
 	D_CORE_API virtual ~ndThreadPool();
 
 	ndInt32 GetThreadCount() const;
 	D_CORE_API void SetThreadCount(ndInt32 count);
+	D_CORE_API static ndInt32 GetMaxThreads();
 
 	D_CORE_API void TickOne();
 	D_CORE_API void Begin();
@@ -90,12 +125,25 @@ class ndThreadPool: public ndSyncMutex, public ndThread
 	template <typename Function>
 	void ParallelExecute(const Function& ndFunction);
 
+	template <typename Function>
+	void ParallelExecuteRange(ndInt32 count, const Function& ndFunction);
+
 	private:
 	D_CORE_API virtual void Release();
+	D_CORE_API void WaitForWorkers();
+	D_CORE_API void WorkerTaskCompleted();
+	D_CORE_API bool GetWork(ndInt32 threadIndex, ndInt32 chunkSize, ndInt32& start, ndInt32& end);
 
 	ndWorker* m_workers;
+	ndWorkQueue* m_queues;
+	ndAtomic<ndInt32> m_pendingTasks;
+	ndAtomic<bool> m_parked;
 	ndInt32 m_count;
 	char m_baseName[32];
+	#ifndef D_USE_THREAD_EMULATION
+	std::mutex m_parkMutex;
+	std::condition_variable m_parkCondition;
+	#endif
 };
 
 inline ndInt32 ndThreadPool::GetThreadCount() const
@@ -103,6 +151,62 @@ inline ndInt32 ndThreadPool::GetThreadCount() const
 	return m_count + 1;
 }
 
+inline ndThreadPool::ndWorkQueue::ndWorkQueue()
+	:m_range(0)
+{
+}
+
+inline void ndThreadPool::ndWorkQueue::Set(ndInt32 start, ndInt32 end)
+{
+	m_range.store((ndUnsigned64(ndUnsigned32(end)) << 32) | ndUnsigned32(start));
+}
+
+inline bool ndThreadPool::ndWorkQueue::Pop(ndInt32 chunkSize, ndInt32& start, ndInt32& end)
+{
+	ndUnsigned64 range = m_range.load();
+	for (;;)
+	{
+		const ndInt32 first = ndInt32(range & 0xffffffff);
+		const ndInt32 last = ndInt32(range >> 32);
+		if (first >= last)
+		{
+			return false;
+		}
+		const ndInt32 next = dMin(first + chunkSize, last);
+		const ndUnsigned64 newRange = (ndUnsigned64(ndUnsigned32(last)) << 32) | ndUnsigned32(next);
+		if (m_range.compare_exchange_weak(range, newRange))
+		{
+			start = first;
+			end = next;
+			return true;
+		}
+		range = m_range.load();
+	}
+}
+
+inline bool ndThreadPool::ndWorkQueue::Steal(ndInt32& start, ndInt32& end)
+{
+	ndUnsigned64 range = m_range.load();
+	for (;;)
+	{
+		const ndInt32 first = ndInt32(range & 0xffffffff);
+		const ndInt32 last = ndInt32(range >> 32);
+		if (first >= last)
+		{
+			return false;
+		}
+		const ndInt32 split = last - (last - first + 1) / 2;
+		const ndUnsigned64 newRange = (ndUnsigned64(ndUnsigned32(split)) << 32) | ndUnsigned32(first);
+		if (m_range.compare_exchange_weak(range, newRange))
+		{
+			start = split;
+			end = last;
+			return true;
+		}
+		range = m_range.load();
+	}
+}
+
 template <typename Type, typename ... Args>
 class ndFunction
 	:public ndFunction<decltype(&Type::operator())(Args...)>
@@ -193,29 +297,16 @@ void ndThreadPool::ParallelExecute(const Function& ndFunction)
 			ndFunction(job->m_threadIndex, job->m_threadCount);
 		}
 		#else
+		m_pendingTasks.store(m_count);
 		for (ndInt32 i = 0; i < m_count; ++i)
 		{
 			ndTaskImplement<Function>* const job = &jobsArray[i];
-			m_workers[i].m_task.store(job);
+			m_workers[i].SubmitTask(job);
 		}
 	
 		ndTaskImplement<Function>* const job = &jobsArray[m_count];
 		ndFunction(job->m_threadIndex, job->m_threadCount);
-
-		bool jobsInProgress = true;
-		do
-		{
-			bool inProgess = false;
-			for (ndInt32 i = 0; i < m_count; ++i)
-			{
-				inProgess = inProgess | (m_workers[i].m_task.load() != nullptr);
-			}
-			jobsInProgress = jobsInProgress & inProgess;
-			if (jobsInProgress)
-			{
-				ndYield();
-			}
-		} while (jobsInProgress);
+		WaitForWorkers();
 		#endif
 	}
 	else
@@ -225,4 +316,31 @@ void ndThreadPool::ParallelExecute(const Function& ndFunction)
 	}
 }
 
+template <typename Function>
+void ndThreadPool::ParallelExecuteRange(ndInt32 count, const Function& ndFunction)
+{
+	// the function is called with (threadIndex, start, end) for each chunk of the range.
+	// each thread starts on its own static slice, and threads that run out of work 
+	// steal from the slowest, so one expensive item no longer stalls the whole phase.
+	const ndInt32 threadCount = GetThreadCount();
+	const ndInt32 chunkSize = dMax(count / (threadCount * D_WORKER_CHUNKS_PER_THREAD), 1);
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		const ndStartEnd startEnd(count, i, threadCount);
+		m_queues[i].Set(startEnd.m_start, startEnd.m_end);
+	}
+
+	auto ExecuteRange = ndMakeObject::ndFunction([this, &ndFunction, chunkSize](ndInt32 threadIndex, ndInt32)
+	{
+		D_TRACKTIME();
+		ndInt32 start;
+		ndInt32 end;
+		while (GetWork(threadIndex, chunkSize, start, end))
+		{
+			ndFunction(threadIndex, start, end);
+		}
+	});
+	ParallelExecute(ExecuteRange);
+}
+
 #endif
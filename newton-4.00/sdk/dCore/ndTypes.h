@@ -333,12 +333,12 @@ inline void operator delete[](void* ptr)	\
 			return m_val;
 		}
 
-		T load() const
+		T load(std::memory_order = std::memory_order_seq_cst) const
 		{
 			return m_val;
 		}
 
-		void store(T val)
+		void store(T val, std::memory_order = std::memory_order_seq_cst)
 		{
 			m_val = val;
 		}
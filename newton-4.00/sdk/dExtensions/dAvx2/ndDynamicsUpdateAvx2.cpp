@@ -658,11 +658,13 @@ void ndDynamicsUpdateAvx2::SortIslands()
 	GetInternalForces().SetCount(bodyArray.GetCount());
 	activeBodyArray.SetCount(bodyArray.GetCount());
 
-	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
-	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const histogram = scene->GetFrameArena().Alloc<ndInt32>(threadCount * 3);
+	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, histogram](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
+		ndInt32* const hist = &histogram[threadIndex * 3];
 		hist[0] = 0;
 		hist[1] = 0;
 		hist[2] = 0;
@@ -682,10 +684,10 @@ void ndDynamicsUpdateAvx2::SortIslands()
 		}
 	});
 
-	auto Sort0 = ndMakeObject::ndFunction([this, &bodyArray, &activeBodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Sort0 = ndMakeObject::ndFunction([this, &bodyArray, &activeBodyArray, histogram](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
+		ndInt32* const hist = &histogram[threadIndex * 3];
 		const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, threadCount);
 
 		ndInt32 map[4];
@@ -710,15 +712,14 @@ void ndDynamicsUpdateAvx2::SortIslands()
 	scan[0] = 0;
 	scan[1] = 0;
 	scan[2] = 0;
-	const ndInt32 threadCount = scene->GetThreadCount();
 
 	ndInt32 sum = 0;
 	for (ndInt32 i = 0; i < 3; ++i)
 	{
 		for (ndInt32 j = 0; j < threadCount; ++j)
 		{
-			ndInt32 partialSum = histogram[j][i];
-			histogram[j][i] = sum;
+			ndInt32 partialSum = histogram[j * 3 + i];
+			histogram[j * 3 + i] = sum;
 			sum += partialSum;
 		}
 		scan[i] = sum;
@@ -817,9 +818,11 @@ void ndDynamicsUpdateAvx2::InitWeights()
 	const ndInt32 bodyCount = bodyArray.GetCount();
 	GetInternalForces().SetCount(bodyCount);
 
-	ndInt32 extraPassesArray[D_MAX_THREADS_COUNT];
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const extraPassesArray = scene->GetFrameArena().Alloc<ndInt32>(threadCount);
 
-	auto InitWeights = ndMakeObject::ndFunction([this, &bodyArray, &extraPassesArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitWeights = ndMakeObject::ndFunction([this, &bodyArray, extraPassesArray](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
 		const ndArray<ndInt32>& jointForceIndexBuffer = GetJointForceIndexBuffer();
@@ -853,7 +856,6 @@ void ndDynamicsUpdateAvx2::InitWeights()
 		scene->ParallelExecute(InitWeights);
 
 		ndInt32 extraPasses = 0;
-		const ndInt32 threadCount = scene->GetThreadCount();
 		for (ndInt32 i = 0; i < threadCount; ++i)
 		{
 			extraPasses = dMax(extraPasses, extraPassesArray[i]);
@@ -998,9 +1000,8 @@ void ndDynamicsUpdateAvx2::InitJacobianMatrix()
 	ndBodyKinematic** const bodyArray = &scene->GetActiveBodyArray()[0];
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndAvxFloat* const internalForces = (ndAvxFloat*)&GetTempInternalForces()[0];
 		auto BuildJacobianMatrix = [this, &internalForces](ndConstraint* const joint, ndInt32 jointIndex)
 		{
@@ -1110,8 +1111,7 @@ void ndDynamicsUpdateAvx2::InitJacobianMatrix()
 			outBody1 = forceAcc1;
 		};
 
-		const ndInt32 jointCount = jointArray.GetCount();
-		for (ndInt32 i = threadIndex; i < jointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			GetJacobianDerivatives(joint);
@@ -1155,26 +1155,21 @@ void ndDynamicsUpdateAvx2::InitJacobianMatrix()
 		}
 	});
 
-	auto TransposeMassMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto TransposeMassMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
-		const ndInt32 jointCount = jointArray.GetCount();
-
 		const ndLeftHandSide* const leftHandSide = &GetLeftHandSide()[0];
 		const ndRightHandSide* const rightHandSide = &GetRightHandSide()[0];
 		ndAvxMatrixArray& massMatrix = *m_avxMassMatrixArray;
 
 		const ndAvxFloat zero(ndAvxFloat::m_zero);
 		const ndAvxFloat ordinals(ndAvxFloat::m_ordinals);
-		const ndInt32 mask = -ndInt32(D_AVX_WORK_GROUP);
-		const ndInt32 soaJointCount = ((jointCount + D_AVX_WORK_GROUP - 1) & mask) / D_AVX_WORK_GROUP;
 
 		ndInt8* const groupType = &m_groupType[0];
 		ndAvxFloat* const jointMask = (ndAvxFloat*)&m_jointMask[0];
 		const ndInt32* const soaJointRows = &m_avxJointRows[0];
 
 		ndConstraint** const jointsPtr = &jointArray[0];
-		for (ndInt32 i = threadIndex; i < soaJointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			const ndInt32 index = i * D_AVX_WORK_GROUP;
 			ndInt32 maxRow = 0;
@@ -1463,9 +1458,9 @@ void ndDynamicsUpdateAvx2::InitJacobianMatrix()
 		D_TRACKTIME();
 		m_rightHandSide[0].m_force = ndFloat32(1.0f);
 
-		scene->ParallelExecute(InitJacobianMatrix);
+		scene->ParallelExecuteRange(jointArray.GetCount(), InitJacobianMatrix);
 		scene->ParallelExecute(InitJacobianAccumulatePartialForces);
-		scene->ParallelExecute(TransposeMassMatrix);
+		scene->ParallelExecuteRange(m_avxJointRows.GetCount(), TransposeMassMatrix);
 	}
 }
 
@@ -1475,16 +1470,14 @@ void ndDynamicsUpdateAvx2::UpdateForceFeedback()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto UpdateForceFeedback = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateForceFeedback = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 		const ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 
 		ndAvxFloat zero(ndFloat32(0.0f));
 		const ndFloat32 timestepRK = GetTimestepRK();
-		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			const ndInt32 rows = joint->m_rowCount;
@@ -1521,7 +1514,7 @@ void ndDynamicsUpdateAvx2::UpdateForceFeedback()
 		}
 	});
 
-	scene->ParallelExecute(UpdateForceFeedback);
+	scene->ParallelExecuteRange(jointArray.GetCount(), UpdateForceFeedback);
 }
 
 void ndDynamicsUpdateAvx2::InitSkeletons()
@@ -1530,13 +1523,12 @@ void ndDynamicsUpdateAvx2::InitSkeletons()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndSkeletonContainer*>& activeSkeletons = m_world->m_activeSkeletons;
 
-	auto InitSkeletons = ndMakeObject::ndFunction([this, &activeSkeletons](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitSkeletons = ndMakeObject::ndFunction([this, &activeSkeletons](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 		const ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 
-		for (ndInt32 i = threadIndex; i < activeSkeletons.GetCount(); i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndSkeletonContainer* const skeleton = activeSkeletons[i];
 			skeleton->InitMassMatrix(&leftHandSide[0], &rightHandSide[0]);
@@ -1545,7 +1537,7 @@ void ndDynamicsUpdateAvx2::InitSkeletons()
 
 	if (activeSkeletons.GetCount())
 	{
-		scene->ParallelExecute(InitSkeletons);
+		scene->ParallelExecuteRange(activeSkeletons.GetCount(), InitSkeletons);
 	}
 }
 
@@ -1556,11 +1548,10 @@ void ndDynamicsUpdateAvx2::UpdateSkeletons()
 	const ndArray<ndSkeletonContainer*>& activeSkeletons = m_world->m_activeSkeletons;
 	const ndBodyKinematic** const bodyArray = (const ndBodyKinematic**)(&scene->GetActiveBodyArray()[0]);
 
-	auto UpdateSkeletons = ndMakeObject::ndFunction([this, &bodyArray, &activeSkeletons](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateSkeletons = ndMakeObject::ndFunction([this, &bodyArray, &activeSkeletons](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJacobian* const internalForces = &GetInternalForces()[0];
-		for (ndInt32 i = threadIndex; i < activeSkeletons.GetCount(); i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndSkeletonContainer* const skeleton = activeSkeletons[i];
 			skeleton->CalculateReactionForces(internalForces);
@@ -1569,7 +1560,7 @@ void ndDynamicsUpdateAvx2::UpdateSkeletons()
 
 	if (activeSkeletons.GetCount())
 	{
-		scene->ParallelExecute(UpdateSkeletons);
+		scene->ParallelExecuteRange(activeSkeletons.GetCount(), UpdateSkeletons);
 	}
 }
 
@@ -1579,9 +1570,8 @@ void ndDynamicsUpdateAvx2::CalculateJointsAcceleration()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto CalculateJointsAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CalculateJointsAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJointAccelerationDecriptor joindDesc;
 		joindDesc.m_timestep = m_timestepRK;
 		joindDesc.m_invTimestep = m_invTimestepRK;
@@ -1589,8 +1579,7 @@ void ndDynamicsUpdateAvx2::CalculateJointsAcceleration()
 		ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 
-		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			const ndInt32 pairStart = joint->m_rowStart;
@@ -1601,20 +1590,16 @@ void ndDynamicsUpdateAvx2::CalculateJointsAcceleration()
 		}
 	});
 
-	auto UpdateAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 
-		const ndInt32 jointCount = jointArray.GetCount();
-		const ndInt32 mask = -ndInt32(D_AVX_WORK_GROUP);
 		const ndInt32* const soaJointRows = &m_avxJointRows[0];
-		const ndInt32 soaJointCountBatches = ((jointCount + D_AVX_WORK_GROUP - 1) & mask) / D_AVX_WORK_GROUP;
 		const ndInt8* const groupType = &m_groupType[0];
 
 		const ndConstraint* const * jointArrayPtr = &jointArray[0];
 		ndAvxMatrixArray& massMatrix = *m_avxMassMatrixArray;
-		for (ndInt32 i = threadIndex; i < soaJointCountBatches; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			if (groupType[i])
 			{
@@ -1655,10 +1640,10 @@ void ndDynamicsUpdateAvx2::CalculateJointsAcceleration()
 		}
 	});
 
-	scene->ParallelExecute(CalculateJointsAcceleration);
+	scene->ParallelExecuteRange(jointArray.GetCount(), CalculateJointsAcceleration);
 
 	m_firstPassCoef = ndFloat32(1.0f);
-	scene->ParallelExecute(UpdateAcceleration);
+	scene->ParallelExecuteRange(m_avxJointRows.GetCount(), UpdateAcceleration);
 }
 
 void ndDynamicsUpdateAvx2::IntegrateBodiesVelocity()
@@ -1719,10 +1704,8 @@ void ndDynamicsUpdateAvx2::CalculateJointsForce()
 	ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
-		const ndInt32 jointCount = jointArray.GetCount();
 		ndJacobian* const jointPartialForces = &GetTempInternalForces()[0];
 
 		const ndInt32* const soaJointRows = &m_avxJointRows[0];
@@ -2135,10 +2118,7 @@ void ndDynamicsUpdateAvx2::CalculateJointsForce()
 			}
 		};
 
-		const ndInt32 mask = -ndInt32(D_AVX_WORK_GROUP);
-		const ndInt32 soaJointCount = ((jointCount + D_AVX_WORK_GROUP - 1) & mask) / D_AVX_WORK_GROUP;
-
-		for (ndInt32 i = threadIndex; i < soaJointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			JointForce(i, &soaMassMatrix[soaJointRows[i]]);
 		}
@@ -2174,7 +2154,7 @@ void ndDynamicsUpdateAvx2::CalculateJointsForce()
 
 	for (ndInt32 i = 0; i < passes; ++i)
 	{
-		scene->ParallelExecute(CalculateJointsForce);
+		scene->ParallelExecuteRange(m_avxJointRows.GetCount(), CalculateJointsForce);
 		scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
 	}
 }
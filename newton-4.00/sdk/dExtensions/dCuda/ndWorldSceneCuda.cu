@@ -160,8 +160,8 @@ void ndWorldSceneCuda::End()
 	ndWorldScene::End();
 }
 
-//void ndWorldSceneCuda::FindCollidingPairs(ndBodyKinematic* const body)
-void ndWorldSceneCuda::FindCollidingPairs(ndBodyKinematic* const)
+//void ndWorldSceneCuda::FindCollidingPairs(ndInt32 threadIndex, ndBodyKinematic* const body)
+void ndWorldSceneCuda::FindCollidingPairs(ndInt32, ndBodyKinematic* const)
 {
 	dAssert(0);
 }
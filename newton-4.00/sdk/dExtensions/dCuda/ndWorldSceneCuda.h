@@ -39,7 +39,7 @@ class ndWorldSceneCuda : public ndWorldScene
 	virtual void CalculateContacts();
 	virtual void FindCollidingPairs();
 
-	virtual void FindCollidingPairs(ndBodyKinematic* const body);
+	virtual void FindCollidingPairs(ndInt32 threadIndex, ndBodyKinematic* const body);
 	virtual void CalculateContacts(ndInt32 threadIndex, ndContact* const contact);
 
 	virtual void UpdateTransform();
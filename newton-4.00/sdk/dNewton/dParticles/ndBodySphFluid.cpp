@@ -26,6 +26,11 @@
 
 #define D_SPH_HASH_BITS				8
 #define D_SPH_BUFFER_GRANULARITY	4096	
+#define D_SPH_MORTON_BITS			10
+#define D_SPH_SORT_INTERVAL			8
+
+// the skin grows the search volume by half, so the list has room for that many more neighbors
+#define D_SPH_MAX_NEIGHBORS			64
 
 class ndBodySphFluid::ndGridHash
 {
@@ -59,7 +64,8 @@ class ndBodySphFluid::ndGridHash
 		m_y = hash.m_iy;
 		m_z = hash.m_iz;
 
-		m_cellType = ndAdjacentGrid;
+		m_lowY = 1;
+		m_lowZ = 1;
 		m_particleIndex = particleIndex;
 	}
 
@@ -70,7 +76,8 @@ class ndBodySphFluid::ndGridHash
 			ndUnsigned64 m_y				: D_SPH_HASH_BITS * 2;
 			ndUnsigned64 m_z				: D_SPH_HASH_BITS * 2;
 			ndUnsigned64 m_particleIndex	: 23;
-			ndUnsigned64 m_cellType			: 1;
+			ndUnsigned64 m_lowY				: 1;
+			ndUnsigned64 m_lowZ				: 1;
 		};
 		struct
 		{
@@ -86,16 +93,17 @@ class ndBodySphFluid::ndGridHash
 class ndBodySphFluid::ndParticlePair
 {
 	public:
-	ndInt32 m_neighborg[32];
+	ndInt32 m_neighborg[D_SPH_MAX_NEIGHBORS];
 };
 
-class ndBodySphFluid::ndParticleKernelDistance
+class ndBodySphFluid::ndParticleKey
 {
 	public:
-	ndFloat32 m_dist[32];
+	ndUnsigned32 m_key;
+	ndInt32 m_particleIndex;
 };
 
-class ndBodySphFluid::ndWorkingData
+class ndBodySphFluid::ndWorkingData: public ndClassAlloc
 {
 	#define D_SPH_GRID_X_RESOLUTION 4
 
@@ -110,32 +118,18 @@ class ndBodySphFluid::ndWorkingData
 		,m_pairs(D_SPH_BUFFER_GRANULARITY)
 		,m_hashGridMap(D_SPH_BUFFER_GRANULARITY)
 		,m_hashGridMapScratchBuffer(D_SPH_BUFFER_GRANULARITY)
-		,m_kernelDistance(D_SPH_BUFFER_GRANULARITY)
+		,m_partialsGridScans(D_SPH_BUFFER_GRANULARITY)
+		,m_buildPosit(D_SPH_BUFFER_GRANULARITY)
+		,m_particleKeys(D_SPH_BUFFER_GRANULARITY)
+		,m_particleKeysScratchBuffer(D_SPH_BUFFER_GRANULARITY)
+		,m_threadBoxes(D_SPH_BUFFER_GRANULARITY)
+		,m_particleMapScratchBuffer(D_SPH_BUFFER_GRANULARITY)
 		,m_worlToGridOrigin(ndFloat32 (1.0f))
 		,m_worlToGridScale(ndFloat32(1.0f))
+		,m_stepsSinceBuild(0)
+		,m_buildsSinceSort(D_SPH_SORT_INTERVAL)
+		,m_saturated(0)
 	{
-		for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
-		{
-			m_partialsGridScans[i].Resize(D_SPH_BUFFER_GRANULARITY);
-		}
-	}
-
-	void Clear()
-	{
-		m_accel.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_locks.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_pairs.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_density.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_pairCount.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_gridScans.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_invDensity.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_hashGridMap.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_kernelDistance.Resize(D_SPH_BUFFER_GRANULARITY);
-		m_hashGridMapScratchBuffer.Resize(D_SPH_BUFFER_GRANULARITY);
-		for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
-		{
-			m_partialsGridScans[i].Resize(D_SPH_BUFFER_GRANULARITY);
-		}
 	}
 
 	void SetWorldToGridMapping(ndInt32 gridCount, ndFloat32 xMax, ndFloat32 xMin)
@@ -160,10 +154,17 @@ class ndBodySphFluid::ndWorkingData
 	ndArray<ndParticlePair> m_pairs;
 	ndArray<ndGridHash> m_hashGridMap;
 	ndArray<ndGridHash> m_hashGridMapScratchBuffer;
-	ndArray<ndParticleKernelDistance> m_kernelDistance;
-	ndArray<ndInt32> m_partialsGridScans[D_MAX_THREADS_COUNT];
+	ndArray<ndInt32> m_partialsGridScans;
+	ndArray<ndVector> m_buildPosit;
+	ndArray<ndParticleKey> m_particleKeys;
+	ndArray<ndParticleKey> m_particleKeysScratchBuffer;
+	ndArray<ndVector> m_threadBoxes;
+	ndArray<ndInt32> m_particleMapScratchBuffer;
 	ndFloat32 m_worlToGridOrigin;
 	ndFloat32 m_worlToGridScale;
+	ndInt32 m_stepsSinceBuild;
+	ndInt32 m_buildsSinceSort;
+	ndAtomic<ndInt32> m_saturated;
 };
 
 ndBodySphFluid::ndBodySphFluid()
@@ -172,6 +173,10 @@ ndBodySphFluid::ndBodySphFluid()
 	,m_viscosity(ndFloat32 (1.05f))
 	,m_restDensity(ndFloat32(1000.0f))
 	,m_gasConstant(ndFloat32(1.0f))
+	,m_searchSkin(ndFloat32(0.0f))
+	,m_neighborSkin(ndFloat32(0.0f))
+	,m_particleMap()
+	,m_workingData(new ndWorkingData)
 {
 }
 
@@ -181,6 +186,10 @@ ndBodySphFluid::ndBodySphFluid(const ndLoadSaveBase::ndLoadDescriptor& desc)
 	,m_viscosity(ndFloat32(1.0f))
 	,m_restDensity(ndFloat32(1000.0f))
 	,m_gasConstant(ndFloat32(1.0f))
+	,m_searchSkin(ndFloat32(0.0f))
+	,m_neighborSkin(ndFloat32(0.0f))
+	,m_particleMap()
+	,m_workingData(new ndWorkingData)
 {
 	// nothing was saved
 	dAssert(0);
@@ -188,8 +197,7 @@ ndBodySphFluid::ndBodySphFluid(const ndLoadSaveBase::ndLoadDescriptor& desc)
 
 ndBodySphFluid::~ndBodySphFluid()
 {
-	ndWorkingData& data = WorkingData();
-	data.Clear();
+	delete m_workingData;
 }
 
 //void ndBodySphFluid::Save(const dLoadSaveBase::dSaveDescriptor& desc) const
@@ -202,8 +210,7 @@ void ndBodySphFluid::Save(const ndLoadSaveBase::ndSaveDescriptor&) const
 
 ndBodySphFluid::ndWorkingData& ndBodySphFluid::WorkingData()
 {
-	static ndWorkingData workingBuffers;
-	return workingBuffers;
+	return *m_workingData;
 }
 
 void ndBodySphFluid::SortXdimension(ndThreadPool* const threadPool)
@@ -347,7 +354,7 @@ void ndBodySphFluid::SortCellBuckects(ndThreadPool* const threadPool)
 	};
 
 	ndWorkingData& data = WorkingData();
-	const ndVector boxSize((m_box1 - m_box0).Scale(ndFloat32(1.0f) / GetSphGridSize()).GetInt());
+	const ndVector boxSize((m_box1 - m_box0).Scale(ndFloat32(1.0f) / GetSearchGridSize()).GetInt());
 
 	ndCountingSort<ndGridHash, ndKey_ylow, D_SPH_HASH_BITS>(*threadPool, data.m_hashGridMap, data.m_hashGridMapScratchBuffer);
 	if (boxSize.m_iy > (1 << D_SPH_HASH_BITS))
@@ -377,62 +384,78 @@ void ndBodySphFluid::CalculateScans(ndThreadPool* const threadPool)
 {
 	D_TRACKTIME();
 	ndWorkingData& data = WorkingData();
-	ndInt32 sums[D_MAX_THREADS_COUNT + 1];
-	ndInt32 scans[D_MAX_THREADS_COUNT + 1];
+	const ndInt32 threadCount = threadPool->GetThreadCount();
+	ndInt32* const sums = dAlloca(ndInt32, threadCount + 1);
+	ndInt32* const scans = dAlloca(ndInt32, threadCount + 1);
+	ndInt32* const partialCounts = dAlloca(ndInt32, threadCount);
 
-	auto CountGridScans = ndMakeObject::ndFunction([this, &data, &scans](ndInt32 threadIndex, ndInt32)
+	// each thread writes its cell counts to its own slice of the particle range, 
+	// a thread never produces more cells than the particles it owns. 
+	auto CountGridScans = ndMakeObject::ndFunction([this, &data, scans, partialCounts](ndInt32 threadIndex, ndInt32)
 	{
 		D_TRACKTIME();
 		const ndGridHash* const hashGridMap = &data.m_hashGridMap[0];
 
 		const ndInt32 start = scans[threadIndex];
 		const ndInt32 end = scans[threadIndex + 1];
-		ndArray<ndInt32>& gridScans = data.m_partialsGridScans[threadIndex];
+		if (start >= end)
+		{
+			// a thread with no particles produces no cells
+			partialCounts[threadIndex] = 0;
+			return;
+		}
+
+		ndInt32* const gridScans = &data.m_partialsGridScans[start];
 		ndUnsigned64 gridHash0 = hashGridMap[start].m_gridHash;
 
 		ndInt32 count = 0;
-		gridScans.SetCount(0);
+		ndInt32 cellCount = 0;
 		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndUnsigned64 gridHash = hashGridMap[i].m_gridHash;
 			if (gridHash != gridHash0)
 			{
-				gridScans.PushBack(count);
+				gridScans[cellCount] = count;
+				cellCount++;
 				count = 0;
 				gridHash0 = gridHash;
 			}
 			count++;
 		}
-		gridScans.PushBack(count);
+		gridScans[cellCount] = count;
+		partialCounts[threadIndex] = cellCount + 1;
 	});
 
-	auto CalculateScans = ndMakeObject::ndFunction([this, &data, &scans, &sums](ndInt32 threadIndex, ndInt32)
+	auto CalculateScans = ndMakeObject::ndFunction([this, &data, scans, sums, partialCounts](ndInt32 threadIndex, ndInt32)
 	{
 		D_TRACKTIME();
+		if (!partialCounts[threadIndex])
+		{
+			return;
+		}
 		ndArray<ndInt32>& gridScans = data.m_gridScans;
-		const ndArray<ndInt32>& partialScan = data.m_partialsGridScans[threadIndex];
+		const ndInt32* const partialScan = &data.m_partialsGridScans[scans[threadIndex]];
 		const ndInt32 base = sums[threadIndex];
 		ndInt32 sum = scans[threadIndex];
-		for (ndInt32 i = 0; i < partialScan.GetCount(); ++i)
+		for (ndInt32 i = 0; i < partialCounts[threadIndex]; ++i)
 		{
 			gridScans[base + i] = sum;
 			sum += partialScan[i];
 		}
 	});
 
-	memset(scans, 0, sizeof(scans));
-	const ndInt32 threadCount = threadPool->GetThreadCount();
-	
 	ndInt32 particleCount = data.m_hashGridMap.GetCount();
+	data.m_partialsGridScans.SetCount(particleCount);
 
 	ndInt32 acc0 = 0;
 	ndInt32 stride = particleCount / threadCount;
 	const ndGridHash* const hashGridMap = &data.m_hashGridMap[0];
 	for (ndInt32 threadIndex = 0; threadIndex < threadCount; threadIndex++)
 	{
-		scans[threadIndex] = acc0;
+		// a large cell can push the start of the slices past the end of the particles
+		scans[threadIndex] = dMin(acc0, particleCount);
 		acc0 += stride;
-		while (acc0 < particleCount && (hashGridMap[acc0].m_gridHash == hashGridMap[acc0 - 1].m_gridHash))
+		while ((acc0 > 0) && (acc0 < particleCount) && (hashGridMap[acc0].m_gridHash == hashGridMap[acc0 - 1].m_gridHash))
 		{
 			acc0++;
 		}
@@ -445,7 +468,7 @@ void ndBodySphFluid::CalculateScans(ndThreadPool* const threadPool)
 	for (ndInt32 i = 0; i < threadCount; ++i)
 	{
 		sums[i] = scansCount;
-		scansCount += data.m_partialsGridScans[i].GetCount();
+		scansCount += partialCounts[i];
 	}
 	sums[threadCount] = scansCount;
 
@@ -482,7 +505,7 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 	data.m_pairs.SetCount(m_posit.GetCount());
 	data.m_locks.SetCount(m_posit.GetCount());
 	data.m_pairCount.SetCount(m_posit.GetCount());
-	data.m_kernelDistance.SetCount(m_posit.GetCount());
+	data.m_buildPosit.SetCount(m_posit.GetCount());
 	for (ndInt32 i = countReset; i < data.m_locks.GetCount(); ++i)
 	{
 		data.m_locks[i].Unlock();
@@ -491,28 +514,27 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 	{
 		data.m_pairCount[i] = 0;
 	}
+	data.m_saturated.store(0);
 
-	auto AddPairs = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	auto AddPairs = ndMakeObject::ndFunction([this, &data](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndGridHash>& hashGridMap = data.m_hashGridMap;
 		const ndArray<ndInt32>& gridScans = data.m_gridScans;
-		const ndFloat32 diameter = GetSphGridSize();
+		const ndFloat32 diameter = GetSearchGridSize();
 		const ndFloat32 diameter2 = diameter * diameter;
-		const ndInt32 windowsTest = data.WorldToGrid(data.m_worlToGridOrigin + diameter) + 1;
+		// the window is rounded up by one more key, quantizing the diameter can round it down
+		const ndInt32 windowsTest = data.WorldToGrid(data.m_worlToGridOrigin + diameter) + 2;
 
 		ndArray<ndSpinLock>& locks = data.m_locks;
 		ndArray<ndInt8>& pairCount = data.m_pairCount;
 		ndArray<ndParticlePair>& pair = data.m_pairs;
-		ndArray<ndParticleKernelDistance>& distance = data.m_kernelDistance;
 
-		auto ProccessCell = [this, &data, &hashGridMap, &pair, &pairCount, &locks, &distance, windowsTest, diameter2](ndInt32 start, ndInt32 count)
+		auto ProccessCell = [this, &data, &hashGridMap, &pair, &pairCount, &locks, windowsTest, diameter2](ndInt32 start, ndInt32 count)
 		{
 			const ndInt32 count0 = count - 1;
 			for (ndInt32 i = 0; i < count0; ++i)
 			{
 				const ndGridHash hash0 = hashGridMap[start + i];
-				const ndInt32 homeGridTest0 = (hash0.m_cellType == ndHomeGrid);
 				const ndInt32 particle0 = hash0.m_particleIndex;
 				const ndInt32 x0 = data.WorldToGrid(m_posit[particle0].m_x);
 				for (ndInt32 j = i + 1; j < count; ++j)
@@ -528,8 +550,9 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 						break;
 					}
 					dAssert(particle0 != particle1);
-					const ndInt32 homeGridTest1 = (hash1.m_cellType == ndHomeGrid);
-					const ndInt32 test = homeGridTest0 | homeGridTest1;
+					// the boxes of the two particles overlap in a block of cells, the pair is only tested
+					// in the lowest cell of that block, which is the low cell of one box on each axis.
+					const ndInt32 test = ndInt32((hash0.m_lowY | hash1.m_lowY) & (hash0.m_lowZ | hash1.m_lowZ));
 					if (test)
 					{
 						dAssert(particle0 != particle1);
@@ -539,11 +562,10 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 						if (dist2 < diameter2)
 						{
 							dAssert(dist2 >= ndFloat32(0.0f));
-							const ndFloat32 dist = ndSqrt(dist2);
 							{
 								ndSpinLock lock(locks[particle0]);
 								ndInt8 neigborCount = pairCount[particle0];
-								if (neigborCount < 32)
+								if (neigborCount < D_SPH_MAX_NEIGHBORS)
 								{
 									ndInt8 isUnique = 1;
 									ndInt32* const neighborg = pair[particle0].m_neighborg;
@@ -553,15 +575,18 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 									}
 
 									neighborg[neigborCount] = particle1;
-									distance[particle0].m_dist[neigborCount] = dist;
 									pairCount[particle0] = neigborCount + isUnique;
 								}
+								else
+								{
+									data.m_saturated.store(1);
+								}
 							}
 
 							{
 								ndSpinLock lock(locks[particle1]);
 								ndInt8 neigborCount = pairCount[particle1];
-								if (neigborCount < 32)
+								if (neigborCount < D_SPH_MAX_NEIGHBORS)
 								{
 									ndInt8 isUnique = 1;
 									ndInt32* const neighborg = pair[particle1].m_neighborg;
@@ -570,9 +595,12 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 										isUnique = isUnique & (neighborg[k] != particle0);
 									}
 									neighborg[neigborCount] = particle0;
-									distance[particle1].m_dist[neigborCount] = dist;
 									pairCount[particle1] = neigborCount + isUnique;
 								}
+								else
+								{
+									data.m_saturated.store(1);
+								}
 							}
 						}
 					}
@@ -580,21 +608,39 @@ void ndBodySphFluid::BuildPairs(ndThreadPool* const threadPool)
 			}
 		};
 
-		// even step is nor good because the bashes tend to be clustered
-		// a better way is to sort, bu that takes about 1 ms,
-		// we interleaving bashes and has the randomizing 
-		// effect that balance the work load on the thread.
+		// even step is nor good because the bashes tend to be clustered,
+		// the cells are handed out in small chunks and idle threads 
+		// steal from the busy ones, that balance the work load on the threads.
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			const ndInt32 cellStart = gridScans[i];
+			const ndInt32 count = gridScans[i + 1] - cellStart;
+			ProccessCell(cellStart, count);
+		}
+	});
 
-		const ndInt32 scansCount = gridScans.GetCount() - 1;
-		for (ndInt32 i = threadIndex; i < scansCount; i += threadCount)
+	// the kernels read the neighbors four at a time, the unused slots of
+	// the last group point to the particle itself and are masked out.
+	auto PadPairs = ndMakeObject::ndFunction([this, &data](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		D_TRACKTIME();
+		const ndVector* const posit = &m_posit[0];
+		ndVector* const buildPosit = &data.m_buildPosit[0];
+		for (ndInt32 i = start; i < end; ++i)
 		{
-			const ndInt32 start = gridScans[i];
-			const ndInt32 count = gridScans[i + 1] - start;
-			ProccessCell(start, count);
+			const ndInt32 count = data.m_pairCount[i];
+			ndInt32* const neighborg = data.m_pairs[i].m_neighborg;
+			for (ndInt32 j = count; j < ((count + 3) & -4); ++j)
+			{
+				neighborg[j] = i;
+			}
+			buildPosit[i] = posit[i];
 		}
 	});
 	
-	threadPool->ParallelExecute(AddPairs);
+	threadPool->ParallelExecuteRange(data.m_gridScans.GetCount() - 1, AddPairs);
+	threadPool->ParallelExecuteRange(m_posit.GetCount(), PadPairs);
+	data.m_stepsSinceBuild = 0;
 }
 
 void ndBodySphFluid::CalculateParticlesDensity(ndThreadPool* const threadPool)
@@ -604,38 +650,51 @@ void ndBodySphFluid::CalculateParticlesDensity(ndThreadPool* const threadPool)
 	data.m_density.SetCount(m_posit.GetCount());
 	data.m_invDensity.SetCount(m_posit.GetCount());
 
-	auto CalculateDensity = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	// the neighbors are read four at the time in soa form, the distances are 
+	// recalculated because the list is reused for as long as the skin allows.
+	auto CalculateDensity = ndMakeObject::ndFunction([this, &data](ndInt32, ndInt32 start, ndInt32 end)
 	{
 		D_TRACKTIME();
-		const ndArray<ndVector>& posit = m_posit;
-
+		const ndVector* const posit = &m_posit[0];
 		const ndFloat32 h = GetSphGridSize();
 		const ndFloat32 h2 = h * h;
 		const ndFloat32 kernelMagicConst = ndFloat32(315.0f) / (ndFloat32(64.0f) * ndPi * ndPow(h, 9));
 		const ndFloat32 kernelConst = m_mass * kernelMagicConst;
 		const ndFloat32 selfDensity = kernelConst * h2 * h2 * h2;
+		const ndVector kernelRadius2(h2);
+		const ndVector lanes(ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(2.0f), ndFloat32(3.0f));
 
-		const ndStartEnd startEnd(posit.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
+			const ndVector p0(posit[i]);
 			const ndInt32 count = data.m_pairCount[i];
-			const ndParticleKernelDistance& distance = data.m_kernelDistance[i];
-			ndFloat32 density = selfDensity;
-			for (ndInt32 j = 0; j < count; ++j)
+			const ndInt32* const neighborg = data.m_pairs[i].m_neighborg;
+			const ndVector laneCount(ndFloat32(data.m_pairCount[i]));
+
+			ndVector density4(ndVector::m_zero);
+			for (ndInt32 j = 0; j < count; j += 4)
 			{
-				const ndFloat32 d = distance.m_dist[j];
-				const ndFloat32 dist2 = h2 - d * d;
-				dAssert(dist2 > ndFloat32(0.0f));
-				const ndFloat32 dist6 = dist2 * dist2 * dist2;
-				density += kernelConst * dist6;
+				ndVector x;
+				ndVector y;
+				ndVector z;
+				ndVector w;
+				ndVector::Transpose4x4(x, y, z, w,
+					posit[neighborg[j + 0]] - p0, posit[neighborg[j + 1]] - p0,
+					posit[neighborg[j + 2]] - p0, posit[neighborg[j + 3]] - p0);
+
+				const ndVector dist2(x * x + y * y + z * z);
+				const ndVector mask((dist2 < kernelRadius2) & ((lanes + ndVector(ndFloat32(j))) < laneCount));
+				const ndVector kernelDist2(kernelRadius2 - dist2);
+				density4 += mask & (kernelDist2 * kernelDist2 * kernelDist2);
 			}
+			const ndFloat32 density = selfDensity + kernelConst * density4.AddHorizontal().GetScalar();
 			dAssert(density > ndFloat32(0.0f));
 			data.m_density[i] = density;
 			data.m_invDensity[i] = ndFloat32(1.0f) / density;
 		}
 	});
 
-	threadPool->ParallelExecute(CalculateDensity);
+	threadPool->ParallelExecuteRange(m_posit.GetCount(), CalculateDensity);
 }
 
 void ndBodySphFluid::CalculateAccelerations(ndThreadPool* const threadPool)
@@ -644,67 +703,83 @@ void ndBodySphFluid::CalculateAccelerations(ndThreadPool* const threadPool)
 	ndWorkingData& data = WorkingData();
 	data.m_accel.SetCount(m_posit.GetCount());
 
-	auto CalculateAcceleration = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CalculateAcceleration = ndMakeObject::ndFunction([this, &data](ndInt32, ndInt32 start, ndInt32 end)
 	{
 		D_TRACKTIME();
 		const ndVector epsilon2 (ndFloat32(1.0e-12f));
 
-		const ndArray<ndVector>& veloc = m_veloc;
-		const ndArray<ndVector>& posit = m_posit;
+		const ndVector* const veloc = &m_veloc[0];
+		const ndVector* const posit = &m_posit[0];
 		const ndFloat32* const density = &data.m_density[0];
 		const ndFloat32* const invDensity = &data.m_invDensity[0];
 
 		const ndFloat32 h = GetSphGridSize();
-		const ndFloat32 u = m_viscosity;
+		const ndVector kernelRadius(h);
+		const ndVector kernelRadius2(h * h);
 		const ndVector kernelConst(m_mass * ndFloat32(45.0f) / (ndPi * ndPow(h, 6)));
 
-		const ndFloat32 viscosity = m_viscosity;
-		const ndFloat32 restDensity = m_restDensity;
-		const ndFloat32 gasConstant = ndFloat32(0.5f) * m_gasConstant;
+		const ndVector viscosity(m_viscosity);
+		const ndVector restDensity(m_restDensity);
+		const ndVector gasConstant(ndFloat32(0.5f) * m_gasConstant);
+		const ndVector lanes(ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(2.0f), ndFloat32(3.0f));
 
 		const ndVector gravity(m_gravity);
-		const ndStartEnd startEnd(posit.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i0 = startEnd.m_start; i0 < startEnd.m_end; ++i0)
+		for (ndInt32 i0 = start; i0 < end; ++i0)
 		{
 			const ndVector p0(posit[i0]);
 			const ndVector v0(veloc[i0]);
 
 			const ndInt32 count = data.m_pairCount[i0];
-			const ndParticlePair& pairs = data.m_pairs[i0];
-			ndParticleKernelDistance& distance = data.m_kernelDistance[i0];
-			const ndFloat32 pressureI0 = density[i0] - restDensity;
-
-			ndVector forceAcc(ndVector::m_zero);
-			for (ndInt32 j = 0; j < count; ++j)
+			const ndInt32* const neighborg = data.m_pairs[i0].m_neighborg;
+			const ndVector pressureI0(density[i0] - m_restDensity);
+			const ndVector laneCount(ndFloat32(data.m_pairCount[i0]));
+
+			ndVector forceAcc_x(ndVector::m_zero);
+			ndVector forceAcc_y(ndVector::m_zero);
+			ndVector forceAcc_z(ndVector::m_zero);
+			for (ndInt32 j = 0; j < count; j += 4)
 			{
-				const ndInt32 i1 = pairs.m_neighborg[j];
-				const ndVector p10(posit[i1] - p0);
-				const ndVector dot(p10.DotProduct(p10) + epsilon2);
-				const ndVector unitDir(p10 * dot.InvSqrt());
+				const ndInt32 i1_0 = neighborg[j + 0];
+				const ndInt32 i1_1 = neighborg[j + 1];
+				const ndInt32 i1_2 = neighborg[j + 2];
+				const ndInt32 i1_3 = neighborg[j + 3];
 
-				dAssert(unitDir.m_w == ndFloat32(0.0f));
+				ndVector x;
+				ndVector y;
+				ndVector z;
+				ndVector w;
+				ndVector::Transpose4x4(x, y, z, w, posit[i1_0] - p0, posit[i1_1] - p0, posit[i1_2] - p0, posit[i1_3] - p0);
+
+				const ndVector dist2(x * x + y * y + z * z);
+				const ndVector mask((dist2 < kernelRadius2) & ((lanes + ndVector(ndFloat32(j))) < laneCount));
+				const ndVector invDist((dist2 + epsilon2).InvSqrt());
 
 				// kernel distance
-				const ndFloat32 dist = distance.m_dist[j];
-				const ndFloat32 kernelDist = h - dist;
-				dAssert(kernelDist >= ndFloat32(0.0f));
+				const ndVector kernelDist(kernelRadius - dist2 * invDist);
+				const ndVector density1(density[i1_0], density[i1_1], density[i1_2], density[i1_3]);
+				const ndVector invDensity1(invDensity[i1_0], invDensity[i1_1], invDensity[i1_2], invDensity[i1_3]);
 
 				// calculate pressure
-				const ndFloat32 kernelDist2 = kernelDist * kernelDist;
-				const ndFloat32 pressureI1 = density[i1] - restDensity;
-				const ndVector force(gasConstant * kernelDist2 * invDensity[i1] * (pressureI0 + pressureI1));
-				forceAcc += force * unitDir;
+				const ndVector pressure(gasConstant * kernelDist * kernelDist * invDensity1 * (pressureI0 + density1 - restDensity));
+				const ndVector pressureDir(mask & (pressure * invDist));
+				forceAcc_x += pressureDir * x;
+				forceAcc_y += pressureDir * y;
+				forceAcc_z += pressureDir * z;
 
 				// calculate viscosity acceleration
-				const ndVector v01(veloc[i1] - v0);
-				forceAcc += v01 * ndVector(kernelDist * viscosity * invDensity[j]);
+				ndVector::Transpose4x4(x, y, z, w, veloc[i1_0] - v0, veloc[i1_1] - v0, veloc[i1_2] - v0, veloc[i1_3] - v0);
+				const ndVector viscosityFactor(mask & (kernelDist * viscosity * invDensity1));
+				forceAcc_x += viscosityFactor * x;
+				forceAcc_y += viscosityFactor * y;
+				forceAcc_z += viscosityFactor * z;
 			}
+			const ndVector forceAcc(forceAcc_x.AddHorizontal().GetScalar(), forceAcc_y.AddHorizontal().GetScalar(), forceAcc_z.AddHorizontal().GetScalar(), ndFloat32(0.0f));
 			const ndVector accel(gravity + ndVector(invDensity[i0]) * kernelConst * forceAcc);
 			data.m_accel[i0] = accel;
 		}
 	});
 
-	threadPool->ParallelExecute(CalculateAcceleration);
+	threadPool->ParallelExecuteRange(m_posit.GetCount(), CalculateAcceleration);
 }
 
 void ndBodySphFluid::IntegrateParticles(ndThreadPool* const threadPool)
@@ -753,7 +828,10 @@ void ndBodySphFluid::CaculateAabb(ndThreadPool* const threadPool)
 		ndVector m_max;
 	};
 
-	ndBox boxes[D_MAX_THREADS_COUNT];
+	// the min and max of each thread
+	ndWorkingData& data = WorkingData();
+	ndArray<ndVector>& boxes = data.m_threadBoxes;
+	boxes.SetCount(threadPool->GetThreadCount() * 2);
 	auto CalculateAabb = ndMakeObject::ndFunction([this, &boxes](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
@@ -765,7 +843,8 @@ void ndBodySphFluid::CaculateAabb(ndThreadPool* const threadPool)
 			box.m_min = box.m_min.GetMin(posit[i]);
 			box.m_max = box.m_max.GetMax(posit[i]);
 		}
-		boxes[threadIndex] = box;
+		boxes[threadIndex * 2 + 0] = box.m_min;
+		boxes[threadIndex * 2 + 1] = box.m_max;
 	});
 
 	threadPool->ParallelExecute(CalculateAabb);
@@ -774,11 +853,11 @@ void ndBodySphFluid::CaculateAabb(ndThreadPool* const threadPool)
 	const ndInt32 threadCount = threadPool->GetThreadCount();
 	for (ndInt32 i = 0; i < threadCount; ++i)
 	{
-		box.m_min = box.m_min.GetMin(boxes[i].m_min);
-		box.m_max = box.m_max.GetMax(boxes[i].m_max);
+		box.m_min = box.m_min.GetMin(boxes[i * 2 + 0]);
+		box.m_max = box.m_max.GetMax(boxes[i * 2 + 1]);
 	}
 
-	const ndFloat32 gridSize = GetSphGridSize();
+	const ndFloat32 gridSize = GetSearchGridSize();
 
 	ndVector grid(gridSize);
 	ndVector invGrid(ndFloat32(1.0f) / gridSize);
@@ -795,11 +874,228 @@ void ndBodySphFluid::CaculateAabb(ndThreadPool* const threadPool)
 	m_box0 = box.m_min & ndVector::m_triplexMask;
 	m_box1 = box.m_max & ndVector::m_triplexMask;
 
-	ndWorkingData& data = WorkingData();
 	ndInt32 numberOfGrid = ndInt32((box.m_max.m_x - box.m_min.m_x) * invGrid.m_x + ndFloat32(1.0f));
 	data.SetWorldToGridMapping(numberOfGrid, m_box1.m_x, m_box0.m_x);
 }
 
+bool ndBodySphFluid::ValidateNeighborList(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	class ndBox
+	{
+		public:
+		ndBox()
+			:m_min(ndFloat32(1.0e10f))
+			,m_max(ndFloat32(-1.0e10f))
+		{
+		}
+		ndVector m_min;
+		ndVector m_max;
+	};
+
+	ndWorkingData& data = WorkingData();
+	if ((m_neighborSkin == ndFloat32(0.0f)) || (data.m_buildPosit.GetCount() != m_posit.GetCount()))
+	{
+		return false;
+	}
+
+	ndArray<ndVector>& boxes = data.m_threadBoxes;
+	boxes.SetCount(threadPool->GetThreadCount() * 2);
+	auto CalculateDisplacement = ndMakeObject::ndFunction([this, &data, &boxes](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		ndBox box;
+		const ndVector* const posit = &m_posit[0];
+		const ndVector* const buildPosit = &data.m_buildPosit[0];
+		const ndStartEnd startEnd(m_posit.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndVector step(posit[i] - buildPosit[i]);
+			box.m_min = box.m_min.GetMin(step);
+			box.m_max = box.m_max.GetMax(step);
+		}
+		boxes[threadIndex * 2 + 0] = box.m_min;
+		boxes[threadIndex * 2 + 1] = box.m_max;
+	});
+	threadPool->ParallelExecute(CalculateDisplacement);
+
+	ndBox box;
+	const ndInt32 threadCount = threadPool->GetThreadCount();
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		box.m_min = box.m_min.GetMin(boxes[i * 2 + 0]);
+		box.m_max = box.m_max.GetMax(boxes[i * 2 + 1]);
+	}
+
+	// the displacements of any two particles differ by no more than the diagonal of 
+	// the displacement box, so the list is valid while the diagonal is smaller than 
+	// the skin, and moving the whole fluid does not invalidate it.
+	data.m_stepsSinceBuild++;
+	const ndVector diagonal((box.m_max - box.m_min) & ndVector::m_triplexMask);
+	const ndFloat32 displacement = ndSqrt(diagonal.DotProduct(diagonal).GetScalar());
+	const ndFloat32 skin = GetSearchGridSize() - GetSphGridSize();
+	if (displacement < skin)
+	{
+		return true;
+	}
+
+	// when the fluid moves so fast that a list would not last two steps 
+	// the larger search radius is not worth it, so the skin is dropped.
+	const ndFloat32 stepDisplacement = displacement / ndFloat32(data.m_stepsSinceBuild);
+	m_searchSkin = (ndFloat32(2.0f) * stepDisplacement < GetSphGridSize() * m_neighborSkin) ? m_neighborSkin : ndFloat32(0.0f);
+	return false;
+}
+
+void ndBodySphFluid::SortParticles(ndThreadPool* const threadPool)
+{
+	D_TRACKTIME();
+	class ndKey_morton0
+	{
+		public:
+		ndKey_morton0(void* const) {}
+		ndInt32 GetKey(const ndParticleKey& key) const
+		{
+			return key.m_key & 0xff;
+		}
+	};
+
+	class ndKey_morton1
+	{
+		public:
+		ndKey_morton1(void* const) {}
+		ndInt32 GetKey(const ndParticleKey& key) const
+		{
+			return (key.m_key >> 8) & 0xff;
+		}
+	};
+
+	class ndKey_morton2
+	{
+		public:
+		ndKey_morton2(void* const) {}
+		ndInt32 GetKey(const ndParticleKey& key) const
+		{
+			return (key.m_key >> 16) & 0xff;
+		}
+	};
+
+	class ndKey_morton3
+	{
+		public:
+		ndKey_morton3(void* const) {}
+		ndInt32 GetKey(const ndParticleKey& key) const
+		{
+			return (key.m_key >> 24) & 0xff;
+		}
+	};
+
+	// the particles drift out of order slowly, so they are only sorted every few builds
+	ndWorkingData& data = WorkingData();
+	if (data.m_buildsSinceSort < D_SPH_SORT_INTERVAL)
+	{
+		data.m_buildsSinceSort++;
+		return;
+	}
+	data.m_buildsSinceSort = 0;
+	const ndInt32 particleCount = m_posit.GetCount();
+	
+	auto CalculateKeys = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		auto SpreadBits = [](ndUnsigned32 x)
+		{
+			x = x & ((1 << D_SPH_MORTON_BITS) - 1);
+			x = (x | (x << 16)) & 0x030000ff;
+			x = (x | (x << 8)) & 0x0300f00f;
+			x = (x | (x << 4)) & 0x030c30c3;
+			x = (x | (x << 2)) & 0x09249249;
+			return x;
+		};
+
+		const ndVector origin(m_box0);
+		const ndVector invGridSize(ndFloat32(1.0f) / GetSearchGridSize());
+		const ndVector* const posit = &m_posit[0];
+		ndParticleKey* const keys = &data.m_particleKeys[0];
+
+		const ndStartEnd startEnd(m_posit.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndVector cell(((posit[i] - origin) * invGridSize).GetInt());
+			keys[i].m_key = SpreadBits(ndUnsigned32(cell.m_ix)) | (SpreadBits(ndUnsigned32(cell.m_iy)) << 1) | (SpreadBits(ndUnsigned32(cell.m_iz)) << 2);
+			keys[i].m_particleIndex = i;
+		}
+	});
+
+	auto ReorderParticles = ndMakeObject::ndFunction([this, &data](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		const ndParticleKey* const keys = &data.m_particleKeys[0];
+		const ndVector* const posit = &m_posit[0];
+		const ndVector* const veloc = &m_veloc[0];
+		const ndInt32* const particleMap = &m_particleMap[0];
+		ndVector* const sortedPosit = &data.m_buildPosit[0];
+		ndVector* const sortedVeloc = &data.m_accel[0];
+		ndInt32* const sortedParticleMap = &data.m_particleMapScratchBuffer[0];
+
+		const ndStartEnd startEnd(m_posit.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			const ndInt32 index = keys[i].m_particleIndex;
+			sortedPosit[i] = posit[index];
+			sortedVeloc[i] = veloc[index];
+			sortedParticleMap[i] = particleMap[index];
+		}
+	});
+
+	dAssert(m_veloc.GetCount() == particleCount);
+	if (m_particleMap.GetCount() > particleCount)
+	{
+		// particles were removed, so the indices the application had are gone.
+		m_particleMap.SetCount(0);
+	}
+	for (ndInt32 i = m_particleMap.GetCount(); i < particleCount; ++i)
+	{
+		m_particleMap.PushBack(i);
+	}
+
+	data.m_particleKeys.SetCount(particleCount);
+	threadPool->ParallelExecute(CalculateKeys);
+
+	// only sort the digits the grid can produce
+	const ndVector boxSize((m_box1 - m_box0).Scale(ndFloat32(1.0f) / GetSearchGridSize()).GetInt());
+	const ndInt32 maxSize = dMax(dMax(ndInt32(boxSize.m_ix), ndInt32(boxSize.m_iy)), ndInt32(boxSize.m_iz));
+	ndInt32 axisBits = 1;
+	while ((axisBits < D_SPH_MORTON_BITS) && ((1 << axisBits) <= maxSize))
+	{
+		axisBits++;
+	}
+	const ndInt32 keyBits = axisBits * 3;
+
+	ndCountingSort<ndParticleKey, ndKey_morton0, 8>(*threadPool, data.m_particleKeys, data.m_particleKeysScratchBuffer);
+	if (keyBits > 8)
+	{
+		ndCountingSort<ndParticleKey, ndKey_morton1, 8>(*threadPool, data.m_particleKeys, data.m_particleKeysScratchBuffer);
+	}
+	if (keyBits > 16)
+	{
+		ndCountingSort<ndParticleKey, ndKey_morton2, 8>(*threadPool, data.m_particleKeys, data.m_particleKeysScratchBuffer);
+	}
+	if (keyBits > 24)
+	{
+		ndCountingSort<ndParticleKey, ndKey_morton3, 8>(*threadPool, data.m_particleKeys, data.m_particleKeysScratchBuffer);
+	}
+
+	// the sorted copies become the particle arrays, the 
+	// old ones are scratch memory until the next rebuild.
+	data.m_accel.SetCount(particleCount);
+	data.m_buildPosit.SetCount(particleCount);
+	data.m_particleMapScratchBuffer.SetCount(particleCount);
+	threadPool->ParallelExecute(ReorderParticles);
+	m_posit.Swap(data.m_buildPosit);
+	m_veloc.Swap(data.m_accel);
+	m_particleMap.Swap(data.m_particleMapScratchBuffer);
+}
+
 void ndBodySphFluid::CreateGrids(ndThreadPool* const threadPool)
 {
 	D_TRACKTIME();
@@ -869,7 +1165,7 @@ void ndBodySphFluid::CreateGrids(ndThreadPool* const threadPool)
 	{
 		D_TRACKTIME();
 		const ndVector origin(m_box0);
-		const ndFloat32 gridSize = GetSphGridSize();
+		const ndFloat32 gridSize = GetSearchGridSize();
 		const ndVector box(gridSize * ndFloat32(0.5f * 0.99f));
 		const ndVector invGridSize(ndFloat32(1.0f) / gridSize);
 		const ndVector* const posit = &m_posit[0];
@@ -899,7 +1195,7 @@ void ndBodySphFluid::CreateGrids(ndThreadPool* const threadPool)
 	{
 		D_TRACKTIME();
 		const ndVector origin(m_box0);
-		const ndFloat32 gridSize = GetSphGridSize();
+		const ndFloat32 gridSize = GetSearchGridSize();
 		ndGridHash* const dst = &data.m_hashGridMap[0];
 		const ndInt32* const scans = &data.m_gridScans[0];
 		
@@ -913,8 +1209,6 @@ void ndBodySphFluid::CreateGrids(ndThreadPool* const threadPool)
 		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 		{
 			const ndVector r(posit[i] - origin);
-			const ndVector p(r * invGridSize);
-			const ndGridHash hashKey(p, i);
 
 			const ndVector p0((r - box) * invGridSize);
 			const ndVector p1((r + box) * invGridSize);
@@ -933,8 +1227,8 @@ void ndBodySphFluid::CreateGrids(ndThreadPool* const threadPool)
 			{
 				ndGridHash quadrand(box0Hash);
 				quadrand.m_gridHash += neigborgh[j].m_gridHash;
-				quadrand.m_cellType = ndGridType(quadrand.m_gridHash == hashKey.m_gridHash);
-				dAssert(quadrand.m_cellType == ((quadrand.m_gridHash == hashKey.m_gridHash) ? ndHomeGrid : ndAdjacentGrid));
+				quadrand.m_lowY = (neigborgh[j].m_y == 0);
+				quadrand.m_lowZ = (neigborgh[j].m_z == 0);
 				dst[base + j] = quadrand;
 			}
 		}
@@ -962,12 +1256,32 @@ void ndBodySphFluid::Execute(ndThreadPool* const threadPool)
 {
 	D_TRACKTIME();
 	dAssert(sizeof(ndGridHash) == sizeof(ndUnsigned64));
+	ndWorkingData& data = WorkingData();
 
-	CaculateAabb(threadPool);
-	CreateGrids(threadPool);
-	SortGrids(threadPool);
-	CalculateScans(threadPool);
-	BuildPairs(threadPool);
+	// the neighbors are found within the kernel radius plus a skin, so the list is 
+	// reused until the particles move relative to each other more than the skin.
+	// every few rebuilds the particles are sorted in morton order of their grid cell, 
+	// so neighbors are close in memory, GetParticleMap tracks the index changes.
+	if (!ValidateNeighborList(threadPool))
+	{
+		CaculateAabb(threadPool);
+		SortParticles(threadPool);
+		CreateGrids(threadPool);
+		SortGrids(threadPool);
+		CalculateScans(threadPool);
+		BuildPairs(threadPool);
+
+		// a full list may have dropped particles inside the kernel radius in favor
+		// of particles that are only inside the skin, so it is built again without it.
+		if (data.m_saturated && (m_searchSkin > ndFloat32(0.0f)))
+		{
+			m_searchSkin = ndFloat32(0.0f);
+			CreateGrids(threadPool);
+			SortGrids(threadPool);
+			CalculateScans(threadPool);
+			BuildPairs(threadPool);
+		}
+	}
 	CalculateParticlesDensity(threadPool);
 	CalculateAccelerations(threadPool);
 	IntegrateParticles(threadPool);
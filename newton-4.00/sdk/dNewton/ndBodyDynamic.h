@@ -89,9 +89,12 @@ class ndBodyDynamic: public ndBodyKinematic
 
 	friend class ndDynamicsUpdate;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateCuda;
 	friend class ndDynamicsUpdateOpencl;
+	friend class ndLoadSave;
+	friend class ndWorldCheckpoint;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 inline ndVector ndBodyDynamic::GetForce() const
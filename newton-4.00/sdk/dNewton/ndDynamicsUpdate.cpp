@@ -40,6 +40,12 @@ ndDynamicsUpdate::ndDynamicsUpdate(ndWorld* const world)
 	,m_tempInternalForces(D_DEFAULT_BUFFER_SIZE)
 	,m_bodyIslandOrder(D_DEFAULT_BUFFER_SIZE)
 	,m_jointBodyPairIndexBuffer(D_DEFAULT_BUFFER_SIZE)
+	,m_islandJoints(D_DEFAULT_BUFFER_SIZE)
+	,m_activeIslands(D_DEFAULT_BUFFER_SIZE)
+	,m_activeJoints(D_DEFAULT_BUFFER_SIZE)
+	,m_bodyIslandParent(D_DEFAULT_BUFFER_SIZE)
+	,m_jointResidual(D_DEFAULT_BUFFER_SIZE)
+	,m_islandResidual(D_DEFAULT_BUFFER_SIZE)
 	,m_world(world)
 	,m_timestep(ndFloat32(0.0f))
 	,m_invTimestep(ndFloat32(0.0f))
@@ -73,6 +79,12 @@ void ndDynamicsUpdate::Clear()
 	m_tempInternalForces.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_jointForcesIndex.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_jointBodyPairIndexBuffer.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_islandJoints.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_activeIslands.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_activeJoints.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_bodyIslandParent.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_jointResidual.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_islandResidual.Resize(D_DEFAULT_BUFFER_SIZE);
 }
 
 void ndDynamicsUpdate::SortBodyJointScan()
@@ -135,8 +147,8 @@ void ndDynamicsUpdate::SortBodyJointScan()
 	});
 	scene->ParallelExecute(CountJointBodyPairs);
 
-	scene->GetScratchBuffer().SetCount(bodyJointPairs.GetCount() * sizeof (ndJointBodyPairIndex));
-	ndJointBodyPairIndex* const tempBuffer = (ndJointBodyPairIndex*)&scene->GetScratchBuffer()[0];
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndJointBodyPairIndex* const tempBuffer = scene->GetFrameArena().Alloc<ndJointBodyPairIndex>(bodyJointPairs.GetCount());
 
 	ndCountingSort<ndJointBodyPairIndex, ndEvaluateKey0, D_MAX_BODY_RADIX_BIT>(*scene, &bodyJointPairs[0], tempBuffer, bodyJointPairs.GetCount());
 	ndCountingSort<ndJointBodyPairIndex, ndEvaluateKey1, D_MAX_BODY_RADIX_BIT>(*scene, tempBuffer, &bodyJointPairs[0], bodyJointPairs.GetCount());
@@ -255,9 +267,12 @@ void ndDynamicsUpdate::SortJointsScan()
 
 	m_leftHandSide.SetCount(jointArray.GetCount() + 32);
 
-	ndInt32 histogram[D_MAX_THREADS_COUNT][2];
-	ndInt32 movingJoints[D_MAX_THREADS_COUNT];
 	const ndInt32 threadCount = scene->GetThreadCount();
+
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const histogram = scene->GetFrameArena().Alloc<ndInt32>(threadCount * 2);
+	ndInt32* const movingJoints = scene->GetFrameArena().Alloc<ndInt32>(threadCount);
+	ndConstraint** const tempJointBuffer = scene->GetFrameArena().Alloc<ndConstraint*>(jointArray.GetCount() + 32);
 	
 	auto MarkFence0 = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
 	{
@@ -289,7 +304,7 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 
-	auto MarkFence1 = ndMakeObject::ndFunction([this, &jointArray, &movingJoints](ndInt32 threadIndex, ndInt32 threadCount)
+	auto MarkFence1 = ndMakeObject::ndFunction([this, &jointArray, movingJoints](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
 		ndInt32 activeJointCount = 0;
@@ -315,13 +330,11 @@ void ndDynamicsUpdate::SortJointsScan()
 		movingJoints[threadIndex] = activeJointCount;
 	});
 
-	auto Scan0 = ndMakeObject::ndFunction([this, &jointArray, &histogram, scene](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Scan0 = ndMakeObject::ndFunction([this, &jointArray, histogram, tempJointBuffer](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
-		//ndScene* const scene = m_world->GetScene();
-		dAssert(scene->GetScratchBuffer().GetCount() >= jointArray.GetCount() * sizeof(ndConstraint*));
-		ndConstraint** const dstBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
+		ndInt32* const hist = &histogram[threadIndex * 2];
+		ndConstraint** const dstBuffer = tempJointBuffer;
 
 		hist[0] = 0;
 		hist[1] = 0;
@@ -338,12 +351,11 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 
-	auto Sort0 = ndMakeObject::ndFunction([this, &jointArray, &histogram, scene](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Sort0 = ndMakeObject::ndFunction([this, &jointArray, histogram, tempJointBuffer](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
-		dAssert(scene->GetScratchBuffer().GetCount() >= jointArray.GetCount() * sizeof (ndConstraint*));
-		ndConstraint** const dstBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
+		ndInt32* const hist = &histogram[threadIndex * 2];
+		ndConstraint** const dstBuffer = tempJointBuffer;
 
 		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
 		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
@@ -358,9 +370,6 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 
-	scene->GetScratchBuffer().SetCount((jointArray.GetCount() + 32) * sizeof (ndConstraint*));
-	ndConstraint** const tempJointBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
-
 	scene->ParallelExecute(MarkFence0);
 	scene->ParallelExecute(MarkFence1);
 	scene->ParallelExecute(Scan0);
@@ -371,8 +380,8 @@ void ndDynamicsUpdate::SortJointsScan()
 	ndInt32 movingJointCount = 0;
 	for (ndInt32 i = 0; i < threadCount; ++i)
 	{
-		scan[0] += histogram[i][0];
-		scan[1] += histogram[i][1];
+		scan[0] += histogram[i * 2];
+		scan[1] += histogram[i * 2 + 1];
 		movingJointCount += movingJoints[i];
 	}
 
@@ -389,8 +398,8 @@ void ndDynamicsUpdate::SortJointsScan()
 	{
 		for (ndInt32 j = 0; j < threadCount; ++j)
 		{
-			ndInt32 partialSum = histogram[j][i];
-			histogram[j][i] = sum;
+			ndInt32 partialSum = histogram[j * 2 + i];
+			histogram[j * 2 + i] = sum;
 			sum += partialSum;
 		}
 	}
@@ -485,11 +494,13 @@ void ndDynamicsUpdate::SortIslands()
 	GetInternalForces().SetCount(bodyArray.GetCount());
 	activeBodyArray.SetCount(bodyArray.GetCount());
 
-	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
-	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const histogram = scene->GetFrameArena().Alloc<ndInt32>(threadCount * 3);
+	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, histogram](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
+		ndInt32* const hist = &histogram[threadIndex * 3];
 		hist[0] = 0;
 		hist[1] = 0;
 		hist[2] = 0;
@@ -509,10 +520,10 @@ void ndDynamicsUpdate::SortIslands()
 		}
 	});
 
-	auto Sort0 = ndMakeObject::ndFunction([this, &bodyArray, &activeBodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Sort0 = ndMakeObject::ndFunction([this, &bodyArray, &activeBodyArray, histogram](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
+		ndInt32* const hist = &histogram[threadIndex * 3];
 		const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, threadCount);
 
 		ndInt32 map[4];
@@ -537,15 +548,14 @@ void ndDynamicsUpdate::SortIslands()
 	scan[0] = 0;
 	scan[1] = 0;
 	scan[2] = 0;
-	const ndInt32 threadCount = scene->GetThreadCount();
 
 	ndInt32 sum = 0;
 	for (ndInt32 i = 0; i < 3; ++i)
 	{
 		for (ndInt32 j = 0; j < threadCount; ++j)
 		{
-			ndInt32 partialSum = histogram[j][i];
-			histogram[j][i] = sum;
+			ndInt32 partialSum = histogram[j * 3 + i];
+			histogram[j * 3 + i] = sum;
 			sum += partialSum;
 		}
 		scan[i] = sum;
@@ -613,9 +623,11 @@ void ndDynamicsUpdate::InitWeights()
 	const ndInt32 bodyCount = bodyArray.GetCount();
 	GetInternalForces().SetCount(bodyCount);
 
-	ndInt32 extraPassesArray[D_MAX_THREADS_COUNT];
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const extraPassesArray = scene->GetFrameArena().Alloc<ndInt32>(threadCount);
 
-	auto InitWeights = ndMakeObject::ndFunction([this, &bodyArray, &extraPassesArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitWeights = ndMakeObject::ndFunction([this, &bodyArray, extraPassesArray](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
 		const ndArray<ndInt32>& jointForceIndexBuffer = GetJointForceIndexBuffer();
@@ -648,7 +660,6 @@ void ndDynamicsUpdate::InitWeights()
 		scene->ParallelExecute(InitWeights);
 
 		ndInt32 extraPasses = 0;
-		const ndInt32 threadCount = scene->GetThreadCount();
 		for (ndInt32 i = 0; i < threadCount; ++i)
 		{
 			extraPasses = dMax(extraPasses, extraPassesArray[i]);
@@ -797,9 +808,8 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 	ndBodyKinematic** const bodyArray = &scene->GetActiveBodyArray()[0];
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJacobian* const internalForces = &GetTempInternalForces()[0];
 		auto BuildJacobianMatrix = [this, &internalForces](ndConstraint* const joint, ndInt32 jointIndex)
 		{
@@ -924,8 +934,7 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 			outBody1.m_angular = torqueAcc1;
 		};
 
-		const ndInt32 jointCount = jointArray.GetCount();
-		for (ndInt32 i = threadIndex; i < jointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			GetJacobianDerivatives(joint);
@@ -974,7 +983,7 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 		D_TRACKTIME();
 		m_rightHandSide[0].m_force = ndFloat32(1.0f);
 
-		scene->ParallelExecute(InitJacobianMatrix);
+		scene->ParallelExecuteRange(jointArray.GetCount(), InitJacobianMatrix);
 		scene->ParallelExecute(InitJacobianAccumulatePartialForces);
 	}
 }
@@ -985,9 +994,8 @@ void ndDynamicsUpdate::CalculateJointsAcceleration()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto CalculateJointsAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CalculateJointsAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJointAccelerationDecriptor joindDesc;
 		joindDesc.m_timestep = m_timestepRK;
 		joindDesc.m_invTimestep = m_invTimestepRK;
@@ -995,8 +1003,7 @@ void ndDynamicsUpdate::CalculateJointsAcceleration()
 		ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 
-		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			const ndInt32 pairStart = joint->m_rowStart;
@@ -1007,7 +1014,7 @@ void ndDynamicsUpdate::CalculateJointsAcceleration()
 		}
 	});
 
-	scene->ParallelExecute(CalculateJointsAcceleration);
+	scene->ParallelExecuteRange(jointArray.GetCount(), CalculateJointsAcceleration);
 	m_firstPassCoef = ndFloat32(1.0f);
 }
 
@@ -1065,16 +1072,14 @@ void ndDynamicsUpdate::UpdateForceFeedback()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto UpdateForceFeedback = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateForceFeedback = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 		const ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 
 		const ndVector zero(ndVector::m_zero);
 		const ndFloat32 timestepRK = GetTimestepRK();
-		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			const ndInt32 rows = joint->m_rowCount;
@@ -1115,7 +1120,7 @@ void ndDynamicsUpdate::UpdateForceFeedback()
 		}
 	});
 
-	scene->ParallelExecute(UpdateForceFeedback);
+	scene->ParallelExecuteRange(jointArray.GetCount(), UpdateForceFeedback);
 }
 
 void ndDynamicsUpdate::IntegrateBodies()
@@ -1209,13 +1214,12 @@ void ndDynamicsUpdate::InitSkeletons()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndSkeletonContainer*>& activeSkeletons = m_world->m_activeSkeletons;
 
-	auto InitSkeletons = ndMakeObject::ndFunction([this, &activeSkeletons](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitSkeletons = ndMakeObject::ndFunction([this, &activeSkeletons](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 		const ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 
-		for (ndInt32 i = threadIndex; i < activeSkeletons.GetCount(); i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndSkeletonContainer* const skeleton = activeSkeletons[i];
 			skeleton->InitMassMatrix(&leftHandSide[0], &rightHandSide[0]);
@@ -1224,7 +1228,7 @@ void ndDynamicsUpdate::InitSkeletons()
 
 	if (activeSkeletons.GetCount())
 	{
-		scene->ParallelExecute(InitSkeletons);
+		scene->ParallelExecuteRange(activeSkeletons.GetCount(), InitSkeletons);
 	}
 }
 
@@ -1235,11 +1239,10 @@ void ndDynamicsUpdate::UpdateSkeletons()
 	const ndArray<ndSkeletonContainer*>& activeSkeletons = m_world->m_activeSkeletons;
 	const ndBodyKinematic** const bodyArray = (const ndBodyKinematic**)(&scene->GetActiveBodyArray()[0]);
 
-	auto UpdateSkeletons = ndMakeObject::ndFunction([this, &bodyArray, &activeSkeletons](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateSkeletons = ndMakeObject::ndFunction([this, &bodyArray, &activeSkeletons](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJacobian* const internalForces = &GetInternalForces()[0];
-		for (ndInt32 i = threadIndex; i < activeSkeletons.GetCount(); i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndSkeletonContainer* const skeleton = activeSkeletons[i];
 			skeleton->CalculateReactionForces(internalForces);
@@ -1248,7 +1251,7 @@ void ndDynamicsUpdate::UpdateSkeletons()
 
 	if (activeSkeletons.GetCount())
 	{
-		scene->ParallelExecute(UpdateSkeletons);
+		scene->ParallelExecuteRange(activeSkeletons.GetCount(), UpdateSkeletons);
 	}
 }
 
@@ -1261,18 +1264,22 @@ void ndDynamicsUpdate::CalculateJointsForce()
 	ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	// the residual of each pass is the squared acceleration error of the 
+	// unclamped rows of a joint, before the pass updates its forces.
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndFloat32* const threadResidual = scene->GetFrameArena().Alloc<ndFloat32>(threadCount);
+	const ndInt32* activeJoints = nullptr;
+	m_jointResidual.SetCount(jointArray.GetCount());
+
+	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &jointArray, &activeJoints, threadResidual](ndInt32 threadIndex, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
-		const ndInt32 jointCount = jointArray.GetCount();
 		ndJacobian* const jointPartialForces = &GetTempInternalForces()[0];
 
 		auto JointForce = [this, &jointPartialForces](ndConstraint* const joint, ndInt32 jointIndex)
 		{
-			#ifdef D_USE_EARLY_OUT_JOINT
 			const ndVector zero(ndVector::m_zero);
 			ndVector accNorm(zero);
-			#endif
 			ndBodyKinematic* const body0 = joint->GetBody0();
 			ndBodyKinematic* const body1 = joint->GetBody1();
 			dAssert(body0);
@@ -1327,10 +1334,8 @@ void ndDynamicsUpdate::CalculateJointsForce()
 					const ndVector lowerFrictionForce(frictionNormal * rhs->m_lowerBoundFrictionCoefficent);
 					const ndVector upperFrictionForce(frictionNormal * rhs->m_upperBoundFrictionCoefficent);
 
-					#ifdef D_USE_EARLY_OUT_JOINT
 					a = a & (f < upperFrictionForce) & (f > lowerFrictionForce);
 					accNorm = accNorm.MulAdd(a, a);
-					#endif
 
 					f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
 					rhs->m_force = f.GetScalar();
@@ -1424,13 +1429,20 @@ void ndDynamicsUpdate::CalculateJointsForce()
 			ndJacobian& outBody1 = jointPartialForces[index1];
 			outBody1.m_linear = forceM1;
 			outBody1.m_angular = torqueM1;
+			return accNorm.GetScalar();
 		};
 
-		for (ndInt32 i = threadIndex; i < jointCount; i += threadCount)
+		ndFloat32 maxResidual = ndFloat32(0.0f);
+		ndFloat32* const jointResidual = &m_jointResidual[0];
+		for (ndInt32 i = start; i < end; ++i)
 		{
-			ndConstraint* const joint = jointArray[i];
-			JointForce(joint, i);
+			const ndInt32 index = activeJoints ? activeJoints[i] : i;
+			ndConstraint* const joint = jointArray[index];
+			const ndFloat32 residual = JointForce(joint, index);
+			jointResidual[index] = residual;
+			maxResidual = dMax(maxResidual, residual);
 		}
+		threadResidual[threadIndex] = dMax(threadResidual[threadIndex], maxResidual);
 	});
 
 	auto ApplyJacobianAccumulatePartialForces = ndMakeObject::ndFunction([this, &bodyArray](ndInt32 threadIndex, ndInt32 threadCount)
@@ -1465,13 +1477,208 @@ void ndDynamicsUpdate::CalculateJointsForce()
 		}
 	});
 	
-	for (ndInt32 i = 0; i < passes; ++i)
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		threadResidual[i] = ndFloat32(0.0f);
+	}
+
+	ndWorld::ndSolverStats& stats = m_world->m_solverStats;
+	stats.m_jointCount = dMax(stats.m_jointCount, m_activeJointCount);
+	if (m_world->m_solverTolerance <= ndFloat32(0.0f))
+	{
+		for (ndInt32 i = 0; i < passes; ++i)
+		{
+			for (ndInt32 j = 0; j < threadCount; ++j)
+			{
+				threadResidual[j] = ndFloat32(0.0f);
+			}
+			scene->ParallelExecuteRange(jointArray.GetCount(), CalculateJointsForce);
+			scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
+		}
+
+		ndFloat32 maxResidual = ndFloat32(0.0f);
+		for (ndInt32 i = 0; i < threadCount; ++i)
+		{
+			maxResidual = dMax(maxResidual, threadResidual[i]);
+		}
+		stats.m_maxPasses = dMax(stats.m_maxPasses, passes);
+		stats.m_jointPasses += ndInt64(m_activeJointCount) * passes;
+		stats.m_maxResidual = dMax(stats.m_maxResidual, ndSqrt(maxResidual));
+	}
+	else
+	{
+		// the first pass solves all joints, after that only the joints 
+		// of the islands that are still above the tolerance.
+		m_activeIslands.SetCount(m_islands.GetCount());
+		for (ndInt32 i = 0; i < m_islands.GetCount(); ++i)
+		{
+			m_activeIslands[i] = i;
+		}
+		stats.m_islandCount = dMax(stats.m_islandCount, ndInt32(m_islands.GetCount()));
+		stats.m_islandSolves += m_islands.GetCount();
+
+		ndInt32 pass = 0;
+		ndInt32 jointCount = jointArray.GetCount();
+		for (; (pass < passes) && jointCount; ++pass)
+		{
+			stats.m_jointPasses += dMin(jointCount, m_activeJointCount);
+			stats.m_islandPasses += m_activeIslands.GetCount();
+			scene->ParallelExecuteRange(jointCount, CalculateJointsForce);
+			scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
+			if (UpdateActiveIslands(pass))
+			{
+				m_activeJoints.SetCount(0);
+				for (ndInt32 i = 0; i < m_activeIslands.GetCount(); ++i)
+				{
+					const ndIsland& island = m_islands[m_activeIslands[i]];
+					for (ndInt32 j = 0; j < island.m_count; ++j)
+					{
+						m_activeJoints.PushBack(m_islandJoints[island.m_start + j]);
+					}
+				}
+				activeJoints = m_activeJoints.GetCount() ? &m_activeJoints[0] : nullptr;
+				jointCount = m_activeJoints.GetCount();
+			}
+		}
+		stats.m_maxPasses = dMax(stats.m_maxPasses, pass);
+	}
+}
+
+void ndDynamicsUpdate::BuildSolverIslands()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	// union find of the moving joints, static bodies do not connect islands, 
+	// and the smaller index is always the root so that the islands are deterministic. 
+	m_bodyIslandParent.SetCount(bodyArray.GetCount());
+	ndInt32* const parent = &m_bodyIslandParent[0];
+	for (ndInt32 i = 0; i < bodyArray.GetCount(); ++i)
+	{
+		parent[i] = i;
+	}
+
+	auto FindRoot = [parent](ndInt32 node)
+	{
+		while (parent[node] != node)
+		{
+			parent[node] = parent[parent[node]];
+			node = parent[node];
+		}
+		return node;
+	};
+
+	for (ndInt32 i = 0; i < m_activeJointCount; ++i)
+	{
+		const ndConstraint* const joint = jointArray[i];
+		const ndBodyKinematic* const body0 = joint->GetBody0();
+		const ndBodyKinematic* const body1 = joint->GetBody1();
+		if (!(body0->m_isStatic | body1->m_isStatic))
+		{
+			const ndInt32 root0 = FindRoot(body0->m_index);
+			const ndInt32 root1 = FindRoot(body1->m_index);
+			parent[dMax(root0, root1)] = dMin(root0, root1);
+		}
+	}
+
+	for (ndInt32 i = 0; i < bodyArray.GetCount(); ++i)
+	{
+		parent[i] = FindRoot(i);
+	}
+
+	// the roots store the island index as a negative number.
+	auto GetIsland = [this, parent](const ndConstraint* const joint)
+	{
+		const ndBodyKinematic* const body0 = joint->GetBody0();
+		const ndBodyKinematic* const body1 = joint->GetBody1();
+		const ndInt32 node = body0->m_isStatic ? body1->m_index : body0->m_index;
+		const ndInt32 root = (parent[node] < 0) ? node : parent[node];
+		if (parent[root] >= 0)
+		{
+			m_islands.PushBack(ndIsland(m_world->GetScene()->GetActiveBodyArray()[root]));
+			parent[root] = -m_islands.GetCount();
+		}
+		return -parent[root] - 1;
+	};
+
+	m_islands.SetCount(0);
+	m_islandJoints.SetCount(m_activeJointCount);
+	for (ndInt32 i = 0; i < m_activeJointCount; ++i)
+	{
+		m_islands[GetIsland(jointArray[i])].m_count++;
+	}
+
+	ndInt32 sum = 0;
+	for (ndInt32 i = 0; i < m_islands.GetCount(); ++i)
 	{
-		scene->ParallelExecute(CalculateJointsForce);
-		scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
+		m_islands[i].m_start = sum;
+		sum += m_islands[i].m_count;
+		m_islands[i].m_count = 0;
+	}
+
+	for (ndInt32 i = 0; i < m_activeJointCount; ++i)
+	{
+		ndIsland& island = m_islands[GetIsland(jointArray[i])];
+		m_islandJoints[island.m_start + island.m_count] = i;
+		island.m_count++;
 	}
 }
 
+bool ndDynamicsUpdate::UpdateActiveIslands(ndInt32 pass)
+{
+	D_TRACKTIME();
+	auto CalculateIslandResidual = ndMakeObject::ndFunction([this](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		D_TRACKTIME();
+		const ndFloat32* const jointResidual = &m_jointResidual[0];
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			const ndInt32 index = m_activeIslands[i];
+			const ndIsland& island = m_islands[index];
+			ndFloat32 residual = ndFloat32(0.0f);
+			for (ndInt32 j = 0; j < island.m_count; ++j)
+			{
+				residual = dMax(residual, jointResidual[m_islandJoints[island.m_start + j]]);
+			}
+			m_islandResidual[index] = residual;
+		}
+	});
+
+	ndScene* const scene = m_world->GetScene();
+	m_islandResidual.SetCount(m_islands.GetCount());
+	scene->ParallelExecuteRange(m_activeIslands.GetCount(), CalculateIslandResidual);
+
+	ndWorld::ndSolverStats& stats = m_world->m_solverStats;
+	const bool lastPass = (pass + 1) >= ndInt32(m_solverPasses);
+	const ndFloat32 tol2 = m_world->m_solverTolerance * m_world->m_solverTolerance;
+
+	ndInt32 count = 0;
+	for (ndInt32 i = 0; i < m_activeIslands.GetCount(); ++i)
+	{
+		const ndInt32 index = m_activeIslands[i];
+		const ndFloat32 residual = m_islandResidual[index];
+		if (residual > tol2)
+		{
+			m_activeIslands[count] = index;
+			count++;
+		}
+		else if (!lastPass)
+		{
+			stats.m_earlyExits++;
+		}
+		if ((residual <= tol2) || lastPass)
+		{
+			stats.m_maxResidual = dMax(stats.m_maxResidual, ndSqrt(residual));
+		}
+	}
+
+	const bool changed = (pass == 0) || (count != m_activeIslands.GetCount());
+	m_activeIslands.SetCount(count);
+	return changed;
+}
+
 void ndDynamicsUpdate::CalculateForces()
 {
 	D_TRACKTIME();
@@ -1480,6 +1687,10 @@ void ndDynamicsUpdate::CalculateForces()
 		m_firstPassCoef = ndFloat32(0.0f);
 
 		InitSkeletons();
+		if (m_world->m_solverTolerance > ndFloat32(0.0f))
+		{
+			BuildSolverIslands();
+		}
 		for (ndInt32 step = 0; step < 4; step++)
 		{
 			CalculateJointsAcceleration();
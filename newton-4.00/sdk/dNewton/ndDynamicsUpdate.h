@@ -98,16 +98,20 @@ class ndDynamicsUpdate : public ndClassAlloc
 	private:
 	void SortJoints();
 	void SortIslands();
+	void CalculateForces();
+	void InitJacobianMatrix();
+	void CalculateJointsForce();
+	void BuildSolverIslands();
+	bool UpdateActiveIslands(ndInt32 pass);
+
+	protected:
 	void BuildIsland();
 	void InitWeights();
 	void InitBodyArray();
 	void InitSkeletons();
-	void CalculateForces();
 	void IntegrateBodies();
 	void UpdateSkeletons();
-	void InitJacobianMatrix();
 	void UpdateForceFeedback();
-	void CalculateJointsForce();
 	void IntegrateBodiesVelocity();
 	void CalculateJointsAcceleration();
 	void IntegrateUnconstrainedBodies();
@@ -115,7 +119,6 @@ class ndDynamicsUpdate : public ndClassAlloc
 	void DetermineSleepStates();
 	void GetJacobianDerivatives(ndConstraint* const joint);
 
-	protected:
 	void Clear();
 	virtual void Update();
 	void SortJointsScan();
@@ -132,6 +135,14 @@ class ndDynamicsUpdate : public ndClassAlloc
 	ndArray<ndBodyKinematic*> m_bodyIslandOrder;
 	ndArray<ndJointBodyPairIndex> m_jointBodyPairIndexBuffer;
 
+	// the islands of moving joints, only built when the world has a solver tolerance
+	ndArray<ndInt32> m_islandJoints;
+	ndArray<ndInt32> m_activeIslands;
+	ndArray<ndInt32> m_activeJoints;
+	ndArray<ndInt32> m_bodyIslandParent;
+	ndArray<ndFloat32> m_jointResidual;
+	ndArray<ndFloat32> m_islandResidual;
+
 	ndWorld* m_world;
 	ndFloat32 m_timestep;
 	ndFloat32 m_invTimestep;
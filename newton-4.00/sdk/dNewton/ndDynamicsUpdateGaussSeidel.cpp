@@ -0,0 +1,450 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyDynamic.h"
+#include "ndSkeletonList.h"
+#include "ndDynamicsUpdateGaussSeidel.h"
+#include "ndJointBilateralConstraint.h"
+
+#define D_GAUSS_SEIDEL_BUFFER_SIZE	1024
+
+// colors with fewer joints than this are solved by the calling thread, 
+// it is cheaper than waking up the workers for a handful of joints.
+#define D_GAUSS_SEIDEL_MIN_PARALLEL_BATCH	64
+
+ndDynamicsUpdateGaussSeidel::ndDynamicsUpdateGaussSeidel(ndWorld* const world)
+	:ndDynamicsUpdate(world)
+	,m_colorJoints(D_GAUSS_SEIDEL_BUFFER_SIZE)
+	,m_jointColor(D_GAUSS_SEIDEL_BUFFER_SIZE)
+	,m_bodyColorMask(D_GAUSS_SEIDEL_BUFFER_SIZE)
+	,m_colorCount(0)
+{
+	memset(m_colorStart, 0, sizeof(m_colorStart));
+}
+
+ndDynamicsUpdateGaussSeidel::~ndDynamicsUpdateGaussSeidel()
+{
+	Clear();
+	m_colorJoints.Resize(D_GAUSS_SEIDEL_BUFFER_SIZE);
+	m_jointColor.Resize(D_GAUSS_SEIDEL_BUFFER_SIZE);
+	m_bodyColorMask.Resize(D_GAUSS_SEIDEL_BUFFER_SIZE);
+}
+
+const char* ndDynamicsUpdateGaussSeidel::GetStringId() const
+{
+	return "gauss seidel";
+}
+
+void ndDynamicsUpdateGaussSeidel::ColorJoints()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	const ndInt32 bodyCount = scene->GetActiveBodyArray().GetCount();
+	const ndInt32 jointCount = jointArray.GetCount();
+
+	m_bodyColorMask.SetCount(bodyCount);
+	m_jointColor.SetCount(jointCount);
+	m_colorJoints.SetCount(jointCount);
+	memset(&m_bodyColorMask[0], 0, bodyCount * sizeof(ndUnsigned64));
+
+	// greedy coloring in joint order, static bodies do not take colors, 
+	// so all the joints resting on the ground can share the first color.
+	ndInt32 histogram[D_GAUSS_SEIDEL_MAX_COLORS];
+	memset(histogram, 0, sizeof(histogram));
+	const ndUnsigned64 overflowBit = ndUnsigned64(1) << (D_GAUSS_SEIDEL_MAX_COLORS - 1);
+	for (ndInt32 i = 0; i < jointCount; ++i)
+	{
+		const ndConstraint* const joint = jointArray[i];
+		const ndBodyKinematic* const body0 = joint->GetBody0();
+		const ndBodyKinematic* const body1 = joint->GetBody1();
+		const ndInt32 m0 = body0->m_index;
+		const ndInt32 m1 = body1->m_index;
+		const ndUnsigned64 used = (body0->m_isStatic ? 0 : m_bodyColorMask[m0]) | (body1->m_isStatic ? 0 : m_bodyColorMask[m1]);
+
+		ndInt32 color = 0;
+		for (ndUnsigned64 bit = 1; (used & bit) && (bit != overflowBit); bit = bit << 1)
+		{
+			color++;
+		}
+		const ndUnsigned64 colorBit = ndUnsigned64(1) << color;
+		if (!body0->m_isStatic)
+		{
+			m_bodyColorMask[m0] |= colorBit;
+		}
+		if (!body1->m_isStatic)
+		{
+			m_bodyColorMask[m1] |= colorBit;
+		}
+		m_jointColor[i] = ndUnsigned8(color);
+		histogram[color]++;
+	}
+
+	m_colorCount = 0;
+	ndInt32 sum = 0;
+	for (ndInt32 i = 0; i < D_GAUSS_SEIDEL_MAX_COLORS; ++i)
+	{
+		m_colorStart[i] = sum;
+		m_colorCount += histogram[i] ? 1 : 0;
+		sum += histogram[i];
+		histogram[i] = m_colorStart[i];
+	}
+	m_colorStart[D_GAUSS_SEIDEL_MAX_COLORS] = sum;
+
+	for (ndInt32 i = 0; i < jointCount; ++i)
+	{
+		const ndInt32 color = m_jointColor[i];
+		m_colorJoints[histogram[color]] = i;
+		histogram[color]++;
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::InitJacobianMatrix()
+{
+	ndScene* const scene = m_world->GetScene();
+	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	// same as the default solver, but with unit weights, the bodies see every 
+	// joint force as soon as it is solved, so they do not need the jacobi weights.
+	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		auto BuildJacobianMatrix = [this](ndConstraint* const joint)
+		{
+			dAssert(joint->GetBody0());
+			dAssert(joint->GetBody1());
+			const ndBodyKinematic* const body0 = joint->GetBody0();
+			const ndBodyKinematic* const body1 = joint->GetBody1();
+
+			const ndVector force0(body0->GetForce());
+			const ndVector torque0(body0->GetTorque());
+			const ndVector force1(body1->GetForce());
+			const ndVector torque1(body1->GetTorque());
+
+			const ndInt32 index = joint->m_rowStart;
+			const ndInt32 count = joint->m_rowCount;
+			const ndMatrix& invInertia0 = body0->m_invWorldInertiaMatrix;
+			const ndMatrix& invInertia1 = body1->m_invWorldInertiaMatrix;
+			const ndVector invMass0(body0->m_invMass[3]);
+			const ndVector invMass1(body1->m_invMass[3]);
+
+			const bool isBilateral = joint->IsBilateral();
+			for (ndInt32 i = 0; i < count; ++i)
+			{
+				ndLeftHandSide* const row = &m_leftHandSide[index + i];
+				ndRightHandSide* const rhs = &m_rightHandSide[index + i];
+
+				row->m_JMinv.m_jacobianM0.m_linear = row->m_Jt.m_jacobianM0.m_linear * invMass0;
+				row->m_JMinv.m_jacobianM0.m_angular = invInertia0.RotateVector(row->m_Jt.m_jacobianM0.m_angular);
+				row->m_JMinv.m_jacobianM1.m_linear = row->m_Jt.m_jacobianM1.m_linear * invMass1;
+				row->m_JMinv.m_jacobianM1.m_angular = invInertia1.RotateVector(row->m_Jt.m_jacobianM1.m_angular);
+
+				const ndJacobian& JMinvM0 = row->m_JMinv.m_jacobianM0;
+				const ndJacobian& JMinvM1 = row->m_JMinv.m_jacobianM1;
+				const ndVector tmpAccel(
+					JMinvM0.m_linear * force0 + JMinvM0.m_angular * torque0 +
+					JMinvM1.m_linear * force1 + JMinvM1.m_angular * torque1);
+
+				const ndFloat32 extenalAcceleration = -tmpAccel.AddHorizontal().GetScalar();
+				rhs->m_deltaAccel = extenalAcceleration;
+				rhs->m_coordenateAccel += extenalAcceleration;
+				dAssert(rhs->m_jointFeebackForce);
+				const ndFloat32 force = rhs->m_jointFeebackForce->GetInitialGuess();
+
+				rhs->m_force = isBilateral ? dClamp(force, rhs->m_lowerBoundFrictionCoefficent, rhs->m_upperBoundFrictionCoefficent) : force;
+				rhs->m_maxImpact = ndFloat32(0.0f);
+
+				const ndJacobian& JtM0 = row->m_Jt.m_jacobianM0;
+				const ndJacobian& JtM1 = row->m_Jt.m_jacobianM1;
+				const ndVector tmpDiag(
+					JMinvM0.m_linear * JtM0.m_linear + JMinvM0.m_angular * JtM0.m_angular +
+					JMinvM1.m_linear * JtM1.m_linear + JMinvM1.m_angular * JtM1.m_angular);
+
+				ndFloat32 diag = tmpDiag.AddHorizontal().GetScalar();
+				dAssert(diag > ndFloat32(0.0f));
+				rhs->m_diagDamp = diag * rhs->m_diagonalRegularizer;
+
+				diag *= (ndFloat32(1.0f) + rhs->m_diagonalRegularizer);
+				rhs->m_invJinvMJt = ndFloat32(1.0f) / diag;
+			}
+		};
+
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			ndConstraint* const joint = jointArray[i];
+			GetJacobianDerivatives(joint);
+			BuildJacobianMatrix(joint);
+		}
+	});
+
+	if (scene->GetActiveContactArray().GetCount())
+	{
+		D_TRACKTIME();
+		m_rightHandSide[0].m_force = ndFloat32(1.0f);
+		scene->ParallelExecuteRange(jointArray.GetCount(), InitJacobianMatrix);
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::AccumulateJointForces()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	// the skeletons overwrite the forces of their bodies after each pass, 
+	// so the body forces are rebuilt from the joint forces before each step.
+	auto CalculateJointPartialForces = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		const ndVector zero(ndVector::m_zero);
+		ndJacobian* const jointPartialForces = &GetTempInternalForces()[0];
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			const ndConstraint* const joint = jointArray[i];
+			const ndInt32 rowStart = joint->m_rowStart;
+			const ndInt32 rowsCount = joint->m_rowCount;
+
+			ndVector forceM0(zero);
+			ndVector torqueM0(zero);
+			ndVector forceM1(zero);
+			ndVector torqueM1(zero);
+			for (ndInt32 j = 0; j < rowsCount; ++j)
+			{
+				ndRightHandSide* const rhs = &m_rightHandSide[rowStart + j];
+				const ndLeftHandSide* const lhs = &m_leftHandSide[rowStart + j];
+
+				const ndVector f(rhs->m_force);
+				forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, f);
+				torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, f);
+				forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, f);
+				torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, f);
+				rhs->m_maxImpact = dMax(dAbs(f.GetScalar()), rhs->m_maxImpact);
+			}
+
+			ndJacobian& outBody0 = jointPartialForces[i * 2 + 0];
+			outBody0.m_linear = forceM0;
+			outBody0.m_angular = torqueM0;
+
+			ndJacobian& outBody1 = jointPartialForces[i * 2 + 1];
+			outBody1.m_linear = forceM1;
+			outBody1.m_angular = torqueM1;
+		}
+	});
+
+	auto AccumulatePartialForces = ndMakeObject::ndFunction([this, &bodyArray](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME();
+		const ndVector zero(ndVector::m_zero);
+
+		ndJacobian* const internalForces = &GetInternalForces()[0];
+		const ndInt32* const bodyIndex = &GetJointForceIndexBuffer()[0];
+
+		const ndJacobian* const jointInternalForces = &GetTempInternalForces()[0];
+		const ndJointBodyPairIndex* const jointBodyPairIndexBuffer = &GetJointBodyPairIndexBuffer()[0];
+
+		const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		{
+			ndVector force(zero);
+			ndVector torque(zero);
+			const ndBodyKinematic* const body = bodyArray[i];
+
+			const ndInt32 startIndex = bodyIndex[i];
+			const ndInt32 mask = body->m_isStatic - 1;
+			const ndInt32 count = mask & (bodyIndex[i + 1] - startIndex);
+			for (ndInt32 j = 0; j < count; ++j)
+			{
+				const ndInt32 index = jointBodyPairIndexBuffer[startIndex + j].m_joint;
+				force += jointInternalForces[index].m_linear;
+				torque += jointInternalForces[index].m_angular;
+			}
+			internalForces[i].m_linear = force;
+			internalForces[i].m_angular = torque;
+		}
+	});
+
+	scene->ParallelExecuteRange(jointArray.GetCount(), CalculateJointPartialForces);
+	scene->ParallelExecute(AccumulatePartialForces);
+}
+
+void ndDynamicsUpdateGaussSeidel::CalculateJointsForce()
+{
+	D_TRACKTIME();
+	const ndInt32 passes = m_solverPasses;
+	ndScene* const scene = m_world->GetScene();
+	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	AccumulateJointForces();
+
+	ndInt32 colorStart = 0;
+	auto SolveJoints = ndMakeObject::ndFunction([this, &jointArray, &colorStart](ndInt32, ndInt32 start, ndInt32 end)
+	{
+		ndJacobian* const internalForces = &GetInternalForces()[0];
+		const ndInt32* const colorJoints = &m_colorJoints[colorStart];
+
+		// no other joint of this color touches the two bodies, so their 
+		// forces are read and written back without synchronization.
+		auto JointForce = [this, internalForces](ndConstraint* const joint)
+		{
+			ndBodyKinematic* const body0 = joint->GetBody0();
+			ndBodyKinematic* const body1 = joint->GetBody1();
+			dAssert(body0);
+			dAssert(body1);
+
+			const ndInt32 resting = body0->m_equilibrium0 & body1->m_equilibrium0;
+			if (resting)
+			{
+				return;
+			}
+
+			const ndVector zero(ndVector::m_zero);
+			const ndInt32 m0 = body0->m_index;
+			const ndInt32 m1 = body1->m_index;
+			const ndInt32 rowStart = joint->m_rowStart;
+			const ndInt32 rowsCount = joint->m_rowCount;
+
+			ndVector forceM0(internalForces[m0].m_linear);
+			ndVector torqueM0(internalForces[m0].m_angular);
+			ndVector forceM1(internalForces[m1].m_linear);
+			ndVector torqueM1(internalForces[m1].m_angular);
+
+			const ndFloat32 tol = ndFloat32(0.125f);
+			const ndFloat32 tol2 = tol * tol;
+			ndVector maxAccel(tol2 * ndFloat32(2.0f));
+			for (ndInt32 k = 0; (k < 4) && (maxAccel.GetScalar() > tol2); ++k)
+			{
+				maxAccel = zero;
+				for (ndInt32 j = 0; j < rowsCount; ++j)
+				{
+					ndRightHandSide* const rhs = &m_rightHandSide[rowStart + j];
+					const ndLeftHandSide* const lhs = &m_leftHandSide[rowStart + j];
+					const ndVector force(rhs->m_force);
+
+					ndVector a(lhs->m_JMinv.m_jacobianM0.m_linear * forceM0);
+					a = a.MulAdd(lhs->m_JMinv.m_jacobianM0.m_angular, torqueM0);
+					a = a.MulAdd(lhs->m_JMinv.m_jacobianM1.m_linear, forceM1);
+					a = a.MulAdd(lhs->m_JMinv.m_jacobianM1.m_angular, torqueM1);
+					a = ndVector(rhs->m_coordenateAccel - rhs->m_force * rhs->m_diagDamp) - a.AddHorizontal();
+
+					dAssert(rhs->m_normalForceIndexFlat >= 0);
+					ndVector f(force + a.Scale(rhs->m_invJinvMJt));
+					const ndInt32 frictionIndex = rhs->m_normalForceIndexFlat;
+					const ndFloat32 frictionNormal = m_rightHandSide[frictionIndex].m_force;
+					const ndVector lowerFrictionForce(frictionNormal * rhs->m_lowerBoundFrictionCoefficent);
+					const ndVector upperFrictionForce(frictionNormal * rhs->m_upperBoundFrictionCoefficent);
+
+					a = a & (f < upperFrictionForce) & (f > lowerFrictionForce);
+					maxAccel = maxAccel.MulAdd(a, a);
+
+					f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
+					rhs->m_force = f.GetScalar();
+					rhs->m_maxImpact = dMax(dAbs(rhs->m_force), rhs->m_maxImpact);
+
+					const ndVector deltaForce(f - force);
+					forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, deltaForce);
+					torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, deltaForce);
+					forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, deltaForce);
+					torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, deltaForce);
+				}
+			}
+
+			// static bodies are shared by the joints of a color, and they do not move.
+			if (!body0->m_isStatic)
+			{
+				internalForces[m0].m_linear = forceM0;
+				internalForces[m0].m_angular = torqueM0;
+			}
+			if (!body1->m_isStatic)
+			{
+				internalForces[m1].m_linear = forceM1;
+				internalForces[m1].m_angular = torqueM1;
+			}
+		};
+
+		for (ndInt32 i = start; i < end; ++i)
+		{
+			ndConstraint* const joint = jointArray[colorJoints[i]];
+			JointForce(joint);
+		}
+	});
+
+	for (ndInt32 i = 0; i < passes; ++i)
+	{
+		for (ndInt32 color = 0; color < D_GAUSS_SEIDEL_MAX_COLORS; ++color)
+		{
+			colorStart = m_colorStart[color];
+			const ndInt32 count = m_colorStart[color + 1] - colorStart;
+			if ((color == (D_GAUSS_SEIDEL_MAX_COLORS - 1)) || (count < D_GAUSS_SEIDEL_MIN_PARALLEL_BATCH))
+			{
+				// the overflow color has joints that share bodies, it is solved in order.
+				if (count)
+				{
+					SolveJoints(0, 0, count);
+				}
+			}
+			else
+			{
+				scene->ParallelExecuteRange(count, SolveJoints);
+			}
+		}
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::CalculateForces()
+{
+	D_TRACKTIME();
+	if (m_world->GetScene()->GetActiveContactArray().GetCount())
+	{
+		m_firstPassCoef = ndFloat32(0.0f);
+
+		ColorJoints();
+		InitSkeletons();
+		for (ndInt32 step = 0; step < 4; step++)
+		{
+			CalculateJointsAcceleration();
+			CalculateJointsForce();
+			UpdateSkeletons();
+			IntegrateBodiesVelocity();
+		}
+		UpdateForceFeedback();
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::Update()
+{
+	D_TRACKTIME();
+	m_timestep = m_world->GetScene()->GetTimestep();
+
+	BuildIsland();
+	IntegrateUnconstrainedBodies();
+	InitWeights();
+
+	// the jacobi solver adds passes for highly connected bodies, gauss seidel does not need them.
+	m_solverPasses = ndUnsigned32(m_world->GetSolverIterations());
+
+	InitBodyArray();
+	InitJacobianMatrix();
+	CalculateForces();
+	IntegrateBodies();
+	DetermineSleepStates();
+}
@@ -0,0 +1,68 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_WORLD_DYNAMICS_UPDATE_GAUSS_SEIDEL_H__
+#define __ND_WORLD_DYNAMICS_UPDATE_GAUSS_SEIDEL_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndDynamicsUpdate.h"
+
+// colors are bits of a per body mask, the last color takes the joints 
+// of bodies with too many contacts, and it is solved by a single thread.
+#define D_GAUSS_SEIDEL_MAX_COLORS	64
+
+// the joint graph is colored so that no two joints of the same color share a dynamic body, 
+// then the joints of each color are solved in parallel and the bodies velocities are updated 
+// in place. each pass sees the forces of the colors before it, so it converges in fewer 
+// passes than the weighted jacobi of the default solver, at the cost of one dispatch per color.
+D_MSV_NEWTON_ALIGN_32
+class ndDynamicsUpdateGaussSeidel: public ndDynamicsUpdate
+{
+	public:
+	ndDynamicsUpdateGaussSeidel(ndWorld* const world);
+	virtual ~ndDynamicsUpdateGaussSeidel();
+
+	virtual const char* GetStringId() const;
+	ndInt32 GetColorCount() const;
+
+	protected:
+	virtual void Update();
+
+	private:
+	void ColorJoints();
+	void CalculateForces();
+	void InitJacobianMatrix();
+	void CalculateJointsForce();
+	void AccumulateJointForces();
+
+	ndArray<ndInt32> m_colorJoints;
+	ndArray<ndUnsigned8> m_jointColor;
+	ndArray<ndUnsigned64> m_bodyColorMask;
+	ndInt32 m_colorStart[D_GAUSS_SEIDEL_MAX_COLORS + 1];
+	ndInt32 m_colorCount;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline ndInt32 ndDynamicsUpdateGaussSeidel::GetColorCount() const
+{
+	return m_colorCount;
+}
+
+#endif
@@ -31,6 +31,36 @@
 #define D_SSE_DEFAULT_BUFFER_SIZE	1024
 using namespace ndSoa;
 
+ndSoaBodyState::ndSoaBodyState()
+	:m_invInertia(D_SSE_DEFAULT_BUFFER_SIZE)
+	,m_force(D_SSE_DEFAULT_BUFFER_SIZE)
+	,m_torque(D_SSE_DEFAULT_BUFFER_SIZE)
+	,m_invMass(D_SSE_DEFAULT_BUFFER_SIZE)
+	,m_weigh(D_SSE_DEFAULT_BUFFER_SIZE)
+	,m_equilibrium(D_SSE_DEFAULT_BUFFER_SIZE)
+{
+}
+
+void ndSoaBodyState::Resize(ndInt32 size)
+{
+	m_invInertia.Resize(size);
+	m_force.Resize(size);
+	m_torque.Resize(size);
+	m_invMass.Resize(size);
+	m_weigh.Resize(size);
+	m_equilibrium.Resize(size);
+}
+
+void ndSoaBodyState::SetCount(ndInt32 count)
+{
+	m_invInertia.SetCount(count);
+	m_force.SetCount(count);
+	m_torque.SetCount(count);
+	m_invMass.SetCount(count);
+	m_weigh.SetCount(count);
+	m_equilibrium.SetCount(count);
+}
+
 ndDynamicsUpdateSoa::ndDynamicsUpdateSoa(ndWorld* const world)
 	:ndDynamicsUpdate(world)
 	,m_ordinals(0, 1, 2, 3)
@@ -38,6 +68,7 @@ ndDynamicsUpdateSoa::ndDynamicsUpdateSoa(ndWorld* const world)
 	,m_jointMask(D_SSE_DEFAULT_BUFFER_SIZE)
 	,m_soaJointRows(D_SSE_DEFAULT_BUFFER_SIZE)
 	,m_soaMassMatrix(D_SSE_DEFAULT_BUFFER_SIZE * 4)
+	,m_bodyState()
 {
 }
 
@@ -49,6 +80,7 @@ ndDynamicsUpdateSoa::~ndDynamicsUpdateSoa()
 	m_groupType.Resize(D_SSE_DEFAULT_BUFFER_SIZE);
 	m_soaJointRows.Resize(D_SSE_DEFAULT_BUFFER_SIZE);
 	m_soaMassMatrix.Resize(D_SSE_DEFAULT_BUFFER_SIZE * 4);
+	m_bodyState.Resize(D_SSE_DEFAULT_BUFFER_SIZE);
 }
 
 const char* ndDynamicsUpdateSoa::GetStringId() const
@@ -242,11 +274,13 @@ void ndDynamicsUpdateSoa::SortIslands()
 	GetInternalForces().SetCount(bodyArray.GetCount());
 	activeBodyArray.SetCount(bodyArray.GetCount());
 
-	ndInt32 histogram[D_MAX_THREADS_COUNT][3];
-	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const histogram = scene->GetFrameArena().Alloc<ndInt32>(threadCount * 3);
+	auto Scan0 = ndMakeObject::ndFunction([this, &bodyArray, histogram](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
+		ndInt32* const hist = &histogram[threadIndex * 3];
 		hist[0] = 0;
 		hist[1] = 0;
 		hist[2] = 0;
@@ -266,10 +300,10 @@ void ndDynamicsUpdateSoa::SortIslands()
 		}
 	});
 
-	auto Sort0 = ndMakeObject::ndFunction([this, &bodyArray, &activeBodyArray, &histogram](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Sort0 = ndMakeObject::ndFunction([this, &bodyArray, &activeBodyArray, histogram](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
-		ndInt32* const hist = &histogram[threadIndex][0];
+		ndInt32* const hist = &histogram[threadIndex * 3];
 		const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, threadCount);
 
 		ndInt32 map[4];
@@ -294,15 +328,14 @@ void ndDynamicsUpdateSoa::SortIslands()
 	scan[0] = 0;
 	scan[1] = 0;
 	scan[2] = 0;
-	const ndInt32 threadCount = scene->GetThreadCount();
 
 	ndInt32 sum = 0;
 	for (ndInt32 i = 0; i < 3; ++i)
 	{
 		for (ndInt32 j = 0; j < threadCount; ++j)
 		{
-			ndInt32 partialSum = histogram[j][i];
-			histogram[j][i] = sum;
+			ndInt32 partialSum = histogram[j * 3 + i];
+			histogram[j * 3 + i] = sum;
 			sum += partialSum;
 		}
 		scan[i] = sum;
@@ -370,9 +403,11 @@ void ndDynamicsUpdateSoa::InitWeights()
 	const ndInt32 bodyCount = bodyArray.GetCount();
 	GetInternalForces().SetCount(bodyCount);
 
-	ndInt32 extraPassesArray[D_MAX_THREADS_COUNT];
+	const ndInt32 threadCount = scene->GetThreadCount();
+	ndFrameArena::ndScope scope(scene->GetFrameArena());
+	ndInt32* const extraPassesArray = scene->GetFrameArena().Alloc<ndInt32>(threadCount);
 
-	auto InitWeights = ndMakeObject::ndFunction([this, &bodyArray, &extraPassesArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitWeights = ndMakeObject::ndFunction([this, &bodyArray, extraPassesArray](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
 		const ndArray<ndInt32>& jointForceIndexBuffer = GetJointForceIndexBuffer();
@@ -405,7 +440,6 @@ void ndDynamicsUpdateSoa::InitWeights()
 		scene->ParallelExecute(InitWeights);
 
 		ndInt32 extraPasses = 0;
-		const ndInt32 threadCount = scene->GetThreadCount();
 		for (ndInt32 i = 0; i < threadCount; ++i)
 		{
 			extraPasses = dMax(extraPasses, extraPassesArray[i]);
@@ -454,9 +488,24 @@ void ndDynamicsUpdateSoa::InitBodyArray()
 	ndScene* const scene = m_world->GetScene();
 	const ndFloat32 timestep = scene->GetTimestep();
 
-	auto InitBodyArray = ndMakeObject::ndFunction([this, timestep](ndInt32 threadIndex, ndInt32 threadCount)
+	// the solver state is written by the same pass that prepares the island bodies, 
+	// the bodies that joints read but that are not in the islands, resting and static 
+	// bodies, are copied by the same threads, so there is no extra pass or sync.
+	auto InitBodyArray = ndMakeObject::ndFunction([this, scene, timestep](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME();
+		ndSoaBodyState& state = m_bodyState;
+		auto CopyState = [&state](const ndBodyKinematic* const body)
+		{
+			const ndInt32 i = body->m_index;
+			state.m_invInertia[i] = body->m_invWorldInertiaMatrix;
+			state.m_force[i] = body->GetForce();
+			state.m_torque[i] = body->GetTorque();
+			state.m_invMass[i] = body->m_invMass.m_w;
+			state.m_weigh[i] = body->m_weigh;
+			state.m_equilibrium[i] = body->m_equilibrium0;
+		};
+
 		const ndArray<ndBodyKinematic*>& bodyArray = GetBodyIslandOrder();
 		const ndStartEnd startEnd(bodyArray.GetCount() - GetUnconstrainedBodyCount(), threadIndex, threadCount);
 		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
@@ -474,8 +523,24 @@ void ndDynamicsUpdateSoa::InitBodyArray()
 			body->m_accel = body->m_veloc;
 			body->m_alpha = body->m_omega;
 			body->m_gyroRotation = body->m_rotation;
+			CopyState(body);
+		}
+
+		// island bodies are the moving constrained ones, see SortIslands
+		const ndArray<ndBodyKinematic*>& activeBodyArray = scene->GetActiveBodyArray();
+		const ndStartEnd activeStartEnd(activeBodyArray.GetCount(), threadIndex, threadCount);
+		for (ndInt32 i = activeStartEnd.m_start; i < activeStartEnd.m_end; ++i)
+		{
+			const ndBodyKinematic* const body = activeBodyArray[i];
+			dAssert(body->m_index == i);
+			if (body->m_equilibrium0 || !body->m_isConstrained)
+			{
+				CopyState(body);
+			}
 		}
 	});
+
+	m_bodyState.SetCount(scene->GetActiveBodyArray().GetCount());
 	scene->ParallelExecute(InitBodyArray);
 }
 
@@ -582,28 +647,30 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 	ndBodyKinematic** const bodyArray = &scene->GetActiveBodyArray()[0];
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJacobian* const internalForces = &GetTempInternalForces()[0];
-		auto BuildJacobianMatrix = [this, &internalForces](ndConstraint* const joint, ndInt32 jointIndex)
+		const ndSoaBodyState& state = m_bodyState;
+		auto BuildJacobianMatrix = [this, &internalForces, &state](ndConstraint* const joint, ndInt32 jointIndex)
 		{
 			dAssert(joint->GetBody0());
 			dAssert(joint->GetBody1());
 			const ndBodyKinematic* const body0 = joint->GetBody0();
 			const ndBodyKinematic* const body1 = joint->GetBody1();
+			const ndInt32 m0 = body0->m_index;
+			const ndInt32 m1 = body1->m_index;
 
-			const ndVector force0(body0->GetForce());
-			const ndVector torque0(body0->GetTorque());
-			const ndVector force1(body1->GetForce());
-			const ndVector torque1(body1->GetTorque());
+			const ndVector force0(state.m_force[m0]);
+			const ndVector torque0(state.m_torque[m0]);
+			const ndVector force1(state.m_force[m1]);
+			const ndVector torque1(state.m_torque[m1]);
 
 			const ndInt32 index = joint->m_rowStart;
 			const ndInt32 count = joint->m_rowCount;
-			const ndMatrix& invInertia0 = body0->m_invWorldInertiaMatrix;
-			const ndMatrix& invInertia1 = body1->m_invWorldInertiaMatrix;
-			const ndVector invMass0(body0->m_invMass[3]);
-			const ndVector invMass1(body1->m_invMass[3]);
+			const ndMatrix& invInertia0 = state.m_invInertia[m0];
+			const ndMatrix& invInertia1 = state.m_invInertia[m1];
+			const ndVector invMass0(state.m_invMass[m0]);
+			const ndVector invMass1(state.m_invMass[m1]);
 
 			#ifdef D_JOINT_PRECONDITIONER
 			joint->m_preconditioner0 = ndFloat32(1.0f);
@@ -633,14 +700,14 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 			ndVector torqueAcc1(zero);
 
 			#ifdef D_JOINT_PRECONDITIONER
-			const ndVector weigh0(body0->m_weigh * joint->m_preconditioner0);
-			const ndVector weigh1(body1->m_weigh * joint->m_preconditioner1);
+			const ndVector weigh0(state.m_weigh[m0] * joint->m_preconditioner0);
+			const ndVector weigh1(state.m_weigh[m1] * joint->m_preconditioner1);
 
 			const ndFloat32 preconditioner0 = joint->m_preconditioner0;
 			const ndFloat32 preconditioner1 = joint->m_preconditioner1;
 			#else
-			const ndVector weigh0(body0->m_weigh);
-			const ndVector weigh1(body1->m_weigh);
+			const ndVector weigh0(state.m_weigh[m0]);
+			const ndVector weigh1(state.m_weigh[m1]);
 			#endif
 
 			const bool isBilateral = joint->IsBilateral();
@@ -709,8 +776,7 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 			outBody1.m_angular = torqueAcc1;
 		};
 
-		const ndInt32 jointCount = jointArray.GetCount();
-		for (ndInt32 i = threadIndex; i < jointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			GetJacobianDerivatives(joint);
@@ -754,26 +820,21 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 		}
 	});
 	
-	auto TransposeMassMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto TransposeMassMatrix = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
-		const ndInt32 jointCount = jointArray.GetCount();
-
 		const ndLeftHandSide* const leftHandSide = &GetLeftHandSide()[0];
 		const ndRightHandSide* const rightHandSide = &GetRightHandSide()[0];
 		ndArray<ndSoa::ndSoaMatrixElement>& massMatrix = m_soaMassMatrix;
 
 		const ndVector zero(ndVector::m_zero);
 		const ndVector ordinals(m_ordinals);
-		const ndInt32 mask = -ndInt32(D_SSE_WORK_GROUP);
-		const ndInt32 soaJointCount = ((jointCount + D_SSE_WORK_GROUP - 1) & mask) / D_SSE_WORK_GROUP;
 
 		ndInt8* const groupType = &m_groupType[0];
 		ndVector* const jointMask = &m_jointMask[0];
 		const ndInt32* const soaJointRows = &m_soaJointRows[0];
 
 		ndConstraint** const jointsPtr = &jointArray[0];
-		for (ndInt32 i = threadIndex; i < soaJointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			const ndInt32 index = i * D_SSE_WORK_GROUP;
 			ndInt32 maxRow = 0;
@@ -1021,9 +1082,9 @@ void ndDynamicsUpdateSoa::InitJacobianMatrix()
 		D_TRACKTIME();
 		m_rightHandSide[0].m_force = ndFloat32(1.0f);
 
-		scene->ParallelExecute(InitJacobianMatrix);
+		scene->ParallelExecuteRange(jointArray.GetCount(), InitJacobianMatrix);
 		scene->ParallelExecute(InitJacobianAccumulatePartialForces);
-		scene->ParallelExecute(TransposeMassMatrix);
+		scene->ParallelExecuteRange(m_soaJointRows.GetCount(), TransposeMassMatrix);
 	}
 }
 
@@ -1033,16 +1094,14 @@ void ndDynamicsUpdateSoa::UpdateForceFeedback()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto UpdateForceFeedback = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateForceFeedback = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 		const ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 
 		const ndVector zero(ndVector::m_zero);
 		const ndFloat32 timestepRK = GetTimestepRK();
-		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			const ndInt32 rows = joint->m_rowCount;
@@ -1083,7 +1142,7 @@ void ndDynamicsUpdateSoa::UpdateForceFeedback()
 		}
 	});
 
-	scene->ParallelExecute(UpdateForceFeedback);
+	scene->ParallelExecuteRange(jointArray.GetCount(), UpdateForceFeedback);
 }
 
 void ndDynamicsUpdateSoa::InitSkeletons()
@@ -1092,13 +1151,12 @@ void ndDynamicsUpdateSoa::InitSkeletons()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndSkeletonContainer*>& activeSkeletons = m_world->m_activeSkeletons;
 
-	auto InitSkeletons = ndMakeObject::ndFunction([this, &activeSkeletons](ndInt32 threadIndex, ndInt32 threadCount)
+	auto InitSkeletons = ndMakeObject::ndFunction([this, &activeSkeletons](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 		const ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 
-		for (ndInt32 i = threadIndex; i < activeSkeletons.GetCount(); i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndSkeletonContainer* const skeleton = activeSkeletons[i];
 			skeleton->InitMassMatrix(&leftHandSide[0], &rightHandSide[0]);
@@ -1107,7 +1165,7 @@ void ndDynamicsUpdateSoa::InitSkeletons()
 
 	if (activeSkeletons.GetCount())
 	{
-		scene->ParallelExecute(InitSkeletons);
+		scene->ParallelExecuteRange(activeSkeletons.GetCount(), InitSkeletons);
 	}
 }
 
@@ -1118,11 +1176,10 @@ void ndDynamicsUpdateSoa::UpdateSkeletons()
 	const ndArray<ndSkeletonContainer*>& activeSkeletons = m_world->m_activeSkeletons;
 	const ndBodyKinematic** const bodyArray = (const ndBodyKinematic**)(&scene->GetActiveBodyArray()[0]);
 
-	auto UpdateSkeletons = ndMakeObject::ndFunction([this, &bodyArray, &activeSkeletons](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateSkeletons = ndMakeObject::ndFunction([this, &bodyArray, &activeSkeletons](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJacobian* const internalForces = &GetInternalForces()[0];
-		for (ndInt32 i = threadIndex; i < activeSkeletons.GetCount(); i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndSkeletonContainer* const skeleton = activeSkeletons[i];
 			skeleton->CalculateReactionForces(internalForces);
@@ -1131,7 +1188,7 @@ void ndDynamicsUpdateSoa::UpdateSkeletons()
 
 	if (activeSkeletons.GetCount())
 	{
-		scene->ParallelExecute(UpdateSkeletons);
+		scene->ParallelExecuteRange(activeSkeletons.GetCount(), UpdateSkeletons);
 	}
 }
 
@@ -1141,9 +1198,8 @@ void ndDynamicsUpdateSoa::CalculateJointsAcceleration()
 	ndScene* const scene = m_world->GetScene();
 	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto CalculateJointsAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CalculateJointsAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		ndJointAccelerationDecriptor joindDesc;
 		joindDesc.m_timestep = m_timestepRK;
 		joindDesc.m_invTimestep = m_invTimestepRK;
@@ -1151,8 +1207,7 @@ void ndDynamicsUpdateSoa::CalculateJointsAcceleration()
 		ndArray<ndLeftHandSide>& leftHandSide = m_leftHandSide;
 		ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 
-		const ndStartEnd startEnd(jointArray.GetCount(), threadIndex, threadCount);
-		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			ndConstraint* const joint = jointArray[i];
 			const ndInt32 pairStart = joint->m_rowStart;
@@ -1163,20 +1218,16 @@ void ndDynamicsUpdateSoa::CalculateJointsAcceleration()
 		}
 	});
 
-	auto UpdateAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto UpdateAcceleration = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
 		const ndArray<ndRightHandSide>& rightHandSide = m_rightHandSide;
 
-		const ndInt32 jointCount = jointArray.GetCount();
-		const ndInt32 mask = -ndInt32(D_SSE_WORK_GROUP);
 		const ndInt32* const soaJointRows = &m_soaJointRows[0];
-		const ndInt32 soaJointCountBatches = ((jointCount + D_SSE_WORK_GROUP - 1) & mask) / D_SSE_WORK_GROUP;
 		const ndInt8* const groupType = &m_groupType[0];
 
 		const ndConstraint* const * jointArrayPtr = &jointArray[0];
 		ndSoaMatrixElement* const massMatrix = &m_soaMassMatrix[0];
-		for (ndInt32 i = threadIndex; i < soaJointCountBatches; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			if (groupType[i])
 			{
@@ -1217,10 +1268,10 @@ void ndDynamicsUpdateSoa::CalculateJointsAcceleration()
 		}
 	});
 
-	scene->ParallelExecute(CalculateJointsAcceleration);
+	scene->ParallelExecuteRange(jointArray.GetCount(), CalculateJointsAcceleration);
 
 	m_firstPassCoef = ndFloat32(1.0f);
-	scene->ParallelExecute(UpdateAcceleration);
+	scene->ParallelExecuteRange(m_soaJointRows.GetCount(), UpdateAcceleration);
 }
 
 void ndDynamicsUpdateSoa::IntegrateBodiesVelocity()
@@ -1232,6 +1283,7 @@ void ndDynamicsUpdateSoa::IntegrateBodiesVelocity()
 		D_TRACKTIME();
 		ndArray<ndBodyKinematic*>& bodyArray = GetBodyIslandOrder();
 		const ndArray<ndJacobian>& internalForces = GetInternalForces();
+		ndSoaBodyState& state = m_bodyState;
 
 		const ndVector timestep4(GetTimestepRK());
 		const ndVector speedFreeze2(m_world->m_freezeSpeed2 * ndFloat32(0.1f));
@@ -1246,8 +1298,8 @@ void ndDynamicsUpdateSoa::IntegrateBodiesVelocity()
 			dAssert(body->m_isConstrained);
 			const ndInt32 index = body->m_index;
 			const ndJacobian& forceAndTorque = internalForces[index];
-			const ndVector force(body->GetForce() + forceAndTorque.m_linear);
-			const ndVector torque(body->GetTorque() + forceAndTorque.m_angular - body->GetGyroTorque());
+			const ndVector force(state.m_force[index] + forceAndTorque.m_linear);
+			const ndVector torque(state.m_torque[index] + forceAndTorque.m_angular - body->GetGyroTorque());
 			const ndJacobian velocStep(body->IntegrateForceAndToque(force, torque, timestep4));
 
 			if (!body->m_equilibrium0)
@@ -1263,6 +1315,7 @@ void ndDynamicsUpdateSoa::IntegrateBodiesVelocity()
 				const ndVector test(((velocStep2 > speedFreeze2) | (omegaStep2 > speedFreeze2)) & ndVector::m_negOne);
 				const ndInt8 equilibrium = test.GetSignMask() ? 0 : 1;
 				body->m_equilibrium0 = equilibrium;
+				state.m_equilibrium[index] = equilibrium;
 			}
 			dAssert(body->m_veloc.m_w == ndFloat32(0.0f));
 			dAssert(body->m_omega.m_w == ndFloat32(0.0f));
@@ -1280,16 +1333,15 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 	ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &jointArray](ndInt32 threadIndex, ndInt32 threadCount)
+	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &jointArray](ndInt32, ndInt32 start, ndInt32 end)
 	{
-		D_TRACKTIME();
-		const ndInt32 jointCount = jointArray.GetCount();
 		ndJacobian* const jointPartialForces = &GetTempInternalForces()[0];
 
 		const ndInt32* const soaJointRows = &m_soaJointRows[0];
 		ndSoaMatrixElement* const soaMassMatrix = &m_soaMassMatrix[0];
+		const ndSoaBodyState& state = m_bodyState;
 
-		auto JointForce = [this, &jointArray, jointPartialForces](ndInt32 group, ndSoaMatrixElement* const massMatrix)
+		auto JointForce = [this, &jointArray, &state, jointPartialForces](ndInt32 group, ndSoaMatrixElement* const massMatrix)
 		{
 			ndSoaVector6 forceM0;
 			ndSoaVector6 forceM1;
@@ -1318,13 +1370,13 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 					const ndInt32 m1 = body1->m_index;
 
 					#ifdef D_JOINT_PRECONDITIONER
-					weight0[i] = body0->m_weigh;
-					weight1[i] = body1->m_weigh;
+					weight0[i] = state.m_weigh[m0];
+					weight1[i] = state.m_weigh[m1];
 					preconditioner0[i] = joint->m_preconditioner0;
 					preconditioner1[i] = joint->m_preconditioner1;
 					#else
-					preconditioner0[i] = body0->m_weigh;
-					preconditioner1[i] = body1->m_weigh;
+					preconditioner0[i] = state.m_weigh[m0];
+					preconditioner1[i] = state.m_weigh[m1];
 					#endif
 
 					forceM0.m_linear.m_x[i] = m_internalForces[m0].m_linear.m_x;
@@ -1376,13 +1428,13 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 						const ndInt32 m1 = body1->m_index;
 
 						#ifdef D_JOINT_PRECONDITIONER
-						weight0[i] = body0->m_weigh;
-						weight1[i] = body1->m_weigh;
+						weight0[i] = state.m_weigh[m0];
+						weight1[i] = state.m_weigh[m1];
 						preconditioner0[i] = joint->m_preconditioner0;
 						preconditioner1[i] = joint->m_preconditioner1;
 						#else	
-						preconditioner0[i] = body0->m_weigh;
-						preconditioner1[i] = body1->m_weigh;
+						preconditioner0[i] = state.m_weigh[m0];
+						preconditioner1[i] = state.m_weigh[m1];
 						#endif
 
 						forceM0.m_linear.m_x[i] = m_internalForces[m0].m_linear.m_x;
@@ -1561,7 +1613,7 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 					const ndBodyKinematic* const body1 = joint->GetBody1();
 					dAssert(body0);
 					dAssert(body1);
-					const ndInt32 resting = body0->m_equilibrium0 & body1->m_equilibrium0;
+					const ndInt32 resting = state.m_equilibrium[body0->m_index] & state.m_equilibrium[body1->m_index];
 					if (resting)
 					{
 						mask[i] = ndFloat32(0.0f);
@@ -1667,9 +1719,7 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 			}
 		};
 
-		const ndInt32 mask = -ndInt32(D_SSE_WORK_GROUP);
-		const ndInt32 soaJointCount = ((jointCount + D_SSE_WORK_GROUP - 1) & mask) / D_SSE_WORK_GROUP;
-		for (ndInt32 i = threadIndex; i < soaJointCount; i += threadCount)
+		for (ndInt32 i = start; i < end; ++i)
 		{
 			JointForce(i, &soaMassMatrix[soaJointRows[i]]);
 		}
@@ -1708,7 +1758,7 @@ void ndDynamicsUpdateSoa::CalculateJointsForce()
 
 	for (ndInt32 i = 0; i < passes; ++i)
 	{
-		scene->ParallelExecute(CalculateJointsForce);
+		scene->ParallelExecuteRange(m_soaJointRows.GetCount(), CalculateJointsForce);
 		scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
 	}
 }
@@ -63,6 +63,23 @@ namespace ndSoa
 		ndVector m_lowerBoundFrictionCoefficent;
 		ndVector m_upperBoundFrictionCoefficent;
 	};
+
+	// per body solver inputs in separate arrays indexed by body m_index, 
+	// so that the joint loops do not pull the whole body object into cache.
+	class ndSoaBodyState
+	{
+		public:
+		ndSoaBodyState();
+		void Resize(ndInt32 size);
+		void SetCount(ndInt32 count);
+
+		ndArray<ndMatrix> m_invInertia;
+		ndArray<ndVector> m_force;
+		ndArray<ndVector> m_torque;
+		ndArray<ndFloat32> m_invMass;
+		ndArray<ndFloat32> m_weigh;
+		ndArray<ndUnsigned8> m_equilibrium;
+	};
 };
 
 D_MSV_NEWTON_ALIGN_32
@@ -102,6 +119,7 @@ class ndDynamicsUpdateSoa: public ndDynamicsUpdate
 	ndArray<ndVector> m_jointMask;
 	ndArray<ndInt32> m_soaJointRows;
 	ndArray<ndSoa::ndSoaMatrixElement> m_soaMassMatrix;
+	ndSoa::ndSoaBodyState m_bodyState;
 
 } D_GCC_NEWTON_ALIGN_32;
 
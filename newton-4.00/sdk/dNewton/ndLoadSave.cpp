@@ -30,6 +30,81 @@
 
 D_CLASS_REFLECTION_IMPLEMENT_LOADER(ndWordSettings);
 
+#define D_SNAPSHOT_VERSION	1
+
+class ndSnapshotHeader
+{
+	public:
+	char m_magic[8];
+	ndInt32 m_version;
+	ndInt32 m_floatSize;
+	ndInt32 m_recordSize;
+	ndInt32 m_bodyCount;
+	ndInt32 m_xmlSize;
+	ndInt32 m_padding;
+};
+
+D_MSV_NEWTON_ALIGN_32
+class ndSnapshotBody
+{
+	public:
+	ndMatrix m_matrix;
+	ndMatrix m_localMatrix;
+	ndMatrix m_alignmentMatrix;
+	ndVector m_veloc;
+	ndVector m_omega;
+	ndVector m_centreOfMass;
+	ndVector m_mass;
+	ndVector m_dampCoef;
+	ndVector m_scale;
+	ndShapeMaterial m_material;
+	ndFloat32 m_skinMargin;
+	ndFloat32 m_maxAngleStep;
+	ndFloat32 m_maxLinearStep;
+	ndInt32 m_hashId;
+	ndInt32 m_shapeHashId;
+	ndInt32 m_notifyIndex;
+	ndUnsigned8 m_isDynamic;
+	ndUnsigned8 m_autoSleep;
+	ndUnsigned8 m_equilibrium;
+	ndUnsigned8 m_collisionMode;
+} D_GCC_NEWTON_ALIGN_32;
+
+// primitives are fully defined by their class and dimensions, so the snapshot saves equal ones only once
+class ndPrimitiveShapeKey
+{
+	public:
+	ndPrimitiveShapeKey(ndShape* const shape)
+	{
+		memset(this, 0, sizeof(ndPrimitiveShapeKey));
+		const ndShapeInfo info(shape->GetShapeInfo());
+		m_className = shape->SubClassName();
+		for (ndInt32 i = 0; i < ndInt32(sizeof(m_params) / sizeof(m_params[0])); ++i)
+		{
+			m_params[i] = info.m_paramArray[i];
+		}
+	}
+
+	static bool IsPrimitive(ndShape* const shape)
+	{
+		return shape->GetAsShapeBox() || shape->GetAsShapeSphere() || shape->GetAsShapeCapsule() || 
+			shape->GetAsShapeCylinder() || shape->GetAsShapeCone() || shape->GetAsShapeChamferCylinder();
+	}
+
+	bool operator< (const ndPrimitiveShapeKey& key) const
+	{
+		return memcmp(this, &key, sizeof(ndPrimitiveShapeKey)) < 0;
+	}
+
+	bool operator> (const ndPrimitiveShapeKey& key) const
+	{
+		return memcmp(this, &key, sizeof(ndPrimitiveShapeKey)) > 0;
+	}
+
+	const char* m_className;
+	ndFloat32 m_params[4];
+};
+
 class ndLoadSaveInfo
 {
 	public:
@@ -65,13 +140,14 @@ class ndLoadSaveInfo
 		if (namePtr)
 		{
 			strncpy(m_assetName, namePtr + 1, sizeof(m_assetName) - 16);
+			namePtr[0] = 0;
 		}
 		else
 		{
-			namePtr = m_assetPath;
-			strncpy(m_assetName, namePtr, sizeof(m_assetName) - 16);
+			// a bare file name, the assets go in the current folder, where the loader looks for them
+			strncpy(m_assetName, m_assetPath, sizeof(m_assetName) - 16);
+			strcpy(m_assetPath, ".");
 		}
-		namePtr[0] = 0;
 		strcat(m_assetName, "_asset");
 		strncpy(m_fileName, fileNameExt, sizeof(m_fileName) - 16);
 	}
@@ -283,7 +359,7 @@ void ndLoadSave::SaveSceneSettings(ndLoadSaveInfo& info) const
 	info.m_setting->Save(descriptor);
 }
 
-void ndLoadSave::SaveShapes(ndLoadSaveInfo& info)
+void ndLoadSave::SaveShapes(ndLoadSaveInfo& info, ndWorldSnapshot* const snapshot)
 {
 	ndTree<const ndShape*, ndInt32> shapeList;
 	ndTree<ndInt32, const ndShape*>::Iterator iter (info.m_shapeMap);
@@ -299,16 +375,59 @@ void ndLoadSave::SaveShapes(ndLoadSaveInfo& info)
 	descriptor.m_assetName = info.m_assetName;
 	descriptor.m_rootNode = info.m_shapesNode;
 	descriptor.m_shapeMap = &info.m_shapeMap;
+	// snapshots write the mesh assets themselves, off the update thread
+	descriptor.m_saveAssets = snapshot ? false : true;
 
 	ndTree<const ndShape*, ndInt32>::Iterator shapeIter(shapeList);
 	for (shapeIter.Begin(); shapeIter; shapeIter++)
 	{
 		descriptor.m_nodeNodeHash = shapeIter.GetKey();
 		const ndShape* const shape = shapeIter.GetNode()->GetInfo();
+		const ndShapeStaticMesh* const mesh = ((ndShape*)shape)->GetAsShapeStaticMesh();
+		if (snapshot && mesh)
+		{
+			descriptor.m_assetIndex = snapshot->CaptureAsset(mesh, info.m_assetPath, info.m_assetName);
+		}
 		shape->Save(descriptor);
 	}
 }
 
+ndInt32 ndLoadSave::GetShapeHash(ndLoadSaveInfo& info, const ndShape* const shape) const
+{
+	ndTree<ndInt32, const ndShape*>::ndNode* shapeNode = info.m_shapeMap.Find(shape);
+	if (!shapeNode)
+	{
+		ndShapeCompound* const compound = ((ndShape*)shape)->GetAsShapeCompound();
+		if (compound)
+		{
+			ndShapeCompound::ndTreeArray::Iterator iter(compound->GetTree());
+			for (iter.Begin(); iter; iter++)
+			{
+				ndShapeCompound::ndNodeBase* const node = iter.GetNode()->GetInfo();
+				ndShapeInstance* const instance = node->GetShape();
+				ndShape* const subShape = instance->GetShape();
+				ndTree<ndInt32, const ndShape*>::ndNode* subShapeNode = info.m_shapeMap.Find(subShape);
+				if (!subShapeNode)
+				{
+					info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), subShape);
+				}
+			}
+		}
+		shapeNode = info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), shape);
+	}
+	return shapeNode->GetInfo();
+}
+
+ndInt32 ndLoadSave::GetBodyHash(ndLoadSaveInfo& info, const ndBodyKinematic* const body) const
+{
+	ndTree<ndInt32, const ndBodyKinematic*>::ndNode* bodyHashNode = info.m_bodyMap.Find(body);
+	if (!bodyHashNode)
+	{
+		bodyHashNode = info.m_bodyMap.Insert(info.m_bodyMap.GetCount() + 1, body);
+	}
+	return bodyHashNode->GetInfo();
+}
+
 void ndLoadSave::SaveBodies(ndLoadSaveInfo& info)
 {
 	ndLoadSaveBase::ndSaveDescriptor descriptor;
@@ -319,37 +438,8 @@ void ndLoadSave::SaveBodies(ndLoadSaveInfo& info)
 	for (ndBodyList::ndNode* bodyNode = info.m_bodyList->GetFirst(); bodyNode; bodyNode = bodyNode->GetNext())
 	{
 		ndBodyKinematic* const body = bodyNode->GetInfo();
-
-		ndShape* const shape = body->GetCollisionShape().GetShape();
-		ndTree<ndInt32, const ndShape*>::ndNode* shapeNode0 = info.m_shapeMap.Find(shape);
-		if (!shapeNode0)
-		{
-			ndShapeCompound* const compound = shape->GetAsShapeCompound();
-			if (compound)
-			{
-				ndShapeCompound::ndTreeArray::Iterator iter(compound->GetTree());
-				for (iter.Begin(); iter; iter++)
-				{
-					ndShapeCompound::ndNodeBase* const node = iter.GetNode()->GetInfo();
-					ndShapeInstance* const instance = node->GetShape();
-					ndShape* const subShape = instance->GetShape();
-					ndTree<ndInt32, const ndShape*>::ndNode* subShapeNode = info.m_shapeMap.Find(subShape);
-					if (!subShapeNode)
-					{
-						info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), subShape);
-					}
-				}
-			}
-			shapeNode0 = info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), shape);
-		}
-		descriptor.m_shapeNodeHash = shapeNode0->GetInfo();
-
-		ndTree<ndInt32, const ndBodyKinematic*>::ndNode* bodyHashNode = info.m_bodyMap.Find(body);
-		if (!bodyHashNode)
-		{
-			bodyHashNode = info.m_bodyMap.Insert(info.m_bodyMap.GetCount() + 1, body);
-		}
-		descriptor.m_nodeNodeHash = bodyHashNode->GetInfo();
+		descriptor.m_shapeNodeHash = GetShapeHash(info, body->GetCollisionShape().GetShape());
+		descriptor.m_nodeNodeHash = GetBodyHash(info, body);
 		body->Save(descriptor);
 	}
 }
@@ -436,7 +526,14 @@ bool ndLoadSave::LoadScene(const char* const path)
 	{
 		namePtr = strrchr(assetPath, '\\');
 	}
-	namePtr[0] = 0;
+	if (namePtr)
+	{
+		namePtr[0] = 0;
+	}
+	else
+	{
+		strcpy(assetPath, ".");
+	}
 
 	const nd::TiXmlElement* const worldNode = doc.RootElement();
 	ndShapeLoaderCache shapesMap;
@@ -562,3 +659,421 @@ void ndLoadSave::SaveModel(const char* const path, const ndModel* const model)
 	setlocale(LC_ALL, oldloc);
 }
 
+
+void ndLoadSave::CaptureSnapshot(ndWorldSnapshot& snapshot, const char* const path, const ndWorld* const world, const ndWordSettings* const setting)
+{
+	D_TRACKTIME();
+	ndLoadSaveInfo info;
+	info.ExtensionAndFilePath(path);
+
+	nd::TiXmlDocument xmlSection;
+	nd::TiXmlElement* const worldNode = new nd::TiXmlElement("ndWorld");
+	xmlSection.LinkEndChild(worldNode);
+
+	info.m_worldNode = worldNode;
+	info.m_settingsNode = new nd::TiXmlElement("ndSettings");
+	info.m_shapesNode = new nd::TiXmlElement("ndShapes");
+	info.m_bodiesNode = new nd::TiXmlElement("ndBodies");
+	info.m_jointsNode = new nd::TiXmlElement("ndJoints");
+	info.m_modelsNode = new nd::TiXmlElement("ndModels");
+	nd::TiXmlElement* const notifiesNode = new nd::TiXmlElement("ndNotifies");
+
+	worldNode->LinkEndChild(info.m_settingsNode);
+	worldNode->LinkEndChild(info.m_shapesNode);
+	worldNode->LinkEndChild(notifiesNode);
+	worldNode->LinkEndChild(info.m_bodiesNode);
+	worldNode->LinkEndChild(info.m_jointsNode);
+	worldNode->LinkEndChild(info.m_modelsNode);
+
+	info.m_setting = setting;
+	info.m_bodyList = &world->GetBodyList();
+	info.m_jointList = &world->GetJointList();
+	info.m_modelList = &world->GetModelList();
+
+	char* const oldloc = setlocale(LC_ALL, 0);
+	setlocale(LC_ALL, "C");
+
+	info.m_bodyMap.Insert(0, nullptr);
+	SaveSceneSettings(info);
+	SaveModels(info);
+	SaveJoints(info);
+	info.m_bodyMap.Remove((ndBodyKinematic*)nullptr);
+
+	// all in tree notifies only save their class and gravity, so bodies share one xml node per pair.
+	class ndNotifyKey
+	{
+		public:
+		const char* m_className;
+		ndFloat32 m_gravity[3];
+	};
+	ndArray<ndNotifyKey> notifyKeys;
+
+	ndLoadSaveBase::ndSaveDescriptor descriptor;
+	descriptor.m_assetPath = info.m_assetPath;
+	descriptor.m_assetName = info.m_assetName;
+	descriptor.m_rootNode = info.m_bodiesNode;
+
+	ndArray<char>& buffer = snapshot.m_buffer;
+	buffer.SetCount(ndInt32(sizeof(ndSnapshotHeader) + info.m_bodyList->GetCount() * sizeof(ndSnapshotBody)));
+	char* const records = &buffer[sizeof(ndSnapshotHeader)];
+
+	ndSnapshotBody record;
+	memset((void*)&record, 0, sizeof(record));
+
+	ndTree<const ndShape*, ndPrimitiveShapeKey> primitives;
+
+	ndInt32 bodyCount = 0;
+	for (ndBodyList::ndNode* bodyNode = info.m_bodyList->GetFirst(); bodyNode; bodyNode = bodyNode->GetNext())
+	{
+		ndBodyKinematic* const body = bodyNode->GetInfo();
+		const ndShape* shape = body->GetCollisionShape().GetShape();
+		if (!info.m_shapeMap.Find(shape) && ndPrimitiveShapeKey::IsPrimitive((ndShape*)shape))
+		{
+			bool wasFound;
+			shape = primitives.Insert(shape, ndPrimitiveShapeKey((ndShape*)shape), wasFound)->GetInfo();
+		}
+		const ndInt32 shapeHash = GetShapeHash(info, shape);
+		const ndInt32 bodyHash = GetBodyHash(info, body);
+
+		const char* const className = body->SubClassName();
+		if (strcmp(className, ndBodyDynamic::ClassName()) && strcmp(className, ndBodyKinematic::ClassName()))
+		{
+			descriptor.m_shapeNodeHash = shapeHash;
+			descriptor.m_nodeNodeHash = bodyHash;
+			body->Save(descriptor);
+			continue;
+		}
+
+		record.m_notifyIndex = -1;
+		ndBodyNotify* const notify = body->GetNotifyCallback();
+		if (notify)
+		{
+			const char* const notifyClassName = notify->SubClassName();
+			const ndVector gravity(notify->GetGravity());
+			for (ndInt32 i = notifyKeys.GetCount() - 1; i >= 0; --i)
+			{
+				const ndNotifyKey& key = notifyKeys[i];
+				if ((key.m_gravity[0] == gravity.m_x) && (key.m_gravity[1] == gravity.m_y) && (key.m_gravity[2] == gravity.m_z) && !strcmp(key.m_className, notifyClassName))
+				{
+					record.m_notifyIndex = i;
+					break;
+				}
+			}
+			if (record.m_notifyIndex < 0)
+			{
+				ndNotifyKey key;
+				key.m_className = notifyClassName;
+				key.m_gravity[0] = gravity.m_x;
+				key.m_gravity[1] = gravity.m_y;
+				key.m_gravity[2] = gravity.m_z;
+				record.m_notifyIndex = notifyKeys.GetCount();
+				notifyKeys.PushBack(key);
+				notify->Save(ndLoadSaveBase::ndSaveDescriptor(descriptor, notifiesNode));
+			}
+		}
+
+		const ndShapeInstance& instance = body->m_shapeInstance;
+		const ndBodyDynamic* const dynamicBody = body->GetAsBodyDynamic();
+
+		record.m_matrix = body->m_matrix;
+		record.m_localMatrix = instance.m_localMatrix;
+		record.m_alignmentMatrix = instance.m_alignmentMatrix;
+		record.m_veloc = body->m_veloc;
+		record.m_omega = body->m_omega;
+		record.m_centreOfMass = body->m_localCentreOfMass;
+		record.m_mass = body->m_mass;
+		record.m_dampCoef = dynamicBody ? dynamicBody->m_dampCoef : ndVector::m_zero;
+		record.m_scale = instance.m_scale;
+		record.m_material = instance.m_shapeMaterial;
+		record.m_skinMargin = instance.m_skinMargin;
+		record.m_maxAngleStep = body->m_maxAngleStep;
+		record.m_maxLinearStep = body->m_maxLinearStep;
+		record.m_hashId = bodyHash;
+		record.m_shapeHashId = shapeHash;
+		record.m_isDynamic = dynamicBody ? 1 : 0;
+		record.m_autoSleep = body->m_autoSleep;
+		record.m_equilibrium = body->m_equilibrium;
+		record.m_collisionMode = instance.m_collisionMode ? 1 : 0;
+
+		memcpy(&records[bodyCount * sizeof(ndSnapshotBody)], &record, sizeof(ndSnapshotBody));
+		bodyCount++;
+	}
+	SaveShapes(info, &snapshot);
+
+	nd::TiXmlPrinter printer;
+	printer.SetStreamPrinting();
+	xmlSection.Accept(&printer);
+	setlocale(LC_ALL, oldloc);
+
+	const ndInt32 recordsSize = ndInt32(sizeof(ndSnapshotHeader) + bodyCount * sizeof(ndSnapshotBody));
+	const ndInt32 xmlSize = ndInt32(printer.Size());
+	buffer.SetCount(recordsSize + xmlSize);
+	memcpy(&buffer[recordsSize], printer.CStr(), size_t(xmlSize));
+
+	ndSnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, "ndSnapSh", sizeof(header.m_magic));
+	header.m_version = D_SNAPSHOT_VERSION;
+	header.m_floatSize = sizeof(ndFloat32);
+	header.m_recordSize = sizeof(ndSnapshotBody);
+	header.m_bodyCount = bodyCount;
+	header.m_xmlSize = xmlSize;
+	memcpy(&buffer[0], &header, sizeof(header));
+
+	strncpy(snapshot.m_fileName, path, sizeof(snapshot.m_fileName) - 8);
+	snapshot.m_fileName[sizeof(snapshot.m_fileName) - 8] = 0;
+}
+
+void ndLoadSave::SaveSnapshot(const char* const path, const ndWorld* const world, const ndWordSettings* const setting)
+{
+	ndWorldSnapshot snapshot;
+	CaptureSnapshot(snapshot, path, world, setting);
+	snapshot.Write();
+}
+
+bool ndLoadSave::LoadSnapshot(const char* const path)
+{
+	D_TRACKTIME();
+	FILE* const file = fopen(path, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const ndInt64 fileSize = ndInt64(ftell(file));
+	fseek(file, 0, SEEK_SET);
+
+	ndSnapshotHeader header;
+	size_t readBytes = fread(&header, 1, sizeof(header), file);
+	if ((readBytes != sizeof(header)) || memcmp(header.m_magic, "ndSnapSh", sizeof(header.m_magic)) ||
+		(header.m_version != D_SNAPSHOT_VERSION) || (header.m_floatSize != sizeof(ndFloat32)) || (header.m_recordSize != sizeof(ndSnapshotBody)))
+	{
+		fclose(file);
+		return false;
+	}
+
+	// the counts come from the file, the records and the xml must add up to its exact size
+	const ndInt64 expectedSize = ndInt64(sizeof(header)) + ndInt64(header.m_bodyCount) * ndInt64(sizeof(ndSnapshotBody)) + ndInt64(header.m_xmlSize);
+	if ((header.m_bodyCount < 0) || (header.m_xmlSize < 0) || (expectedSize != fileSize))
+	{
+		fclose(file);
+		return false;
+	}
+
+	const ndInt32 recordsSize = ndInt32(header.m_bodyCount * sizeof(ndSnapshotBody));
+	ndArray<char> buffer;
+	buffer.SetCount(recordsSize + header.m_xmlSize + 1);
+	readBytes = fread(&buffer[0], 1, size_t(recordsSize + header.m_xmlSize), file);
+	fclose(file);
+	if (readBytes != size_t(recordsSize + header.m_xmlSize))
+	{
+		return false;
+	}
+	buffer[recordsSize + header.m_xmlSize] = 0;
+
+	char* const oldloc = setlocale(LC_ALL, 0);
+	setlocale(LC_ALL, "C");
+
+	nd::TiXmlDocument doc;
+	doc.Parse(&buffer[recordsSize]);
+	if (doc.Error() || !doc.FirstChild("ndWorld"))
+	{
+		setlocale(LC_ALL, oldloc);
+		return false;
+	}
+
+	char assetPath[1024];
+	strcpy(assetPath, path);
+	char* namePtr = strrchr(assetPath, '/');
+	if (!namePtr)
+	{
+		namePtr = strrchr(assetPath, '\\');
+	}
+	if (namePtr)
+	{
+		namePtr[0] = 0;
+	}
+	else
+	{
+		strcpy(assetPath, ".");
+	}
+
+	const nd::TiXmlElement* const worldNode = doc.RootElement();
+	ndShapeLoaderCache shapesMap;
+
+	ndBodySentinel sentinel;
+	m_bodyMap.Insert(&sentinel, 0);
+
+	LoadSceneSettings(worldNode, assetPath);
+	LoadShapes(worldNode, assetPath, shapesMap);
+
+	ndArray<const nd::TiXmlNode*> notifyNodes;
+	const nd::TiXmlNode* const notifies = worldNode->FirstChild("ndNotifies");
+	for (const nd::TiXmlNode* node = notifies ? notifies->FirstChild() : nullptr; node; node = node->NextSibling())
+	{
+		notifyNodes.PushBack(node);
+	}
+
+	ndLoadSaveBase::ndLoadDescriptor descriptor;
+	descriptor.m_assetPath = assetPath;
+	descriptor.m_shapeMap = &shapesMap;
+
+	// every record must reference a saved shape and notify before any body is made
+	ndSnapshotBody record;
+	for (ndInt32 i = 0; i < header.m_bodyCount; ++i)
+	{
+		memcpy((void*)&record, &buffer[i * sizeof(ndSnapshotBody)], sizeof(ndSnapshotBody));
+		if (!shapesMap.Find(record.m_shapeHashId) || (record.m_notifyIndex >= notifyNodes.GetCount()))
+		{
+			setlocale(LC_ALL, oldloc);
+			m_bodyMap.Remove(0);
+			return false;
+		}
+	}
+
+	for (ndInt32 i = 0; i < header.m_bodyCount; ++i)
+	{
+		memcpy((void*)&record, &buffer[i * sizeof(ndSnapshotBody)], sizeof(ndSnapshotBody));
+
+		ndBodyKinematic* const body = record.m_isDynamic ? new ndBodyDynamic() : new ndBodyKinematic();
+		body->m_localCentreOfMass = record.m_centreOfMass;
+		body->SetMatrix(record.m_matrix);
+		body->m_veloc = record.m_veloc;
+		body->m_omega = record.m_omega;
+		body->m_autoSleep = record.m_autoSleep;
+		body->m_equilibrium = record.m_equilibrium;
+
+		ndShapeInstance instance(shapesMap.Find(record.m_shapeHashId)->GetInfo());
+		instance.m_localMatrix = record.m_localMatrix;
+		instance.m_alignmentMatrix = record.m_alignmentMatrix;
+		instance.m_shapeMaterial = record.m_material;
+		instance.m_skinMargin = record.m_skinMargin;
+		instance.m_collisionMode = record.m_collisionMode ? true : false;
+		instance.SetScale(record.m_scale);
+		body->SetCollisionShape(instance);
+		body->SetMassMatrix(record.m_mass);
+
+		body->m_maxAngleStep = record.m_maxAngleStep;
+		body->m_maxLinearStep = record.m_maxLinearStep;
+		if (record.m_isDynamic)
+		{
+			((ndBodyDynamic*)body)->m_dampCoef = record.m_dampCoef;
+		}
+
+		if (record.m_notifyIndex >= 0)
+		{
+			const nd::TiXmlNode* const notifyNode = notifyNodes[record.m_notifyIndex];
+			descriptor.m_rootNode = notifyNode;
+			ndBodyNotify* const notify = D_CLASS_REFLECTION_LOAD_NODE(ndBodyNotify, notifyNode->Value(), descriptor);
+			body->SetNotifyCallback(notify);
+		}
+		m_bodyMap.Insert(body, record.m_hashId);
+	}
+
+	LoadBodies(worldNode, assetPath, shapesMap);
+	LoadJoints(worldNode, assetPath);
+	LoadModels(worldNode, assetPath);
+	setlocale(LC_ALL, oldloc);
+
+	m_bodyMap.Remove(0);
+	return true;
+}
+
+ndWorldSnapshot::ndWorldSnapshot()
+	:ndBackgroundTask()
+	,ndClassAlloc()
+	,m_buffer()
+	,m_assets()
+	,m_assetCount(0)
+	,m_writeStatus(false)
+{
+	m_fileName[0] = 0;
+}
+
+ndWorldSnapshot::~ndWorldSnapshot()
+{
+	Sync();
+	ndTree<ndAsset, const ndShape*>::Iterator iter(m_assets);
+	for (iter.Begin(); iter; iter++)
+	{
+		iter.GetKey()->Release();
+	}
+}
+
+ndInt32 ndWorldSnapshot::CaptureAsset(const ndShapeStaticMesh* const mesh, const char* const assetPath, const char* const assetName)
+{
+	ndTree<ndAsset, const ndShape*>::ndNode* node = m_assets.Find(mesh);
+	if (!node)
+	{
+		// the reference keeps the address from being reused by another shape
+		node = m_assets.Insert(mesh->AddRef());
+	}
+
+	ndAsset& asset = node->GetInfo();
+	char pathName[sizeof(asset.m_pathName)];
+	snprintf(pathName, sizeof(pathName), "%s/%s_%d.bin", assetPath, assetName, asset.m_index);
+	if ((asset.m_index < 0) || strcmp(pathName, asset.m_pathName))
+	{
+		// new shapes, or snapshots moved to another file, get a new asset
+		asset.m_index = m_assetCount;
+		m_assetCount++;
+		snprintf(asset.m_pathName, sizeof(asset.m_pathName), "%s/%s_%d.bin", assetPath, assetName, asset.m_index);
+		asset.m_pending = mesh->GetAssetData(asset.m_data);
+		asset.m_revision = mesh->GetAssetRevision();
+	}
+	else if (asset.m_revision != mesh->GetAssetRevision())
+	{
+		asset.m_pending = mesh->GetAssetData(asset.m_data);
+		asset.m_revision = mesh->GetAssetRevision();
+	}
+	return asset.m_index;
+}
+
+void ndWorldSnapshot::Capture(const char* const path, const ndWorld* const world, const ndWordSettings* const setting)
+{
+	// must be called between world updates, the buffer is reused by the next capture
+	Sync();
+	ndLoadSave loadSave;
+	loadSave.CaptureSnapshot(*this, path, world, setting);
+}
+
+bool ndWorldSnapshot::Write()
+{
+	Sync();
+	Execute(nullptr);
+	return m_writeStatus;
+}
+
+void ndWorldSnapshot::WriteAsync(ndWorld* const world)
+{
+	Sync();
+	world->SendBackgroundTask(this);
+}
+
+void ndWorldSnapshot::Execute(ndThreadPool* const)
+{
+	D_TRACKTIME();
+	// the assets go first, so a snapshot file never references an asset that is not on disk.
+	// every file is written to a temporary and renamed, a crash never destroys the last good one.
+	bool assetStatus = true;
+	ndTree<ndAsset, const ndShape*>::Iterator iter(m_assets);
+	for (iter.Begin(); iter; iter++)
+	{
+		ndAsset& asset = iter.GetNode()->GetInfo();
+		if (asset.m_pending)
+		{
+			if (SaveBinaryFile(asset.m_pathName, &asset.m_data[0], size_t(asset.m_data.GetCount())))
+			{
+				ndArray<char> empty;
+				asset.m_data.Swap(empty);
+				asset.m_pending = false;
+			}
+			else
+			{
+				assetStatus = false;
+			}
+		}
+	}
+	m_writeStatus = assetStatus && SaveBinaryFile(m_fileName, &m_buffer[0], size_t(m_buffer.GetCount()));
+}
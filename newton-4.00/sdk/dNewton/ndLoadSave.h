@@ -26,6 +26,7 @@
 
 class ndWorld;
 class ndLoadSaveInfo;
+class ndWorldSnapshot;
 
 class ndWordSettings : public ndClassAlloc
 {
@@ -62,9 +63,18 @@ class ndLoadSave: public ndClassAlloc
 	D_NEWTON_API void SaveModel(const char* const path, const ndModel* const model);
 	D_NEWTON_API void SaveScene(const char* const path, const ndWorld* const world, const ndWordSettings* const setting);
 
+	// binary snapshots, plain dynamic and kinematic bodies are saved as flat records, 
+	// everything else (shapes, custom bodies, joints and models) as an embedded xml section.
+	D_NEWTON_API bool LoadSnapshot(const char* const path);
+	D_NEWTON_API void SaveSnapshot(const char* const path, const ndWorld* const world, const ndWordSettings* const setting);
+
 	private:
+	ndInt32 GetShapeHash(ndLoadSaveInfo& info, const ndShape* const shape) const;
+	ndInt32 GetBodyHash(ndLoadSaveInfo& info, const ndBodyKinematic* const body) const;
+	void CaptureSnapshot(ndWorldSnapshot& snapshot, const char* const path, const ndWorld* const world, const ndWordSettings* const setting);
+
 	void SaveSceneSettings(ndLoadSaveInfo& info) const;
-	void SaveShapes(ndLoadSaveInfo& info);
+	void SaveShapes(ndLoadSaveInfo& info, ndWorldSnapshot* const snapshot = nullptr);
 	void SaveBodies(ndLoadSaveInfo& info);
 	void SaveJoints(ndLoadSaveInfo& info);
 	void SaveModels(ndLoadSaveInfo& info);
@@ -80,8 +90,59 @@ class ndLoadSave: public ndClassAlloc
 	ndBodyLoaderCache m_bodyMap;
 	ndJointLoaderCache m_jointMap;
 	ndModelLoaderCache m_modelMap;
+	friend class ndWorldSnapshot;
 } D_GCC_NEWTON_ALIGN_32;
 
+// a world snapshot captured in memory, the file can be written on the 
+// world background thread so that periodic snapshots do not stall the update.
+// mesh assets are copied and written only the first time a capture sees them, or after they 
+// change, later captures reference the same files. the snapshot keeps a reference to those shapes.
+class ndWorldSnapshot: public ndBackgroundTask, public ndClassAlloc
+{
+	public:
+	D_NEWTON_API ndWorldSnapshot();
+	D_NEWTON_API virtual ~ndWorldSnapshot();
+
+	D_NEWTON_API void Capture(const char* const path, const ndWorld* const world, const ndWordSettings* const setting);
+	D_NEWTON_API bool Write();
+	D_NEWTON_API void WriteAsync(ndWorld* const world);
+
+	ndInt32 GetSize() const;
+	bool GetWriteStatus() const;
+
+	protected:
+	D_NEWTON_API virtual void Execute(ndThreadPool* const threadPool);
+
+	private:
+	class ndAsset
+	{
+		public:
+		ndAsset()
+			:m_data()
+			,m_index(-1)
+			,m_revision(0)
+			,m_pending(false)
+		{
+			m_pathName[0] = 0;
+		}
+
+		ndArray<char> m_data;
+		char m_pathName[512 + 128];
+		ndInt32 m_index;
+		ndUnsigned32 m_revision;
+		bool m_pending;
+	};
+
+	ndInt32 CaptureAsset(const ndShapeStaticMesh* const mesh, const char* const assetPath, const char* const assetName);
+
+	ndArray<char> m_buffer;
+	ndTree<ndAsset, const ndShape*> m_assets;
+	char m_fileName[512];
+	ndInt32 m_assetCount;
+	bool m_writeStatus;
+	friend class ndLoadSave;
+};
+
 
 inline ndLoadSave::ndLoadSave()
 	:ndClassAlloc()	
@@ -100,5 +161,15 @@ inline ndLoadSave::~ndLoadSave()
 	}
 }
 
+inline ndInt32 ndWorldSnapshot::GetSize() const
+{
+	return m_buffer.GetCount();
+}
+
+inline bool ndWorldSnapshot::GetWriteStatus() const
+{
+	return m_writeStatus;
+}
+
 
 #endif
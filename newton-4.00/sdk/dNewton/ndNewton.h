@@ -33,6 +33,7 @@
 #include <ndShape.h>
 #include <ndWorld.h>
 #include <ndScene.h>
+#include <ndWorldGroup.h>
 #include <ndModel.h>
 #include <ndContact.h>
 #include <ndIkSolver.h>
@@ -56,6 +57,7 @@
 #include <ndIkJointHinge.h>
 #include <ndBodySphFluid.h>
 #include <ndContactArray.h>
+#include <ndWorldCheckpoint.h>
 #include <ndJointFix6dof.h>
 #include <ndBodySphFluid.h>
 #include <ndSkeletonList.h>
@@ -78,6 +80,7 @@
 #include <ndCharacterRootNode.h>
 #include <ndSkeletonContainer.h>
 #include <ndDynamicsUpdateSoa.h>
+#include <ndDynamicsUpdateGaussSeidel.h>
 #include <ndIkJointDoubleHinge.h>
 #include <ndBodyParticleSetList.h>
 #include <ndMultiBodyVehicleMotor.h>
@@ -471,6 +471,7 @@ void ndSkeletonContainer::ClearCloseLoopJoints()
 
 void ndSkeletonContainer::AddCloseLoopJoint(ndConstraint* const joint)
 {
+	ndMemoryScope memoryScope(m_skeletonMemory);
 	ndScopeSpinLock lock(joint->GetBody0()->GetScene()->m_lock);
 	if (m_loopingJoints.GetCount() < (m_loopCount + m_dynamicsLoopCount + 1)) 
 	{
@@ -533,6 +534,7 @@ void ndSkeletonContainer::CheckSleepState()
 
 void ndSkeletonContainer::CalculateBufferSizeInBytes()
 {
+	ndMemoryScope memoryScope(m_skeletonMemory);
 	ndInt32 rowCount = 0;
 	ndInt32 auxiliaryRowCount = 0;
 	if (m_nodesOrder) 
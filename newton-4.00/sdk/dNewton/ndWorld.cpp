@@ -28,7 +28,9 @@
 #include "ndSkeletonList.h"
 #include "ndDynamicsUpdate.h"
 #include "ndBodyParticleSet.h"
+#include "ndWorldCheckpoint.h"
 #include "ndDynamicsUpdateSoa.h"
+#include "ndDynamicsUpdateGaussSeidel.h"
 #include "ndJointBilateralConstraint.h"
 
 #ifdef _D_USE_AVX2_SOLVER
@@ -108,6 +110,8 @@ ndWorld::ndWorld()
 	,m_skeletonList()
 	,m_particleSetList()
 	,m_activeSkeletons(256)
+	,m_memoryAccount("world")
+	,m_frameArena()
 	,m_timestep(ndFloat32 (0.0f))
 	,m_freezeAccel2(D_FREEZE_ACCEL2)
 	//,m_freezeAlpha2(D_FREEZE_ACCEL2)
@@ -120,6 +124,7 @@ ndWorld::ndWorld()
 	,m_subSteps(1)
 	,m_solverMode(ndStandardSolver)
 	,m_solverIterations(4)
+	,m_solverTolerance(ndFloat32(0.0f))
 	,m_frameIndex(0)
 	,m_subStepIndex(0)
 	,m_transformsLock()
@@ -127,7 +132,9 @@ ndWorld::ndWorld()
 	,m_collisionUpdate(true)
 {
 	// start the engine thread;
+	ndMemoryScope memoryScope(m_memoryAccount);
 	ndBody::m_uniqueIdCount = 0;
+	memset(&m_solverStats, 0, sizeof(m_solverStats));
 	m_solver = new ndDynamicsUpdate(this);
 	m_scene = new ndWorldScene(this);
 
@@ -218,6 +225,25 @@ void ndWorld::ClearCache()
 	ndFreeListAlloc::Flush();
 }
 
+void ndWorld::ReserveFrameMemory(ndInt32 sizeInBytes)
+{
+	Sync();
+	m_frameArena.Reset();
+	m_frameArena.Reserve(sizeInBytes);
+}
+
+void ndWorld::SaveCheckpoint(ndWorldCheckpoint& checkpoint) const
+{
+	Sync();
+	checkpoint.Save(this);
+}
+
+bool ndWorld::RestoreCheckpoint(ndWorldCheckpoint& checkpoint)
+{
+	Sync();
+	return checkpoint.Restore(this);
+}
+
 void ndWorld::UpdateTransforms()
 {
 	for (ndBodyParticleSetList::ndNode* node = m_particleSetList.GetFirst(); node; node = node->GetNext())
@@ -237,6 +263,7 @@ void ndWorld::PostUpdate(ndFloat32)
 
 bool ndWorld::AddBody(ndBody* const body)
 {
+	ndMemoryScope memoryScope(m_memoryAccount);
 	ndBodyKinematic* const kinematicBody = body->GetAsBodyKinematic();
 	dAssert(kinematicBody != GetSentinelBody());
 	if (kinematicBody)
@@ -296,6 +323,7 @@ void ndWorld::DeleteBody(ndBody* const body)
 
 void ndWorld::AddJoint(ndJointBilateralConstraint* const joint)
 {
+	ndMemoryScope memoryScope(m_memoryAccount);
 	// if the second body is nullPtr, replace it the sentinel
 	if (joint->m_body1 == nullptr)
 	{
@@ -338,6 +366,7 @@ void ndWorld::RemoveJoint(ndJointBilateralConstraint* const joint)
 
 void ndWorld::AddModel(ndModel* const model)
 {
+	ndMemoryScope memoryScope(m_memoryAccount);
 	if (!model->m_node)
 	{
 		model->AddToWorld(this);
@@ -397,11 +426,29 @@ void ndWorld::UpdateTransformsUnlock()
 	//m_transformsLock.unlock();
 }
 
+void ndWorld::StopThreads()
+{
+	// a world in a group is stepped by the workers of the group, 
+	// so it does not need an update thread or a background thread.
+	Sync();
+	SetThreadCount(1);
+	m_scene->Finish();
+	m_scene->m_backgroundThread.Stop();
+}
+
+void ndWorld::RestartThreads()
+{
+	m_scene->Restart();
+	m_scene->m_backgroundThread.Restart();
+}
+
 void ndWorld::ThreadFunction()
 {
 	ndUnsigned64 timeAcc = dGetTimeInMicroseconds();
 	const bool collisionUpdate = m_collisionUpdate;
+	ndMemoryScope memoryScope(m_memoryAccount, m_generalMemory);
 	m_inUpdate = true;
+	m_frameArena.Reset();
 
 	if (collisionUpdate)
 	{
@@ -413,10 +460,12 @@ void ndWorld::ThreadFunction()
 	{
 		D_TRACKTIME();
 		m_scene->Begin();
+		m_scene->ApplyElevationRegions();
 		m_collisionUpdate = true;
 
 		m_scene->SetTimestep(m_timestep);
 		m_scene->BalanceScene();
+		memset(&m_solverStats, 0, sizeof(m_solverStats));
 
 		ndInt32 const steps = m_subSteps;
 		ndFloat32 timestep = m_timestep / steps;
@@ -440,6 +489,7 @@ void ndWorld::ThreadFunction()
 	}
 	
 	m_frameIndex++;
+	m_memoryAccount.UpdatePeaks();
 	m_lastExecutionTime = (dGetTimeInMicroseconds() - timeAcc) * ndFloat32(1.0e-6f);
 	CalculateAverageUpdateTime();
 }
@@ -488,7 +538,10 @@ void ndWorld::SubStepUpdate(ndFloat32 timestep)
 
 	// calculate internal forces, integrate bodies and update matrices.
 	dAssert(m_solver);
-	m_solver->Update();
+	{
+		ndMemoryScope memoryScope(m_solverMemory);
+		m_solver->Update();
+	}
 
 	// second pass on models
 	ModelPostUpdate();
@@ -499,6 +552,7 @@ void ndWorld::SubStepUpdate(ndFloat32 timestep)
 void ndWorld::ParticleUpdate(ndFloat32 timestep)
 {
 	D_TRACKTIME();
+	ndMemoryScope memoryScope(m_particleMemory);
 	for (ndBodyParticleSetList::ndNode* node = m_particleSetList.GetFirst(); node; node = node->GetNext())
 	{
 		ndBodyParticleSet* const body = node->GetInfo();
@@ -606,6 +660,7 @@ bool ndWorld::SkeletonJointTest(ndJointBilateralConstraint* const constraint) co
 void ndWorld::UpdateSkeletons()
 {
 	D_TRACKTIME();
+	ndMemoryScope memoryScope(m_skeletonMemory);
 	if (m_skeletonList.m_skelListIsDirty)
 	{
 		m_skeletonList.m_skelListIsDirty = false;
@@ -878,11 +933,29 @@ bool ndWorld::RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, c
 	return m_scene->RayCast(callback, globalOrigin, globalDest);
 }
 
+// casts a batch of rays across the world threads and writes the closest hit of each ray
+// into results. when filterMask is not zero, only shapes whose user data id shares a 
+// bit with the mask are hit. must be called outside the world update.
+void ndWorld::RayCast(const ndRayCastQuery* const rays, ndRayCastResult* const results, ndInt32 count, ndUnsigned64 filterMask)
+{
+	dAssert(!m_inUpdate);
+	m_scene->RayCast(rays, results, count, filterMask);
+}
+
 bool ndWorld::ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const
 {
 	return m_scene->ConvexCast(callback, convexShape, globalOrigin, globalDest);
 }
 
+// sweeps a batch of shapes across the world threads and writes the first hit of each
+// sweep into results, the filter mask works like in the batched ray cast.
+// must be called outside the world update.
+void ndWorld::ConvexCast(const ndConvexCastQuery* const casts, ndConvexCastResult* const results, ndInt32 count, ndUnsigned64 filterMask)
+{
+	dAssert(!m_inUpdate);
+	m_scene->ConvexCast(casts, results, count, filterMask);
+}
+
 void ndWorld::BodiesInAabb(ndBodiesInAabbNotify& callback) const
 {
 	m_scene->BodiesInAabb(callback);
@@ -893,6 +966,7 @@ void ndWorld::SelectSolver(ndSolverModes solverMode)
 	if (solverMode != m_solverMode)
 	{
 		Sync();
+		ndMemoryScope memoryScope(m_memoryAccount);
 		delete m_solver;
 		switch (solverMode)
 		{
@@ -907,6 +981,17 @@ void ndWorld::SelectSolver(ndSolverModes solverMode)
 				break;
 			}
 
+			case ndGaussSeidelSolver:
+			{
+				ndWorldScene* const newScene = new ndWorldScene(*((ndWorldScene*)m_scene));
+				delete m_scene;
+				m_scene = newScene;
+
+				m_solverMode = solverMode;
+				m_solver = new ndDynamicsUpdateGaussSeidel(this);
+				break;
+			}
+
 			#ifdef _D_USE_AVX2_SOLVER
 			case ndSimdAvx2Solver:
 			{
@@ -31,9 +31,14 @@
 class ndWorld;
 class ndModel;
 class ndBodyDynamic;
+class ndRayCastQuery;
 class ndRayCastNotify;
+class ndRayCastResult;
 class ndDynamicsUpdate;
+class ndConvexCastQuery;
 class ndConvexCastNotify;
+class ndConvexCastResult;
+class ndWorldCheckpoint;
 class ndBodiesInAabbNotify;
 class ndJointBilateralConstraint;
 
@@ -54,6 +59,22 @@ class ndWorld: public ndClassAlloc
 		ndCudaSolver,
 		ndOpenclSolver1,
 		ndOpenclSolver2,
+		ndGaussSeidelSolver,
+	};
+
+	// what the solver did in the last update, over all sub steps and the four velocity steps of each.
+	// islands and residuals are measured by the default solver when a solver tolerance is set.
+	class ndSolverStats
+	{
+		public:
+		ndInt32 m_jointCount;
+		ndInt32 m_islandCount;
+		ndInt32 m_maxPasses;
+		ndInt32 m_earlyExits;
+		ndInt64 m_islandSolves;
+		ndInt64 m_islandPasses;
+		ndInt64 m_jointPasses;
+		ndFloat32 m_maxResidual;
 	};
 
 	D_NEWTON_API ndWorld();
@@ -75,6 +96,9 @@ class ndWorld: public ndClassAlloc
 	ndInt32 GetSubSteps() const;
 	void SetSubSteps(ndInt32 subSteps);
 
+	bool IsDeterministic() const;
+	void SetDeterministic(bool state);
+
 	ndSolverModes GetSelectedSolver() const;
 	D_NEWTON_API void SelectSolver(ndSolverModes solverMode);
 	D_NEWTON_API const char* GetSolverString() const;
@@ -104,6 +128,15 @@ class ndWorld: public ndClassAlloc
 	ndInt32 GetSolverIterations() const;
 	void SetSolverIterations(ndInt32 iterations);
 
+	// with a tolerance, the solver iterations are an upper limit, each island of moving 
+	// bodies stops iterating as soon as the acceleration error of all its joints is below it.
+	// zero, the default, runs the same number of passes for all islands.
+	// only the standard solver measures it, the soa and gauss seidel solvers 
+	// ignore the tolerance, always run all the passes and leave the stats at zero.
+	ndFloat32 GetSolverTolerance() const;
+	void SetSolverTolerance(ndFloat32 tolerance);
+	const ndSolverStats& GetSolverStats() const;
+
 	ndScene* GetScene() const;
 
 	ndFloat32 GetUpdateTime() const;
@@ -116,14 +149,43 @@ class ndWorld: public ndClassAlloc
 	void DebugScene(ndSceneTreeNotiFy* const notify);
 	void SendBackgroundTask(ndBackgroundTask* const job);
 
+	// replaces the elevations of the vertices in [x0, x1] x [z0, z1] of a heightfield body at the beginning of 
+	// the next update, elevation holds the rows of the region and is copied, so it can be posted at any time.
+	// elevation is null if the map was already edited in place, the collision reads that map during an update, 
+	// so in place edits and this call must be made between updates, after Sync.
+	void UpdateElevationRegion(ndBodyKinematic* const body, ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1, const ndReal* const elevation = nullptr);
+
 	D_NEWTON_API void ClearCache();
+
+	// copies the mutable state of the world into the checkpoint, and restores it in place,
+	// restore fails if bodies or joints were added or removed after the checkpoint was saved.
+	D_NEWTON_API void SaveCheckpoint(ndWorldCheckpoint& checkpoint) const;
+	D_NEWTON_API bool RestoreCheckpoint(ndWorldCheckpoint& checkpoint);
+
+	// scratch memory of the solver and the collision system, all of it is released at the
+	// beginning of each update. an application can read the high water mark after a 
+	// representative run and reserve that much at load time, so that updates never 
+	// have to go to the heap for transient memory.
+	ndFrameArena& GetFrameArena();
+	ndInt32 GetFrameMemoryHighWaterMark() const;
+
+	// the memory the world allocates is charged to this account by subsystem, an application
+	// can charge the bodies and shapes it creates for the world with a ndMemoryScope.
+	ndMemoryAccount& GetMemoryAccount();
+	const ndMemoryAccount& GetMemoryAccount() const;
+	D_NEWTON_API void ReserveFrameMemory(ndInt32 sizeInBytes);
+
 	D_NEWTON_API void BodiesInAabb(ndBodiesInAabbNotify& callback) const;
 	D_NEWTON_API bool RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, const ndVector& globalDest) const;
+	D_NEWTON_API void RayCast(const ndRayCastQuery* const rays, ndRayCastResult* const results, ndInt32 count, ndUnsigned64 filterMask = 0);
 	D_NEWTON_API bool ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
+	D_NEWTON_API void ConvexCast(const ndConvexCastQuery* const casts, ndConvexCastResult* const results, ndInt32 count, ndUnsigned64 filterMask = 0);
 
 	private:
 	void ThreadFunction();
 	void PostUpdate(ndFloat32 timestep);
+	void StopThreads();
+	void RestartThreads();
 	
 	protected:
 	D_NEWTON_API virtual void UpdateSkeletons();
@@ -164,6 +226,8 @@ class ndWorld: public ndClassAlloc
 	ndSkeletonList m_skeletonList;
 	ndBodyParticleSetList m_particleSetList;
 	ndArray<ndSkeletonContainer*> m_activeSkeletons;
+	ndMemoryAccount m_memoryAccount;
+	ndFrameArena m_frameArena;
 	ndFloat32 m_timestep;
 	ndFloat32 m_freezeAccel2;
 	//ndFloat32 m_freezeAlpha2;
@@ -177,8 +241,10 @@ class ndWorld: public ndClassAlloc
 	dgSolverProgressiveSleepEntry m_sleepTable[D_SLEEP_ENTRIES];
 
 	ndInt32 m_subSteps;
+	ndSolverStats m_solverStats;
 	ndSolverModes m_solverMode;
 	ndInt32 m_solverIterations;
+	ndFloat32 m_solverTolerance;
 	ndUnsigned32 m_frameIndex;
 	ndUnsigned32 m_subStepIndex;
 	std::mutex m_transformsLock;
@@ -187,13 +253,16 @@ class ndWorld: public ndClassAlloc
 
 	friend class ndScene;
 	friend class ndWorldScene;
+	friend class ndWorldGroup;
 	friend class ndBodyDynamic;
 	friend class ndDynamicsUpdate;
 	friend class ndSkeletonContainer;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateCuda;
 	friend class ndDynamicsUpdateOpencl;
+	friend class ndWorldCheckpoint;
 } D_GCC_NEWTON_ALIGN_32;
 
 inline void ndWorld::Sync() const
@@ -222,6 +291,18 @@ inline void ndWorld::SetSubSteps(ndInt32 subSteps)
 	m_subSteps = dClamp(subSteps, 1, 16);
 }
 
+// in deterministic mode the result of an update does not depend on the thread count, 
+// at the cost of sorting the new contacts every substep.
+inline bool ndWorld::IsDeterministic() const
+{
+	return m_scene->IsDeterministic();
+}
+
+inline void ndWorld::SetDeterministic(bool state)
+{
+	m_scene->SetDeterministic(state);
+}
+
 inline ndScene* ndWorld::GetScene() const
 {
 	return m_scene;
@@ -237,6 +318,21 @@ inline void ndWorld::SetSolverIterations(ndInt32 iterations)
 	m_solverIterations = ndUnsigned32(dMax(4, iterations));
 }
 
+inline ndFloat32 ndWorld::GetSolverTolerance() const
+{
+	return m_solverTolerance;
+}
+
+inline void ndWorld::SetSolverTolerance(ndFloat32 tolerance)
+{
+	m_solverTolerance = dMax(ndFloat32(0.0f), tolerance);
+}
+
+inline const ndWorld::ndSolverStats& ndWorld::GetSolverStats() const
+{
+	return m_solverStats;
+}
+
 inline ndContactNotify* ndWorld::GetContactNotify() const
 {
 	return m_scene->GetContactNotify();
@@ -297,6 +393,26 @@ inline ndUnsigned32 ndWorld::GetFrameIndex() const
 	return m_frameIndex;
 }
 
+inline ndFrameArena& ndWorld::GetFrameArena()
+{
+	return m_frameArena;
+}
+
+inline ndInt32 ndWorld::GetFrameMemoryHighWaterMark() const
+{
+	return m_frameArena.GetHighWaterMark();
+}
+
+inline ndMemoryAccount& ndWorld::GetMemoryAccount()
+{
+	return m_memoryAccount;
+}
+
+inline const ndMemoryAccount& ndWorld::GetMemoryAccount() const
+{
+	return m_memoryAccount;
+}
+
 inline void ndWorld::OnPostUpdate(ndFloat32)
 {
 }
@@ -344,4 +460,9 @@ inline void ndWorld::SendBackgroundTask(ndBackgroundTask* const job)
 {
 	m_scene->SendBackgroundTask(job);
 }
+
+inline void ndWorld::UpdateElevationRegion(ndBodyKinematic* const body, ndInt32 x0, ndInt32 z0, ndInt32 x1, ndInt32 z1, const ndReal* const elevation)
+{
+	m_scene->UpdateElevationRegion(body, x0, z0, x1, z1, elevation);
+}
 #endif
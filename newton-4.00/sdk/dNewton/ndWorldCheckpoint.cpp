@@ -0,0 +1,410 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyDynamic.h"
+#include "ndWorldCheckpoint.h"
+
+ndWorldCheckpoint::ndWorldCheckpoint()
+	:ndClassAlloc()
+	,m_bodies()
+	,m_joints()
+	,m_contacts()
+	,m_contactPoints()
+	,m_restoredContacts()
+	,m_world(nullptr)
+	,m_timestep(ndFloat32(0.0f))
+	,m_frameIndex(0)
+	,m_subStepIndex(0)
+	,m_sceneLru(0)
+{
+}
+
+ndWorldCheckpoint::~ndWorldCheckpoint()
+{
+}
+
+ndInt32 ndWorldCheckpoint::GetSizeInBytes() const
+{
+	return ndInt32(m_bodies.GetCount() * sizeof(ndBodyState) + m_joints.GetCount() * sizeof(ndJointState) +
+		m_contacts.GetCount() * sizeof(ndContactState) + m_contactPoints.GetCount() * sizeof(ndContactMaterial));
+}
+
+void ndWorldCheckpoint::Save(const ndWorld* const world)
+{
+	D_TRACKTIME();
+	const ndScene* const scene = world->GetScene();
+	m_world = world;
+	m_timestep = scene->m_timestep;
+	m_frameIndex = world->m_frameIndex;
+	m_subStepIndex = world->m_subStepIndex;
+	m_sceneLru = scene->m_lru;
+
+	const ndBodyList& bodyList = world->GetBodyList();
+	m_bodies.SetCount(bodyList.GetCount());
+	ndInt32 index = 0;
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		ndBodyKinematic* const body = node->GetInfo();
+		ndBodyState& state = m_bodies[index];
+		index++;
+
+		state.m_body = body;
+		state.m_matrix = body->m_matrix;
+		state.m_shapeGlobalMatrix = body->m_shapeInstance.GetGlobalMatrix();
+		state.m_invWorldInertiaMatrix = body->m_invWorldInertiaMatrix;
+		state.m_rotation = body->m_rotation;
+		state.m_veloc = body->m_veloc;
+		state.m_omega = body->m_omega;
+		state.m_globalCentreOfMass = body->m_globalCentreOfMass;
+		state.m_minAabb = body->m_minAabb;
+		state.m_maxAabb = body->m_maxAabb;
+		state.m_accel = body->m_accel;
+		state.m_alpha = body->m_alpha;
+		state.m_gyroAlpha = body->m_gyroAlpha;
+		state.m_gyroTorque = body->m_gyroTorque;
+		state.m_gyroRotation = body->m_gyroRotation;
+		state.m_weigh = body->m_weigh;
+		state.m_equilibrium = body->m_equilibrium;
+		state.m_equilibrium0 = body->m_equilibrium0;
+		state.m_isJointFence0 = body->m_isJointFence0;
+		state.m_isJointFence1 = body->m_isJointFence1;
+		state.m_isConstrained = body->m_isConstrained;
+		state.m_sceneForceUpdate = body->m_sceneForceUpdate;
+		state.m_sceneEquilibrium = body->m_sceneEquilibrium;
+
+		const ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
+		state.m_nodeMinBox = bodyNode ? bodyNode->m_minBox : body->m_minAabb;
+		state.m_nodeMaxBox = bodyNode ? bodyNode->m_maxBox : body->m_maxAabb;
+		state.m_nodeSurfaceArea = bodyNode ? bodyNode->m_surfaceArea : ndFloat32(0.0f);
+
+		const ndBodyDynamic* const dynamicBody = body->GetAsBodyDynamic();
+		if (dynamicBody)
+		{
+			state.m_externalForce = dynamicBody->m_externalForce;
+			state.m_externalTorque = dynamicBody->m_externalTorque;
+			state.m_impulseForce = dynamicBody->m_impulseForce;
+			state.m_impulseTorque = dynamicBody->m_impulseTorque;
+			state.m_savedExternalForce = dynamicBody->m_savedExternalForce;
+			state.m_savedExternalTorque = dynamicBody->m_savedExternalTorque;
+			state.m_cachedDampCoef = dynamicBody->m_cachedDampCoef;
+			state.m_cachedTimeStep = dynamicBody->m_cachedTimeStep;
+		}
+	}
+
+	const ndJointList& jointList = world->GetJointList();
+	m_joints.SetCount(jointList.GetCount());
+	index = 0;
+	for (ndJointList::ndNode* node = jointList.GetFirst(); node; node = node->GetNext())
+	{
+		ndJointBilateralConstraint* const joint = node->GetInfo();
+		ndJointState& state = m_joints[index];
+		index++;
+
+		state.m_joint = joint;
+		state.m_forceBody0 = joint->m_forceBody0;
+		state.m_torqueBody0 = joint->m_torqueBody0;
+		state.m_forceBody1 = joint->m_forceBody1;
+		state.m_torqueBody1 = joint->m_torqueBody1;
+		for (ndInt32 i = 0; i < ND_BILATERAL_CONTRAINT_DOF; ++i)
+		{
+			state.m_jointForce[i] = joint->m_jointForce[i];
+			state.m_motorAcceleration[i] = joint->m_motorAcceleration[i];
+		}
+		state.m_active = joint->m_active;
+		state.m_fence0 = joint->m_fence0;
+		state.m_fence1 = joint->m_fence1;
+		state.m_resting = joint->m_resting;
+		state.m_isInSkeletonLoop = joint->m_isInSkeletonLoop;
+	}
+
+	const ndContactArray& contactArray = scene->GetContactArray();
+	m_contacts.SetCount(contactArray.GetCount());
+	m_contactPoints.SetCount(0);
+	for (ndInt32 i = 0; i < contactArray.GetCount(); ++i)
+	{
+		const ndContact* const contact = contactArray[i];
+		ndContactState& state = m_contacts[i];
+
+		state.m_positAcc = contact->m_positAcc;
+		state.m_rotationAcc = contact->m_rotationAcc;
+		state.m_separatingVector = contact->m_separatingVector;
+		state.m_body0 = contact->m_body0;
+		state.m_body1 = contact->m_body1;
+		state.m_material = contact->m_material;
+		state.m_timeOfImpact = contact->m_timeOfImpact;
+		state.m_separationDistance = contact->m_separationDistance;
+		state.m_contactPruningTolereance = contact->m_contactPruningTolereance;
+		state.m_maxDOF = contact->m_maxDOF;
+		state.m_sceneLru = contact->m_sceneLru;
+		state.m_active = contact->m_active;
+		state.m_fence0 = contact->m_fence0;
+		state.m_fence1 = contact->m_fence1;
+		state.m_resting = contact->m_resting;
+		state.m_isInSkeletonLoop = contact->m_isInSkeletonLoop;
+		state.m_isDead = ndUnsigned8(contact->m_isDead);
+		state.m_isAttached = ndUnsigned8(contact->m_isAttached);
+		state.m_isIntersetionTestOnly = ndUnsigned8(contact->m_isIntersetionTestOnly);
+		state.m_skeletonIntraCollision = ndUnsigned8(contact->m_skeletonIntraCollision);
+		state.m_skeletonSelftCollision = ndUnsigned8(contact->m_skeletonSelftCollision);
+
+		// the points are copied with their normal and friction impulses, which are the solver warm start
+		state.m_firstPoint = m_contactPoints.GetCount();
+		state.m_pointCount = contact->m_contacPointsList.GetCount();
+		for (ndContactPointList::ndNode* pointNode = contact->m_contacPointsList.GetFirst(); pointNode; pointNode = pointNode->GetNext())
+		{
+			m_contactPoints.PushBack(pointNode->GetInfo());
+		}
+	}
+}
+
+void ndWorldCheckpoint::RestoreContacts(ndWorld* const world)
+{
+	D_TRACKTIME();
+	ndScene* const scene = world->GetScene();
+	ndContactArray& contactArray = scene->m_contactArray;
+
+	// reuse the contacts that are still alive, a pair that was recreated with the bodies swapped does not count
+	m_restoredContacts.SetCount(m_contacts.GetCount());
+	for (ndInt32 i = 0; i < m_contacts.GetCount(); ++i)
+	{
+		const ndContactState& state = m_contacts[i];
+		ndContact* contact = state.m_isAttached ? scene->FindContactJoint(state.m_body0, state.m_body1) : nullptr;
+		if (contact && ((contact->m_body0 != state.m_body0) || contact->m_checkpointMark))
+		{
+			contact = nullptr;
+		}
+		if (contact)
+		{
+			contact->m_checkpointMark = 1;
+		}
+		m_restoredContacts[i] = contact;
+	}
+
+	// contacts created after the save are deleted
+	for (ndInt32 i = 0; i < contactArray.GetCount(); ++i)
+	{
+		ndContact* const contact = contactArray[i];
+		if (!contact->m_checkpointMark)
+		{
+			contactArray.DeleteContact(contact);
+			delete contact;
+		}
+	}
+
+	// and the ones deleted since the save are created again
+	for (ndInt32 i = 0; i < m_contacts.GetCount(); ++i)
+	{
+		if (!m_restoredContacts[i])
+		{
+			const ndContactState& state = m_contacts[i];
+			ndContact* const contact = new ndContact;
+			contact->SetBodies(state.m_body0, state.m_body1);
+			contact->m_material = state.m_material;
+			if (state.m_isAttached)
+			{
+				contact->AttachToBodies();
+			}
+			m_restoredContacts[i] = contact;
+		}
+	}
+
+	contactArray.SetCount(m_restoredContacts.GetCount());
+	for (ndInt32 i = 0; i < m_restoredContacts.GetCount(); ++i)
+	{
+		const ndContactState& state = m_contacts[i];
+		ndContact* const contact = m_restoredContacts[i];
+		contactArray[i] = contact;
+
+		contact->m_checkpointMark = 0;
+		contact->m_positAcc = state.m_positAcc;
+		contact->m_rotationAcc = state.m_rotationAcc;
+		contact->m_separatingVector = state.m_separatingVector;
+		contact->m_material = state.m_material;
+		contact->m_timeOfImpact = state.m_timeOfImpact;
+		contact->m_separationDistance = state.m_separationDistance;
+		contact->m_contactPruningTolereance = state.m_contactPruningTolereance;
+		contact->m_maxDOF = state.m_maxDOF;
+		contact->m_sceneLru = state.m_sceneLru;
+		contact->m_active = state.m_active;
+		contact->m_fence0 = state.m_fence0;
+		contact->m_fence1 = state.m_fence1;
+		contact->m_resting = state.m_resting;
+		contact->m_isInSkeletonLoop = state.m_isInSkeletonLoop;
+		contact->m_isDead = state.m_isDead;
+		contact->m_isIntersetionTestOnly = state.m_isIntersetionTestOnly;
+		contact->m_skeletonIntraCollision = state.m_skeletonIntraCollision;
+		contact->m_skeletonSelftCollision = state.m_skeletonSelftCollision;
+
+		// reuse the point list nodes, the free list allocator recycles the few that are missing
+		ndContactPointList& points = contact->m_contacPointsList;
+		while (points.GetCount() > state.m_pointCount)
+		{
+			points.Remove(points.GetLast());
+		}
+		while (points.GetCount() < state.m_pointCount)
+		{
+			points.Append();
+		}
+		ndInt32 pointIndex = state.m_firstPoint;
+		for (ndContactPointList::ndNode* pointNode = points.GetFirst(); pointNode; pointNode = pointNode->GetNext())
+		{
+			pointNode->GetInfo() = m_contactPoints[pointIndex];
+			pointIndex++;
+		}
+	}
+
+	// the active array is rebuilt by the next update, until then it would hold deleted contacts
+	scene->m_activeConstraintArray.SetCount(0);
+}
+
+bool ndWorldCheckpoint::Restore(ndWorld* const world)
+{
+	D_TRACKTIME();
+	const ndBodyList& bodyList = world->GetBodyList();
+	if ((m_world != world) || (bodyList.GetCount() != m_bodies.GetCount()) || (world->GetJointList().GetCount() != m_joints.GetCount()))
+	{
+		return false;
+	}
+
+	ndInt32 index = 0;
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		if (m_bodies[index].m_body != node->GetInfo())
+		{
+			return false;
+		}
+		index++;
+	}
+	index = 0;
+	for (ndJointList::ndNode* node = world->GetJointList().GetFirst(); node; node = node->GetNext())
+	{
+		if (m_joints[index].m_joint != node->GetInfo())
+		{
+			return false;
+		}
+		index++;
+	}
+
+	ndScene* const scene = world->GetScene();
+	scene->m_timestep = m_timestep;
+	scene->m_lru = m_sceneLru;
+	world->m_frameIndex = m_frameIndex;
+	world->m_subStepIndex = m_subStepIndex;
+
+	// attaching and detaching contacts changes the sleep state of the bodies, so they go first
+	RestoreContacts(world);
+
+	index = 0;
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		ndBodyKinematic* const body = node->GetInfo();
+		const ndBodyState& state = m_bodies[index];
+		index++;
+
+		body->m_matrix = state.m_matrix;
+		body->m_invWorldInertiaMatrix = state.m_invWorldInertiaMatrix;
+		body->m_rotation = state.m_rotation;
+		body->m_veloc = state.m_veloc;
+		body->m_omega = state.m_omega;
+		body->m_globalCentreOfMass = state.m_globalCentreOfMass;
+		body->m_accel = state.m_accel;
+		body->m_alpha = state.m_alpha;
+		body->m_gyroAlpha = state.m_gyroAlpha;
+		body->m_gyroTorque = state.m_gyroTorque;
+		body->m_gyroRotation = state.m_gyroRotation;
+		body->m_weigh = state.m_weigh;
+		body->m_equilibrium = state.m_equilibrium;
+		body->m_equilibrium0 = state.m_equilibrium0;
+		body->m_isJointFence0 = state.m_isJointFence0;
+		body->m_isJointFence1 = state.m_isJointFence1;
+		body->m_isConstrained = state.m_isConstrained;
+		body->m_sceneForceUpdate = state.m_sceneForceUpdate;
+		body->m_sceneEquilibrium = state.m_sceneEquilibrium;
+
+		// the shape matrix lags the body matrix by one integration, so it is restored rather than recalculated
+		body->m_shapeInstance.SetGlobalMatrix(state.m_shapeGlobalMatrix);
+		body->m_minAabb = state.m_minAabb;
+		body->m_maxAabb = state.m_maxAabb;
+		// so that the notify callbacks see the restored matrix on the next update
+		body->m_transformIsDirty = 1;
+
+		ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
+		if (bodyNode)
+		{
+			// the saved box is already quantized, going through SetAabb would grow it
+			bodyNode->m_minBox = state.m_nodeMinBox;
+			bodyNode->m_maxBox = state.m_nodeMaxBox;
+			bodyNode->m_surfaceArea = state.m_nodeSurfaceArea;
+		}
+
+		ndBodyDynamic* const dynamicBody = body->GetAsBodyDynamic();
+		if (dynamicBody)
+		{
+			dynamicBody->m_externalForce = state.m_externalForce;
+			dynamicBody->m_externalTorque = state.m_externalTorque;
+			dynamicBody->m_impulseForce = state.m_impulseForce;
+			dynamicBody->m_impulseTorque = state.m_impulseTorque;
+			dynamicBody->m_savedExternalForce = state.m_savedExternalForce;
+			dynamicBody->m_savedExternalTorque = state.m_savedExternalTorque;
+			dynamicBody->m_cachedDampCoef = state.m_cachedDampCoef;
+			dynamicBody->m_cachedTimeStep = state.m_cachedTimeStep;
+		}
+	}
+
+	// parent boxes only grow here, they are tightened again when the tree is balanced
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		ndSceneBodyNode* const bodyNode = node->GetInfo()->GetSceneBodyNode();
+		if (bodyNode)
+		{
+			scene->UpdateParentAabb(bodyNode);
+		}
+	}
+	scene->m_queryTree.Invalidate();
+
+	index = 0;
+	for (ndJointList::ndNode* node = world->GetJointList().GetFirst(); node; node = node->GetNext())
+	{
+		ndJointBilateralConstraint* const joint = node->GetInfo();
+		const ndJointState& state = m_joints[index];
+		index++;
+
+		joint->m_forceBody0 = state.m_forceBody0;
+		joint->m_torqueBody0 = state.m_torqueBody0;
+		joint->m_forceBody1 = state.m_forceBody1;
+		joint->m_torqueBody1 = state.m_torqueBody1;
+		for (ndInt32 i = 0; i < ND_BILATERAL_CONTRAINT_DOF; ++i)
+		{
+			joint->m_jointForce[i] = state.m_jointForce[i];
+			joint->m_motorAcceleration[i] = state.m_motorAcceleration[i];
+		}
+		joint->m_active = state.m_active;
+		joint->m_fence0 = state.m_fence0;
+		joint->m_fence1 = state.m_fence1;
+		joint->m_resting = state.m_resting;
+		joint->m_isInSkeletonLoop = state.m_isInSkeletonLoop;
+	}
+
+	return true;
+}
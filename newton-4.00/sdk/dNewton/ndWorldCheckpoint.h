@@ -0,0 +1,156 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_WORLD_CHECKPOINT_H__
+#define __ND_WORLD_CHECKPOINT_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+class ndContact;
+
+// the mutable state of a world: body transforms, velocities and sleep state, the contact
+// cache with the warm start impulses of each point and the joint force accumulators.
+// the arrays keep their capacity, so after the first save taking a checkpoint does not allocate.
+// a checkpoint can only be restored to the world it was taken from, and only if no bodies or
+// joints were added or removed in between, the state members of derived joints are not saved.
+D_MSV_NEWTON_ALIGN_32
+class ndWorldCheckpoint: public ndClassAlloc
+{
+	public:
+	D_MSV_NEWTON_ALIGN_32
+	class ndBodyState
+	{
+		public:
+		ndMatrix m_matrix;
+		ndMatrix m_shapeGlobalMatrix;
+		ndMatrix m_invWorldInertiaMatrix;
+		ndQuaternion m_rotation;
+		ndVector m_veloc;
+		ndVector m_omega;
+		ndVector m_globalCentreOfMass;
+		ndVector m_minAabb;
+		ndVector m_maxAabb;
+		ndVector m_nodeMinBox;
+		ndVector m_nodeMaxBox;
+		ndVector m_accel;
+		ndVector m_alpha;
+		ndVector m_gyroAlpha;
+		ndVector m_gyroTorque;
+		ndQuaternion m_gyroRotation;
+		ndVector m_externalForce;
+		ndVector m_externalTorque;
+		ndVector m_impulseForce;
+		ndVector m_impulseTorque;
+		ndVector m_savedExternalForce;
+		ndVector m_savedExternalTorque;
+		ndVector m_cachedDampCoef;
+		ndBodyKinematic* m_body;
+		ndFloat32 m_cachedTimeStep;
+		ndFloat32 m_weigh;
+		ndFloat32 m_nodeSurfaceArea;
+		ndUnsigned8 m_equilibrium;
+		ndUnsigned8 m_equilibrium0;
+		ndUnsigned8 m_isJointFence0;
+		ndUnsigned8 m_isJointFence1;
+		ndUnsigned8 m_isConstrained;
+		ndUnsigned8 m_sceneForceUpdate;
+		ndUnsigned8 m_sceneEquilibrium;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_MSV_NEWTON_ALIGN_32
+	class ndContactState
+	{
+		public:
+		ndVector m_positAcc;
+		ndQuaternion m_rotationAcc;
+		ndVector m_separatingVector;
+		ndBodyKinematic* m_body0;
+		ndBodyKinematic* m_body1;
+		ndMaterial* m_material;
+		ndFloat32 m_timeOfImpact;
+		ndFloat32 m_separationDistance;
+		ndFloat32 m_contactPruningTolereance;
+		ndUnsigned32 m_maxDOF;
+		ndUnsigned32 m_sceneLru;
+		ndInt32 m_firstPoint;
+		ndInt32 m_pointCount;
+		ndUnsigned8 m_active;
+		ndUnsigned8 m_fence0;
+		ndUnsigned8 m_fence1;
+		ndUnsigned8 m_resting;
+		ndUnsigned8 m_isInSkeletonLoop;
+		ndUnsigned8 m_isDead;
+		ndUnsigned8 m_isAttached;
+		ndUnsigned8 m_isIntersetionTestOnly;
+		ndUnsigned8 m_skeletonIntraCollision;
+		ndUnsigned8 m_skeletonSelftCollision;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_MSV_NEWTON_ALIGN_32
+	class ndJointState
+	{
+		public:
+		ndVector m_forceBody0;
+		ndVector m_torqueBody0;
+		ndVector m_forceBody1;
+		ndVector m_torqueBody1;
+		ndForceImpactPair m_jointForce[ND_BILATERAL_CONTRAINT_DOF];
+		ndFloat32 m_motorAcceleration[ND_BILATERAL_CONTRAINT_DOF];
+		ndJointBilateralConstraint* m_joint;
+		ndUnsigned8 m_active;
+		ndUnsigned8 m_fence0;
+		ndUnsigned8 m_fence1;
+		ndUnsigned8 m_resting;
+		ndUnsigned8 m_isInSkeletonLoop;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_NEWTON_API ndWorldCheckpoint();
+	D_NEWTON_API ~ndWorldCheckpoint();
+
+	D_NEWTON_API ndInt32 GetSizeInBytes() const;
+	ndInt32 GetContactCount() const;
+
+	private:
+	void Save(const ndWorld* const world);
+	bool Restore(ndWorld* const world);
+	void RestoreContacts(ndWorld* const world);
+
+	ndArray<ndBodyState> m_bodies;
+	ndArray<ndJointState> m_joints;
+	ndArray<ndContactState> m_contacts;
+	ndArray<ndContactMaterial> m_contactPoints;
+	ndArray<ndContact*> m_restoredContacts;
+	const ndWorld* m_world;
+	ndFloat32 m_timestep;
+	ndUnsigned32 m_frameIndex;
+	ndUnsigned32 m_subStepIndex;
+	ndUnsigned32 m_sceneLru;
+
+	friend class ndWorld;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline ndInt32 ndWorldCheckpoint::GetContactCount() const
+{
+	return m_contacts.GetCount();
+}
+
+#endif
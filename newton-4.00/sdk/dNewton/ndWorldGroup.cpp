@@ -0,0 +1,131 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndWorldGroup.h"
+
+ndWorldGroup::ndWorldGroup()
+	:ndThreadPool("worldGroup")
+	,m_worlds()
+	,m_schedule()
+	,m_timestep(ndFloat32(0.0f))
+	,m_lastExecutionTime(ndFloat32(0.0f))
+{
+}
+
+ndWorldGroup::~ndWorldGroup()
+{
+	Sync();
+	Finish();
+}
+
+void ndWorldGroup::AddWorld(ndWorld* const world)
+{
+	Sync();
+	#ifdef _DEBUG
+	for (ndInt32 i = 0; i < m_worlds.GetCount(); ++i)
+	{
+		dAssert(m_worlds[i] != world);
+	}
+	#endif
+
+	// the group provides the parallelism, the world runs on a single thread.
+	world->StopThreads();
+	m_worlds.PushBack(world);
+}
+
+void ndWorldGroup::RemoveWorld(ndWorld* const world)
+{
+	Sync();
+	for (ndInt32 i = 0; i < m_worlds.GetCount(); ++i)
+	{
+		if (m_worlds[i] == world)
+		{
+			m_worlds[i] = m_worlds[m_worlds.GetCount() - 1];
+			m_worlds.SetCount(m_worlds.GetCount() - 1);
+			world->RestartThreads();
+			break;
+		}
+	}
+}
+
+void ndWorldGroup::ThreadFunction()
+{
+	D_TRACKTIME();
+	ndUnsigned64 timeAcc = dGetTimeInMicroseconds();
+	Begin();
+	UpdateWorlds();
+	End();
+	m_lastExecutionTime = (dGetTimeInMicroseconds() - timeAcc) * ndFloat32(1.0e-6f);
+}
+
+void ndWorldGroup::UpdateWorlds()
+{
+	D_TRACKTIME();
+	class ndCompareWorldCost
+	{
+		public:
+		ndInt32 Compare(const ndWorld* const worldA, const ndWorld* const worldB, void* const) const
+		{
+			const ndFloat32 costA = worldA->GetUpdateTime();
+			const ndFloat32 costB = worldB->GetUpdateTime();
+			if (costA > costB)
+			{
+				return -1;
+			}
+			else if (costA < costB)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	// hand out the most expensive worlds of the last update first, 
+	// so that the cheap ones fill the gaps at the end of the step.
+	m_schedule.SetCount(m_worlds.GetCount());
+	for (ndInt32 i = 0; i < m_worlds.GetCount(); ++i)
+	{
+		m_schedule[i] = m_worlds[i];
+	}
+	if (m_schedule.GetCount() > 1)
+	{
+		ndSort<ndWorld*, ndCompareWorldCost>(&m_schedule[0], m_schedule.GetCount());
+	}
+
+	const ndFloat32 timestep = m_timestep;
+	ndAtomic<ndInt32> nextWorld(0);
+	auto StepWorlds = ndMakeObject::ndFunction([this, timestep, &nextWorld](ndInt32, ndInt32)
+	{
+		D_TRACKTIME();
+		const ndInt32 count = m_schedule.GetCount();
+		for (ndInt32 i = nextWorld.fetch_add(1); i < count; i = nextWorld.fetch_add(1))
+		{
+			ndWorld* const world = m_schedule[i];
+			world->m_timestep = timestep;
+			world->m_collisionUpdate = false;
+			world->ThreadFunction();
+		}
+	});
+	ParallelExecute(StepWorlds);
+}
@@ -0,0 +1,81 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_WORLD_GROUP_H__
+#define __ND_WORLD_GROUP_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+
+// steps many independent worlds on one shared thread pool. 
+// worlds added to a group run single threaded, and the group workers 
+// take whole worlds from a shared index, the most expensive first.
+// this way many small worlds keep all cores busy without each world 
+// owning any threads, the update and background threads of a world 
+// are stopped while it is in a group, and restarted when it is removed.
+// a world in a group must not be updated on its own, and collision 
+// shapes with per thread scratch data (procedural meshes) should not 
+// be shared by worlds of the same group.
+class ndWorldGroup: public ndThreadPool
+{
+	public:
+	D_NEWTON_API ndWorldGroup();
+	D_NEWTON_API virtual ~ndWorldGroup();
+
+	D_NEWTON_API void AddWorld(ndWorld* const world);
+	D_NEWTON_API void RemoveWorld(ndWorld* const world);
+	const ndArray<ndWorld*>& GetWorlds() const;
+
+	void Update(ndFloat32 timestep);
+	ndFloat32 GetUpdateTime() const;
+
+	private:
+	virtual void ThreadFunction();
+	void UpdateWorlds();
+
+	ndArray<ndWorld*> m_worlds;
+	ndArray<ndWorld*> m_schedule;
+	ndFloat32 m_timestep;
+	ndFloat32 m_lastExecutionTime;
+};
+
+inline const ndArray<ndWorld*>& ndWorldGroup::GetWorlds() const
+{
+	return m_worlds;
+}
+
+inline ndFloat32 ndWorldGroup::GetUpdateTime() const
+{
+	return m_lastExecutionTime;
+}
+
+inline void ndWorldGroup::Update(ndFloat32 timestep)
+{
+	// wait until previous update complete.
+	Sync();
+
+	// update all worlds asynchronous 
+	m_timestep = timestep;
+	TickOne();
+}
+
+#endif
@@ -27,6 +27,7 @@ ndWorldScene::ndWorldScene(ndWorld* const world)
 	:ndScene()
 	,m_world(world)
 {
+	m_frameArena = &world->m_frameArena;
 }
 
 ndWorldScene::ndWorldScene(const ndWorldScene& src)